@@ -0,0 +1,158 @@
+#include "FakeHttpClient.hpp"
+#include <benchmark/benchmark.h>
+#include <sauron/Sauron.hpp>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace sauron;
+
+namespace {
+
+/// Pipeline stages attached to the client, selected by a benchmark argument.
+enum Stages : long {
+    Bare = 0,          ///< Transport only
+    Observed = 1,      ///< Metrics
+    Resilient = 2,     ///< Metrics, retries and adaptive rate limiting
+};
+
+std::unique_ptr<client::SauronClient> makeClient(long stages, std::size_t responseSize,
+                                                 std::vector<std::string> chunks = {}) {
+    auto http = std::make_unique<bench::FakeHttpClient>();
+    http->respond("/ai/query", 200, dto::AIQueryResponse(std::string(responseSize, 'r')).toString());
+    http->respond("/health", 200, "{\"status\":\"ok\"}");
+    http->streamChunks(std::move(chunks));
+    auto sauron = std::make_unique<client::SauronClient>(std::move(http));
+    sauron->setToken("bench-token");
+    if (stages >= Observed) {
+        sauron->setMetrics(client::Metrics::create());
+    }
+    if (stages >= Resilient) {
+        sauron->setRetrier(client::Retrier::create());
+        sauron->setRateLimiter(client::RateLimiter::create());
+    }
+    return sauron;
+}
+
+void stageArgs(benchmark::internal::Benchmark* bench) {
+    bench->ArgNames({"stages"})->Arg(Bare)->Arg(Observed)->Arg(Resilient);
+}
+
+// Shared across threads of a multi-threaded run; built by thread 0.
+std::unique_ptr<client::SauronClient> shared;
+
+void BM_Client_Query(benchmark::State& state) {
+    if (state.thread_index() == 0) {
+        shared = makeClient(state.range(0), 1024);
+    }
+    dto::AIQueryRequest request("Explain merge sort in one paragraph.", dto::AIProvider::OPENAI);
+    for (auto _ : state) {
+        dto::AIQueryResponse response = shared->query(request);
+        benchmark::DoNotOptimize(response);
+    }
+    state.SetItemsProcessed(state.iterations());
+    if (state.thread_index() == 0) {
+        shared.reset();
+    }
+}
+BENCHMARK(BM_Client_Query)->Apply(stageArgs)->ThreadRange(1, 8)->UseRealTime();
+
+void BM_Client_QueryLargePrompt(benchmark::State& state) {
+    auto sauron = makeClient(Bare, 1024);
+    dto::AIQueryRequest request(std::string(static_cast<std::size_t>(state.range(0)), 'p'), dto::AIProvider::OPENAI);
+    for (auto _ : state) {
+        dto::AIQueryResponse response = sauron->query(request);
+        benchmark::DoNotOptimize(response);
+    }
+    state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * request.getPrompt().size()));
+}
+BENCHMARK(BM_Client_QueryLargePrompt)->Arg(4 << 10)->Arg(256 << 10)->Arg(4 << 20);
+
+void BM_Client_QueryCacheHit(benchmark::State& state) {
+    auto sauron = makeClient(Bare, 1024);
+    sauron->setResponseCache(client::ResponseCache::create());
+    dto::AIQueryRequest request("Explain merge sort in one paragraph.", dto::AIProvider::OPENAI);
+    sauron->query(request);
+    for (auto _ : state) {
+        dto::AIQueryResponse response = sauron->query(request);
+        benchmark::DoNotOptimize(response);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Client_QueryCacheHit);
+
+void BM_Client_CheckHealth(benchmark::State& state) {
+    auto sauron = makeClient(state.range(0), 0);
+    for (auto _ : state) {
+        dto::HealthResponse response = sauron->checkHealth();
+        benchmark::DoNotOptimize(response);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Client_CheckHealth)->Apply(stageArgs);
+
+/// state.range(0) SSE events of state.range(1) data bytes each, one event per chunk.
+std::vector<std::string> makeEventChunks(const benchmark::State& state) {
+    std::string event = "data: " + std::string(static_cast<std::size_t>(state.range(1)), 'e') + "\n\n";
+    return std::vector<std::string>(static_cast<std::size_t>(state.range(0)), event);
+}
+
+void streamArgs(benchmark::internal::Benchmark* bench) {
+    bench->ArgNames({"events", "size"})->Args({1000, 16})->Args({1000, 256})->Args({100, 16 << 10});
+}
+
+void BM_Client_QueryStream(benchmark::State& state) {
+    std::vector<std::string> chunks = makeEventChunks(state);
+    auto sauron = makeClient(Bare, 0, chunks);
+    dto::AIQueryRequest request("Stream a story.", dto::AIProvider::OPENAI);
+    std::size_t bytes = 0;
+    for (auto _ : state) {
+        sauron->queryStream(request, [&bytes](const std::string& chunk, bool) {
+            bytes += chunk.size();
+            return true;
+        });
+    }
+    state.SetBytesProcessed(static_cast<std::int64_t>(bytes));
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Client_QueryStream)->Apply(streamArgs);
+
+void BM_Client_QueryStreamEvents(benchmark::State& state) {
+    std::vector<std::string> chunks = makeEventChunks(state);
+    auto sauron = makeClient(Bare, 0, chunks);
+    dto::AIQueryRequest request("Stream a story.", dto::AIProvider::OPENAI);
+    std::size_t bytes = 0;
+    for (auto _ : state) {
+        sauron->queryStreamEvents(request, [&bytes](const client::SseEvent& event) {
+            bytes += event.data.size();
+            return true;
+        });
+    }
+    state.SetBytesProcessed(static_cast<std::int64_t>(bytes));
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Client_QueryStreamEvents)->Apply(streamArgs);
+
+/// Decoder alone, fed in fixed-size chunks that split events at arbitrary points.
+void BM_SseDecoder_Feed(benchmark::State& state) {
+    std::string stream;
+    for (int i = 0; i < 1000; ++i) {
+        stream += "event: delta\ndata: {\"text\":\"" + std::string(48, 't') + "\"}\n\n";
+    }
+    const std::size_t chunkSize = static_cast<std::size_t>(state.range(0));
+    std::size_t events = 0;
+    for (auto _ : state) {
+        client::SseDecoder decoder;
+        for (std::size_t at = 0; at < stream.size(); at += chunkSize) {
+            decoder.feed(std::string_view(stream).substr(at, chunkSize), [&events](const client::SseEvent&) {
+                ++events;
+                return true;
+            });
+        }
+    }
+    state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * stream.size()));
+    state.SetItemsProcessed(static_cast<std::int64_t>(events));
+}
+BENCHMARK(BM_SseDecoder_Feed)->Arg(64)->Arg(1500)->Arg(16 << 10);
+
+} // namespace
@@ -0,0 +1,311 @@
+#include <benchmark/benchmark.h>
+#include <sauron/Sauron.hpp>
+#include <string>
+#include <vector>
+
+using namespace sauron;
+
+namespace {
+
+// Prose with the occasional quote, newline and non-ASCII character, so
+// escaping is exercised the way a real prompt exercises it.
+std::string makeText(std::size_t size) {
+    static const std::string sample =
+        "Explain why \"merge sort\" runs in O(n log n).\nInclude an example \xC3\xA9t\xC3\xA9 and a table\t| a | b |. ";
+    std::string text;
+    text.reserve(size + sample.size());
+    while (text.size() < size) {
+        text += sample;
+    }
+    text.resize(size);
+    while (!text.empty() && (static_cast<unsigned char>(text.back()) & 0xC0) == 0x80) {
+        text.pop_back(); // do not cut a UTF-8 sequence in half
+    }
+    if (!text.empty() && static_cast<unsigned char>(text.back()) >= 0xC0) {
+        text.pop_back();
+    }
+    return text;
+}
+
+std::string makeImage(std::size_t rawBytes) {
+    std::string raw(rawBytes, '\0');
+    for (std::size_t i = 0; i < raw.size(); ++i) {
+        raw[i] = static_cast<char>((i * 131) ^ (i >> 7));
+    }
+    return util::base64::encode(raw);
+}
+
+/// state.range(0): prompt bytes; state.range(1): number of 256 KiB images.
+dto::AIQueryRequest makeRequest(const benchmark::State& state) {
+    std::vector<std::string> images(static_cast<std::size_t>(state.range(1)), makeImage(256 * 1024));
+    return dto::AIQueryRequest(makeText(static_cast<std::size_t>(state.range(0))), dto::AIProvider::OPENAI,
+                               "gpt-4o", images);
+}
+
+void requestArgs(benchmark::internal::Benchmark* bench) {
+    bench->ArgNames({"prompt", "images"});
+    for (long prompt : {64L, 4L << 10, 256L << 10, 4L << 20}) {
+        bench->Args({prompt, 0});
+    }
+    bench->Args({4L << 10, 1});
+    bench->Args({4L << 10, 4});
+}
+
+void BM_AIQueryRequest_ToJsonDump(benchmark::State& state) {
+    dto::AIQueryRequest request = makeRequest(state);
+    std::size_t bytes = 0;
+    for (auto _ : state) {
+        std::string text = request.toJson().dump();
+        bytes += text.size();
+        benchmark::DoNotOptimize(text);
+    }
+    state.SetBytesProcessed(static_cast<std::int64_t>(bytes));
+}
+BENCHMARK(BM_AIQueryRequest_ToJsonDump)->Apply(requestArgs);
+
+void BM_AIQueryRequest_ToString(benchmark::State& state) {
+    dto::AIQueryRequest request = makeRequest(state);
+    std::size_t bytes = 0;
+    for (auto _ : state) {
+        std::string text = request.toString();
+        bytes += text.size();
+        benchmark::DoNotOptimize(text);
+    }
+    state.SetBytesProcessed(static_cast<std::int64_t>(bytes));
+}
+BENCHMARK(BM_AIQueryRequest_ToString)->Apply(requestArgs);
+
+void BM_AIQueryRequest_WriteJsonReused(benchmark::State& state) {
+    dto::AIQueryRequest request = makeRequest(state);
+    std::string text;
+    std::size_t bytes = 0;
+    for (auto _ : state) {
+        request.writeJson(text);
+        bytes += text.size();
+        benchmark::DoNotOptimize(text.data());
+    }
+    state.SetBytesProcessed(static_cast<std::int64_t>(bytes));
+}
+BENCHMARK(BM_AIQueryRequest_WriteJsonReused)->Apply(requestArgs);
+
+template <dto::WireFormat Format>
+void BM_AIQueryRequest_WriteBinaryReused(benchmark::State& state) {
+    dto::AIQueryRequest request = makeRequest(state);
+    std::string data;
+    std::size_t bytes = 0;
+    for (auto _ : state) {
+        request.writeBinary(Format, data);
+        bytes += data.size();
+        benchmark::DoNotOptimize(data.data());
+    }
+    state.SetBytesProcessed(static_cast<std::int64_t>(bytes));
+}
+BENCHMARK_TEMPLATE(BM_AIQueryRequest_WriteBinaryReused, dto::WireFormat::CBOR)->Apply(requestArgs);
+BENCHMARK_TEMPLATE(BM_AIQueryRequest_WriteBinaryReused, dto::WireFormat::MSGPACK)->Apply(requestArgs);
+
+/// A chat of range(0) turns of 1 KiB each; every turn is sent with the whole history.
+void BM_Conversation_FlattenPerTurn(benchmark::State& state) {
+    const std::string turn = makeText(1024);
+    std::string body;
+    for (auto _ : state) {
+        std::string history;
+        dto::AIQueryRequest request("", dto::AIProvider::OPENAI);
+        for (long i = 0; i < state.range(0); ++i) {
+            if (!history.empty()) {
+                history += "\n\n";
+            }
+            history += (i % 2 == 0 ? "User: " : "Assistant: ") + turn;
+            request.setPrompt(history);
+            request.writeJson(body);
+            benchmark::DoNotOptimize(body.data());
+        }
+    }
+}
+BENCHMARK(BM_Conversation_FlattenPerTurn)->Arg(16)->Arg(128)->Arg(512);
+
+void BM_Conversation_AppendPerTurn(benchmark::State& state) {
+    const std::string turn = makeText(1024);
+    std::string body;
+    for (auto _ : state) {
+        dto::Conversation conversation;
+        dto::AIQueryRequest request("", dto::AIProvider::OPENAI);
+        for (long i = 0; i < state.range(0); ++i) {
+            conversation.add(i % 2 == 0 ? dto::Role::USER : dto::Role::ASSISTANT, turn);
+            request.setConversation(conversation);
+            request.writeJson(body);
+            benchmark::DoNotOptimize(body.data());
+        }
+    }
+}
+BENCHMARK(BM_Conversation_AppendPerTurn)->Arg(16)->Arg(128)->Arg(512);
+
+/// state.range(0): raw bytes. Unsupported kernels are skipped.
+template <util::base64::Kernel K>
+void BM_Base64_Encode(benchmark::State& state) {
+    if (!util::base64::isSupported(K)) {
+        state.SkipWithError("kernel not supported on this CPU");
+        return;
+    }
+    const std::string raw = util::base64::decode(makeImage(static_cast<std::size_t>(state.range(0))));
+    std::string text;
+    for (auto _ : state) {
+        text.clear();
+        util::base64::encode(reinterpret_cast<const std::uint8_t*>(raw.data()), raw.size(), text,
+                             util::base64::Alphabet::Standard, K);
+        benchmark::DoNotOptimize(text.data());
+    }
+    state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * raw.size()));
+    state.SetLabel(util::base64::kernelName(K));
+}
+
+template <util::base64::Kernel K>
+void BM_Base64_Decode(benchmark::State& state) {
+    if (!util::base64::isSupported(K)) {
+        state.SkipWithError("kernel not supported on this CPU");
+        return;
+    }
+    const std::string text = makeImage(static_cast<std::size_t>(state.range(0)));
+    std::string raw;
+    for (auto _ : state) {
+        raw.clear();
+        util::base64::decode(text, raw, K);
+        benchmark::DoNotOptimize(raw.data());
+    }
+    state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * text.size()));
+    state.SetLabel(util::base64::kernelName(K));
+}
+
+void base64Sizes(benchmark::internal::Benchmark* bench) {
+    bench->Arg(64)->Arg(4 << 10)->Arg(256 << 10)->Arg(4 << 20);
+}
+
+#define SAURON_BASE64_BENCHMARKS(K)                                \
+    BENCHMARK_TEMPLATE(BM_Base64_Encode, K)->Apply(base64Sizes);   \
+    BENCHMARK_TEMPLATE(BM_Base64_Decode, K)->Apply(base64Sizes)
+
+SAURON_BASE64_BENCHMARKS(util::base64::Kernel::Scalar);
+SAURON_BASE64_BENCHMARKS(util::base64::Kernel::Sse41);
+SAURON_BASE64_BENCHMARKS(util::base64::Kernel::Avx2);
+SAURON_BASE64_BENCHMARKS(util::base64::Kernel::Neon);
+
+/// JSON text of a response DTO whose text fields add up to about size bytes.
+template <typename T>
+std::string makeResponseJson(std::size_t size);
+
+template <>
+std::string makeResponseJson<dto::AIQueryResponse>(std::size_t size) {
+    return dto::AIQueryResponse(makeText(size)).toString();
+}
+
+template <>
+std::string makeResponseJson<dto::AIAlgorithmResponse>(std::size_t size) {
+    nlohmann::json json;
+    json["explanation"] = makeText(size / 2);
+    json["response"] = makeText(size / 2);
+    json["complexity"] = {{"time", {{"value", "O(n log n)"}, {"explanation", "Each level halves the input."}}},
+                          {"space", {{"value", "O(n)"}, {"explanation", "The merge buffer."}}}};
+    return json.dump();
+}
+
+template <>
+std::string makeResponseJson<dto::TokenResponse>(std::size_t size) {
+    return nlohmann::json{{"token", std::string(size, 'x')}}.dump();
+}
+
+template <>
+std::string makeResponseJson<dto::HealthResponse>(std::size_t) {
+    return "{\"status\":\"ok\"}";
+}
+
+template <>
+std::string makeResponseJson<dto::Error>(std::size_t size) {
+    return nlohmann::json{{"error", makeText(size)}}.dump();
+}
+
+template <typename T>
+void BM_FromJson(benchmark::State& state) {
+    const std::string text = makeResponseJson<T>(static_cast<std::size_t>(state.range(0)));
+    for (auto _ : state) {
+        T value = T::fromJson(nlohmann::json::parse(text));
+        benchmark::DoNotOptimize(value);
+    }
+    state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * text.size()));
+}
+
+template <typename T>
+void BM_Parse(benchmark::State& state) {
+    const std::string text = makeResponseJson<T>(static_cast<std::size_t>(state.range(0)));
+    for (auto _ : state) {
+        T value = T::parse(text);
+        benchmark::DoNotOptimize(value);
+    }
+    state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * text.size()));
+}
+
+template <typename T>
+void BM_ParseInto(benchmark::State& state) {
+    const std::string text = makeResponseJson<T>(static_cast<std::size_t>(state.range(0)));
+    T value;
+    for (auto _ : state) {
+        T::parseInto(text, value);
+        benchmark::DoNotOptimize(value);
+    }
+    state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * text.size()));
+}
+
+template <typename T, dto::WireFormat Format>
+void BM_ParseBinary(benchmark::State& state) {
+    std::string data;
+    dto::encodeWireFormat(nlohmann::json::parse(makeResponseJson<T>(static_cast<std::size_t>(state.range(0)))), Format,
+                          data);
+    T value;
+    for (auto _ : state) {
+        T::parseInto(data, value, Format);
+        benchmark::DoNotOptimize(value);
+    }
+    state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * data.size()));
+}
+
+void textSizes(benchmark::internal::Benchmark* bench) {
+    bench->Arg(256)->Arg(16 << 10)->Arg(1 << 20);
+}
+
+void fixedSize(benchmark::internal::Benchmark* bench) {
+    bench->Arg(512);
+}
+
+#define SAURON_RESPONSE_BENCHMARKS(T, sizes)                                      \
+    BENCHMARK_TEMPLATE(BM_FromJson, T)->Apply(sizes);                             \
+    BENCHMARK_TEMPLATE(BM_Parse, T)->Apply(sizes);                                \
+    BENCHMARK_TEMPLATE(BM_ParseInto, T)->Apply(sizes);                            \
+    BENCHMARK_TEMPLATE2(BM_ParseBinary, T, dto::WireFormat::CBOR)->Apply(sizes);  \
+    BENCHMARK_TEMPLATE2(BM_ParseBinary, T, dto::WireFormat::MSGPACK)->Apply(sizes)
+
+SAURON_RESPONSE_BENCHMARKS(dto::AIQueryResponse, textSizes);
+SAURON_RESPONSE_BENCHMARKS(dto::AIAlgorithmResponse, textSizes);
+SAURON_RESPONSE_BENCHMARKS(dto::TokenResponse, fixedSize);
+SAURON_RESPONSE_BENCHMARKS(dto::HealthResponse, fixedSize);
+SAURON_RESPONSE_BENCHMARKS(dto::Error, textSizes);
+
+/// Incremental parsing of an algorithm response fed in chunks of range(1) bytes.
+void BM_AlgorithmResponse_ParseStream(benchmark::State& state) {
+    const std::string text = makeResponseJson<dto::AIAlgorithmResponse>(static_cast<std::size_t>(state.range(0)));
+    const std::size_t chunk = static_cast<std::size_t>(state.range(1));
+    std::size_t pieces = 0;
+    dto::AlgorithmStreamCallbacks callbacks;
+    callbacks.onExplanation = [&pieces](std::string_view) { ++pieces; return true; };
+    callbacks.onResponse = callbacks.onExplanation;
+    for (auto _ : state) {
+        dto::AlgorithmResponseParser parser(callbacks);
+        for (std::size_t offset = 0; offset < text.size(); offset += chunk) {
+            parser.feed(std::string_view(text).substr(offset, chunk));
+        }
+        parser.finish();
+        benchmark::DoNotOptimize(parser.response());
+    }
+    benchmark::DoNotOptimize(pieces);
+    state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * text.size()));
+}
+BENCHMARK(BM_AlgorithmResponse_ParseStream)->ArgsProduct({{256, 16 << 10, 1 << 20}, {64, 16 << 10}});
+
+} // namespace
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <sauron/client/HttpClient.hpp>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace sauron {
+namespace bench {
+
+/**
+ * @brief In-process HttpClient returning canned responses
+ *
+ * Lets benchmarks measure the SDK's own overhead without sockets. Responses
+ * are configured before the client is shared and only read afterwards, so
+ * any number of threads may call it concurrently.
+ */
+class FakeHttpClient : public client::HttpClient {
+public:
+    /**
+     * @brief Set the response returned for a path
+     *
+     * @param path Request path, e.g. "/ai/query"
+     * @param statusCode HTTP status code
+     * @param body Response body
+     */
+    void respond(const std::string& path, int statusCode, std::string body) {
+        client::HttpResponse response;
+        response.statusCode = statusCode;
+        response.body = std::move(body);
+        response.headers = {"Content-Type: application/json"};
+        responses_[path] = std::move(response);
+    }
+
+    /**
+     * @brief Set the chunks delivered by postStream
+     *
+     * @param chunks Chunks passed to the stream callback in order
+     */
+    void streamChunks(std::vector<std::string> chunks) { chunks_ = std::move(chunks); }
+
+    void setBaseUrl(const std::string& url) override { baseUrl_ = url; }
+    std::string getBaseUrl() const override { return baseUrl_; }
+    void setDefaultHeader(const std::string&, const std::string&) override {}
+    void removeDefaultHeader(const std::string&) override {}
+    void setBearerToken(const std::string&) override {}
+    void clearAuthorization() override {}
+
+    client::HttpResponse get(const std::string& path, const std::vector<std::string>& = {}) override {
+        return lookup(path);
+    }
+
+    client::HttpResponse post(const std::string& path, const nlohmann::json&,
+                              const std::vector<std::string>& = {}) override {
+        return lookup(path);
+    }
+
+    client::HttpResponse post(const std::string& path, const std::string&, const std::string&,
+                              const std::vector<std::string>& = {}) override {
+        return lookup(path);
+    }
+
+    int postStream(const std::string&, const nlohmann::json&, const client::StreamCallback& callback,
+                   const std::vector<std::string>& = {}) override {
+        return deliver(callback);
+    }
+
+    int postStream(const std::string&, const std::string&, const std::string&,
+                   const client::StreamCallback& callback, const std::vector<std::string>& = {}) override {
+        return deliver(callback);
+    }
+
+private:
+    client::HttpResponse lookup(const std::string& path) const {
+        auto it = responses_.find(path);
+        if (it == responses_.end()) {
+            return client::HttpResponse{404, "{\"error\":\"Not found\"}", {}, {}};
+        }
+        return it->second;
+    }
+
+    int deliver(const client::StreamCallback& callback) const {
+        for (std::size_t i = 0; i < chunks_.size(); ++i) {
+            if (!callback(chunks_[i], i + 1 == chunks_.size())) {
+                break;
+            }
+        }
+        return 200;
+    }
+
+    std::string baseUrl_;
+    std::map<std::string, client::HttpResponse> responses_;
+    std::vector<std::string> chunks_;
+};
+
+} // namespace bench
+} // namespace sauron
@@ -0,0 +1,20 @@
+# Finds libzstd and provides the imported target zstd::libzstd.
+#
+# Used by sauron-sdk at build time and installed next to its package config,
+# so consumers resolve zstd on their own machine instead of inheriting the
+# build machine's library path.
+
+find_path(zstd_INCLUDE_DIR zstd.h)
+find_library(zstd_LIBRARY NAMES zstd zstd_static)
+mark_as_advanced(zstd_INCLUDE_DIR zstd_LIBRARY)
+
+include(FindPackageHandleStandardArgs)
+find_package_handle_standard_args(zstd REQUIRED_VARS zstd_LIBRARY zstd_INCLUDE_DIR)
+
+if(zstd_FOUND AND NOT TARGET zstd::libzstd)
+    add_library(zstd::libzstd UNKNOWN IMPORTED)
+    set_target_properties(zstd::libzstd PROPERTIES
+        IMPORTED_LOCATION "${zstd_LIBRARY}"
+        INTERFACE_INCLUDE_DIRECTORIES "${zstd_INCLUDE_DIR}"
+    )
+endif()
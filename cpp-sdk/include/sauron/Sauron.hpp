@@ -3,10 +3,30 @@
 /**
  * @file Sauron.hpp
  * @brief Main header file for the Sauron SDK
+ *
+ * Portable; the built-in Linux transports are opt-in through
+ * client/DefaultHttpClient.hpp.
  */
 
 #include "dto/DTOs.hpp"
 #include "client/HttpClient.hpp"
+#include "client/Cancellation.hpp"
+#include "client/Compression.hpp"
+#include "client/AsyncHttpClient.hpp"
+#include "client/Batch.hpp"
+#include "client/SseDecoder.hpp"
+#include "client/Jwt.hpp"
+#include "client/TokenRefresher.hpp"
+#include "client/ResponseCache.hpp"
+#include "client/RequestCoalescer.hpp"
+#include "client/RateLimiter.hpp"
+#include "client/Endpoint.hpp"
+#include "client/HttpStatusError.hpp"
+#include "client/Scheduler.hpp"
+#include "client/Retrier.hpp"
+#include "client/Hedger.hpp"
+#include "client/Metrics.hpp"
+#include "client/PrometheusExporter.hpp"
 #include "client/SauronClient.hpp"
 
 /**
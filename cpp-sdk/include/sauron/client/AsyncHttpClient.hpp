@@ -0,0 +1,148 @@
+#pragma once
+
+#include "HttpClient.hpp"
+#include "TransportError.hpp"
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace sauron {
+namespace client {
+
+/**
+ * @brief A request submitted to an AsyncHttpClient
+ */
+struct AsyncHttpRequest {
+    std::string method = "POST";                 ///< Request method
+    std::string path;                            ///< Path appended to the base URL
+    std::string body;                            ///< Request body
+    std::shared_ptr<dto::BodyStream> bodyStream; ///< Optional; sent instead of body with chunked transfer encoding
+    std::string contentType = "application/json"; ///< Content type of the body
+    std::vector<std::string> headers;            ///< Additional "Name: value" headers
+    StreamCallback onData;                       ///< Optional; receives a 2xx body as it arrives instead of buffering it
+    CallOptions options;                         ///< Deadline and cancellation token of the request
+};
+
+/**
+ * @brief Completion handler for asynchronous requests
+ *
+ * Exactly one of the arguments is meaningful: error is null on success, in
+ * which case response holds the HTTP response (with an empty body if it was
+ * streamed through AsyncHttpRequest::onData).
+ */
+using AsyncCompletion = std::function<void(HttpResponse response, std::exception_ptr error)>;
+
+/**
+ * @brief Non-blocking HTTP client interface
+ *
+ * Requests are submitted without blocking the caller; completion handlers
+ * and stream callbacks run on the client's I/O thread and must not block.
+ */
+class AsyncHttpClient {
+public:
+    using RequestId = std::uint64_t;
+
+    virtual ~AsyncHttpClient() = default;
+
+    /**
+     * @brief Set base URL for all requests
+     *
+     * @param url The base URL
+     */
+    virtual void setBaseUrl(const std::string& url) = 0;
+
+    /**
+     * @brief Get the base URL
+     *
+     * @return std::string The base URL
+     */
+    virtual std::string getBaseUrl() const = 0;
+
+    /**
+     * @brief Set a default header for all requests
+     *
+     * @param name Header name
+     * @param value Header value
+     */
+    virtual void setDefaultHeader(const std::string& name, const std::string& value) = 0;
+
+    /**
+     * @brief Remove a default header
+     *
+     * @param name Header name
+     */
+    virtual void removeDefaultHeader(const std::string& name) = 0;
+
+    /**
+     * @brief Submit a request
+     *
+     * @param request The request
+     * @param onComplete Called once with the response or the error
+     * @return RequestId Identifier that can be passed to cancel()
+     */
+    virtual RequestId send(AsyncHttpRequest request, AsyncCompletion onComplete) = 0;
+
+    /**
+     * @brief Cancel a request
+     *
+     * The completion handler receives RequestCancelled unless the request
+     * already completed. Unknown identifiers are ignored.
+     *
+     * @param id The request identifier
+     */
+    virtual void cancel(RequestId id) = 0;
+
+    /**
+     * @brief Submit a request and get its response as a future
+     *
+     * @param request The request
+     * @return std::future<HttpResponse> The response, or the transport error
+     */
+    std::future<HttpResponse> send(AsyncHttpRequest request) {
+        auto promise = std::make_shared<std::promise<HttpResponse>>();
+        std::future<HttpResponse> future = promise->get_future();
+        send(std::move(request), [promise](HttpResponse response, std::exception_ptr error) {
+            if (error) {
+                promise->set_exception(error);
+            } else {
+                promise->set_value(std::move(response));
+            }
+        });
+        return future;
+    }
+
+    /**
+     * @brief Create a new AsyncHttpClient instance
+     *
+     * Defined by sauron/client/DefaultHttpClient.hpp, which returns the
+     * built-in EpollHttpClient (Linux only); its I/O thread is started on
+     * the first request.
+     *
+     * @param baseUrl Optional base URL
+     * @return std::unique_ptr<AsyncHttpClient> A new AsyncHttpClient instance
+     */
+    static std::unique_ptr<AsyncHttpClient> create(const std::string& baseUrl = "");
+
+    using Factory = std::unique_ptr<AsyncHttpClient> (*)(const std::string& baseUrl);
+
+    /**
+     * @brief Factory SauronClient uses when it was not given an AsyncHttpClient
+     *
+     * Null unless DefaultHttpClient.hpp is included, which sets it to
+     * create() during static initialization. Applications may set their own
+     * before creating any client.
+     *
+     * @return Factory& The factory, shared by every translation unit
+     */
+    static Factory& defaultFactory() {
+        static Factory factory = nullptr;
+        return factory;
+    }
+};
+
+} // namespace client
+} // namespace sauron
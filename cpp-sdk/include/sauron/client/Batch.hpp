@@ -0,0 +1,55 @@
+#pragma once
+
+#include "Cancellation.hpp"
+#include "../dto/AIAlgorithmResponse.hpp"
+#include "../dto/AIQueryResponse.hpp"
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <optional>
+
+namespace sauron {
+namespace client {
+
+/**
+ * @brief Outcome of one request of a batch
+ */
+struct BatchResult {
+    std::size_t index = 0;                                    ///< Position of the request in the input
+    std::optional<dto::AIQueryResponse> response;             ///< Set on success for BatchEndpoint::Query
+    std::optional<dto::AIAlgorithmResponse> algorithmResponse; ///< Set on success for BatchEndpoint::QueryAlgorithm
+    std::exception_ptr error;                                 ///< Set on failure
+
+    /**
+     * @brief Whether the request succeeded
+     */
+    bool ok() const { return !error; }
+};
+
+/**
+ * @brief Endpoint targeted by a batch
+ */
+enum class BatchEndpoint {
+    Query,         ///< /ai/query
+    QueryAlgorithm ///< /ai/query/algorithm
+};
+
+/**
+ * @brief Options for SauronClient::queryBatch
+ */
+struct BatchOptions {
+    BatchEndpoint endpoint = BatchEndpoint::Query; ///< Endpoint every request is sent to
+    std::size_t maxInFlight = 64;                  ///< Upper bound on concurrently outstanding requests
+    CallOptions call;                              ///< Deadline and cancellation token applied to every request
+
+    /**
+     * @brief Optional completion stream
+     *
+     * Called once per request as soon as it finishes, in completion order.
+     * Usually runs on the I/O thread, so it must not block.
+     */
+    std::function<void(const BatchResult&)> onResult;
+};
+
+} // namespace client
+} // namespace sauron
@@ -0,0 +1,378 @@
+#pragma once
+
+#include "TransportError.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+#if defined(__linux__)
+#include <sys/eventfd.h>
+#include <unistd.h>
+#endif
+
+namespace sauron {
+namespace client {
+
+/**
+ * @brief Lets one thread abort calls running on others
+ *
+ * Copies share one state, so a token can be handed to a call and kept to
+ * cancel it. Cancellation is final: use a new token for the next call.
+ */
+class CancellationToken {
+    struct State;
+
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @brief RAII handle on a callback registered with onCancel()
+     *
+     * Destroying it unregisters the callback; if cancel() is running the
+     * callback on another thread at that moment, the destructor waits for
+     * it to return. Do not destroy a registration while holding a lock its
+     * callback takes.
+     */
+    class Registration {
+    public:
+        Registration() = default;
+        ~Registration() { reset(); }
+
+        Registration(Registration&& other) noexcept
+            : state_(std::move(other.state_)), id_(std::exchange(other.id_, 0)) {}
+
+        Registration& operator=(Registration&& other) noexcept {
+            if (this != &other) {
+                reset();
+                state_ = std::move(other.state_);
+                id_ = std::exchange(other.id_, 0);
+            }
+            return *this;
+        }
+
+        Registration(const Registration&) = delete;
+        Registration& operator=(const Registration&) = delete;
+
+        /**
+         * @brief Unregister the callback now
+         */
+        void reset() {
+            if (!state_) {
+                return;
+            }
+            {
+                std::unique_lock<std::mutex> lock(state_->mutex);
+                auto& callbacks = state_->callbacks;
+                auto it = std::find_if(callbacks.begin(), callbacks.end(),
+                                       [this](const Callback& callback) { return callback.first == id_; });
+                if (it != callbacks.end()) {
+                    callbacks.erase(it);
+                } else if (state_->running == id_ && state_->runner != std::this_thread::get_id()) {
+                    state_->changed.wait(lock, [this] { return state_->running != id_; });
+                }
+            }
+            state_.reset();
+            id_ = 0;
+        }
+
+    private:
+        friend class CancellationToken;
+
+        Registration(std::shared_ptr<State> state, std::uint64_t id) : state_(std::move(state)), id_(id) {}
+
+        std::shared_ptr<State> state_;
+        std::uint64_t id_ = 0;
+    };
+
+    /**
+     * @brief Create a token that has not been cancelled
+     */
+    CancellationToken() : state_(std::make_shared<State>()) {}
+
+    /**
+     * @brief Cancel every call holding the token
+     *
+     * Runs the registered callbacks on the calling thread. Calling it again
+     * does nothing.
+     */
+    void cancel() {
+        State& state = *state_;
+        std::unique_lock<std::mutex> lock(state.mutex);
+        if (state.cancelled.load(std::memory_order_relaxed)) {
+            return;
+        }
+        state.cancelled.store(true, std::memory_order_release);
+#if defined(__linux__)
+        if (state.fd >= 0) {
+            std::uint64_t one = 1;
+            ssize_t ignored = ::write(state.fd, &one, sizeof(one));
+            (void)ignored;
+        }
+#endif
+        state.changed.notify_all();
+        state.runner = std::this_thread::get_id();
+        while (!state.callbacks.empty()) {
+            Callback callback = std::move(state.callbacks.back());
+            state.callbacks.pop_back();
+            state.running = callback.first;
+            lock.unlock();
+            try {
+                callback.second();
+            } catch (...) {
+                // Cancellation must reach every call; a failing callback cannot stop it.
+            }
+            lock.lock();
+            state.running = 0;
+            state.changed.notify_all();
+        }
+    }
+
+    /**
+     * @brief Check whether the token has been cancelled
+     */
+    bool isCancelled() const { return state_->cancelled.load(std::memory_order_acquire); }
+
+    /**
+     * @brief Run a callback when the token is cancelled
+     *
+     * The callback runs on the thread calling cancel() and must not block.
+     * Nothing is registered if the token is already cancelled, so check
+     * isCancelled() after registering.
+     *
+     * @param callback The callback
+     * @return Registration Keeps the callback registered while it lives
+     */
+    Registration onCancel(std::function<void()> callback) const {
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        if (state_->cancelled.load(std::memory_order_relaxed)) {
+            return Registration();
+        }
+        std::uint64_t id = state_->nextId++;
+        state_->callbacks.emplace_back(id, std::move(callback));
+        return Registration(state_, id);
+    }
+
+    /**
+     * @brief Sleep unless the token is cancelled first
+     *
+     * @param duration How long to sleep
+     * @return bool True if the token was cancelled
+     */
+    bool sleepFor(Clock::duration duration) const {
+        std::unique_lock<std::mutex> lock(state_->mutex);
+        return state_->changed.wait_for(lock, duration, [this] {
+            return state_->cancelled.load(std::memory_order_relaxed);
+        });
+    }
+
+#if defined(__linux__)
+    /**
+     * @brief Descriptor that becomes readable once the token is cancelled
+     *
+     * For waiting on sockets and cancellation with one poll(). Created on
+     * first use and owned by the token. Linux only.
+     *
+     * @throws TransportError if the descriptor cannot be created
+     */
+    int fd() const {
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        if (state_->fd < 0) {
+            unsigned initial = state_->cancelled.load(std::memory_order_relaxed) ? 1 : 0;
+            state_->fd = ::eventfd(initial, EFD_CLOEXEC | EFD_NONBLOCK);
+            if (state_->fd < 0) {
+                throw TransportError(std::string("Failed to create cancellation descriptor: ") + std::strerror(errno));
+            }
+        }
+        return state_->fd;
+    }
+#endif
+
+private:
+    using Callback = std::pair<std::uint64_t, std::function<void()>>;
+
+    struct State {
+#if defined(__linux__)
+        ~State() {
+            if (fd >= 0) {
+                ::close(fd);
+            }
+        }
+#endif
+
+        std::mutex mutex;
+        std::condition_variable changed;
+        std::atomic<bool> cancelled{false};
+        std::vector<Callback> callbacks;
+        std::uint64_t nextId = 1;
+        std::uint64_t running = 0; ///< Callback being run by cancel(), if any
+        std::thread::id runner;    ///< Thread running cancel()
+        int fd = -1;               ///< Descriptor returned by fd(); Linux only
+    };
+
+    std::shared_ptr<State> state_;
+};
+
+/**
+ * @brief Deadline and cancellation of one call
+ *
+ * A call stops with DeadlineExceeded once its deadline passes and with
+ * RequestCancelled once its token is cancelled, whether it is waiting for a
+ * connection, connecting, sending, waiting for the response or reading a
+ * stream. DNS resolution is the one step that cannot be interrupted.
+ */
+struct CallOptions {
+    using Clock = std::chrono::steady_clock;
+
+    Clock::time_point deadline = Clock::time_point::max(); ///< Point in time the call must end by; max() for none
+    std::optional<CancellationToken> cancellation;        ///< Token that aborts the call when cancelled
+
+    /**
+     * @brief Options with a deadline this far from now
+     */
+    static CallOptions timeout(Clock::duration timeout) {
+        CallOptions options;
+        options.deadline = Clock::now() + timeout;
+        return options;
+    }
+
+    /**
+     * @brief Whether there is a deadline or a token to honour
+     */
+    bool active() const { return deadline != Clock::time_point::max() || cancellation.has_value(); }
+
+    /**
+     * @brief Whether the call must stop now
+     */
+    bool stopped() const {
+        return (cancellation && cancellation->isCancelled()) ||
+               (deadline != Clock::time_point::max() && Clock::now() >= deadline);
+    }
+
+    /**
+     * @brief The error a stopped call ends with
+     */
+    std::exception_ptr stopError() const {
+        if (cancellation && cancellation->isCancelled()) {
+            return std::make_exception_ptr(RequestCancelled());
+        }
+        return std::make_exception_ptr(DeadlineExceeded());
+    }
+
+    /**
+     * @brief Throw the call's error if it must stop
+     *
+     * @throws RequestCancelled if the token has been cancelled
+     * @throws DeadlineExceeded if the deadline has passed
+     */
+    void check() const {
+        if (stopped()) {
+            std::rethrow_exception(stopError());
+        }
+    }
+
+    /**
+     * @brief Milliseconds left until the deadline, rounded up, for poll()
+     *
+     * @return int The time left, capped at INT_MAX; -1 without a deadline
+     */
+    int pollTimeout() const {
+        if (deadline == Clock::time_point::max()) {
+            return -1;
+        }
+        auto left = std::chrono::ceil<std::chrono::milliseconds>(deadline - Clock::now()).count();
+        return static_cast<int>(std::max<long long>(0, std::min<long long>(left, 0x7fffffff)));
+    }
+
+    /**
+     * @brief Wait on a condition variable until ready() holds or the call must stop
+     *
+     * The deadline is watched here. For cancellation to wake the wait, the
+     * caller registers a callback with the token that notifies cv under the
+     * lock's mutex, before taking the lock.
+     *
+     * @return bool The final value of ready()
+     */
+    template <typename Ready>
+    bool wait(std::unique_lock<std::mutex>& lock, std::condition_variable& cv, Ready ready) const {
+        while (!ready()) {
+            if (cancellation && cancellation->isCancelled()) {
+                return false;
+            }
+            if (deadline == Clock::time_point::max()) {
+                cv.wait(lock);
+            } else if (cv.wait_until(lock, deadline) == std::cv_status::timeout) {
+                return ready();
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief Sleep before another attempt
+     *
+     * @param delay How long to sleep
+     * @return bool False, without sleeping, if the deadline comes first
+     * @throws RequestCancelled if the token is cancelled before the delay ends
+     */
+    bool sleepFor(Clock::duration delay) const {
+        if (deadline != Clock::time_point::max() && deadline - Clock::now() <= delay) {
+            return false;
+        }
+        bool cancelled = cancellation ? cancellation->sleepFor(delay) : (std::this_thread::sleep_for(delay), false);
+        if (cancelled) {
+            throw RequestCancelled();
+        }
+        return true;
+    }
+};
+
+/**
+ * @brief Makes CallOptions apply to the synchronous calls of this thread
+ *
+ * HttpClient has no per-call parameters, so SauronClient installs a scope
+ * around each synchronous call and the built-in transport picks it up
+ * through current(). Scopes nest; a scope with inactive options leaves the
+ * enclosing one in force. The options must outlive the scope.
+ */
+class CallScope {
+public:
+    explicit CallScope(const CallOptions& options) : previous_(slot()) {
+        if (options.active()) {
+            slot() = &options;
+        }
+    }
+
+    ~CallScope() { slot() = previous_; }
+
+    CallScope(const CallScope&) = delete;
+    CallScope& operator=(const CallScope&) = delete;
+
+    /**
+     * @brief Options of the innermost active scope on this thread
+     *
+     * @return const CallOptions* The options, or null outside any active scope
+     */
+    static const CallOptions* current() { return slot(); }
+
+private:
+    static const CallOptions*& slot() {
+        thread_local const CallOptions* current = nullptr;
+        return current;
+    }
+
+    const CallOptions* previous_;
+};
+
+} // namespace client
+} // namespace sauron
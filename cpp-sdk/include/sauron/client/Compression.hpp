@@ -0,0 +1,409 @@
+#pragma once
+
+#include "HttpWire.hpp"
+#include "TransportError.hpp"
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Codecs are compiled in when the build defines these; the CMake target does
+// so for the libraries it finds and links.
+#ifndef SAURON_WITH_ZLIB
+#define SAURON_WITH_ZLIB 0
+#endif
+#ifndef SAURON_WITH_ZSTD
+#define SAURON_WITH_ZSTD 0
+#endif
+
+#if SAURON_WITH_ZLIB
+#include <zlib.h>
+#endif
+#if SAURON_WITH_ZSTD
+#include <zstd.h>
+#endif
+
+namespace sauron {
+namespace client {
+
+/**
+ * @brief HTTP content codings understood by the built-in transports
+ */
+enum class ContentCoding {
+    Identity, ///< No compression
+    Gzip,     ///< gzip (zlib), understood by virtually every server
+    Zstd      ///< Zstandard; faster and smaller than gzip at its default level
+};
+
+/**
+ * @brief Compression settings of a transport
+ *
+ * Compression is off by default. With decompressResponses the transport
+ * advertises the compiled-in codings in Accept-Encoding and decodes
+ * compressed responses as they arrive, so streamed (SSE) bodies reach the
+ * callback incrementally. With compressRequests, bodies of at least
+ * requestThreshold bytes are sent with Content-Encoding; the server must
+ * accept compressed request bodies.
+ */
+struct CompressionOptions {
+    bool decompressResponses = false;             ///< Send Accept-Encoding and decode compressed responses
+    bool compressRequests = false;                ///< Compress large request bodies
+    std::size_t requestThreshold = 16 * 1024;     ///< Smallest body worth compressing, in bytes
+    ContentCoding requestCoding = ContentCoding::Gzip; ///< Coding of compressed request bodies
+    int level = 0;                                ///< Compression level; 0 selects the coding's default
+};
+
+namespace compression {
+
+/**
+ * @brief Whether a coding is compiled in
+ */
+inline bool available(ContentCoding coding) {
+    switch (coding) {
+        case ContentCoding::Identity:
+            return true;
+        case ContentCoding::Gzip:
+            return SAURON_WITH_ZLIB != 0;
+        case ContentCoding::Zstd:
+            return SAURON_WITH_ZSTD != 0;
+    }
+    return false;
+}
+
+/**
+ * @brief Token of a coding in Content-Encoding and Accept-Encoding headers
+ */
+inline const char* name(ContentCoding coding) {
+    switch (coding) {
+        case ContentCoding::Gzip:
+            return "gzip";
+        case ContentCoding::Zstd:
+            return "zstd";
+        default:
+            return "identity";
+    }
+}
+
+/**
+ * @brief Accept-Encoding value listing the compiled-in codings, preferred first
+ *
+ * @return std::string e.g. "zstd, gzip"; empty if no coding is compiled in
+ */
+inline std::string acceptEncoding() {
+    std::string value;
+    for (ContentCoding coding : {ContentCoding::Zstd, ContentCoding::Gzip}) {
+        if (available(coding)) {
+            value.append(value.empty() ? "" : ", ").append(name(coding));
+        }
+    }
+    return value;
+}
+
+/**
+ * @brief Check that options can be honoured by this build
+ *
+ * @throws std::invalid_argument if an enabled feature needs a coding that is not compiled in
+ */
+inline void validate(const CompressionOptions& options) {
+    if (options.decompressResponses && acceptEncoding().empty()) {
+        throw std::invalid_argument("Response decompression needs zlib or zstd (SAURON_WITH_ZLIB/SAURON_WITH_ZSTD)");
+    }
+    if (options.compressRequests &&
+        (options.requestCoding == ContentCoding::Identity || !available(options.requestCoding))) {
+        throw std::invalid_argument(std::string("Request coding is not available: ") + name(options.requestCoding));
+    }
+}
+
+/**
+ * @brief Compress a buffer in one go
+ *
+ * @param coding Gzip or Zstd
+ * @param data The bytes to compress
+ * @param level Compression level; 0 selects the coding's default
+ * @return std::string The compressed bytes
+ * @throws std::invalid_argument if the coding is not compiled in
+ * @throws std::runtime_error if the codec fails
+ */
+inline std::string compress(ContentCoding coding, std::string_view data, int level = 0) {
+    std::string out;
+#if SAURON_WITH_ZLIB
+    if (coding == ContentCoding::Gzip) {
+        z_stream stream{};
+        // windowBits 15 + 16 selects the gzip wrapper.
+        if (deflateInit2(&stream, level == 0 ? Z_DEFAULT_COMPRESSION : level, Z_DEFLATED, 15 + 16, 8,
+                         Z_DEFAULT_STRATEGY) != Z_OK) {
+            throw std::runtime_error("Failed to initialise gzip compression");
+        }
+        out.resize(deflateBound(&stream, static_cast<uLong>(data.size())));
+        stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+        stream.avail_in = static_cast<uInt>(data.size());
+        stream.next_out = reinterpret_cast<Bytef*>(&out[0]);
+        stream.avail_out = static_cast<uInt>(out.size());
+        int rc = deflate(&stream, Z_FINISH);
+        out.resize(stream.total_out);
+        deflateEnd(&stream);
+        if (rc != Z_STREAM_END) {
+            throw std::runtime_error("Failed to gzip request body");
+        }
+        return out;
+    }
+#endif
+#if SAURON_WITH_ZSTD
+    if (coding == ContentCoding::Zstd) {
+        out.resize(ZSTD_compressBound(data.size()));
+        std::size_t size = ZSTD_compress(&out[0], out.size(), data.data(), data.size(), level);
+        if (ZSTD_isError(size)) {
+            throw std::runtime_error(std::string("Failed to zstd-compress request body: ") + ZSTD_getErrorName(size));
+        }
+        out.resize(size);
+        return out;
+    }
+#endif
+    (void)data;
+    (void)level;
+    throw std::invalid_argument(std::string("Content coding is not available: ") + name(coding));
+}
+
+/**
+ * @brief Prepare a request for sending under the given options
+ *
+ * Adds Accept-Encoding when responses are to be decoded, and compresses the
+ * body when it is large enough and compression actually shrinks it. Headers
+ * the caller already set are left alone.
+ *
+ * @param options Compression options of the transport
+ * @param body The request body
+ * @param headers The per-request headers; receives the added header lines
+ * @param encoded Receives the compressed body
+ * @return bool Whether the body was compressed into encoded
+ */
+inline bool prepareRequest(const CompressionOptions& options,
+                           const std::string& body,
+                           std::vector<std::string>& headers,
+                           std::string& encoded) {
+    std::string ignored;
+    if (options.decompressResponses && !wire::findHeader(headers, "Accept-Encoding", ignored)) {
+        headers.push_back("Accept-Encoding: " + acceptEncoding());
+    }
+    if (!options.compressRequests || body.size() < options.requestThreshold ||
+        wire::findHeader(headers, "Content-Encoding", ignored)) {
+        return false;
+    }
+    encoded = compress(options.requestCoding, body, options.level);
+    if (encoded.size() >= body.size()) {
+        return false;
+    }
+    headers.push_back(std::string("Content-Encoding: ") + name(options.requestCoding));
+    return true;
+}
+
+/**
+ * @brief Incremental decoder for a response body with Content-Encoding
+ *
+ * The coding is taken from the response headers on the first body bytes;
+ * decoded bytes are passed to the sink as soon as the codec produces them.
+ * Responses without Content-Encoding pass through unchanged.
+ */
+class BodyDecoder {
+public:
+    using Sink = HttpResponseParser::BodySink;
+
+    /**
+     * @brief Prepare for a new response
+     *
+     * @param enabled Whether to decode; when false every body passes through
+     */
+    void reset(bool enabled) {
+        enabled_ = enabled;
+        started_ = false;
+        coding_ = ContentCoding::Identity;
+        ended_ = true;
+#if SAURON_WITH_ZLIB
+        if (inflater_) {
+            inflateReset(&inflater_->stream);
+        }
+#endif
+#if SAURON_WITH_ZSTD
+        if (zstd_) {
+            ZSTD_DCtx_reset(zstd_.get(), ZSTD_reset_session_only);
+        }
+#endif
+    }
+
+    /**
+     * @brief Whether compressed responses are decoded
+     */
+    bool enabled() const { return enabled_; }
+
+    /**
+     * @brief Decode body bytes
+     *
+     * @param headers Headers of the response the bytes belong to
+     * @param data Body bytes as received, framing removed
+     * @param size Number of bytes
+     * @param sink Receives the decoded bytes
+     * @return bool false if the sink asked to stop
+     * @throws TransportError if the coding is unsupported or the data is corrupt
+     */
+    bool feed(const std::vector<std::string>& headers, const char* data, std::size_t size, const Sink& sink) {
+        if (!started_) {
+            start(headers);
+        }
+        switch (coding_) {
+#if SAURON_WITH_ZLIB
+            case ContentCoding::Gzip:
+                return decodeGzip(data, size, sink);
+#endif
+#if SAURON_WITH_ZSTD
+            case ContentCoding::Zstd:
+                return decodeZstd(data, size, sink);
+#endif
+            default:
+                return sink(data, size);
+        }
+    }
+
+    /**
+     * @brief Check that the body ended on a complete compressed stream
+     *
+     * @throws TransportError if the compressed body was cut short
+     */
+    void finish() const {
+        if (!ended_) {
+            throw TransportError(std::string("Truncated ") + name(coding_) + " response body", true);
+        }
+    }
+
+private:
+    static constexpr std::size_t kOutputSize = 16 * 1024;
+
+#if SAURON_WITH_ZLIB
+    struct Inflater {
+        Inflater() {
+            // windowBits 15 + 32 accepts both the gzip and the zlib ("deflate") wrapper.
+            if (inflateInit2(&stream, 15 + 32) != Z_OK) {
+                throw std::runtime_error("Failed to initialise gzip decompression");
+            }
+        }
+        ~Inflater() { inflateEnd(&stream); }
+        Inflater(const Inflater&) = delete;
+        Inflater& operator=(const Inflater&) = delete;
+        z_stream stream{};
+    };
+#endif
+#if SAURON_WITH_ZSTD
+    struct ZstdDeleter {
+        void operator()(ZSTD_DCtx* context) const { ZSTD_freeDCtx(context); }
+    };
+#endif
+
+    void start(const std::vector<std::string>& headers) {
+        started_ = true;
+        std::string value;
+        if (!enabled_ || !wire::findHeader(headers, "Content-Encoding", value) ||
+            wire::equalsIgnoreCase(value, "identity")) {
+            return;
+        }
+        if (wire::equalsIgnoreCase(value, "gzip") || wire::equalsIgnoreCase(value, "x-gzip") ||
+            wire::equalsIgnoreCase(value, "deflate")) {
+            coding_ = ContentCoding::Gzip;
+        } else if (wire::equalsIgnoreCase(value, "zstd")) {
+            coding_ = ContentCoding::Zstd;
+        }
+        if (coding_ == ContentCoding::Identity || !available(coding_)) {
+            coding_ = ContentCoding::Identity;
+            throw TransportError("Unsupported Content-Encoding: " + value, true);
+        }
+        if (!output_) {
+            output_.reset(new char[kOutputSize]);
+        }
+        ended_ = false;
+#if SAURON_WITH_ZLIB
+        if (coding_ == ContentCoding::Gzip && !inflater_) {
+            inflater_ = std::make_unique<Inflater>();
+        }
+#endif
+#if SAURON_WITH_ZSTD
+        if (coding_ == ContentCoding::Zstd && !zstd_) {
+            zstd_.reset(ZSTD_createDCtx());
+            if (!zstd_) {
+                throw std::runtime_error("Failed to initialise zstd decompression");
+            }
+        }
+#endif
+    }
+
+#if SAURON_WITH_ZLIB
+    bool decodeGzip(const char* data, std::size_t size, const Sink& sink) {
+        z_stream& stream = inflater_->stream;
+        stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+        stream.avail_in = static_cast<uInt>(size);
+        for (;;) {
+            if (ended_) {
+                if (stream.avail_in == 0) {
+                    break;
+                }
+                // Concatenated gzip members decode as one body.
+                inflateReset(&stream);
+                ended_ = false;
+            }
+            stream.next_out = reinterpret_cast<Bytef*>(output_.get());
+            stream.avail_out = static_cast<uInt>(kOutputSize);
+            int rc = ::inflate(&stream, Z_NO_FLUSH);
+            if (rc != Z_OK && rc != Z_STREAM_END && rc != Z_BUF_ERROR) {
+                throw TransportError(std::string("Failed to decode gzip response body: ") +
+                                     (stream.msg != nullptr ? stream.msg : "corrupt data"), true);
+            }
+            std::size_t produced = kOutputSize - stream.avail_out;
+            if (produced > 0 && !sink(output_.get(), produced)) {
+                return false;
+            }
+            if (rc == Z_STREAM_END) {
+                ended_ = true;
+            } else if (rc == Z_BUF_ERROR || (stream.avail_in == 0 && stream.avail_out > 0)) {
+                break; // needs more input
+            }
+        }
+        return true;
+    }
+#endif
+
+#if SAURON_WITH_ZSTD
+    bool decodeZstd(const char* data, std::size_t size, const Sink& sink) {
+        ZSTD_inBuffer in{data, size, 0};
+        bool full;
+        do {
+            ZSTD_outBuffer out{output_.get(), kOutputSize, 0};
+            std::size_t rc = ZSTD_decompressStream(zstd_.get(), &out, &in);
+            if (ZSTD_isError(rc)) {
+                throw TransportError(std::string("Failed to decode zstd response body: ") + ZSTD_getErrorName(rc),
+                                     true);
+            }
+            ended_ = rc == 0;
+            if (out.pos > 0 && !sink(output_.get(), out.pos)) {
+                return false;
+            }
+            full = out.pos == out.size;
+        } while (in.pos < in.size || full);
+        return true;
+    }
+#endif
+
+    bool enabled_ = false;
+    bool started_ = false;
+    bool ended_ = true; ///< No compressed stream is open
+    ContentCoding coding_ = ContentCoding::Identity;
+    std::unique_ptr<char[]> output_;
+#if SAURON_WITH_ZLIB
+    std::unique_ptr<Inflater> inflater_;
+#endif
+#if SAURON_WITH_ZSTD
+    std::unique_ptr<ZSTD_DCtx, ZstdDeleter> zstd_;
+#endif
+};
+
+} // namespace compression
+} // namespace client
+} // namespace sauron
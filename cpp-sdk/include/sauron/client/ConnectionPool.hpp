@@ -0,0 +1,550 @@
+#pragma once
+
+#include "Cancellation.hpp"
+#include "TransportError.hpp"
+#include "Url.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace sauron {
+namespace client {
+
+/**
+ * @brief Tuning knobs for ConnectionPool
+ */
+struct ConnectionPoolOptions {
+    std::size_t maxConnectionsPerHost = 8;           ///< Open connections (idle + leased) allowed per origin
+    std::chrono::milliseconds idleTimeout{30000};    ///< Idle connections older than this are closed, not reused
+    std::chrono::milliseconds connectTimeout{10000}; ///< Timeout for DNS + TCP connect
+    std::chrono::milliseconds dnsTtl{30000};         ///< Resolved addresses are reused this long; 0 resolves for every connect
+};
+
+/**
+ * @brief A TCP connection owned by a ConnectionPool
+ */
+class Connection {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    Connection(int fd, std::string originKey)
+        : fd_(fd), originKey_(std::move(originKey)), lastUsed_(Clock::now()) {}
+
+    ~Connection() {
+        if (fd_ >= 0) {
+            ::close(fd_);
+        }
+    }
+
+    Connection(const Connection&) = delete;
+    Connection& operator=(const Connection&) = delete;
+
+    /**
+     * @brief Get the socket descriptor
+     */
+    int fd() const { return fd_; }
+
+    /**
+     * @brief Get the origin this connection is bound to
+     */
+    const std::string& originKey() const { return originKey_; }
+
+    /**
+     * @brief Number of requests completed on this connection
+     */
+    std::size_t requestCount() const { return requestCount_; }
+
+    /**
+     * @brief Time the connection was last returned to the pool
+     */
+    Clock::time_point lastUsed() const { return lastUsed_; }
+
+    /**
+     * @brief Check that an idle connection has not been closed by the peer
+     *
+     * An idle HTTP/1.1 connection must not have anything to read; readability
+     * means EOF or an unsolicited error response, and the socket is unusable.
+     *
+     * @return bool True if the connection can carry a new request
+     */
+    bool isAlive() const {
+        pollfd pfd{fd_, POLLIN, 0};
+        int rc = ::poll(&pfd, 1, 0);
+        return rc == 0;
+    }
+
+private:
+    friend class ConnectionPool;
+
+    int fd_;
+    std::string originKey_;
+    Clock::time_point lastUsed_;
+    std::size_t requestCount_ = 0;
+};
+
+/**
+ * @brief Per-origin pool of persistent HTTP/1.1 connections
+ *
+ * Connections are leased for the duration of one request/response exchange
+ * and handed back when the response was fully read and the server allows
+ * keep-alive. When an origin has reached maxConnectionsPerHost, acquire()
+ * waits for a lease to be returned instead of opening a new socket.
+ *
+ * An origin's addresses are resolved when a connection is first opened to
+ * it and reused for later connections for dnsTtl, after which the next
+ * connection resolves them again. They are also dropped as soon as none of
+ * them accepts a connection.
+ */
+class ConnectionPool : public std::enable_shared_from_this<ConnectionPool> {
+public:
+    /**
+     * @brief RAII handle on a leased connection
+     *
+     * Unless release(true) is called the connection is considered unusable
+     * and is closed when the lease goes out of scope.
+     */
+    class Lease {
+    public:
+        Lease() = default;
+        Lease(std::shared_ptr<ConnectionPool> pool, std::unique_ptr<Connection> connection, bool reused)
+            : pool_(std::move(pool)), connection_(std::move(connection)), reused_(reused) {}
+
+        ~Lease() { release(false); }
+
+        Lease(Lease&&) noexcept = default;
+        Lease& operator=(Lease&& other) noexcept {
+            if (this != &other) {
+                release(false);
+                pool_ = std::move(other.pool_);
+                connection_ = std::move(other.connection_);
+                reused_ = other.reused_;
+            }
+            return *this;
+        }
+
+        Connection* operator->() const { return connection_.get(); }
+        Connection& operator*() const { return *connection_; }
+        explicit operator bool() const { return connection_ != nullptr; }
+
+        /**
+         * @brief Whether the connection already served a previous request
+         *
+         * A failure before any response byte on a reused connection usually
+         * means the server closed it while idle, and the request can be
+         * replayed on a fresh connection.
+         */
+        bool reused() const { return reused_; }
+
+        /**
+         * @brief Return the connection to the pool
+         *
+         * @param reusable True if another request may be sent on the connection
+         */
+        void release(bool reusable) {
+            if (connection_ && pool_) {
+                pool_->giveBack(std::move(connection_), reusable);
+            }
+            connection_.reset();
+            pool_.reset();
+        }
+
+    private:
+        std::shared_ptr<ConnectionPool> pool_;
+        std::unique_ptr<Connection> connection_;
+        bool reused_ = false;
+    };
+
+    /**
+     * @brief Create a pool
+     *
+     * Pools are always shared: leases keep the pool alive so it can be shared
+     * between several clients.
+     *
+     * @param options Pool options
+     * @return std::shared_ptr<ConnectionPool> A new pool
+     */
+    static std::shared_ptr<ConnectionPool> create(const ConnectionPoolOptions& options = {}) {
+        return std::shared_ptr<ConnectionPool>(new ConnectionPool(options));
+    }
+
+    ~ConnectionPool() = default;
+    ConnectionPool(const ConnectionPool&) = delete;
+    ConnectionPool& operator=(const ConnectionPool&) = delete;
+
+    /**
+     * @brief Get the pool options
+     */
+    const ConnectionPoolOptions& options() const { return options_; }
+
+    /**
+     * @brief Lease a connection to an origin
+     *
+     * Returns an idle connection when one is available, otherwise opens a new
+     * one if the origin is below its limit, otherwise waits.
+     *
+     * @param url The origin to connect to
+     * @param waited Optional; receives the time spent waiting for the origin's limit
+     * @param call Optional; deadline and cancellation token bounding the wait and the connect
+     * @return Lease The leased connection
+     * @throws TransportError if a new connection could not be established
+     * @throws RequestCancelled, DeadlineExceeded if the call stopped first
+     */
+    Lease acquire(const Url& url, Connection::Clock::duration* waited = nullptr,
+                  const CallOptions* call = nullptr) {
+        const std::string key = url.originKey();
+        CancellationToken::Registration wake;
+        if (call && call->cancellation) {
+            wake = call->cancellation->onCancel([this] {
+                std::lock_guard<std::mutex> lock(mutex_);
+                for (auto& entry : hosts_) {
+                    entry.second.available.notify_all();
+                }
+            });
+        }
+        std::unique_lock<std::mutex> lock(mutex_);
+        HostPool& host = hosts_[key];
+        std::optional<Connection::Clock::time_point> waitStart;
+        auto reportWait = [&] {
+            if (waited) {
+                *waited = waitStart ? Connection::Clock::now() - *waitStart : Connection::Clock::duration::zero();
+            }
+        };
+        for (;;) {
+            while (!host.idle.empty()) {
+                std::unique_ptr<Connection> connection = std::move(host.idle.back());
+                host.idle.pop_back();
+                if (Connection::Clock::now() - connection->lastUsed() < options_.idleTimeout && connection->isAlive()) {
+                    reportWait();
+                    return Lease(shared_from_this(), std::move(connection), true);
+                }
+                --host.open;
+            }
+            if (host.open < options_.maxConnectionsPerHost) {
+                break;
+            }
+            if (!waitStart) {
+                waitStart = Connection::Clock::now();
+            }
+            if (!call) {
+                host.available.wait(lock);
+            } else if (!call->wait(lock, host.available, [&] {
+                           return !host.idle.empty() || host.open < options_.maxConnectionsPerHost;
+                       })) {
+                lock.unlock();
+                reportWait();
+                call->check();
+            }
+        }
+        ++host.open;
+        lock.unlock();
+        reportWait();
+
+        try {
+            std::vector<int> fds = openConnections(url, 1, call);
+            return Lease(shared_from_this(), std::make_unique<Connection>(fds.front(), key), false);
+        } catch (...) {
+            lock.lock();
+            --host.open;
+            host.available.notify_one();
+            throw;
+        }
+    }
+
+    /**
+     * @brief Open connections to an origin ahead of the first requests
+     *
+     * Tops the origin up to the given number of open connections, within
+     * maxConnectionsPerHost, connecting all the missing ones at once; they
+     * wait in the pool as idle connections. Connections left unused for
+     * longer than idleTimeout are closed as usual.
+     *
+     * @param url The origin to connect to
+     * @param connections Number of connections wanted
+     * @param call Optional; deadline and cancellation token bounding the connects
+     * @return std::size_t Number of connections opened, possibly fewer than were missing
+     * @throws TransportError if none of the missing connections could be established
+     * @throws RequestCancelled, DeadlineExceeded if the call stopped first
+     */
+    std::size_t warmup(const Url& url, std::size_t connections, const CallOptions* call = nullptr) {
+        const std::string key = url.originKey();
+        std::unique_lock<std::mutex> lock(mutex_);
+        HostPool& host = hosts_[key];
+        const std::size_t target = std::min(connections, options_.maxConnectionsPerHost);
+        if (host.open >= target) {
+            return 0;
+        }
+        const std::size_t missing = target - host.open;
+        host.open += missing;
+        lock.unlock();
+
+        std::vector<int> fds;
+        try {
+            fds = openConnections(url, missing, call);
+        } catch (...) {
+            lock.lock();
+            host.open -= missing;
+            host.available.notify_all();
+            throw;
+        }
+        lock.lock();
+        host.open -= missing - fds.size();
+        for (int fd : fds) {
+            host.idle.push_back(std::make_unique<Connection>(fd, key));
+        }
+        host.available.notify_all();
+        return fds.size();
+    }
+
+    /**
+     * @brief Number of idle connections kept for an origin
+     */
+    std::size_t idleCount(const Url& url) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = hosts_.find(url.originKey());
+        return it == hosts_.end() ? 0 : it->second.idle.size();
+    }
+
+    /**
+     * @brief Close every idle connection
+     */
+    void clear() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& entry : hosts_) {
+            entry.second.open -= entry.second.idle.size();
+            entry.second.idle.clear();
+            entry.second.available.notify_all();
+        }
+    }
+
+private:
+    struct HostPool {
+        std::deque<std::unique_ptr<Connection>> idle; ///< Most recently used at the back
+        std::size_t open = 0;                         ///< Idle + leased connections
+        std::condition_variable available;
+    };
+
+    explicit ConnectionPool(const ConnectionPoolOptions& options) : options_(options) {
+        if (options_.maxConnectionsPerHost == 0) {
+            options_.maxConnectionsPerHost = 1;
+        }
+    }
+
+    void giveBack(std::unique_ptr<Connection> connection, bool reusable) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        HostPool& host = hosts_[connection->originKey()];
+        if (reusable) {
+            connection->lastUsed_ = Connection::Clock::now();
+            ++connection->requestCount_;
+            host.idle.push_back(std::move(connection));
+        } else {
+            --host.open;
+            connection.reset();
+        }
+        host.available.notify_one();
+    }
+
+    struct Address {
+        sockaddr_storage storage;
+        socklen_t length;
+        int family;
+        int protocol;
+    };
+    using AddressList = std::vector<Address>;
+
+    struct CachedAddresses {
+        std::shared_ptr<const AddressList> addresses;
+        Connection::Clock::time_point resolvedAt;
+    };
+
+    /// Addresses of an origin, resolved on first use and cached for dnsTtl.
+    std::shared_ptr<const AddressList> resolve(const Url& url) {
+        const std::string key = url.originKey();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = addressCache_.find(key);
+            if (it != addressCache_.end() && Connection::Clock::now() - it->second.resolvedAt < options_.dnsTtl) {
+                return it->second.addresses;
+            }
+        }
+        addrinfo hints{};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        addrinfo* results = nullptr;
+        const std::string service = std::to_string(url.port);
+        int rc = ::getaddrinfo(url.host.c_str(), service.c_str(), &hints, &results);
+        if (rc != 0) {
+            throw TransportError("Failed to resolve " + url.host + ": " + ::gai_strerror(rc));
+        }
+        auto list = std::make_shared<AddressList>();
+        for (addrinfo* ai = results; ai != nullptr; ai = ai->ai_next) {
+            Address address{};
+            std::memcpy(&address.storage, ai->ai_addr, ai->ai_addrlen);
+            address.length = ai->ai_addrlen;
+            address.family = ai->ai_family;
+            address.protocol = ai->ai_protocol;
+            list->push_back(address);
+        }
+        ::freeaddrinfo(results);
+        if (list->empty()) {
+            throw TransportError("Failed to resolve " + url.host + ": no addresses");
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        addressCache_[key] = CachedAddresses{list, Connection::Clock::now()};
+        return list;
+    }
+
+    /**
+     * Connects count sockets to an origin at the same time. Each socket tries
+     * the origin's addresses in order, giving each connectTimeout. Returns the
+     * sockets that connected, in blocking mode; throws if none did, after
+     * dropping the cached addresses so the next attempt resolves again.
+     */
+    std::vector<int> openConnections(const Url& url, std::size_t count, const CallOptions* call) {
+        const std::shared_ptr<const AddressList> addresses = resolve(url);
+        struct Attempt {
+            int fd = -1;
+            std::size_t next = 0; ///< Next address to try
+            Connection::Clock::time_point giveUp;
+        };
+        std::vector<Attempt> attempts(count);
+        std::vector<int> connected;
+        std::string lastError = "no addresses";
+        auto closeAll = [&] {
+            for (Attempt& attempt : attempts) {
+                if (attempt.fd >= 0) {
+                    ::close(attempt.fd);
+                }
+            }
+            for (int fd : connected) {
+                ::close(fd);
+            }
+        };
+        auto startNext = [&](Attempt& attempt) {
+            attempt.fd = -1;
+            while (attempt.next < addresses->size()) {
+                const Address& address = (*addresses)[attempt.next++];
+                int fd = ::socket(address.family, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, address.protocol);
+                if (fd < 0) {
+                    lastError = std::strerror(errno);
+                    continue;
+                }
+                if (::connect(fd, reinterpret_cast<const sockaddr*>(&address.storage), address.length) != 0 &&
+                    errno != EINPROGRESS) {
+                    lastError = std::strerror(errno);
+                    ::close(fd);
+                    continue;
+                }
+                attempt.fd = fd;
+                attempt.giveUp = Connection::Clock::now() + options_.connectTimeout;
+                return;
+            }
+        };
+
+        try {
+            for (Attempt& attempt : attempts) {
+                startNext(attempt);
+            }
+            std::vector<pollfd> pfds;
+            std::vector<Attempt*> polled;
+            for (;;) {
+                pfds.clear();
+                polled.clear();
+                Connection::Clock::time_point giveUp = Connection::Clock::time_point::max();
+                for (Attempt& attempt : attempts) {
+                    if (attempt.fd >= 0) {
+                        pfds.push_back({attempt.fd, POLLOUT, 0});
+                        polled.push_back(&attempt);
+                        giveUp = std::min(giveUp, attempt.giveUp);
+                    }
+                }
+                if (polled.empty()) {
+                    break;
+                }
+                if (call && call->cancellation) {
+                    pfds.push_back({call->cancellation->fd(), POLLIN, 0});
+                }
+                if (call) {
+                    call->check();
+                }
+                auto left = std::chrono::ceil<std::chrono::milliseconds>(giveUp - Connection::Clock::now()).count();
+                int wait = static_cast<int>(std::max<long long>(0, std::min<long long>(left, 0x7fffffff)));
+                if (call && call->pollTimeout() >= 0) {
+                    wait = std::min(wait, call->pollTimeout());
+                }
+                int ready = ::poll(pfds.data(), pfds.size(), wait);
+                if (ready < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    throw TransportError(std::string("Failed to poll socket: ") + std::strerror(errno));
+                }
+                const Connection::Clock::time_point now = Connection::Clock::now();
+                for (std::size_t i = 0; i < polled.size(); ++i) {
+                    Attempt& attempt = *polled[i];
+                    if (pfds[i].revents == 0) {
+                        if (now >= attempt.giveUp) {
+                            lastError = "connect timed out";
+                            ::close(attempt.fd);
+                            startNext(attempt);
+                        }
+                        continue;
+                    }
+                    int soError = 0;
+                    socklen_t len = sizeof(soError);
+                    if (::getsockopt(attempt.fd, SOL_SOCKET, SO_ERROR, &soError, &len) != 0 || soError != 0) {
+                        lastError = std::strerror(soError != 0 ? soError : errno);
+                        ::close(attempt.fd);
+                        startNext(attempt);
+                        continue;
+                    }
+                    int flags = ::fcntl(attempt.fd, F_GETFL, 0);
+                    ::fcntl(attempt.fd, F_SETFL, flags & ~O_NONBLOCK);
+                    int one = 1;
+                    ::setsockopt(attempt.fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+                    connected.push_back(attempt.fd);
+                    attempt.fd = -1;
+                    attempt.next = addresses->size();
+                }
+            }
+        } catch (...) {
+            closeAll();
+            throw;
+        }
+        if (connected.empty() && count > 0) {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                auto it = addressCache_.find(url.originKey());
+                if (it != addressCache_.end() && it->second.addresses == addresses) {
+                    addressCache_.erase(it);
+                }
+            }
+            throw TransportError("Failed to connect to " + url.host + ":" + std::to_string(url.port) + ": " +
+                                 lastError);
+        }
+        return connected;
+    }
+
+    ConnectionPoolOptions options_;
+    mutable std::mutex mutex_;
+    std::map<std::string, HostPool> hosts_;
+    std::map<std::string, CachedAddresses> addressCache_;
+};
+
+} // namespace client
+} // namespace sauron
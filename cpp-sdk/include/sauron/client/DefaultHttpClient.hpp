@@ -0,0 +1,49 @@
+#pragma once
+
+/**
+ * @file DefaultHttpClient.hpp
+ * @brief Built-in transports behind HttpClient::create and AsyncHttpClient::create
+ *
+ * Opt-in: include this header in one or more translation units to get the
+ * Linux socket and epoll transports as the defaults. Applications that bring
+ * their own HttpClient and AsyncHttpClient, or build for another platform,
+ * leave it out and may define the create functions themselves. Define
+ * SAURON_NO_DEFAULT_HTTP_CLIENT to get the transport classes without the
+ * definitions.
+ */
+
+#if !defined(__linux__)
+#error "The built-in Sauron transports need Linux; provide your own HttpClient instead"
+#endif
+
+#include "AsyncHttpClient.hpp"
+#include "EpollHttpClient.hpp"
+#include "HttpClient.hpp"
+#include "SocketHttpClient.hpp"
+#include <memory>
+#include <string>
+
+#ifndef SAURON_NO_DEFAULT_HTTP_CLIENT
+
+namespace sauron {
+namespace client {
+
+inline std::unique_ptr<HttpClient> HttpClient::create(const std::string& baseUrl) {
+    return std::make_unique<SocketHttpClient>(baseUrl);
+}
+
+inline std::unique_ptr<AsyncHttpClient> AsyncHttpClient::create(const std::string& baseUrl) {
+    return std::make_unique<EpollHttpClient>(baseUrl);
+}
+
+namespace detail {
+
+/// Lets SauronClient fall back to the epoll transport for asynchronous calls.
+inline const bool kDefaultAsyncFactoryRegistered = (AsyncHttpClient::defaultFactory() = &AsyncHttpClient::create, true);
+
+} // namespace detail
+
+} // namespace client
+} // namespace sauron
+
+#endif
@@ -0,0 +1,43 @@
+#pragma once
+
+namespace sauron {
+namespace client {
+
+/**
+ * @brief API operations, for per-endpoint configuration
+ */
+enum class Endpoint {
+    Login,          ///< POST /auth/login
+    RefreshToken,   ///< POST /auth/refresh
+    Health,         ///< GET /health
+    Query,          ///< POST /ai/query
+    QueryAlgorithm, ///< POST /ai/query/algorithm
+    QueryStream     ///< POST /ai/query/stream
+};
+
+/**
+ * @brief Get the request path of an endpoint
+ *
+ * @param endpoint The endpoint
+ * @return const char* The path, relative to the base URL
+ */
+inline const char* endpointPath(Endpoint endpoint) {
+    switch (endpoint) {
+        case Endpoint::Login:
+            return "/auth/login";
+        case Endpoint::RefreshToken:
+            return "/auth/refresh";
+        case Endpoint::Health:
+            return "/health";
+        case Endpoint::Query:
+            return "/ai/query";
+        case Endpoint::QueryAlgorithm:
+            return "/ai/query/algorithm";
+        case Endpoint::QueryStream:
+            return "/ai/query/stream";
+    }
+    return "";
+}
+
+} // namespace client
+} // namespace sauron
@@ -0,0 +1,915 @@
+#pragma once
+
+#include "AsyncHttpClient.hpp"
+#include "Compression.hpp"
+#include "ConnectionPool.hpp"
+#include "HttpWire.hpp"
+#include "TransportError.hpp"
+#include "Url.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace sauron {
+namespace client {
+
+/**
+ * @brief Built-in AsyncHttpClient driven by a single epoll I/O thread
+ *
+ * Every request is a small state machine (connect, write, read) over a
+ * non-blocking socket, so one thread can keep thousands of requests in
+ * flight. Keep-alive connections are pooled per origin on the I/O thread
+ * with the same rules as ConnectionPool; requests beyond
+ * maxConnectionsPerHost wait for a connection to be released.
+ *
+ * A request whose AsyncHttpRequest::options deadline passes or whose token
+ * is cancelled completes with DeadlineExceeded or RequestCancelled at once,
+ * in any phase. Its connection goes back to the pool if nothing was written
+ * on it yet.
+ */
+class EpollHttpClient : public AsyncHttpClient {
+public:
+    using AsyncHttpClient::send;
+
+    /**
+     * @brief Default options: a much larger per-host limit than the blocking
+     * pool, since every in-flight request needs its own connection
+     */
+    static ConnectionPoolOptions defaultOptions() {
+        ConnectionPoolOptions options;
+        options.maxConnectionsPerHost = 1024;
+        return options;
+    }
+
+    /**
+     * @brief Constructor
+     *
+     * @param baseUrl The base URL, e.g. "http://localhost:3000"
+     * @param options Connection limits and timeouts
+     */
+    explicit EpollHttpClient(const std::string& baseUrl = "",
+                             const ConnectionPoolOptions& options = defaultOptions())
+        : options_(options) {
+        if (options_.maxConnectionsPerHost == 0) {
+            options_.maxConnectionsPerHost = 1;
+        }
+        if (!baseUrl.empty()) {
+            setBaseUrl(baseUrl);
+        }
+    }
+
+    /**
+     * @brief Destructor; outstanding requests complete with RequestCancelled
+     */
+    ~EpollHttpClient() override { stop(); }
+
+    EpollHttpClient(const EpollHttpClient&) = delete;
+    EpollHttpClient& operator=(const EpollHttpClient&) = delete;
+
+    void setBaseUrl(const std::string& url) override {
+        Url parsed = Url::parse(url);
+        if (parsed.scheme != "http") {
+            throw std::invalid_argument("EpollHttpClient only supports http:// URLs: " + url);
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        baseUrl_ = url;
+        url_ = std::move(parsed);
+    }
+
+    std::string getBaseUrl() const override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return baseUrl_;
+    }
+
+    void setDefaultHeader(const std::string& name, const std::string& value) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& line : defaultHeaders_) {
+            if (wire::equalsIgnoreCase(wire::headerName(line), name)) {
+                line = name + ": " + value;
+                return;
+            }
+        }
+        defaultHeaders_.push_back(name + ": " + value);
+    }
+
+    void removeDefaultHeader(const std::string& name) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto it = defaultHeaders_.begin(); it != defaultHeaders_.end(); ++it) {
+            if (wire::equalsIgnoreCase(wire::headerName(*it), name)) {
+                defaultHeaders_.erase(it);
+                return;
+            }
+        }
+    }
+
+    /**
+     * @brief Enable or disable body compression
+     *
+     * Request bodies are compressed on the thread calling send(), not on
+     * the I/O thread. Streamed bodies (AsyncHttpRequest::bodyStream) are
+     * never compressed; their responses are still decompressed.
+     *
+     * @param options Compression options; the default-constructed value turns compression off
+     * @throws std::invalid_argument if the options need a coding that is not compiled in
+     */
+    void setCompression(const CompressionOptions& options) {
+        compression::validate(options);
+        std::lock_guard<std::mutex> lock(mutex_);
+        compression_ = options;
+    }
+
+    /**
+     * @brief Get the compression options
+     */
+    CompressionOptions getCompression() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return compression_;
+    }
+
+    RequestId send(AsyncHttpRequest request, AsyncCompletion onComplete) override {
+        auto op = std::make_unique<Op>();
+        op->onData = std::move(request.onData);
+        op->onComplete = std::move(onComplete);
+        op->body = std::move(request.body);
+        op->bodyStream = std::move(request.bodyStream);
+        op->options = std::move(request.options);
+        CompressionOptions compression = getCompression();
+        op->decoder.reset(compression.decompressResponses);
+        if (compression.decompressResponses || compression.compressRequests) {
+            std::string encoded;
+            if (compression::prepareRequest(compression, op->body, request.headers, encoded)) {
+                op->body = std::move(encoded);
+            }
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (baseUrl_.empty()) {
+                throw std::logic_error("EpollHttpClient: base URL is not set");
+            }
+            op->url = url_;
+            wire::writeRequestHead(request.method, url_.basePath + request.path, url_.hostHeader(),
+                                   defaultHeaders_, request.headers, request.contentType,
+                                   op->bodyStream ? wire::kChunked : op->body.size(), op->head);
+        }
+        op->id = nextId_.fetch_add(1, std::memory_order_relaxed);
+        const RequestId id = op->id;
+        if (op->options.cancellation) {
+            // A cancel() racing with submission is caught by the check in processQueue().
+            op->cancelled = op->options.cancellation->onCancel([this, id] { cancel(id); });
+        }
+        if (op->options.stopped()) {
+            op->onComplete(HttpResponse{}, op->options.stopError());
+            return id;
+        }
+
+        try {
+            op->addresses = resolve(op->url);
+            start();
+        } catch (...) {
+            op->onComplete(HttpResponse{}, std::current_exception());
+            return id;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(queueMutex_);
+            if (stopping_) {
+                op->onComplete(HttpResponse{}, std::make_exception_ptr(RequestCancelled("EpollHttpClient stopped")));
+                return id;
+            }
+            submissions_.push_back(std::move(op));
+        }
+        inFlight_.fetch_add(1, std::memory_order_relaxed);
+        wake();
+        return id;
+    }
+
+    void cancel(RequestId id) override {
+        {
+            std::lock_guard<std::mutex> lock(queueMutex_);
+            cancellations_.push_back(id);
+        }
+        wake();
+    }
+
+    /**
+     * @brief Number of requests submitted and not yet completed
+     */
+    std::size_t inFlight() const { return inFlight_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Stop the I/O thread
+     *
+     * Outstanding requests complete with RequestCancelled and new requests
+     * are rejected.
+     */
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(queueMutex_);
+            if (stopping_) {
+                return;
+            }
+            stopping_ = true;
+        }
+        if (thread_.joinable()) {
+            wake();
+            thread_.join();
+        }
+        if (epollFd_ >= 0) {
+            ::close(epollFd_);
+            epollFd_ = -1;
+        }
+        if (wakeFd_ >= 0) {
+            ::close(wakeFd_);
+            wakeFd_ = -1;
+        }
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Address {
+        sockaddr_storage storage;
+        socklen_t length;
+        int family;
+    };
+    using AddressList = std::vector<Address>;
+
+    struct CachedAddresses {
+        std::shared_ptr<const AddressList> addresses;
+        Clock::time_point resolvedAt;
+    };
+
+    enum class Phase { Queued, Connecting, Writing, Reading };
+
+    struct Conn {
+        explicit Conn(int descriptor) : fd(descriptor) {}
+        ~Conn() {
+            if (fd >= 0) {
+                ::close(fd);
+            }
+        }
+        int fd;
+        Clock::time_point lastUsed = Clock::now();
+    };
+
+    struct Op {
+        RequestId id = 0;
+        Url url;
+        std::shared_ptr<const AddressList> addresses;
+        std::size_t addressIndex = 0;
+        std::string head;
+        std::string body;
+        std::shared_ptr<dto::BodyStream> bodyStream;
+        std::unique_ptr<wire::ChunkedBodyWriter> chunked; ///< Set while a streamed body is being written
+        StreamCallback onData;
+        AsyncCompletion onComplete;
+        std::unique_ptr<Conn> conn;
+        Phase phase = Phase::Queued;
+        bool holdsSlot = false; ///< Counted in Origin::open (connection attached or being opened)
+        bool reused = false;
+        bool retried = false;
+        bool received = false;
+        bool delivered = false;
+        std::size_t written = 0;
+        std::uint64_t connectSerial = 0;
+        std::string lastError = "no addresses";
+        Clock::time_point queuedAt; ///< When the op started waiting for a connection slot
+        Clock::time_point sentAt;
+        HttpTiming timing;
+        HttpResponseParser parser;
+        compression::BodyDecoder decoder;
+        HttpResponse response;
+        std::string chunk; ///< Reused for every streamed body chunk
+        CallOptions options;
+        CancellationToken::Registration cancelled; ///< Calls cancel(id) when the token is cancelled
+    };
+
+    struct Origin {
+        std::deque<std::unique_ptr<Conn>> idle; ///< Most recently used at the back
+        std::size_t open = 0;                   ///< Idle + attached connections
+        std::deque<RequestId> waiting;          ///< Requests waiting for a connection slot
+    };
+
+    struct Timer {
+        Clock::time_point deadline;
+        RequestId id;
+        std::uint64_t serial;
+        bool callDeadline; ///< Ends the whole request rather than one connect attempt
+        bool operator>(const Timer& other) const { return deadline > other.deadline; }
+    };
+
+    static constexpr std::size_t kReadBufferSize = 64 * 1024;
+    static constexpr int kMaxEvents = 256;
+    static constexpr int kSweepIntervalMs = 1000;
+
+    // ---- caller side ----------------------------------------------------
+
+    std::shared_ptr<const AddressList> resolve(const Url& url) {
+        const std::string key = url.originKey();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = addressCache_.find(key);
+            if (it != addressCache_.end() && Clock::now() - it->second.resolvedAt < options_.dnsTtl) {
+                return it->second.addresses;
+            }
+        }
+        addrinfo hints{};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        addrinfo* results = nullptr;
+        const std::string service = std::to_string(url.port);
+        int rc = ::getaddrinfo(url.host.c_str(), service.c_str(), &hints, &results);
+        if (rc != 0) {
+            throw TransportError("Failed to resolve " + url.host + ": " + ::gai_strerror(rc));
+        }
+        auto list = std::make_shared<AddressList>();
+        for (addrinfo* ai = results; ai != nullptr; ai = ai->ai_next) {
+            Address address{};
+            std::memcpy(&address.storage, ai->ai_addr, ai->ai_addrlen);
+            address.length = ai->ai_addrlen;
+            address.family = ai->ai_family;
+            list->push_back(address);
+        }
+        ::freeaddrinfo(results);
+        if (list->empty()) {
+            throw TransportError("Failed to resolve " + url.host + ": no addresses");
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        addressCache_[key] = CachedAddresses{list, Clock::now()};
+        return list;
+    }
+
+    void start() {
+        std::call_once(startFlag_, [this] {
+            epollFd_ = ::epoll_create1(EPOLL_CLOEXEC);
+            wakeFd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+            if (epollFd_ < 0 || wakeFd_ < 0) {
+                throw TransportError(std::string("Failed to create event loop: ") + std::strerror(errno));
+            }
+            epoll_event ev{};
+            ev.events = EPOLLIN;
+            ev.data.u64 = 0;
+            ::epoll_ctl(epollFd_, EPOLL_CTL_ADD, wakeFd_, &ev);
+            thread_ = std::thread([this] { run(); });
+        });
+    }
+
+    void wake() {
+        if (wakeFd_ >= 0) {
+            std::uint64_t one = 1;
+            ssize_t ignored = ::write(wakeFd_, &one, sizeof(one));
+            (void)ignored;
+        }
+    }
+
+    // ---- I/O thread -----------------------------------------------------
+
+    void run() {
+        epoll_event events[kMaxEvents];
+        Clock::time_point lastSweep = Clock::now();
+        for (;;) {
+            int n = ::epoll_wait(epollFd_, events, kMaxEvents, nextTimeoutMs());
+            if (n < 0 && errno != EINTR) {
+                break;
+            }
+            for (int i = 0; i < n; ++i) {
+                if (events[i].data.u64 == 0) {
+                    std::uint64_t value;
+                    while (::read(wakeFd_, &value, sizeof(value)) > 0) {
+                    }
+                    continue;
+                }
+                onEvent(events[i].data.u64);
+            }
+            if (!processQueue()) {
+                break;
+            }
+            expireTimers();
+            if (Clock::now() - lastSweep >= std::chrono::milliseconds(kSweepIntervalMs)) {
+                sweepIdle();
+                lastSweep = Clock::now();
+            }
+        }
+        shutdownLoop();
+    }
+
+    int nextTimeoutMs() {
+        if (timers_.empty()) {
+            return kSweepIntervalMs;
+        }
+        auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(timers_.top().deadline - Clock::now());
+        return static_cast<int>(std::max<long long>(0, std::min<long long>(wait.count() + 1, kSweepIntervalMs)));
+    }
+
+    bool processQueue() {
+        std::vector<std::unique_ptr<Op>> submissions;
+        std::vector<RequestId> cancellations;
+        bool stopping;
+        {
+            std::lock_guard<std::mutex> lock(queueMutex_);
+            submissions.swap(submissions_);
+            cancellations.swap(cancellations_);
+            stopping = stopping_;
+        }
+        for (auto& op : submissions) {
+            RequestId id = op->id;
+            const CallOptions& options = op->options;
+            if (options.deadline != Clock::time_point::max()) {
+                timers_.push(Timer{options.deadline, id, 0, true});
+            }
+            std::exception_ptr stopped = options.stopped() ? options.stopError() : nullptr;
+            ops_.emplace(id, std::move(op));
+            if (stopped) {
+                halt(id, stopped);
+                continue;
+            }
+            acquireConnection(id);
+        }
+        for (RequestId id : cancellations) {
+            if (ops_.count(id) != 0) {
+                halt(id, std::make_exception_ptr(RequestCancelled()));
+            }
+        }
+        return !stopping;
+    }
+
+    Op* find(RequestId id) {
+        auto it = ops_.find(id);
+        return it == ops_.end() ? nullptr : it->second.get();
+    }
+
+    void acquireConnection(RequestId id) {
+        Op* op = find(id);
+        Origin& origin = origins_[op->url.originKey()];
+        while (!origin.idle.empty()) {
+            std::unique_ptr<Conn> conn = std::move(origin.idle.back());
+            origin.idle.pop_back();
+            if (Clock::now() - conn->lastUsed < options_.idleTimeout && isAlive(conn->fd)) {
+                attach(*op, std::move(conn), true);
+                return;
+            }
+            --origin.open;
+        }
+        if (origin.open < options_.maxConnectionsPerHost) {
+            ++origin.open;
+            op->holdsSlot = true;
+            connect(id);
+            return;
+        }
+        op->phase = Phase::Queued;
+        op->queuedAt = Clock::now();
+        origin.waiting.push_back(id);
+    }
+
+    static bool isAlive(int fd) {
+        pollfd pfd{fd, POLLIN, 0};
+        return ::poll(&pfd, 1, 0) == 0;
+    }
+
+    // Opens a connection for an op that already owns a slot in its origin.
+    void connect(RequestId id) {
+        Op* op = find(id);
+        while (op->addressIndex < op->addresses->size()) {
+            const Address& address = (*op->addresses)[op->addressIndex++];
+            int fd = ::socket(address.family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+            if (fd < 0) {
+                op->lastError = std::strerror(errno);
+                continue;
+            }
+            int one = 1;
+            ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            auto conn = std::make_unique<Conn>(fd);
+            int rc = ::connect(fd, reinterpret_cast<const sockaddr*>(&address.storage), address.length);
+            if (rc != 0 && errno != EINPROGRESS) {
+                op->lastError = std::strerror(errno);
+                continue;
+            }
+            op->conn = std::move(conn);
+            op->reused = false;
+            op->phase = rc == 0 ? Phase::Writing : Phase::Connecting;
+            watch(*op, EPOLLOUT, EPOLL_CTL_ADD);
+            if (op->phase == Phase::Connecting) {
+                timers_.push(Timer{Clock::now() + options_.connectTimeout, id, ++op->connectSerial, false});
+            }
+            return;
+        }
+        forgetAddresses(op->url, op->addresses);
+        fail(id, std::make_exception_ptr(TransportError(
+            "Failed to connect to " + op->url.host + ":" + std::to_string(op->url.port) + ": " + op->lastError)));
+    }
+
+    // Drops cached addresses none of which accepted a connection, so the next request resolves again.
+    void forgetAddresses(const Url& url, const std::shared_ptr<const AddressList>& addresses) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = addressCache_.find(url.originKey());
+        if (it != addressCache_.end() && it->second.addresses == addresses) {
+            addressCache_.erase(it);
+        }
+    }
+
+    // Accounts for the time a queued op waited for its connection slot.
+    static void dequeued(Op& op) { op.timing.poolWait += Clock::now() - op.queuedAt; }
+
+    void attach(Op& op, std::unique_ptr<Conn> conn, bool reused) {
+        op.conn = std::move(conn);
+        op.holdsSlot = true;
+        op.reused = reused;
+        op.phase = Phase::Writing;
+        watch(op, EPOLLOUT, EPOLL_CTL_ADD);
+    }
+
+    void watch(Op& op, std::uint32_t events, int operation) {
+        epoll_event ev{};
+        ev.events = events;
+        ev.data.u64 = op.id;
+        ::epoll_ctl(epollFd_, operation, op.conn->fd, &ev);
+    }
+
+    void onEvent(RequestId id) {
+        Op* op = find(id);
+        if (op == nullptr || !op->conn) {
+            return;
+        }
+        switch (op->phase) {
+            case Phase::Connecting:
+                onConnected(id);
+                break;
+            case Phase::Writing:
+                onWritable(id);
+                break;
+            case Phase::Reading:
+                onReadable(id);
+                break;
+            default:
+                break;
+        }
+    }
+
+    void onConnected(RequestId id) {
+        Op* op = find(id);
+        int soError = 0;
+        socklen_t len = sizeof(soError);
+        if (::getsockopt(op->conn->fd, SOL_SOCKET, SO_ERROR, &soError, &len) != 0 || soError != 0) {
+            op->lastError = std::strerror(soError != 0 ? soError : errno);
+            ::epoll_ctl(epollFd_, EPOLL_CTL_DEL, op->conn->fd, nullptr);
+            op->conn.reset();
+            connect(id);
+            return;
+        }
+        op->phase = Phase::Writing;
+        onWritable(id);
+    }
+
+    void onWritable(RequestId id) {
+        Op* op = find(id);
+        if (op->bodyStream) {
+            writeChunked(op);
+            return;
+        }
+        const std::size_t total = op->head.size() + op->body.size();
+        if (op->written == 0) {
+            op->sentAt = Clock::now();
+        }
+        while (op->written < total) {
+            iovec iov[2];
+            int count = 0;
+            if (op->written < op->head.size()) {
+                iov[count].iov_base = const_cast<char*>(op->head.data() + op->written);
+                iov[count].iov_len = op->head.size() - op->written;
+                ++count;
+                if (!op->body.empty()) {
+                    iov[count].iov_base = const_cast<char*>(op->body.data());
+                    iov[count].iov_len = op->body.size();
+                    ++count;
+                }
+            } else {
+                std::size_t offset = op->written - op->head.size();
+                iov[count].iov_base = const_cast<char*>(op->body.data() + offset);
+                iov[count].iov_len = op->body.size() - offset;
+                ++count;
+            }
+            msghdr msg{};
+            msg.msg_iov = iov;
+            msg.msg_iovlen = static_cast<std::size_t>(count);
+            ssize_t n = ::sendmsg(op->conn->fd, &msg, MSG_NOSIGNAL);
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                    return;
+                }
+                onIoError(id, std::string("Failed to send HTTP request: ") + std::strerror(errno));
+                return;
+            }
+            op->written += static_cast<std::size_t>(n);
+            op->timing.bytesSent += static_cast<std::size_t>(n);
+        }
+        op->phase = Phase::Reading;
+        watch(*op, EPOLLIN, EPOLL_CTL_MOD);
+    }
+
+    void writeChunked(Op* op) {
+        if (!op->chunked) {
+            op->sentAt = Clock::now();
+            op->bodyStream->rewind();
+            op->chunked = std::make_unique<wire::ChunkedBodyWriter>(op->head, *op->bodyStream);
+        }
+        iovec iov[wire::ChunkedBodyWriter::kMaxIovecs];
+        for (int count = op->chunked->pending(iov); count > 0; count = op->chunked->pending(iov)) {
+            msghdr msg{};
+            msg.msg_iov = iov;
+            msg.msg_iovlen = static_cast<std::size_t>(count);
+            ssize_t n = ::sendmsg(op->conn->fd, &msg, MSG_NOSIGNAL);
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                    return;
+                }
+                onIoError(op->id, std::string("Failed to send HTTP request: ") + std::strerror(errno));
+                return;
+            }
+            op->written += static_cast<std::size_t>(n);
+            op->timing.bytesSent += static_cast<std::size_t>(n);
+            op->chunked->advance(static_cast<std::size_t>(n));
+        }
+        op->chunked.reset();
+        op->phase = Phase::Reading;
+        watch(*op, EPOLLIN, EPOLL_CTL_MOD);
+    }
+
+    void onReadable(RequestId id) {
+        Op* op = find(id);
+        HttpResponseParser::BodySink deliver = [op](const char* data, std::size_t size) {
+            int status = op->parser.statusCode();
+            if (op->onData && status >= 200 && status < 300) {
+                op->delivered = true;
+                op->chunk.assign(data, size);
+                return op->onData(op->chunk, false);
+            }
+            op->response.body.append(data, size);
+            return true;
+        };
+        HttpResponseParser::BodySink sink = [op, &deliver](const char* data, std::size_t size) {
+            return op->decoder.feed(op->parser.headers(), data, size, deliver);
+        };
+
+        for (;;) {
+            ssize_t n = ::recv(op->conn->fd, readBuffer_, sizeof(readBuffer_), 0);
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                    return;
+                }
+                onIoError(id, std::string("Failed to read HTTP response: ") + std::strerror(errno));
+                return;
+            }
+            if (n == 0) {
+                if (!op->received) {
+                    onIoError(id, "Connection closed by peer before the response");
+                    return;
+                }
+                try {
+                    op->parser.finish();
+                    op->decoder.finish();
+                } catch (...) {
+                    fail(id, std::current_exception());
+                    return;
+                }
+                complete(id, false);
+                return;
+            }
+            if (!op->received) {
+                op->timing.firstByte = Clock::now() - op->sentAt;
+            }
+            op->received = true;
+            op->timing.bytesReceived += static_cast<std::size_t>(n);
+            std::size_t consumed;
+            try {
+                consumed = op->parser.feed(readBuffer_, static_cast<std::size_t>(n), sink);
+            } catch (...) {
+                fail(id, std::current_exception());
+                return;
+            }
+            if (op->parser.aborted()) {
+                complete(id, false);
+                return;
+            }
+            if (op->parser.complete()) {
+                try {
+                    op->decoder.finish();
+                } catch (...) {
+                    fail(id, std::current_exception());
+                    return;
+                }
+                complete(id, op->parser.keepAlive() && consumed == static_cast<std::size_t>(n));
+                return;
+            }
+        }
+    }
+
+    void onIoError(RequestId id, const std::string& message) {
+        Op* op = find(id);
+        if (op->reused && !op->retried && !op->received) {
+            // The server closed the idle connection; replay on a fresh one.
+            ::epoll_ctl(epollFd_, EPOLL_CTL_DEL, op->conn->fd, nullptr);
+            op->conn.reset();
+            op->retried = true;
+            op->written = 0;
+            op->chunked.reset();
+            op->addressIndex = 0;
+            op->parser.reset();
+            op->decoder.reset(op->decoder.enabled());
+            op->response = HttpResponse{};
+            connect(id);
+            return;
+        }
+        fail(id, std::make_exception_ptr(TransportError(message, op->written > 0)));
+    }
+
+    void complete(RequestId id, bool reusable) {
+        auto it = ops_.find(id);
+        std::unique_ptr<Op> op = std::move(it->second);
+        ops_.erase(it);
+        inFlight_.fetch_sub(1, std::memory_order_relaxed);
+
+        op->response.statusCode = op->parser.statusCode();
+        op->response.headers = std::move(op->parser.headers());
+        op->response.timing = op->timing;
+        bool aborted = op->parser.aborted();
+        release(op->url.originKey(), std::move(op->conn), reusable);
+
+        int status = op->response.statusCode;
+        if (op->onData && !aborted && (op->delivered || (status >= 200 && status < 300))) {
+            invoke([&] { op->onData(std::string(), true); });
+        }
+        invoke([&] { op->onComplete(std::move(op->response), nullptr); });
+    }
+
+    void fail(RequestId id, std::exception_ptr error, bool reusable = false) {
+        auto it = ops_.find(id);
+        std::unique_ptr<Op> op = std::move(it->second);
+        ops_.erase(it);
+        inFlight_.fetch_sub(1, std::memory_order_relaxed);
+        if (op->conn) {
+            release(op->url.originKey(), std::move(op->conn), reusable);
+        } else if (op->holdsSlot) {
+            releaseSlot(op->url.originKey());
+        }
+        invoke([&] { op->onComplete(HttpResponse{}, error); });
+    }
+
+    // Ends a cancelled or overdue request; a connection with nothing written on it yet is kept.
+    void halt(RequestId id, std::exception_ptr error) {
+        Op* op = find(id);
+        bool clean = op->conn && op->phase == Phase::Writing && op->written == 0;
+        fail(id, std::move(error), clean);
+    }
+
+    void release(const std::string& key, std::unique_ptr<Conn> conn, bool reusable) {
+        ::epoll_ctl(epollFd_, EPOLL_CTL_DEL, conn->fd, nullptr);
+        Origin& origin = origins_[key];
+        if (!reusable) {
+            conn.reset();
+            releaseSlot(key);
+            return;
+        }
+        conn->lastUsed = Clock::now();
+        while (!origin.waiting.empty()) {
+            RequestId next = origin.waiting.front();
+            origin.waiting.pop_front();
+            if (Op* op = find(next)) {
+                dequeued(*op);
+                attach(*op, std::move(conn), true);
+                return;
+            }
+        }
+        origin.idle.push_back(std::move(conn));
+    }
+
+    // Gives a connection slot back and lets the next waiting request open one.
+    void releaseSlot(const std::string& key) {
+        Origin& origin = origins_[key];
+        --origin.open;
+        while (!origin.waiting.empty()) {
+            RequestId next = origin.waiting.front();
+            origin.waiting.pop_front();
+            if (Op* op = find(next)) {
+                dequeued(*op);
+                ++origin.open;
+                op->holdsSlot = true;
+                connect(next);
+                return;
+            }
+        }
+    }
+
+    template <typename F>
+    static void invoke(F&& f) {
+        try {
+            f();
+        } catch (...) {
+            // Handlers run on the I/O thread; there is nowhere to rethrow.
+        }
+    }
+
+    void expireTimers() {
+        const Clock::time_point now = Clock::now();
+        while (!timers_.empty() && timers_.top().deadline <= now) {
+            Timer timer = timers_.top();
+            timers_.pop();
+            Op* op = find(timer.id);
+            if (op != nullptr && timer.callDeadline) {
+                halt(timer.id, std::make_exception_ptr(DeadlineExceeded()));
+            } else if (op != nullptr && op->phase == Phase::Connecting && op->connectSerial == timer.serial) {
+                // Give up on this address only; connect() moves on to the next one.
+                op->lastError = "connect timed out";
+                ::epoll_ctl(epollFd_, EPOLL_CTL_DEL, op->conn->fd, nullptr);
+                op->conn.reset();
+                connect(timer.id);
+            }
+        }
+    }
+
+    void sweepIdle() {
+        const Clock::time_point now = Clock::now();
+        for (auto& entry : origins_) {
+            Origin& origin = entry.second;
+            while (!origin.idle.empty() && now - origin.idle.front()->lastUsed >= options_.idleTimeout) {
+                origin.idle.pop_front();
+                --origin.open;
+            }
+        }
+    }
+
+    void shutdownLoop() {
+        std::vector<std::unique_ptr<Op>> pending;
+        {
+            std::lock_guard<std::mutex> lock(queueMutex_);
+            pending.swap(submissions_);
+        }
+        for (auto& op : pending) {
+            RequestId id = op->id;
+            ops_.emplace(id, std::move(op));
+        }
+        while (!ops_.empty()) {
+            fail(ops_.begin()->first, std::make_exception_ptr(RequestCancelled("EpollHttpClient stopped")));
+        }
+        origins_.clear();
+    }
+
+    ConnectionPoolOptions options_;
+
+    mutable std::mutex mutex_;
+    std::string baseUrl_;
+    Url url_;
+    std::vector<std::string> defaultHeaders_;
+    CompressionOptions compression_;
+    std::map<std::string, CachedAddresses> addressCache_;
+
+    std::mutex queueMutex_;
+    bool stopping_ = false;
+    std::vector<std::unique_ptr<Op>> submissions_;
+    std::vector<RequestId> cancellations_;
+
+    std::atomic<RequestId> nextId_{1};
+    std::atomic<std::size_t> inFlight_{0};
+    std::once_flag startFlag_;
+    std::thread thread_;
+    int epollFd_ = -1;
+    int wakeFd_ = -1;
+
+    // Owned by the I/O thread
+    std::unordered_map<RequestId, std::unique_ptr<Op>> ops_;
+    std::map<std::string, Origin> origins_;
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> timers_;
+    char readBuffer_[kReadBufferSize];
+};
+
+} // namespace client
+} // namespace sauron
@@ -0,0 +1,318 @@
+#pragma once
+
+#include "AsyncHttpClient.hpp"
+#include "Endpoint.hpp"
+#include "Scheduler.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace sauron {
+namespace client {
+
+/**
+ * @brief Options for Hedger
+ */
+struct HedgeOptions {
+    double percentile = 0.95;                  ///< Hedge once a request is slower than this fraction of recent ones
+    std::chrono::milliseconds minDelay{5};     ///< Never hedge sooner than this
+    std::size_t window = 1000;                 ///< Recent latencies the percentile is taken over
+    std::size_t minSamples = 100;              ///< Latencies needed before hedging starts
+    double budgetRatio = 0.05;                 ///< Hedges allowed per request
+    double maxBalance = 20;                    ///< Cap on saved-up hedges
+    std::vector<Endpoint> endpoints{Endpoint::Query}; ///< Endpoints that are hedged
+};
+
+/**
+ * @brief Counters of a Hedger
+ */
+struct HedgeStats {
+    std::uint64_t requests = 0;        ///< Requests sent through the hedger
+    std::uint64_t hedges = 0;          ///< Duplicate requests sent
+    std::uint64_t hedgeWins = 0;       ///< Requests answered by the duplicate
+    std::uint64_t budgetExhausted = 0; ///< Hedges skipped because the budget was empty
+};
+
+/**
+ * @brief Cuts tail latency by duplicating slow requests
+ *
+ * A request still unanswered after the configured percentile of recent
+ * latencies for its endpoint is sent a second time; the first response wins
+ * and the other request is cancelled. Every request deposits budgetRatio
+ * hedges and every hedge withdraws one, so duplicates add at most that
+ * fraction of extra load. Both copies go over the same AsyncHttpClient, whose
+ * connection pool usually has a warm connection for the hedge.
+ */
+class Hedger : public std::enable_shared_from_this<Hedger> {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @brief Create a hedger
+     *
+     * @param options Percentile, window and budget
+     * @return std::shared_ptr<Hedger> The hedger
+     */
+    static std::shared_ptr<Hedger> create(const HedgeOptions& options = {}) {
+        return std::shared_ptr<Hedger>(new Hedger(options));
+    }
+
+    Hedger(const Hedger&) = delete;
+    Hedger& operator=(const Hedger&) = delete;
+
+    /**
+     * @brief Whether requests to an endpoint are hedged
+     */
+    bool hedges(Endpoint endpoint) const { return windows_.find(endpoint) != windows_.end(); }
+
+    /**
+     * @brief Current hedge delay of an endpoint
+     *
+     * @return std::optional<std::chrono::milliseconds> The delay, or nothing
+     *         while too few latencies have been recorded
+     */
+    std::optional<std::chrono::milliseconds> hedgeDelay(Endpoint endpoint) {
+        auto it = windows_.find(endpoint);
+        if (it == windows_.end()) {
+            return std::nullopt;
+        }
+        LatencyWindow& window = *it->second;
+        std::lock_guard<std::mutex> lock(window.mutex);
+        if (window.count < options_.minSamples) {
+            return std::nullopt;
+        }
+        return std::max(options_.minDelay, window.threshold);
+    }
+
+    /**
+     * @brief Send a request, hedging it if it is slow
+     *
+     * Streaming requests and endpoints not configured for hedging are sent
+     * once.
+     *
+     * @param client The transport both copies go over
+     * @param endpoint The endpoint the request goes to
+     * @param request The request
+     * @param onComplete Called once with the first response, or with the
+     *        last error if every copy failed
+     */
+    void send(const std::shared_ptr<AsyncHttpClient>& client, Endpoint endpoint,
+              AsyncHttpRequest request, AsyncCompletion onComplete) {
+        if (request.onData || !hedges(endpoint)) {
+            client->send(std::move(request), std::move(onComplete));
+            return;
+        }
+        requests_.fetch_add(1, std::memory_order_relaxed);
+        {
+            std::lock_guard<std::mutex> lock(budgetMutex_);
+            balance_ = std::min(options_.maxBalance, balance_ + options_.budgetRatio);
+        }
+
+        auto race = std::make_shared<Race>();
+        race->endpoint = endpoint;
+        race->client = client;
+        race->onComplete = std::move(onComplete);
+        std::optional<std::chrono::milliseconds> delay = hedgeDelay(endpoint);
+        if (delay) {
+            race->hedge = request; // the primary's copy is consumed by send()
+        }
+        launch(race, 0, *client, std::move(request));
+        if (delay) {
+            scheduler_.schedule(Clock::now() + *delay, [self = shared_from_this(), race] { self->sendHedge(race); });
+        }
+    }
+
+    /**
+     * @brief Send a request, hedging it if it is slow, and wait for the response
+     *
+     * @param client The transport both copies go over
+     * @param endpoint The endpoint the request goes to
+     * @param request The request
+     * @return HttpResponse The first response
+     * @throws The last error if every copy failed
+     */
+    HttpResponse run(const std::shared_ptr<AsyncHttpClient>& client, Endpoint endpoint, AsyncHttpRequest request) {
+        auto promise = std::make_shared<std::promise<HttpResponse>>();
+        std::future<HttpResponse> future = promise->get_future();
+        send(client, endpoint, std::move(request), [promise](HttpResponse response, std::exception_ptr error) {
+            if (error) {
+                promise->set_exception(error);
+            } else {
+                promise->set_value(std::move(response));
+            }
+        });
+        return future.get();
+    }
+
+    /**
+     * @brief Get the counters
+     */
+    HedgeStats stats() const {
+        HedgeStats stats;
+        stats.requests = requests_.load(std::memory_order_relaxed);
+        stats.hedges = hedges_.load(std::memory_order_relaxed);
+        stats.hedgeWins = hedgeWins_.load(std::memory_order_relaxed);
+        stats.budgetExhausted = budgetExhausted_.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+private:
+    /// Recent latencies of one endpoint; the percentile is recomputed every window/16 samples.
+    struct LatencyWindow {
+        std::mutex mutex;
+        std::vector<std::chrono::microseconds> samples; ///< Ring buffer
+        std::size_t next = 0;
+        std::size_t count = 0;
+        std::size_t sinceUpdate = 0;
+        std::chrono::milliseconds threshold{0};
+    };
+
+    /// The primary request and its hedge, racing for one completion.
+    struct Race {
+        std::mutex mutex;
+        Endpoint endpoint = Endpoint::Query;
+        std::weak_ptr<AsyncHttpClient> client; ///< Weak: a pending hedge must not keep the transport alive
+        AsyncCompletion onComplete;
+        AsyncHttpRequest hedge;
+        AsyncHttpClient::RequestId ids[2] = {0, 0};
+        Clock::time_point sentAt[2];
+        int outstanding = 0;
+        bool finished = false;
+        int winner = -1;
+    };
+
+    explicit Hedger(const HedgeOptions& options) : options_(options) {
+        options_.window = std::max<std::size_t>(1, options_.window);
+        options_.minSamples = std::max<std::size_t>(1, std::min(options_.minSamples, options_.window));
+        options_.percentile = std::min(1.0, std::max(0.0, options_.percentile));
+        for (Endpoint endpoint : options_.endpoints) {
+            auto window = std::make_unique<LatencyWindow>();
+            window->samples.resize(options_.window);
+            windows_.emplace(endpoint, std::move(window));
+        }
+    }
+
+    void launch(const std::shared_ptr<Race>& race, int index, AsyncHttpClient& client, AsyncHttpRequest request) {
+        {
+            std::lock_guard<std::mutex> lock(race->mutex);
+            ++race->outstanding;
+            race->sentAt[index] = Clock::now();
+        }
+        std::weak_ptr<Hedger> weak = weak_from_this();
+        AsyncHttpClient::RequestId id = client.send(std::move(request),
+            [weak, race, index](HttpResponse response, std::exception_ptr error) {
+                std::shared_ptr<Hedger> self = weak.lock();
+                finish(race, index, std::move(response), error, self.get());
+            });
+        bool lost = false;
+        {
+            std::lock_guard<std::mutex> lock(race->mutex);
+            race->ids[index] = id;
+            lost = race->finished && race->winner != index;
+        }
+        if (lost) {
+            client.cancel(id); // the other copy won before send() returned
+        }
+    }
+
+    void sendHedge(const std::shared_ptr<Race>& race) {
+        {
+            std::lock_guard<std::mutex> lock(race->mutex);
+            if (race->finished) {
+                return;
+            }
+        }
+        {
+            std::lock_guard<std::mutex> lock(budgetMutex_);
+            if (balance_ < 1) {
+                budgetExhausted_.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            balance_ -= 1;
+        }
+        std::shared_ptr<AsyncHttpClient> client = race->client.lock();
+        if (!client) {
+            return;
+        }
+        hedges_.fetch_add(1, std::memory_order_relaxed);
+        launch(race, 1, *client, std::move(race->hedge));
+    }
+
+    /// Completes the race on the first response, or on the last error once no copy is left.
+    static void finish(const std::shared_ptr<Race>& race, int index, HttpResponse response,
+                       std::exception_ptr error, Hedger* self) {
+        AsyncHttpClient::RequestId loser = 0;
+        Clock::duration latency{};
+        {
+            std::lock_guard<std::mutex> lock(race->mutex);
+            --race->outstanding;
+            if (race->finished) {
+                return; // the cancelled loser
+            }
+            if (error && race->outstanding > 0) {
+                return; // the other copy may still answer
+            }
+            race->finished = true;
+            race->winner = index;
+            latency = Clock::now() - race->sentAt[index];
+            loser = race->ids[1 - index];
+        }
+        if (loser != 0) {
+            if (std::shared_ptr<AsyncHttpClient> client = race->client.lock()) {
+                client->cancel(loser);
+            }
+        }
+        if (self && !error) {
+            self->record(race->endpoint, latency);
+            if (index == 1) {
+                self->hedgeWins_.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        AsyncCompletion onComplete = std::move(race->onComplete);
+        onComplete(std::move(response), error);
+    }
+
+    void record(Endpoint endpoint, Clock::duration latency) {
+        LatencyWindow& window = *windows_.at(endpoint);
+        std::lock_guard<std::mutex> lock(window.mutex);
+        window.samples[window.next] = std::chrono::duration_cast<std::chrono::microseconds>(latency);
+        window.next = (window.next + 1) % window.samples.size();
+        window.count = std::min(window.count + 1, window.samples.size());
+        if (window.count < options_.minSamples) {
+            return;
+        }
+        if (window.threshold.count() != 0 && ++window.sinceUpdate < std::max<std::size_t>(1, window.samples.size() / 16)) {
+            return;
+        }
+        window.sinceUpdate = 0;
+        std::vector<std::chrono::microseconds> recent(window.samples.begin(), window.samples.begin() + window.count);
+        auto rank = recent.begin() + static_cast<std::ptrdiff_t>(options_.percentile * (recent.size() - 1));
+        std::nth_element(recent.begin(), rank, recent.end());
+        window.threshold = std::chrono::duration_cast<std::chrono::milliseconds>(*rank);
+        if (window.threshold.count() == 0) {
+            window.threshold = std::chrono::milliseconds(1);
+        }
+    }
+
+    HedgeOptions options_;
+    std::map<Endpoint, std::unique_ptr<LatencyWindow>> windows_;
+    std::mutex budgetMutex_;
+    double balance_ = 0;
+    std::atomic<std::uint64_t> requests_{0};
+    std::atomic<std::uint64_t> hedges_{0};
+    std::atomic<std::uint64_t> hedgeWins_{0};
+    std::atomic<std::uint64_t> budgetExhausted_{0};
+    Scheduler scheduler_; ///< Declared last: stopped before the state its tasks may use
+};
+
+} // namespace client
+} // namespace sauron
@@ -1,14 +1,32 @@
 #pragma once
 
+#include <chrono>
+#include <cstddef>
 #include <string>
 #include <vector>
 #include <functional>
 #include <memory>
 #include <nlohmann/json.hpp>
+#include "Cancellation.hpp"
+#include "TransportError.hpp"
+#include "../dto/BodyStream.hpp"
 
 namespace sauron {
 namespace client {
 
+/**
+ * @brief Transport measurements of one exchange
+ *
+ * Filled in by the built-in transports; zero where a transport does not
+ * measure a value.
+ */
+struct HttpTiming {
+    std::chrono::steady_clock::duration poolWait{};  ///< Time queued behind the per-origin connection limit
+    std::chrono::steady_clock::duration firstByte{}; ///< From the start of the send until the first response byte
+    std::size_t bytesSent = 0;                       ///< Request bytes written, head included
+    std::size_t bytesReceived = 0;                   ///< Response bytes read, head included
+};
+
 /**
  * @brief HTTP response structure
  */
@@ -16,6 +34,7 @@ struct HttpResponse {
     int statusCode;                  ///< HTTP status code
     std::string body;                ///< Response body
     std::vector<std::string> headers; ///< Response headers
+    HttpTiming timing;               ///< Transport measurements
 };
 
 /**
@@ -30,7 +49,9 @@ using StreamCallback = std::function<bool(const std::string& chunk, bool done)>;
 /**
  * @brief HTTP client interface
  * 
- * Abstract class for making HTTP requests
+ * Abstract class for making HTTP requests. Calls carry no per-call options;
+ * implementations should honour the deadline and cancellation token of the
+ * calling thread's CallScope, as the built-in one does.
  */
 class HttpClient {
 public:
@@ -113,6 +134,28 @@ public:
                              const std::string& contentType,
                              const std::vector<std::string>& headers = {}) = 0;
 
+    /**
+     * @brief Make a POST request with a body produced while it is sent
+     * 
+     * The built-in transports send the body with chunked transfer encoding,
+     * one piece at a time. The default implementation reads the whole body
+     * into a string and forwards to the string overload.
+     * 
+     * @param path The request path (will be appended to the base URL)
+     * @param body The request body, read from the start
+     * @param contentType The content type of the body
+     * @param headers Additional headers for this request
+     * @return HttpResponse The HTTP response
+     */
+    virtual HttpResponse post(const std::string& path,
+                             dto::BodyStream& body,
+                             const std::string& contentType,
+                             const std::vector<std::string>& headers = {}) {
+        std::string text;
+        body.readAll(text);
+        return post(path, text, contentType, headers);
+    }
+
     /**
      * @brief Make a streaming POST request with JSON body
      * 
@@ -127,9 +170,116 @@ public:
                           const StreamCallback& callback,
                           const std::vector<std::string>& headers = {}) = 0;
 
+    /**
+     * @brief Make a streaming POST request with a pre-serialized body
+     * 
+     * Lets callers that already hold the serialized body avoid a JSON DOM
+     * round trip. The default implementation parses the body and forwards
+     * to the JSON overload, so it only supports JSON content.
+     * 
+     * @param path The request path (will be appended to the base URL)
+     * @param body The request body
+     * @param contentType The content type of the body
+     * @param callback The callback function to handle streaming data
+     * @param headers Additional headers for this request
+     * @return int The HTTP status code
+     */
+    virtual int postStream(const std::string& path,
+                          const std::string& body,
+                          const std::string& contentType,
+                          const StreamCallback& callback,
+                          const std::vector<std::string>& headers = {}) {
+        (void)contentType;
+        return postStream(path, nlohmann::json::parse(body), callback, headers);
+    }
+
+    /**
+     * @brief Make a streaming POST request with a body produced while it is sent
+     * 
+     * Counterpart of the streamed post() for streaming responses. The
+     * default implementation reads the whole body into a string and
+     * forwards to the string overload.
+     * 
+     * @param path The request path (will be appended to the base URL)
+     * @param body The request body, read from the start
+     * @param contentType The content type of the body
+     * @param callback The callback function to handle streaming data
+     * @param headers Additional headers for this request
+     * @return int The HTTP status code
+     */
+    virtual int postStream(const std::string& path,
+                          dto::BodyStream& body,
+                          const std::string& contentType,
+                          const StreamCallback& callback,
+                          const std::vector<std::string>& headers = {}) {
+        std::string text;
+        body.readAll(text);
+        return postStream(path, text, contentType, callback, headers);
+    }
+
+    /**
+     * @brief Make a streaming POST request and return the whole response
+     *
+     * Like postStream(), but a body that is not passed to the callback,
+     * such as the error of a non-2xx response, is returned along with the
+     * status code and headers. The default implementation forwards to
+     * postStream() and returns the status code alone.
+     *
+     * @param path The request path (will be appended to the base URL)
+     * @param body The request body
+     * @param contentType The content type of the body
+     * @param callback The callback function to handle streaming data
+     * @param headers Additional headers for this request
+     * @return HttpResponse The response, with an empty body if it was streamed
+     */
+    virtual HttpResponse postStreamResponse(const std::string& path,
+                                            const std::string& body,
+                                            const std::string& contentType,
+                                            const StreamCallback& callback,
+                                            const std::vector<std::string>& headers = {}) {
+        return HttpResponse{postStream(path, body, contentType, callback, headers), std::string(), {}, {}};
+    }
+
+    /**
+     * @brief Make a streaming POST request with a body produced while it is sent, and return the whole response
+     *
+     * @param path The request path (will be appended to the base URL)
+     * @param body The request body, read from the start
+     * @param contentType The content type of the body
+     * @param callback The callback function to handle streaming data
+     * @param headers Additional headers for this request
+     * @return HttpResponse The response, with an empty body if it was streamed
+     * @see postStreamResponse(const std::string&, const std::string&, const std::string&, const StreamCallback&, const std::vector<std::string>&)
+     */
+    virtual HttpResponse postStreamResponse(const std::string& path,
+                                            dto::BodyStream& body,
+                                            const std::string& contentType,
+                                            const StreamCallback& callback,
+                                            const std::vector<std::string>& headers = {}) {
+        return HttpResponse{postStream(path, body, contentType, callback, headers), std::string(), {}, {}};
+    }
+
+    /**
+     * @brief Open connections to the base URL ahead of the first requests
+     * 
+     * The default implementation opens none; transports that pool
+     * connections override it.
+     * 
+     * @param connections Number of connections wanted
+     * @return std::size_t Number of connections opened
+     */
+    virtual std::size_t warmup(std::size_t connections) {
+        (void)connections;
+        return 0;
+    }
+
     /**
      * @brief Create a new HttpClient instance
      * 
+     * Defined by sauron/client/DefaultHttpClient.hpp, which returns the
+     * built-in SocketHttpClient (Linux only). Applications that bring their
+     * own transport may define it themselves instead.
+     * 
      * @param baseUrl Optional base URL
      * @return std::unique_ptr<HttpClient> A new HttpClient instance
      */
@@ -137,4 +287,4 @@ public:
 };
 
 } // namespace client
-} // namespace sauron 
\ No newline at end of file
+} // namespace sauron
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace sauron {
+namespace client {
+
+/**
+ * @brief Error raised when the API answers with an unsuccessful HTTP status
+ *
+ * Derives from std::runtime_error with the API's error message, so existing
+ * handlers keep working; the status code and response headers (e.g.
+ * Retry-After) remain available to callers that need them.
+ */
+class HttpStatusError : public std::runtime_error {
+public:
+    /**
+     * @brief Constructor
+     *
+     * @param statusCode The HTTP status code
+     * @param message The error message
+     * @param headers The response headers
+     */
+    HttpStatusError(int statusCode, const std::string& message, std::vector<std::string> headers = {})
+        : std::runtime_error(message), statusCode_(statusCode), headers_(std::move(headers)) {}
+
+    /**
+     * @brief Get the HTTP status code
+     */
+    int statusCode() const { return statusCode_; }
+
+    /**
+     * @brief Get the response headers
+     */
+    const std::vector<std::string>& headers() const { return headers_; }
+
+private:
+    int statusCode_;
+    std::vector<std::string> headers_;
+};
+
+} // namespace client
+} // namespace sauron
@@ -0,0 +1,539 @@
+#pragma once
+
+#include "TransportError.hpp"
+#include "../dto/BodyStream.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstddef>
+#include <cstdio>
+#include <functional>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <vector>
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/uio.h>
+#endif
+
+namespace sauron {
+namespace client {
+
+/**
+ * @brief Helpers for the HTTP/1.1 wire format shared by the built-in transports
+ */
+namespace wire {
+
+/**
+ * @brief Case-insensitive ASCII comparison of two header names
+ */
+inline bool equalsIgnoreCase(const std::string& a, const std::string& b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (std::size_t i = 0; i < a.size(); ++i) {
+        if (std::tolower(static_cast<unsigned char>(a[i])) != std::tolower(static_cast<unsigned char>(b[i]))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Extract the name part of a "Name: value" header line
+ */
+inline std::string headerName(const std::string& line) {
+    std::string::size_type colon = line.find(':');
+    return colon == std::string::npos ? line : line.substr(0, colon);
+}
+
+/**
+ * @brief Extract the trimmed value part of a "Name: value" header line
+ */
+inline std::string headerValue(const std::string& line) {
+    std::string::size_type colon = line.find(':');
+    if (colon == std::string::npos) {
+        return {};
+    }
+    std::string::size_type begin = line.find_first_not_of(" \t", colon + 1);
+    if (begin == std::string::npos) {
+        return {};
+    }
+    std::string::size_type end = line.find_last_not_of(" \t\r");
+    return line.substr(begin, end - begin + 1);
+}
+
+/**
+ * @brief Find a header value in a list of "Name: value" lines
+ *
+ * @param headers The header lines
+ * @param name The header name (case-insensitive)
+ * @param value Receives the value when found
+ * @return bool True if the header is present
+ */
+inline bool findHeader(const std::vector<std::string>& headers, const std::string& name, std::string& value) {
+    for (const auto& line : headers) {
+        if (equalsIgnoreCase(headerName(line), name)) {
+            value = headerValue(line);
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief contentLength of writeRequestHead for a chunked body
+ */
+constexpr std::size_t kChunked = static_cast<std::size_t>(-1);
+
+/**
+ * @brief Serialize an HTTP/1.1 request head
+ *
+ * Default headers are skipped when the per-request headers carry the same
+ * name, so a request can override e.g. Authorization without sending it twice.
+ *
+ * @param method Request method ("GET", "POST")
+ * @param target Request target (absolute path)
+ * @param host Value of the Host header
+ * @param defaultHeaders Headers applied to every request, as "Name: value" lines
+ * @param headers Per-request headers, as "Name: value" lines
+ * @param contentType Content type of the body (omitted when empty)
+ * @param contentLength Length of the body (omitted for GET without body), or
+ *        kChunked for a body sent with chunked transfer encoding
+ * @param out Buffer that receives the head; cleared first
+ */
+inline void writeRequestHead(const std::string& method,
+                             const std::string& target,
+                             const std::string& host,
+                             const std::vector<std::string>& defaultHeaders,
+                             const std::vector<std::string>& headers,
+                             const std::string& contentType,
+                             std::size_t contentLength,
+                             std::string& out) {
+    out.clear();
+    out.reserve(256 + target.size());
+    out.append(method).append(" ").append(target).append(" HTTP/1.1\r\n");
+    out.append("Host: ").append(host).append("\r\n");
+    out.append("Connection: keep-alive\r\n");
+    if (!contentType.empty()) {
+        out.append("Content-Type: ").append(contentType).append("\r\n");
+    }
+    if (contentLength == kChunked) {
+        out.append("Transfer-Encoding: chunked\r\n");
+    } else if (method != "GET" || contentLength > 0) {
+        out.append("Content-Length: ").append(std::to_string(contentLength)).append("\r\n");
+    }
+    for (const auto& line : defaultHeaders) {
+        std::string name = headerName(line);
+        bool overridden = false;
+        for (const auto& extra : headers) {
+            if (equalsIgnoreCase(headerName(extra), name)) {
+                overridden = true;
+                break;
+            }
+        }
+        if (!overridden) {
+            out.append(line).append("\r\n");
+        }
+    }
+    for (const auto& line : headers) {
+        out.append(line).append("\r\n");
+    }
+    out.append("\r\n");
+}
+
+#if defined(__unix__) || defined(__APPLE__)
+/**
+ * @brief Lays out a request head and a streamed, chunked body as iovecs
+ *
+ * For the socket transports' writev(); only built where there is one.
+ *
+ * Each piece of the body goes out as one chunk: size line, the piece itself
+ * and CRLF in a single writev, with the head in front of the first one.
+ * Pieces are only pulled from the body once everything before them has been
+ * written, so the body's buffer is never overwritten while still queued.
+ *
+ * The writer refers to the head and the body, which must outlive it, and
+ * points into itself, so it cannot be moved.
+ */
+class ChunkedBodyWriter {
+public:
+    static constexpr int kMaxIovecs = 4;
+
+    /**
+     * @brief Constructor
+     *
+     * @param head Request head, written first
+     * @param body Body, read from its current position
+     */
+    ChunkedBodyWriter(std::string_view head, dto::BodyStream& body) : body_(body) {
+        parts_[count_++] = head;
+        appendPiece();
+    }
+
+    ChunkedBodyWriter(const ChunkedBodyWriter&) = delete;
+    ChunkedBodyWriter& operator=(const ChunkedBodyWriter&) = delete;
+
+    /**
+     * @brief Describe the bytes still to write
+     *
+     * @param iov Receives up to kMaxIovecs entries
+     * @return int Number of entries; 0 once the request has been written
+     */
+    int pending(iovec* iov) {
+        if (first_ == count_ && !finished_) {
+            first_ = count_ = 0;
+            appendPiece();
+        }
+        for (int i = first_; i < count_; ++i) {
+            iov[i - first_].iov_base = const_cast<char*>(parts_[i].data());
+            iov[i - first_].iov_len = parts_[i].size();
+        }
+        return count_ - first_;
+    }
+
+    /**
+     * @brief Mark bytes returned by pending() as written
+     */
+    void advance(std::size_t written) {
+        while (written > 0 && first_ < count_) {
+            std::size_t size = parts_[first_].size();
+            if (written >= size) {
+                written -= size;
+                ++first_;
+            } else {
+                parts_[first_].remove_prefix(written);
+                written = 0;
+            }
+        }
+        while (first_ < count_ && parts_[first_].empty()) {
+            ++first_;
+        }
+    }
+
+private:
+    void appendPiece() {
+        std::string_view piece = body_.next();
+        if (piece.empty()) {
+            parts_[count_++] = std::string_view("0\r\n\r\n");
+            finished_ = true;
+            return;
+        }
+        int length = std::snprintf(sizeLine_, sizeof(sizeLine_), "%zx\r\n", piece.size());
+        parts_[count_++] = std::string_view(sizeLine_, static_cast<std::size_t>(length));
+        parts_[count_++] = piece;
+        parts_[count_++] = std::string_view("\r\n");
+    }
+
+    dto::BodyStream& body_;
+    std::string_view parts_[kMaxIovecs];
+    int first_ = 0;
+    int count_ = 0;
+    char sizeLine_[24];
+    bool finished_ = false;
+};
+#endif
+
+} // namespace wire
+
+/**
+ * @brief Incremental HTTP/1.1 response parser
+ *
+ * Bytes are fed as they arrive from the socket, in chunks of any size. Body
+ * bytes (after Content-Length or chunked framing has been removed) are
+ * pushed to a sink as soon as they are available, which lets the same parser
+ * serve buffered and streaming requests.
+ */
+class HttpResponseParser {
+public:
+    /**
+     * @brief Receives decoded body bytes
+     *
+     * @return bool False to abort parsing
+     */
+    using BodySink = std::function<bool(const char* data, std::size_t size)>;
+
+    HttpResponseParser() { reset(); }
+
+    /**
+     * @brief Prepare the parser for a new response
+     *
+     * @param noBody True if the response cannot carry a body (HEAD request)
+     */
+    void reset(bool noBody = false) {
+        state_ = State::StatusLine;
+        noBody_ = noBody;
+        statusCode_ = 0;
+        keepAlive_ = true;
+        chunked_ = false;
+        hasLength_ = false;
+        remaining_ = 0;
+        line_.clear();
+        headers_.clear();
+    }
+
+    /**
+     * @brief Feed received bytes to the parser
+     *
+     * @param data Received bytes
+     * @param size Number of bytes
+     * @param sink Receives decoded body bytes
+     * @return std::size_t Number of bytes consumed; less than size once the message is complete
+     * @throws TransportError if the response is malformed
+     */
+    std::size_t feed(const char* data, std::size_t size, const BodySink& sink) {
+        std::size_t pos = 0;
+        while (pos < size && state_ != State::Done && state_ != State::Aborted) {
+            switch (state_) {
+                case State::StatusLine:
+                case State::Headers:
+                case State::ChunkSize:
+                case State::ChunkDataEnd:
+                case State::Trailers: {
+                    if (!readLine(data, size, pos)) {
+                        break;
+                    }
+                    onLine();
+                    break;
+                }
+                case State::Body:
+                case State::ChunkData: {
+                    std::size_t n = std::min<std::size_t>(remaining_, size - pos);
+                    if (n > 0 && !sink(data + pos, n)) {
+                        state_ = State::Aborted;
+                        return pos + n;
+                    }
+                    pos += n;
+                    remaining_ -= n;
+                    if (remaining_ == 0) {
+                        state_ = state_ == State::Body ? State::Done : State::ChunkDataEnd;
+                    }
+                    break;
+                }
+                case State::UntilClose: {
+                    if (!sink(data + pos, size - pos)) {
+                        state_ = State::Aborted;
+                    }
+                    pos = size;
+                    break;
+                }
+                default:
+                    break;
+            }
+        }
+        return pos;
+    }
+
+    /**
+     * @brief Signal that the peer closed the connection
+     *
+     * @throws TransportError if the message was not complete
+     */
+    void finish() {
+        if (state_ == State::UntilClose) {
+            state_ = State::Done;
+            keepAlive_ = false;
+            return;
+        }
+        if (state_ != State::Done) {
+            throw TransportError("Connection closed before the response was complete", true);
+        }
+    }
+
+    bool headersComplete() const {
+        return state_ != State::StatusLine && state_ != State::Headers;
+    }
+
+    bool complete() const { return state_ == State::Done; }
+
+    bool aborted() const { return state_ == State::Aborted; }
+
+    bool started() const { return state_ != State::StatusLine || !line_.empty(); }
+
+    int statusCode() const { return statusCode_; }
+
+    /**
+     * @brief Whether the connection may carry another request after this response
+     */
+    bool keepAlive() const { return keepAlive_ && state_ == State::Done; }
+
+    const std::vector<std::string>& headers() const { return headers_; }
+
+    std::vector<std::string>& headers() { return headers_; }
+
+private:
+    enum class State {
+        StatusLine,
+        Headers,
+        Body,
+        ChunkSize,
+        ChunkData,
+        ChunkDataEnd,
+        Trailers,
+        UntilClose,
+        Done,
+        Aborted
+    };
+
+    static constexpr std::size_t kMaxLineLength = 64 * 1024;
+
+    bool readLine(const char* data, std::size_t size, std::size_t& pos) {
+        while (pos < size) {
+            char c = data[pos++];
+            if (c == '\n') {
+                if (!line_.empty() && line_.back() == '\r') {
+                    line_.pop_back();
+                }
+                return true;
+            }
+            line_.push_back(c);
+            if (line_.size() > kMaxLineLength) {
+                throw TransportError("HTTP response line too long", true);
+            }
+        }
+        return false;
+    }
+
+    void onLine() {
+        std::string line;
+        line.swap(line_);
+        switch (state_) {
+            case State::StatusLine:
+                parseStatusLine(line);
+                state_ = State::Headers;
+                break;
+            case State::Headers:
+                if (line.empty()) {
+                    onHeadersComplete();
+                } else {
+                    onHeader(line);
+                }
+                break;
+            case State::ChunkSize: {
+                std::size_t size = 0;
+                std::size_t digits = 0;
+                for (char c : line) {
+                    int v;
+                    if (c >= '0' && c <= '9') {
+                        v = c - '0';
+                    } else if (c >= 'a' && c <= 'f') {
+                        v = c - 'a' + 10;
+                    } else if (c >= 'A' && c <= 'F') {
+                        v = c - 'A' + 10;
+                    } else {
+                        break;
+                    }
+                    // A size that does not fit would wrap, possibly to 0, the last chunk
+                    if (size > (std::numeric_limits<std::size_t>::max() - static_cast<std::size_t>(v)) / 16) {
+                        throw TransportError("Malformed chunk size in HTTP response", true);
+                    }
+                    size = size * 16 + static_cast<std::size_t>(v);
+                    ++digits;
+                }
+                if (digits == 0) {
+                    throw TransportError("Malformed chunk size in HTTP response", true);
+                }
+                remaining_ = size;
+                state_ = size == 0 ? State::Trailers : State::ChunkData;
+                break;
+            }
+            case State::ChunkDataEnd:
+                if (!line.empty()) {
+                    throw TransportError("Malformed chunk terminator in HTTP response", true);
+                }
+                state_ = State::ChunkSize;
+                break;
+            case State::Trailers:
+                if (line.empty()) {
+                    state_ = State::Done;
+                }
+                break;
+            default:
+                break;
+        }
+    }
+
+    void parseStatusLine(const std::string& line) {
+        // HTTP/1.x SP status SP reason
+        if (line.compare(0, 5, "HTTP/") != 0) {
+            throw TransportError("Malformed HTTP status line: " + line, true);
+        }
+        std::string::size_type sp = line.find(' ');
+        if (sp == std::string::npos || sp + 4 > line.size()) {
+            throw TransportError("Malformed HTTP status line: " + line, true);
+        }
+        int code = 0;
+        for (std::size_t i = sp + 1; i < sp + 4; ++i) {
+            if (line[i] < '0' || line[i] > '9') {
+                throw TransportError("Malformed HTTP status line: " + line, true);
+            }
+            code = code * 10 + (line[i] - '0');
+        }
+        statusCode_ = code;
+        if (line.compare(0, 8, "HTTP/1.0") == 0) {
+            keepAlive_ = false;
+        }
+    }
+
+    void onHeader(const std::string& line) {
+        std::string name = wire::headerName(line);
+        std::string value = wire::headerValue(line);
+        if (wire::equalsIgnoreCase(name, "Content-Length")) {
+            remaining_ = 0;
+            for (char c : value) {
+                if (c < '0' || c > '9') {
+                    throw TransportError("Malformed Content-Length in HTTP response", true);
+                }
+                std::size_t digit = static_cast<std::size_t>(c - '0');
+                if (remaining_ > (std::numeric_limits<std::size_t>::max() - digit) / 10) {
+                    throw TransportError("Malformed Content-Length in HTTP response", true);
+                }
+                remaining_ = remaining_ * 10 + digit;
+            }
+            hasLength_ = true;
+        } else if (wire::equalsIgnoreCase(name, "Transfer-Encoding")) {
+            chunked_ = value.find("chunked") != std::string::npos;
+        } else if (wire::equalsIgnoreCase(name, "Connection")) {
+            if (wire::equalsIgnoreCase(value, "close")) {
+                keepAlive_ = false;
+            } else if (wire::equalsIgnoreCase(value, "keep-alive")) {
+                keepAlive_ = true;
+            }
+        }
+        headers_.push_back(line);
+    }
+
+    void onHeadersComplete() {
+        if (statusCode_ >= 100 && statusCode_ < 200) {
+            // Interim response (e.g. 100 Continue): wait for the final one.
+            headers_.clear();
+            hasLength_ = false;
+            chunked_ = false;
+            state_ = State::StatusLine;
+            return;
+        }
+        if (noBody_ || statusCode_ == 204 || statusCode_ == 304) {
+            state_ = State::Done;
+        } else if (chunked_) {
+            state_ = State::ChunkSize;
+        } else if (hasLength_) {
+            state_ = remaining_ == 0 ? State::Done : State::Body;
+        } else {
+            state_ = State::UntilClose;
+            keepAlive_ = false;
+        }
+        hasLength_ = false;
+    }
+
+    State state_ = State::StatusLine;
+    bool noBody_ = false;
+    int statusCode_ = 0;
+    bool keepAlive_ = true;
+    bool chunked_ = false;
+    bool hasLength_ = false;
+    std::size_t remaining_ = 0;
+    std::string line_;
+    std::vector<std::string> headers_;
+};
+
+} // namespace client
+} // namespace sauron
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "../util/Base64.hpp"
+#include <chrono>
+#include <optional>
+#include <string>
+#include <nlohmann/json.hpp>
+
+namespace sauron {
+namespace client {
+
+/**
+ * @brief Helpers for reading (not verifying) JWT claims
+ *
+ * The SDK never validates signatures; the server does. Claims are only read
+ * to schedule token refreshes.
+ */
+namespace jwt {
+
+/**
+ * @brief Decode the payload (claims) segment of a JWT
+ *
+ * @param token The JWT
+ * @return std::optional<nlohmann::json> The claims, or nothing if the token is not a well-formed JWT
+ */
+inline std::optional<nlohmann::json> claims(const std::string& token) {
+    std::string::size_type first = token.find('.');
+    if (first == std::string::npos) {
+        return std::nullopt;
+    }
+    std::string::size_type second = token.find('.', first + 1);
+    if (second == std::string::npos) {
+        return std::nullopt;
+    }
+    try {
+        std::string payload = util::base64::decode(std::string_view(token).substr(first + 1, second - first - 1));
+        nlohmann::json json = nlohmann::json::parse(payload);
+        if (!json.is_object()) {
+            return std::nullopt;
+        }
+        return json;
+    } catch (const std::exception&) {
+        return std::nullopt;
+    }
+}
+
+/**
+ * @brief Read the expiry ("exp" claim) of a JWT
+ *
+ * @param token The JWT
+ * @return std::optional<std::chrono::system_clock::time_point> The expiry, or nothing if absent,
+ *         not a number, or beyond what system_clock can represent
+ */
+inline std::optional<std::chrono::system_clock::time_point> expiry(const std::string& token) {
+    std::optional<nlohmann::json> json = claims(token);
+    if (!json || !json->contains("exp") || !(*json)["exp"].is_number()) {
+        return std::nullopt;
+    }
+    const double exp = (*json)["exp"].get<double>();
+    const double limit = static_cast<double>(
+        std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::duration::max()).count());
+    if (!(exp > -limit && exp < limit)) {
+        return std::nullopt;
+    }
+    auto seconds = std::chrono::seconds(static_cast<long long>(exp));
+    return std::chrono::system_clock::time_point(seconds);
+}
+
+} // namespace jwt
+
+} // namespace client
+} // namespace sauron
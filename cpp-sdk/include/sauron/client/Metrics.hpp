@@ -0,0 +1,319 @@
+#pragma once
+
+#include "../dto/AIProvider.hpp"
+#include "../util/HdrHistogram.hpp"
+#include "Endpoint.hpp"
+#include "HttpClient.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace sauron {
+namespace client {
+
+/**
+ * @brief One attempt as seen by Metrics
+ */
+struct RequestSample {
+    Endpoint endpoint = Endpoint::Query;
+    std::optional<dto::AIProvider> provider;        ///< Empty for endpoints without a provider
+    int statusCode = 0;                             ///< HTTP status; 0 if the attempt failed without one
+    std::chrono::steady_clock::duration latency{};  ///< From sending the request until it completed
+    HttpTiming timing;                              ///< Transport measurements; zero fields are skipped
+};
+
+/**
+ * @brief Identifies one metrics series
+ */
+struct SeriesKey {
+    Endpoint endpoint = Endpoint::Query;
+    std::optional<dto::AIProvider> provider;
+
+    bool operator<(const SeriesKey& other) const {
+        return endpoint != other.endpoint ? endpoint < other.endpoint : provider < other.provider;
+    }
+};
+
+/**
+ * @brief Metrics of one endpoint and provider
+ *
+ * Durations are in microseconds.
+ */
+struct SeriesMetrics {
+    util::HistogramSnapshot latency;    ///< Attempt latency
+    util::HistogramSnapshot firstByte;  ///< Time to the first response byte
+    util::HistogramSnapshot firstEvent; ///< Time to the first decoded stream event
+    std::uint64_t bytesSent = 0;        ///< Request bytes, head included where the transport reports it
+    std::uint64_t bytesReceived = 0;    ///< Response bytes, head included where the transport reports it
+    std::uint64_t errors = 0;           ///< Attempts that failed without an HTTP status
+    std::uint64_t retries = 0;          ///< Attempts after the first
+    std::uint64_t poolWaits = 0;        ///< Attempts that queued for a pooled connection
+    std::uint64_t poolWaitTime = 0;     ///< Total time spent queued for a pooled connection
+    std::map<int, std::uint64_t> statusCodes; ///< Responses per HTTP status
+
+    /**
+     * @brief Add another series' values to this one
+     */
+    void merge(const SeriesMetrics& other) {
+        latency.merge(other.latency);
+        firstByte.merge(other.firstByte);
+        firstEvent.merge(other.firstEvent);
+        bytesSent += other.bytesSent;
+        bytesReceived += other.bytesReceived;
+        errors += other.errors;
+        retries += other.retries;
+        poolWaits += other.poolWaits;
+        poolWaitTime += other.poolWaitTime;
+        for (const auto& entry : other.statusCodes) {
+            statusCodes[entry.first] += entry.second;
+        }
+    }
+};
+
+/**
+ * @brief Point-in-time copy of all metrics
+ */
+struct MetricsSnapshot {
+    std::map<SeriesKey, SeriesMetrics> series; ///< Series that recorded anything
+
+    /**
+     * @brief Metrics of one endpoint across all providers
+     */
+    SeriesMetrics total(Endpoint endpoint) const {
+        SeriesMetrics sum;
+        for (const auto& entry : series) {
+            if (entry.first.endpoint == endpoint) {
+                sum.merge(entry.second);
+            }
+        }
+        return sum;
+    }
+};
+
+/**
+ * @brief Per-endpoint, per-provider request metrics
+ *
+ * Every recording thread writes to its own shard of HDR histograms and
+ * counters without locks or read-modify-write instructions; snapshot()
+ * merges the shards. A shard is handed to a new thread once its thread
+ * exits, so memory grows with the number of concurrent threads, not the
+ * number of threads ever seen. A series is allocated by a shard the first
+ * time it records into it.
+ */
+class Metrics {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @brief Create a metrics registry
+     *
+     * @return std::shared_ptr<Metrics> The registry
+     */
+    static std::shared_ptr<Metrics> create() { return std::shared_ptr<Metrics>(new Metrics()); }
+
+    Metrics(const Metrics&) = delete;
+    Metrics& operator=(const Metrics&) = delete;
+
+    /**
+     * @brief Record one attempt
+     */
+    void record(const RequestSample& sample) {
+        Series& series = seriesFor(sample.endpoint, sample.provider);
+        series.latency.record(micros(sample.latency));
+        if (sample.timing.firstByte.count() > 0) {
+            series.firstByte.record(micros(sample.timing.firstByte));
+        }
+        add(series.bytesSent, sample.timing.bytesSent);
+        add(series.bytesReceived, sample.timing.bytesReceived);
+        if (sample.timing.poolWait.count() > 0) {
+            add(series.poolWaits, 1);
+            add(series.poolWaitTime, micros(sample.timing.poolWait));
+        }
+        if (sample.statusCode == 0) {
+            add(series.errors, 1);
+        } else {
+            int code = sample.statusCode;
+            add(series.statuses[code >= 100 && code < kMaxStatus ? code : 0], 1);
+        }
+    }
+
+    /**
+     * @brief Record the time from sending a stream request to its first decoded event
+     */
+    void recordFirstEvent(Endpoint endpoint, std::optional<dto::AIProvider> provider, Clock::duration elapsed) {
+        seriesFor(endpoint, provider).firstEvent.record(micros(elapsed));
+    }
+
+    /**
+     * @brief Count an attempt after the first
+     */
+    void recordRetry(Endpoint endpoint, std::optional<dto::AIProvider> provider) {
+        add(seriesFor(endpoint, provider).retries, 1);
+    }
+
+    /**
+     * @brief Merge every thread's metrics
+     *
+     * Safe to call while other threads record; values recorded concurrently
+     * may or may not be included.
+     */
+    MetricsSnapshot snapshot() const {
+        MetricsSnapshot snapshot;
+        std::lock_guard<std::mutex> lock(registry_->mutex);
+        for (const auto& shard : registry_->shards) {
+            for (std::size_t index = 0; index < kSeriesCount; ++index) {
+                const Series* series = shard->series[index].load(std::memory_order_acquire);
+                if (series == nullptr) {
+                    continue;
+                }
+                SeriesMetrics& out = snapshot.series[keyOf(index)];
+                series->latency.snapshotInto(out.latency);
+                series->firstByte.snapshotInto(out.firstByte);
+                series->firstEvent.snapshotInto(out.firstEvent);
+                out.bytesSent += load(series->bytesSent);
+                out.bytesReceived += load(series->bytesReceived);
+                out.errors += load(series->errors);
+                out.retries += load(series->retries);
+                out.poolWaits += load(series->poolWaits);
+                out.poolWaitTime += load(series->poolWaitTime);
+                for (int code = 0; code < kMaxStatus; ++code) {
+                    if (std::uint64_t n = load(series->statuses[static_cast<std::size_t>(code)])) {
+                        out.statusCodes[code] += n;
+                    }
+                }
+            }
+        }
+        return snapshot;
+    }
+
+private:
+    static constexpr int kMaxStatus = 600; ///< Statuses outside [100, 600) are counted under 0
+    static constexpr std::size_t kEndpointCount = 6;
+    static constexpr std::size_t kProviderSlots = 6; ///< No provider, then each dto::AIProvider
+    static constexpr std::size_t kSeriesCount = kEndpointCount * kProviderSlots;
+
+    struct Series {
+        util::HdrHistogram latency;
+        util::HdrHistogram firstByte;
+        util::HdrHistogram firstEvent;
+        std::atomic<std::uint64_t> bytesSent{0};
+        std::atomic<std::uint64_t> bytesReceived{0};
+        std::atomic<std::uint64_t> errors{0};
+        std::atomic<std::uint64_t> retries{0};
+        std::atomic<std::uint64_t> poolWaits{0};
+        std::atomic<std::uint64_t> poolWaitTime{0};
+        std::array<std::atomic<std::uint64_t>, kMaxStatus> statuses{};
+    };
+
+    /// Written by one thread at a time; read by snapshot().
+    struct Shard {
+        std::array<std::atomic<Series*>, kSeriesCount> series{};
+        std::vector<std::unique_ptr<Series>> owned;
+        bool claimed = true; ///< Guarded by Registry::mutex
+    };
+
+    /// Outlives the Metrics object while threads still hold shards.
+    struct Registry {
+        std::mutex mutex;
+        std::vector<std::unique_ptr<Shard>> shards;
+    };
+
+    /// A thread's shards, one per registry; returned to their registries on thread exit.
+    struct ThreadShards {
+        struct Entry {
+            std::weak_ptr<Registry> registry;
+            Shard* shard;
+        };
+        std::vector<Entry> entries;
+
+        ~ThreadShards() {
+            for (auto& entry : entries) {
+                if (std::shared_ptr<Registry> registry = entry.registry.lock()) {
+                    std::lock_guard<std::mutex> lock(registry->mutex);
+                    entry.shard->claimed = false;
+                }
+            }
+        }
+    };
+
+    Metrics() : registry_(std::make_shared<Registry>()) {}
+
+    Shard& shard() {
+        thread_local ThreadShards mine;
+        for (auto& entry : mine.entries) {
+            if (!entry.registry.owner_before(registry_) && !registry_.owner_before(entry.registry)) {
+                return *entry.shard;
+            }
+        }
+        // Forget shards of registries that are gone before adding one.
+        mine.entries.erase(std::remove_if(mine.entries.begin(), mine.entries.end(),
+                                          [](const ThreadShards::Entry& entry) { return entry.registry.expired(); }),
+                           mine.entries.end());
+        Shard* shard = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(registry_->mutex);
+            for (auto& candidate : registry_->shards) {
+                if (!candidate->claimed) {
+                    candidate->claimed = true;
+                    shard = candidate.get();
+                    break;
+                }
+            }
+            if (shard == nullptr) {
+                registry_->shards.push_back(std::make_unique<Shard>());
+                shard = registry_->shards.back().get();
+            }
+        }
+        mine.entries.push_back(ThreadShards::Entry{registry_, shard});
+        return *shard;
+    }
+
+    Series& seriesFor(Endpoint endpoint, std::optional<dto::AIProvider> provider) {
+        std::size_t index = static_cast<std::size_t>(endpoint) * kProviderSlots +
+                            (provider ? static_cast<std::size_t>(*provider) + 1 : 0);
+        Shard& owner = shard();
+        Series* series = owner.series[index].load(std::memory_order_relaxed);
+        if (series == nullptr) {
+            owner.owned.push_back(std::make_unique<Series>());
+            series = owner.owned.back().get();
+            owner.series[index].store(series, std::memory_order_release);
+        }
+        return *series;
+    }
+
+    static SeriesKey keyOf(std::size_t index) {
+        SeriesKey key;
+        key.endpoint = static_cast<Endpoint>(index / kProviderSlots);
+        std::size_t slot = index % kProviderSlots;
+        if (slot != 0) {
+            key.provider = static_cast<dto::AIProvider>(slot - 1);
+        }
+        return key;
+    }
+
+    static std::uint64_t micros(Clock::duration duration) {
+        auto us = std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+        return us < 0 ? 0 : static_cast<std::uint64_t>(us);
+    }
+
+    static void add(std::atomic<std::uint64_t>& counter, std::uint64_t by) {
+        counter.store(counter.load(std::memory_order_relaxed) + by, std::memory_order_relaxed);
+    }
+
+    static std::uint64_t load(const std::atomic<std::uint64_t>& counter) {
+        return counter.load(std::memory_order_relaxed);
+    }
+
+    std::shared_ptr<Registry> registry_;
+};
+
+} // namespace client
+} // namespace sauron
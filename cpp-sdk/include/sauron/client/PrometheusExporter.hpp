@@ -0,0 +1,113 @@
+#pragma once
+
+#include "Metrics.hpp"
+#include <cstdint>
+#include <functional>
+#include <sstream>
+#include <string>
+
+namespace sauron {
+namespace client {
+
+/**
+ * @brief Prometheus text exposition of Metrics snapshots
+ */
+namespace prometheus {
+
+namespace detail {
+
+inline std::string labels(const SeriesKey& key, const std::string& extra = "") {
+    std::string out = "{endpoint=\"";
+    out += endpointPath(key.endpoint);
+    out += '"';
+    if (key.provider) {
+        out += ",provider=\"" + dto::AIProviderToString(*key.provider) + '"';
+    }
+    if (!extra.empty()) {
+        out += ',' + extra;
+    }
+    out += '}';
+    return out;
+}
+
+inline void header(std::ostringstream& out, const std::string& name, const char* type, const char* help) {
+    out << "# HELP " << name << ' ' << help << '\n' << "# TYPE " << name << ' ' << type << '\n';
+}
+
+inline void summary(std::ostringstream& out, const MetricsSnapshot& snapshot, const std::string& name,
+                    const char* help, const util::HistogramSnapshot SeriesMetrics::*histogram) {
+    header(out, name, "summary", help);
+    for (const auto& entry : snapshot.series) {
+        const util::HistogramSnapshot& values = entry.second.*histogram;
+        if (values.count() == 0) {
+            continue;
+        }
+        for (double quantile : {0.5, 0.9, 0.99, 0.999}) {
+            std::ostringstream q;
+            q << "quantile=\"" << quantile << '"';
+            out << name << labels(entry.first, q.str()) << ' ' << values.valueAtQuantile(quantile) / 1e6 << '\n';
+        }
+        out << name << "_sum" << labels(entry.first) << ' ' << values.sum() / 1e6 << '\n';
+        out << name << "_count" << labels(entry.first) << ' ' << values.count() << '\n';
+    }
+}
+
+inline void counter(std::ostringstream& out, const MetricsSnapshot& snapshot, const std::string& name,
+                    const char* help, const std::function<double(const SeriesMetrics&)>& value) {
+    header(out, name, "counter", help);
+    for (const auto& entry : snapshot.series) {
+        out << name << labels(entry.first) << ' ' << value(entry.second) << '\n';
+    }
+}
+
+} // namespace detail
+
+/**
+ * @brief Render a snapshot in the Prometheus text format (version 0.0.4)
+ *
+ * Latencies are exported as summaries in seconds, with 0.5, 0.9, 0.99 and
+ * 0.999 quantiles; everything else as counters.
+ *
+ * @param snapshot The snapshot, e.g. from Metrics::snapshot()
+ * @param prefix Prepended to every metric name
+ * @return std::string The exposition, ready to serve on /metrics
+ */
+inline std::string format(const MetricsSnapshot& snapshot, const std::string& prefix = "sauron_") {
+    std::ostringstream out;
+    out.imbue(std::locale::classic());
+    out.precision(9);
+    detail::summary(out, snapshot, prefix + "request_duration_seconds", "Latency of each attempt.",
+                    &SeriesMetrics::latency);
+    detail::summary(out, snapshot, prefix + "time_to_first_byte_seconds", "Time until the first response byte.",
+                    &SeriesMetrics::firstByte);
+    detail::summary(out, snapshot, prefix + "time_to_first_event_seconds", "Time until the first stream event.",
+                    &SeriesMetrics::firstEvent);
+
+    const std::string responses = prefix + "responses_total";
+    detail::header(out, responses, "counter", "Responses by HTTP status code.");
+    for (const auto& entry : snapshot.series) {
+        for (const auto& status : entry.second.statusCodes) {
+            out << responses << detail::labels(entry.first, "code=\"" + std::to_string(status.first) + '"') << ' '
+                << status.second << '\n';
+        }
+    }
+
+    detail::counter(out, snapshot, prefix + "transport_errors_total", "Attempts that failed without a response.",
+                    [](const SeriesMetrics& m) { return static_cast<double>(m.errors); });
+    detail::counter(out, snapshot, prefix + "retries_total", "Attempts after the first.",
+                    [](const SeriesMetrics& m) { return static_cast<double>(m.retries); });
+    detail::counter(out, snapshot, prefix + "bytes_sent_total", "Request bytes sent.",
+                    [](const SeriesMetrics& m) { return static_cast<double>(m.bytesSent); });
+    detail::counter(out, snapshot, prefix + "bytes_received_total", "Response bytes received.",
+                    [](const SeriesMetrics& m) { return static_cast<double>(m.bytesReceived); });
+    detail::counter(out, snapshot, prefix + "pool_waits_total", "Attempts that queued for a pooled connection.",
+                    [](const SeriesMetrics& m) { return static_cast<double>(m.poolWaits); });
+    detail::counter(out, snapshot, prefix + "pool_wait_seconds_total", "Time spent queued for a pooled connection.",
+                    [](const SeriesMetrics& m) { return m.poolWaitTime / 1e6; });
+    return out.str();
+}
+
+} // namespace prometheus
+
+} // namespace client
+} // namespace sauron
@@ -0,0 +1,531 @@
+#pragma once
+
+#include "Cancellation.hpp"
+#include "../dto/AIProvider.hpp"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace sauron {
+namespace client {
+
+/**
+ * @brief Tuning knobs for the adaptive (AIMD) concurrency controller
+ */
+struct AimdOptions {
+    double initialLimit = 16;     ///< Concurrent requests allowed before any feedback
+    double minLimit = 1;          ///< Floor the limit never drops below
+    double maxLimit = 256;        ///< Ceiling the limit never grows past
+    double backoffRatio = 0.5;    ///< Multiplier applied to the limit on overload
+    double latencyTolerance = 2.0; ///< Recent latency above this multiple of the long-term average counts as overload
+};
+
+/**
+ * @brief Limits applied to one provider
+ */
+struct ProviderRateLimit {
+    double requestsPerSecond = 0; ///< Token bucket refill rate; zero disables the bucket
+    double burst = 0;             ///< Token bucket capacity; zero means max(1, requestsPerSecond)
+    bool adaptive = true;         ///< Whether the AIMD controller caps concurrency
+    AimdOptions aimd;             ///< AIMD tuning
+};
+
+/**
+ * @brief Options for RateLimiter
+ */
+struct RateLimiterOptions {
+    ProviderRateLimit defaults;                         ///< Limits for providers without an entry below
+    std::map<dto::AIProvider, ProviderRateLimit> providers; ///< Per-provider overrides
+};
+
+/**
+ * @brief Current state of one provider's limiter
+ */
+struct RateLimiterStats {
+    double concurrencyLimit = 0; ///< Current AIMD limit (0 when not adaptive)
+    std::size_t inFlight = 0;    ///< Permits currently held
+    std::size_t waiting = 0;     ///< Callers queued for a permit
+    std::uint64_t granted = 0;   ///< Permits granted so far
+    std::uint64_t backoffs = 0;  ///< Multiplicative decreases so far
+};
+
+/**
+ * @brief Client-side governor for upstream requests, per provider
+ *
+ * Each provider has a token bucket bounding its request rate and an AIMD
+ * controller bounding its concurrency. The controller grows the limit by
+ * roughly one request per round trip while responses are healthy and
+ * multiplies it by backoffRatio on 429, 5xx, transport failures or a
+ * latency spike, at most once per round trip. Callers wait in FIFO order.
+ */
+class RateLimiter : public std::enable_shared_from_this<RateLimiter> {
+    struct Lane;
+
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @brief Right to send one request; report its outcome before dropping it
+     *
+     * A permit dropped without an outcome is released without feedback.
+     */
+    class Permit {
+    public:
+        Permit() = default;
+        ~Permit() { release(); }
+
+        Permit(Permit&& other) noexcept { *this = std::move(other); }
+        Permit& operator=(Permit&& other) noexcept {
+            if (this != &other) {
+                release();
+                owner_ = std::move(other.owner_);
+                lane_ = other.lane_;
+                epoch_ = other.epoch_;
+                grantedAt_ = other.grantedAt_;
+                other.lane_ = nullptr;
+            }
+            return *this;
+        }
+        Permit(const Permit&) = delete;
+        Permit& operator=(const Permit&) = delete;
+
+        /**
+         * @brief Report the response and release the permit
+         *
+         * @param statusCode The HTTP status code
+         * @param sampleLatency False for streams, whose duration says little about load
+         */
+        void complete(int statusCode, bool sampleLatency = true) {
+            bool overloaded = statusCode == 429 || statusCode >= 500;
+            finish(overloaded ? Outcome::Overloaded : Outcome::Success, sampleLatency);
+        }
+
+        /**
+         * @brief Report a transport failure and release the permit
+         */
+        void fail() { finish(Outcome::Overloaded, false); }
+
+        /**
+         * @brief Release the permit without feedback
+         */
+        void release() { finish(Outcome::Neutral, false); }
+
+    private:
+        friend class RateLimiter;
+
+        enum class Outcome { Success, Overloaded, Neutral };
+
+        void finish(Outcome outcome, bool sampleLatency) {
+            if (lane_) {
+                Lane* lane = lane_;
+                lane_ = nullptr;
+                owner_->finish(*lane, epoch_, grantedAt_, outcome, sampleLatency);
+                owner_.reset();
+            }
+        }
+
+        std::shared_ptr<RateLimiter> owner_;
+        Lane* lane_ = nullptr;
+        std::uint64_t epoch_ = 0;
+        Clock::time_point grantedAt_;
+    };
+
+    /**
+     * @brief Receives a granted permit
+     */
+    using GrantCallback = std::function<void(Permit permit)>;
+
+    /**
+     * @brief Receives the error of a wait that ended without a permit
+     */
+    using StopCallback = std::function<void(std::exception_ptr error)>;
+
+    /**
+     * @brief Create a limiter
+     *
+     * @param options Per-provider limits
+     * @return std::shared_ptr<RateLimiter> The limiter
+     */
+    static std::shared_ptr<RateLimiter> create(const RateLimiterOptions& options = {}) {
+        return std::shared_ptr<RateLimiter>(new RateLimiter(options));
+    }
+
+    ~RateLimiter() {
+        {
+            std::lock_guard<std::mutex> lock(timer_->mutex);
+            timer_->stopping = true;
+        }
+        timer_->wake.notify_all();
+        if (timerThread_.joinable()) {
+            if (timerThread_.get_id() == std::this_thread::get_id()) {
+                timerThread_.detach(); // the last permit was released by a grant on the timer thread
+            } else {
+                timerThread_.join();
+            }
+        }
+    }
+
+    RateLimiter(const RateLimiter&) = delete;
+    RateLimiter& operator=(const RateLimiter&) = delete;
+
+    /**
+     * @brief Wait for a permit
+     *
+     * @param provider The provider the request goes to
+     * @param call Optional deadline and cancellation token bounding the wait
+     * @return Permit The permit
+     * @throws DeadlineExceeded if the deadline passes first
+     * @throws RequestCancelled if the token is cancelled first
+     */
+    Permit acquire(dto::AIProvider provider, const CallOptions* call = nullptr) {
+        auto promise = std::make_shared<std::promise<Permit>>();
+        std::future<Permit> future = promise->get_future();
+        acquireAsync(provider, [promise](Permit permit) { promise->set_value(std::move(permit)); },
+                     call ? *call : CallOptions(),
+                     [promise](std::exception_ptr error) { promise->set_exception(error); });
+        return future.get();
+    }
+
+    /**
+     * @brief Request a permit without blocking
+     *
+     * @param provider The provider the request goes to
+     * @param onGranted Called with the permit: on the calling thread when one
+     *        is available right away, otherwise on the thread that releases a
+     *        permit or on the limiter's timer thread. Must not block.
+     */
+    void acquireAsync(dto::AIProvider provider, GrantCallback onGranted) {
+        acquireAsync(provider, std::move(onGranted), CallOptions(), nullptr);
+    }
+
+    /**
+     * @brief Request a permit without blocking, giving up when the call must stop
+     *
+     * A waiter that gives up leaves the queue without using a token.
+     *
+     * @param provider The provider the request goes to
+     * @param onGranted Called with the permit, as above
+     * @param call Deadline and cancellation token bounding the wait
+     * @param onStopped Called instead with DeadlineExceeded or RequestCancelled:
+     *        on the limiter's timer thread, on the thread cancelling the token,
+     *        or on the calling thread if the call is already over. Must not block.
+     */
+    void acquireAsync(dto::AIProvider provider, GrantCallback onGranted, const CallOptions& call,
+                      StopCallback onStopped) {
+        if (call.stopped()) {
+            onStopped(call.stopError());
+            return;
+        }
+        Lane& lane = laneFor(provider);
+        std::uint64_t id;
+        {
+            std::lock_guard<std::mutex> lock(lane.mutex);
+            id = ++lane.lastWaiter;
+            Waiter waiter;
+            waiter.id = id;
+            waiter.onGranted = std::move(onGranted);
+            waiter.onStopped = std::move(onStopped);
+            waiter.deadline = call.deadline;
+            if (waiter.deadline != Clock::time_point::max()) {
+                ++lane.timedWaiters;
+            }
+            lane.waiters.push_back(std::move(waiter));
+        }
+        if (call.cancellation) {
+            std::weak_ptr<RateLimiter> weak = weak_from_this();
+            Lane* target = &lane;
+            CancellationToken::Registration registration = call.cancellation->onCancel([weak, target, id] {
+                if (std::shared_ptr<RateLimiter> self = weak.lock()) {
+                    self->abandon(*target, id, std::make_exception_ptr(RequestCancelled()));
+                }
+            });
+            if (call.cancellation->isCancelled()) {
+                abandon(lane, id, std::make_exception_ptr(RequestCancelled()));
+            } else {
+                std::lock_guard<std::mutex> lock(lane.mutex);
+                auto it = findWaiter(lane, id);
+                if (it != lane.waiters.end()) {
+                    it->registration = std::move(registration);
+                }
+            }
+            // An unattached registration is dropped here, outside the lane lock its callback takes.
+        }
+        drain(lane);
+    }
+
+    /**
+     * @brief Get the state of one provider's limiter
+     */
+    RateLimiterStats stats(dto::AIProvider provider) {
+        Lane& lane = laneFor(provider);
+        std::lock_guard<std::mutex> lock(lane.mutex);
+        RateLimiterStats stats;
+        stats.concurrencyLimit = lane.options.adaptive ? lane.limit : 0;
+        stats.inFlight = lane.inFlight;
+        stats.waiting = lane.waiters.size();
+        stats.granted = lane.granted;
+        stats.backoffs = lane.backoffs;
+        return stats;
+    }
+
+private:
+    struct Waiter {
+        std::uint64_t id = 0;
+        GrantCallback onGranted;
+        StopCallback onStopped;
+        Clock::time_point deadline = Clock::time_point::max();
+        CancellationToken::Registration registration; ///< Destroy outside the lane lock
+    };
+
+    struct Lane {
+        ProviderRateLimit options;
+        std::mutex mutex;
+        double tokens = 0;
+        Clock::time_point refilledAt;
+        double limit = 0;
+        std::size_t inFlight = 0;
+        std::uint64_t epoch = 0;          ///< Bumped on every decrease; older permits cannot decrease again
+        double recentLatencyMs = 0;       ///< Fast EWMA of response latency
+        double baselineLatencyMs = 0;     ///< Slow EWMA of response latency
+        std::uint64_t latencySamples = 0;
+        std::deque<Waiter> waiters;
+        std::uint64_t lastWaiter = 0;
+        std::size_t timedWaiters = 0; ///< Waiters with a deadline
+        std::uint64_t granted = 0;
+        std::uint64_t backoffs = 0;
+    };
+
+    static constexpr std::uint64_t kMinLatencySamples = 20;
+
+    explicit RateLimiter(const RateLimiterOptions& options) {
+        for (dto::AIProvider provider : {dto::AIProvider::OPENAI, dto::AIProvider::ANTHROPIC,
+                                         dto::AIProvider::GOOGLE, dto::AIProvider::MISTRAL,
+                                         dto::AIProvider::CUSTOM}) {
+            auto lane = std::make_unique<Lane>();
+            auto it = options.providers.find(provider);
+            lane->options = it != options.providers.end() ? it->second : options.defaults;
+            if (lane->options.burst <= 0) {
+                lane->options.burst = std::max(1.0, lane->options.requestsPerSecond);
+            }
+            lane->tokens = lane->options.burst;
+            lane->refilledAt = Clock::now();
+            lane->limit = std::min(std::max(lane->options.aimd.initialLimit, lane->options.aimd.minLimit),
+                                   lane->options.aimd.maxLimit);
+            lanes_.emplace(provider, std::move(lane));
+        }
+    }
+
+    Lane& laneFor(dto::AIProvider provider) { return *lanes_.at(provider); }
+
+    /// Grants what the lane allows now, and schedules a timer if the head waiter lacks a token.
+    void drain(Lane& lane) {
+        std::vector<std::pair<Waiter, Permit>> grants;
+        std::vector<Waiter> expired;
+        std::optional<Clock::time_point> retryAt;
+        {
+            std::lock_guard<std::mutex> lock(lane.mutex);
+            Clock::time_point now = Clock::now();
+            const ProviderRateLimit& options = lane.options;
+            if (options.requestsPerSecond > 0) {
+                double elapsed = std::chrono::duration<double>(now - lane.refilledAt).count();
+                lane.tokens = std::min(options.burst, lane.tokens + elapsed * options.requestsPerSecond);
+                lane.refilledAt = now;
+            }
+            if (lane.timedWaiters > 0) {
+                retryAt = expire(lane, now, expired);
+            }
+            while (!lane.waiters.empty()) {
+                if (options.adaptive && lane.inFlight >= std::max<std::size_t>(1, static_cast<std::size_t>(lane.limit))) {
+                    break; // a release will drain again
+                }
+                if (options.requestsPerSecond > 0) {
+                    if (lane.tokens < 1) {
+                        double wait = (1 - lane.tokens) / options.requestsPerSecond;
+                        Clock::time_point refillAt =
+                            now + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(wait));
+                        retryAt = retryAt ? std::min(*retryAt, refillAt) : refillAt;
+                        break;
+                    }
+                    lane.tokens -= 1;
+                }
+                ++lane.inFlight;
+                ++lane.granted;
+                Permit permit;
+                permit.owner_ = shared_from_this();
+                permit.lane_ = &lane;
+                permit.epoch_ = lane.epoch;
+                permit.grantedAt_ = now;
+                if (lane.waiters.front().deadline != Clock::time_point::max()) {
+                    --lane.timedWaiters;
+                }
+                grants.emplace_back(std::move(lane.waiters.front()), std::move(permit));
+                lane.waiters.pop_front();
+            }
+        }
+        if (retryAt) {
+            scheduleDrain(*retryAt);
+        }
+        for (Waiter& waiter : expired) {
+            stop(waiter, std::make_exception_ptr(DeadlineExceeded()));
+        }
+        for (auto& grant : grants) {
+            try {
+                grant.first.onGranted(std::move(grant.second));
+            } catch (...) {
+                // The permit was released when the callback's copy was destroyed.
+            }
+        }
+    }
+
+    /// Moves waiters past their deadline to expired; returns the earliest deadline left, if any.
+    static std::optional<Clock::time_point> expire(Lane& lane, Clock::time_point now, std::vector<Waiter>& expired) {
+        std::optional<Clock::time_point> next;
+        for (auto it = lane.waiters.begin(); it != lane.waiters.end();) {
+            if (it->deadline <= now) {
+                expired.push_back(std::move(*it));
+                it = lane.waiters.erase(it);
+                --lane.timedWaiters;
+                continue;
+            }
+            if (it->deadline != Clock::time_point::max()) {
+                next = next ? std::min(*next, it->deadline) : it->deadline;
+            }
+            ++it;
+        }
+        return next;
+    }
+
+    static std::deque<Waiter>::iterator findWaiter(Lane& lane, std::uint64_t id) {
+        return std::find_if(lane.waiters.begin(), lane.waiters.end(),
+                            [id](const Waiter& waiter) { return waiter.id == id; });
+    }
+
+    /// Takes a waiter out of the queue without granting it.
+    void abandon(Lane& lane, std::uint64_t id, std::exception_ptr error) {
+        Waiter waiter;
+        {
+            std::lock_guard<std::mutex> lock(lane.mutex);
+            auto it = findWaiter(lane, id);
+            if (it == lane.waiters.end()) {
+                return;
+            }
+            waiter = std::move(*it);
+            lane.waiters.erase(it);
+            if (waiter.deadline != Clock::time_point::max()) {
+                --lane.timedWaiters;
+            }
+        }
+        stop(waiter, std::move(error));
+    }
+
+    static void stop(Waiter& waiter, std::exception_ptr error) {
+        if (!waiter.onStopped) {
+            return;
+        }
+        try {
+            waiter.onStopped(std::move(error));
+        } catch (...) {
+            // Reported by the caller's own handler; nothing else to do.
+        }
+    }
+
+    void finish(Lane& lane, std::uint64_t epoch, Clock::time_point grantedAt,
+                Permit::Outcome outcome, bool sampleLatency) {
+        {
+            std::lock_guard<std::mutex> lock(lane.mutex);
+            --lane.inFlight;
+            const AimdOptions& aimd = lane.options.aimd;
+            bool overloaded = outcome == Permit::Outcome::Overloaded;
+            if (outcome == Permit::Outcome::Success && sampleLatency) {
+                double ms = std::chrono::duration<double, std::milli>(Clock::now() - grantedAt).count();
+                if (lane.latencySamples++ == 0) {
+                    lane.recentLatencyMs = ms;
+                    lane.baselineLatencyMs = ms;
+                } else {
+                    lane.recentLatencyMs += 0.2 * (ms - lane.recentLatencyMs);
+                    lane.baselineLatencyMs += 0.01 * (ms - lane.baselineLatencyMs);
+                }
+                overloaded = lane.latencySamples >= kMinLatencySamples &&
+                             lane.recentLatencyMs > aimd.latencyTolerance * lane.baselineLatencyMs;
+            }
+            if (lane.options.adaptive && outcome != Permit::Outcome::Neutral) {
+                if (overloaded) {
+                    if (epoch == lane.epoch) {
+                        lane.limit = std::max(aimd.minLimit, lane.limit * aimd.backoffRatio);
+                        ++lane.epoch;
+                        ++lane.backoffs;
+                    }
+                } else if ((lane.inFlight + 1) * 2 >= lane.limit) {
+                    // Only grow while the limit is actually being used.
+                    lane.limit = std::min(aimd.maxLimit, lane.limit + 1 / lane.limit);
+                }
+            }
+        }
+        drain(lane);
+    }
+
+    /// Timer state shared with the timer thread, which must not keep the limiter alive while it sleeps.
+    struct Timer {
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::optional<Clock::time_point> next;
+        bool stopping = false;
+    };
+
+    void scheduleDrain(Clock::time_point at) {
+        std::lock_guard<std::mutex> lock(timer_->mutex);
+        if (timer_->stopping) {
+            return;
+        }
+        if (!timerThread_.joinable()) {
+            timerThread_ = std::thread(runTimer, timer_, weak_from_this());
+        }
+        if (!timer_->next || at < *timer_->next) {
+            timer_->next = at;
+            timer_->wake.notify_all();
+        }
+    }
+
+    static void runTimer(std::shared_ptr<Timer> timer, std::weak_ptr<RateLimiter> weak) {
+        std::unique_lock<std::mutex> lock(timer->mutex);
+        while (!timer->stopping) {
+            if (!timer->next) {
+                timer->wake.wait(lock);
+                continue;
+            }
+            Clock::time_point at = *timer->next;
+            if (timer->wake.wait_until(lock, at, [&] { return timer->stopping || !timer->next || *timer->next < at; })) {
+                continue;
+            }
+            timer->next.reset();
+            lock.unlock();
+            if (std::shared_ptr<RateLimiter> self = weak.lock()) {
+                // drain() reschedules through scheduleDrain() for lanes still short of tokens.
+                for (auto& entry : self->lanes_) {
+                    self->drain(*entry.second);
+                }
+                // Releasing self may destroy the limiter on this thread; only the timer state is touched after.
+            }
+            lock.lock();
+        }
+    }
+
+    std::map<dto::AIProvider, std::unique_ptr<Lane>> lanes_;
+    std::shared_ptr<Timer> timer_ = std::make_shared<Timer>();
+    std::thread timerThread_; ///< Wakes waiters short of tokens; started on first need
+};
+
+} // namespace client
+} // namespace sauron
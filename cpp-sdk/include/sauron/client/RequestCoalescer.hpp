@@ -0,0 +1,385 @@
+#pragma once
+
+#include "AsyncHttpClient.hpp"
+#include "HttpClient.hpp"
+#include "ResponseCache.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace sauron {
+namespace client {
+
+/**
+ * @brief Counters of a RequestCoalescer
+ */
+struct RequestCoalescerStats {
+    std::uint64_t leaders = 0;   ///< Requests actually sent upstream
+    std::uint64_t followers = 0; ///< Requests that joined one already in flight
+};
+
+/**
+ * @brief Options for RequestCoalescer
+ */
+struct RequestCoalescerOptions {
+    std::size_t maxReplayBytes = 1024 * 1024; ///< Stream bytes kept for late joiners; once exceeded, callers send their own request
+};
+
+/**
+ * @brief Shares one upstream request between identical concurrent requests
+ *
+ * The first caller for a key becomes the leader and sends the request; callers
+ * arriving while it is in flight become followers and receive a copy of the
+ * leader's response (or error) instead of sending their own. Once the leader
+ * completes, the key is free again, so later callers start a new request.
+ *
+ * Streams are fanned out: every chunk the leader receives is recorded and
+ * handed to each follower, and a follower joining mid-stream is first
+ * replayed the chunks it missed. Once a stream has received more than
+ * maxReplayBytes it admits no more followers, and chunks every follower
+ * has been handed are dropped, so a long stream holds only what its
+ * slowest follower has yet to read.
+ */
+class RequestCoalescer {
+public:
+    using Key = ResponseCache::Key;
+
+    /**
+     * @brief Create a coalescer
+     *
+     * @param options Replay limit of coalesced streams
+     * @return std::shared_ptr<RequestCoalescer> The coalescer
+     */
+    static std::shared_ptr<RequestCoalescer> create(const RequestCoalescerOptions& options = {}) {
+        return std::shared_ptr<RequestCoalescer>(new RequestCoalescer(options));
+    }
+
+    RequestCoalescer(const RequestCoalescer&) = delete;
+    RequestCoalescer& operator=(const RequestCoalescer&) = delete;
+
+    /**
+     * @brief Shared state of one coalesced stream
+     */
+    class StreamFlight {
+    public:
+        /**
+         * @brief Constructor
+         *
+         * @param maxReplayBytes Bytes received after which no follower is admitted
+         */
+        explicit StreamFlight(std::size_t maxReplayBytes) : maxReplayBytes_(maxReplayBytes) {}
+
+        /**
+         * @brief Record a chunk received by the leader and wake followers
+         *
+         * @return bool True while a follower still wants the stream
+         */
+        bool publish(const std::string& chunk, bool done) {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                received_ += chunk.size();
+                full_ = full_ || received_ > maxReplayBytes_;
+                if (full_ && cursors_.empty()) {
+                    ++dropped_; // nobody left to hand it to
+                } else {
+                    chunks_.emplace_back(chunk, done);
+                }
+                trim();
+            }
+            changed_.notify_all();
+            return activeFollowers_.load(std::memory_order_acquire) > 0;
+        }
+
+        /**
+         * @brief Deliver the stream to a follower, blocking until it ends
+         *
+         * @param callback The follower's stream callback; return false to stop
+         * @return int The HTTP status code of the shared request
+         * @throws The leader's error if the shared request failed
+         */
+        int consume(const StreamCallback& callback) {
+            // Stream position of the next chunk to deliver; the cursor joinStream() registered.
+            std::size_t next = 0;
+            struct Leave {
+                StreamFlight& flight;
+                const std::size_t& next;
+                ~Leave() {
+                    {
+                        std::lock_guard<std::mutex> lock(flight.mutex_);
+                        flight.cursors_.erase(flight.cursors_.find(next));
+                        flight.trim();
+                    }
+                    flight.activeFollowers_.fetch_sub(1, std::memory_order_acq_rel);
+                }
+            } leave{*this, next};
+
+            std::unique_lock<std::mutex> lock(mutex_);
+            while (true) {
+                changed_.wait(lock, [&] { return next < dropped_ + chunks_.size() || finished_; });
+                if (next == dropped_ + chunks_.size()) {
+                    break;
+                }
+                // Our cursor keeps the chunk from being dropped, and deque elements
+                // stay put while the leader appends, so no copy is needed.
+                const std::pair<std::string, bool>& entry = chunks_[next - dropped_];
+                lock.unlock();
+                bool wanted = callback(entry.first, entry.second);
+                lock.lock();
+                cursors_.erase(cursors_.find(next));
+                cursors_.insert(++next);
+                trim();
+                if (!wanted) {
+                    return 200; // Chunks are only delivered for successful responses.
+                }
+            }
+            if (error_) {
+                std::exception_ptr error = error_;
+                lock.unlock();
+                std::rethrow_exception(error);
+            }
+            return statusCode_;
+        }
+
+    private:
+        friend class RequestCoalescer;
+
+        /// Registers a follower at the start of the stream, unless the replay limit was passed.
+        bool admit() {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (full_) {
+                return false;
+            }
+            cursors_.insert(0);
+            activeFollowers_.fetch_add(1, std::memory_order_acq_rel);
+            return true;
+        }
+
+        /// Once no follower can join, drops the chunks every follower has been handed.
+        void trim() {
+            if (!full_) {
+                return;
+            }
+            std::size_t keep = cursors_.empty() ? dropped_ + chunks_.size() : *cursors_.begin();
+            while (dropped_ < keep) {
+                chunks_.pop_front();
+                ++dropped_;
+            }
+        }
+
+        const std::size_t maxReplayBytes_;
+        std::mutex mutex_;
+        std::condition_variable changed_;
+        std::deque<std::pair<std::string, bool>> chunks_; ///< Chunks from stream position dropped_ on
+        std::size_t dropped_ = 0;           ///< Chunks no longer kept
+        std::size_t received_ = 0;          ///< Bytes the leader published
+        bool full_ = false;                 ///< received_ passed maxReplayBytes_; no follower is admitted
+        std::multiset<std::size_t> cursors_; ///< Stream position of each follower's next chunk
+        std::atomic<std::size_t> activeFollowers_{0};
+        bool closing_ = false; ///< Upstream stop decided; guarded by the coalescer's mutex
+        bool finished_ = false;
+        int statusCode_ = 0;
+        std::exception_ptr error_;
+    };
+
+    /**
+     * @brief Join the request in flight for a key, or lead a new one
+     *
+     * @param key The request's key
+     * @param waiter Receives a copy of the leader's response if a request is in flight
+     * @return bool True if the caller is the leader: it must send the request
+     *         and then call complete(), and waiter was not registered
+     */
+    bool join(const Key& key, AsyncCompletion waiter) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = flights_.find(key);
+        if (it != flights_.end()) {
+            it->second.push_back(std::move(waiter));
+            followers_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        flights_.emplace(key, std::vector<AsyncCompletion>());
+        leaders_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    /**
+     * @brief Finish a request led by the caller and hand its outcome to the followers
+     *
+     * Followers run on the calling thread.
+     *
+     * @param key The request's key
+     * @param response The response (ignored when error is set)
+     * @param error The error the request failed with, if any
+     */
+    void complete(const Key& key, const HttpResponse& response, std::exception_ptr error) {
+        std::vector<AsyncCompletion> waiters;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = flights_.find(key);
+            if (it == flights_.end()) {
+                return;
+            }
+            waiters.swap(it->second);
+            flights_.erase(it);
+        }
+        for (auto& waiter : waiters) {
+            try {
+                waiter(response, error);
+            } catch (...) {
+                // One follower's failure must not keep the others waiting.
+            }
+        }
+    }
+
+    /**
+     * @brief Run a request through the coalescer, blocking until it completes
+     *
+     * @param key The request's key
+     * @param send Sends the request; only called by the leader
+     * @param shared Optional; set to true if the response came from another caller's request
+     * @return HttpResponse The response
+     * @throws The error the shared request failed with
+     */
+    template <typename Send>
+    HttpResponse run(const Key& key, Send&& send, bool* shared = nullptr) {
+        auto promise = std::make_shared<std::promise<HttpResponse>>();
+        std::future<HttpResponse> future = promise->get_future();
+        bool leader = join(key, [promise](HttpResponse response, std::exception_ptr error) {
+            if (error) {
+                promise->set_exception(error);
+            } else {
+                promise->set_value(std::move(response));
+            }
+        });
+        if (shared) {
+            *shared = !leader;
+        }
+        if (!leader) {
+            return future.get();
+        }
+        HttpResponse response;
+        try {
+            response = send();
+        } catch (...) {
+            complete(key, response, std::current_exception());
+            throw;
+        }
+        complete(key, response, nullptr);
+        return response;
+    }
+
+    /**
+     * @brief Join the stream in flight for a key, or lead a new one
+     *
+     * A stream past maxReplayBytes is not joined: the caller leads a new one.
+     *
+     * @param key The request's key
+     * @param leader Set to true if the caller must send the request, publish
+     *        every chunk and then call finishStream()
+     * @return std::shared_ptr<StreamFlight> The stream to publish to or consume
+     */
+    std::shared_ptr<StreamFlight> joinStream(const Key& key, bool& leader) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = streams_.find(key);
+        if (it != streams_.end() && !it->second->closing_ && it->second->admit()) {
+            followers_.fetch_add(1, std::memory_order_relaxed);
+            leader = false;
+            return it->second;
+        }
+        // Past its replay limit, a stream still in flight is replaced here; its leader
+        // only removes its own flight when it finishes.
+        auto flight = std::make_shared<StreamFlight>(options_.maxReplayBytes);
+        streams_[key] = flight;
+        leaders_.fetch_add(1, std::memory_order_relaxed);
+        leader = true;
+        return flight;
+    }
+
+    /**
+     * @brief Decide whether the leader keeps reading the upstream stream
+     *
+     * Once this returns false the flight accepts no new followers.
+     *
+     * @param flight The leader's stream
+     * @param leaderWants Whether the leader's own callback wants more
+     * @param followersWant Result of the last publish()
+     * @return bool True to keep reading
+     */
+    bool keepStreaming(StreamFlight& flight, bool leaderWants, bool followersWant) {
+        if (leaderWants || followersWant) {
+            return true;
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        // A follower may have joined since publish() sampled the count.
+        if (flight.activeFollowers_.load(std::memory_order_acquire) > 0) {
+            return true;
+        }
+        flight.closing_ = true;
+        return false;
+    }
+
+    /**
+     * @brief End a stream led by the caller and release its followers
+     *
+     * @param key The request's key
+     * @param flight The leader's stream
+     * @param statusCode The HTTP status code of the request
+     * @param error The error the request failed with, if any
+     */
+    void finishStream(const Key& key, const std::shared_ptr<StreamFlight>& flight,
+                      int statusCode, std::exception_ptr error) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            flight->closing_ = true;
+            auto it = streams_.find(key);
+            if (it != streams_.end() && it->second == flight) {
+                streams_.erase(it);
+            }
+        }
+        {
+            std::lock_guard<std::mutex> lock(flight->mutex_);
+            flight->finished_ = true;
+            flight->statusCode_ = statusCode;
+            flight->error_ = error;
+        }
+        flight->changed_.notify_all();
+    }
+
+    /**
+     * @brief Get the counters
+     */
+    RequestCoalescerStats stats() const {
+        RequestCoalescerStats stats;
+        stats.leaders = leaders_.load(std::memory_order_relaxed);
+        stats.followers = followers_.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+private:
+    explicit RequestCoalescer(const RequestCoalescerOptions& options) : options_(options) {}
+
+    struct KeyHash {
+        std::size_t operator()(const Key& key) const { return static_cast<std::size_t>(key.low); }
+    };
+
+    RequestCoalescerOptions options_;
+    std::mutex mutex_;
+    std::unordered_map<Key, std::vector<AsyncCompletion>, KeyHash> flights_;
+    std::unordered_map<Key, std::shared_ptr<StreamFlight>, KeyHash> streams_;
+    std::atomic<std::uint64_t> leaders_{0};
+    std::atomic<std::uint64_t> followers_{0};
+};
+
+} // namespace client
+} // namespace sauron
@@ -0,0 +1,260 @@
+#pragma once
+
+#include "../dto/AIQueryRequest.hpp"
+#include "../util/Hash.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace sauron {
+namespace client {
+
+/**
+ * @brief Tuning knobs for ResponseCache
+ */
+struct ResponseCacheOptions {
+    std::size_t maxBytes = 64 * 1024 * 1024; ///< Total budget for cached bodies and bookkeeping, split across shards
+    std::chrono::milliseconds ttl{300000};    ///< Entries older than this are not served; zero disables expiry
+    std::size_t shards = 16;                  ///< Independently locked partitions
+};
+
+/**
+ * @brief Counters and occupancy of a ResponseCache
+ */
+struct ResponseCacheStats {
+    std::uint64_t hits = 0;        ///< Lookups served from the cache
+    std::uint64_t misses = 0;      ///< Lookups that found nothing usable
+    std::uint64_t insertions = 0;  ///< Bodies stored
+    std::uint64_t evictions = 0;   ///< Entries dropped to stay within maxBytes
+    std::uint64_t expirations = 0; ///< Entries dropped because their TTL elapsed
+    std::size_t entries = 0;       ///< Entries currently cached
+    std::size_t bytes = 0;         ///< Bytes currently charged against maxBytes
+};
+
+/**
+ * @brief In-memory cache of successful response bodies
+ *
+ * Keys are 128-bit hashes of the endpoint and every AIQueryRequest field;
+ * images are hashed, never stored. Only the hash is kept, so a hit is not
+ * checked against the request; the hash is seeded randomly per process
+ * (see util::hash::Hasher128), so colliding requests cannot be prepared
+ * in advance. Each shard is an LRU list bounded by its
+ * share of maxBytes. Bodies are shared immutably, so a hit copies a pointer
+ * under the shard lock and parsing happens outside it.
+ *
+ * Keys do not include the caller's token: share a cache only between
+ * callers that may see each other's responses.
+ */
+class ResponseCache {
+public:
+    using Clock = std::chrono::steady_clock;
+    using Key = util::hash::Hash128;
+
+    /**
+     * @brief Create a cache
+     *
+     * @param options Size budget, TTL and sharding
+     * @return std::shared_ptr<ResponseCache> The cache
+     */
+    static std::shared_ptr<ResponseCache> create(const ResponseCacheOptions& options = {}) {
+        return std::shared_ptr<ResponseCache>(new ResponseCache(options));
+    }
+
+    ResponseCache(const ResponseCache&) = delete;
+    ResponseCache& operator=(const ResponseCache&) = delete;
+
+    /**
+     * @brief Compute the key of a request
+     *
+     * Attached image files are hashed by content, read from their mappings,
+     * and a conversation turn by turn, without rendering it.
+     *
+     * @param endpoint The endpoint path the request is sent to
+     * @param request The AI query request
+     * @param format Wire format the response is requested in
+     * @return Key The request's key
+     */
+    static Key makeKey(std::string_view endpoint, const dto::AIQueryRequest& request,
+                       dto::WireFormat format = dto::WireFormat::JSON) {
+        util::hash::Hasher128 hasher;
+        hasher.add(endpoint)
+            .add(static_cast<std::uint64_t>(format))
+            .add(static_cast<std::uint64_t>(request.getProvider()))
+            .add(request.getModel())
+            .add(request.getPrompt());
+        if (const dto::Conversation* conversation = request.getConversation()) {
+            hasher.add(static_cast<std::uint64_t>(conversation->size()));
+            conversation->forEachTurn([&hasher](std::string_view turn) { hasher.add(turn); });
+        }
+        hasher.add(static_cast<std::uint64_t>(request.getImages().size()));
+        for (const auto& image : request.getImages()) {
+            hasher.add(image);
+        }
+        if (!request.getImageFiles().empty()) {
+            hasher.add(static_cast<std::uint64_t>(request.getImageFiles().size()));
+            for (const auto& file : request.getImageFiles()) {
+                hasher.add(file->view());
+            }
+        }
+        return hasher.value();
+    }
+
+    /**
+     * @brief Look up a body
+     *
+     * @param key The request's key
+     * @return std::shared_ptr<const std::string> The cached body, or null on a miss
+     */
+    std::shared_ptr<const std::string> find(const Key& key) {
+        Shard& shard = shardFor(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.index.find(key);
+        if (it == shard.index.end()) {
+            misses_.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        auto entry = it->second;
+        if (options_.ttl.count() > 0 && Clock::now() >= entry->expiresAt) {
+            erase(shard, entry);
+            expirations_.fetch_add(1, std::memory_order_relaxed);
+            misses_.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        shard.lru.splice(shard.lru.begin(), shard.lru, entry);
+        hits_.fetch_add(1, std::memory_order_relaxed);
+        return entry->body;
+    }
+
+    /**
+     * @brief Store a body, replacing any previous one for the key
+     *
+     * Bodies larger than a shard's budget are not cached.
+     *
+     * @param key The request's key
+     * @param body The response body
+     */
+    void insert(const Key& key, std::string body) {
+        std::size_t cost = body.size() + kEntryOverhead;
+        Shard& shard = shardFor(key);
+        if (cost > shardBudget_) {
+            return;
+        }
+        auto shared = std::make_shared<const std::string>(std::move(body));
+        Clock::time_point expiresAt = Clock::now() + options_.ttl;
+
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.index.find(key);
+        if (it != shard.index.end()) {
+            erase(shard, it->second);
+        }
+        while (shard.bytes + cost > shardBudget_ && !shard.lru.empty()) {
+            erase(shard, std::prev(shard.lru.end()));
+            evictions_.fetch_add(1, std::memory_order_relaxed);
+        }
+        shard.lru.push_front(Entry{key, std::move(shared), cost, expiresAt});
+        shard.index.emplace(key, shard.lru.begin());
+        shard.bytes += cost;
+        insertions_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Drop the entry for a key, if any
+     */
+    void invalidate(const Key& key) {
+        Shard& shard = shardFor(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.index.find(key);
+        if (it != shard.index.end()) {
+            erase(shard, it->second);
+        }
+    }
+
+    /**
+     * @brief Drop every entry; counters are kept
+     */
+    void clear() {
+        for (auto& shard : shards_) {
+            std::lock_guard<std::mutex> lock(shard->mutex);
+            shard->index.clear();
+            shard->lru.clear();
+            shard->bytes = 0;
+        }
+    }
+
+    /**
+     * @brief Get the counters and current occupancy
+     */
+    ResponseCacheStats stats() const {
+        ResponseCacheStats stats;
+        stats.hits = hits_.load(std::memory_order_relaxed);
+        stats.misses = misses_.load(std::memory_order_relaxed);
+        stats.insertions = insertions_.load(std::memory_order_relaxed);
+        stats.evictions = evictions_.load(std::memory_order_relaxed);
+        stats.expirations = expirations_.load(std::memory_order_relaxed);
+        for (const auto& shard : shards_) {
+            std::lock_guard<std::mutex> lock(shard->mutex);
+            stats.entries += shard->index.size();
+            stats.bytes += shard->bytes;
+        }
+        return stats;
+    }
+
+private:
+    /// Approximate per-entry bookkeeping (list node, index node, shared body control block)
+    static constexpr std::size_t kEntryOverhead = 128;
+
+    struct Entry {
+        Key key;
+        std::shared_ptr<const std::string> body;
+        std::size_t cost;
+        Clock::time_point expiresAt;
+    };
+
+    struct KeyHash {
+        std::size_t operator()(const Key& key) const { return static_cast<std::size_t>(key.low); }
+    };
+
+    struct Shard {
+        std::mutex mutex;
+        std::list<Entry> lru; ///< Most recently used first
+        std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> index;
+        std::size_t bytes = 0;
+    };
+
+    explicit ResponseCache(const ResponseCacheOptions& options) : options_(options) {
+        std::size_t count = options_.shards == 0 ? 1 : options_.shards;
+        shardBudget_ = options_.maxBytes / count;
+        shards_.reserve(count);
+        for (std::size_t i = 0; i < count; ++i) {
+            shards_.push_back(std::make_unique<Shard>());
+        }
+    }
+
+    Shard& shardFor(const Key& key) { return *shards_[key.high % shards_.size()]; }
+
+    static void erase(Shard& shard, std::list<Entry>::iterator entry) {
+        shard.bytes -= entry->cost;
+        shard.index.erase(entry->key);
+        shard.lru.erase(entry);
+    }
+
+    ResponseCacheOptions options_;
+    std::size_t shardBudget_ = 0;
+    std::vector<std::unique_ptr<Shard>> shards_;
+    std::atomic<std::uint64_t> hits_{0};
+    std::atomic<std::uint64_t> misses_{0};
+    std::atomic<std::uint64_t> insertions_{0};
+    std::atomic<std::uint64_t> evictions_{0};
+    std::atomic<std::uint64_t> expirations_{0};
+};
+
+} // namespace client
+} // namespace sauron
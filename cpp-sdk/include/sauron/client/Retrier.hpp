@@ -0,0 +1,338 @@
+#pragma once
+
+#include "Endpoint.hpp"
+#include "HttpClient.hpp"
+#include "HttpWire.hpp"
+#include "Scheduler.hpp"
+#include "TransportError.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <exception>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace sauron {
+namespace client {
+
+/**
+ * @brief When and how often one endpoint is retried
+ */
+struct RetryPolicy {
+    int maxAttempts = 3;                            ///< Total attempts including the first; 1 disables retries
+    std::chrono::milliseconds baseDelay{100};       ///< Backoff before the first retry, doubled per retry
+    std::chrono::milliseconds maxDelay{10000};      ///< Cap on the exponential backoff
+    std::vector<int> retryableStatuses{408, 429, 500, 502, 503, 504}; ///< Statuses worth retrying
+    bool retryTransportErrors = true;               ///< Whether connect/send/receive failures are retried
+    bool idempotent = true;                         ///< False: only retry requests the server provably did not process
+    bool honorRetryAfter = true;                    ///< Wait at least as long as the server's Retry-After
+    std::chrono::milliseconds maxRetryAfter{60000}; ///< Give up rather than honor a longer Retry-After
+};
+
+/**
+ * @brief Limits retries to a fraction of the request rate
+ *
+ * Every request deposits ratio tokens and every retry withdraws one, so
+ * during an outage retries add at most ratio extra load instead of
+ * multiplying it. minRetriesPerSecond keeps low-traffic clients able to
+ * retry at all.
+ */
+struct RetryBudgetOptions {
+    double ratio = 0.2;               ///< Retries allowed per request
+    double minRetriesPerSecond = 5;   ///< Retries always allowed regardless of traffic
+    double maxBalance = 100;          ///< Cap on saved-up retries
+};
+
+/**
+ * @brief Options for Retrier
+ *
+ * Login and RefreshToken default to non-idempotent copies of defaults:
+ * they are only retried when the request never reached the server or the
+ * server rejected it outright (429, 503).
+ */
+struct RetryOptions {
+    RetryPolicy defaults;                       ///< Policy for endpoints without an entry below
+    std::map<Endpoint, RetryPolicy> endpoints;  ///< Per-endpoint overrides
+    RetryBudgetOptions budget;                  ///< Budget shared by all endpoints
+};
+
+/**
+ * @brief Counters of a Retrier
+ */
+struct RetryStats {
+    std::uint64_t requests = 0;        ///< First attempts
+    std::uint64_t retries = 0;         ///< Retries sent
+    std::uint64_t budgetExhausted = 0; ///< Retries skipped because the budget was empty
+};
+
+/**
+ * @brief What an attempt ended with, as seen by the retry decision
+ */
+struct AttemptOutcome {
+    int statusCode = 0;                             ///< HTTP status; 0 when the attempt failed
+    const std::vector<std::string>* headers = nullptr; ///< Response headers, if any
+    std::exception_ptr error;                       ///< Transport or other error, if any
+    bool delivered = false;                         ///< Whether stream data already reached the caller
+};
+
+/**
+ * @brief Retry engine: classification, jittered exponential backoff,
+ *        Retry-After and a shared retry budget
+ */
+class Retrier : public std::enable_shared_from_this<Retrier> {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @brief Create a retrier
+     *
+     * @param options Per-endpoint policies and the retry budget
+     * @return std::shared_ptr<Retrier> The retrier
+     */
+    static std::shared_ptr<Retrier> create(const RetryOptions& options = {}) {
+        return std::shared_ptr<Retrier>(new Retrier(options));
+    }
+
+    Retrier(const Retrier&) = delete;
+    Retrier& operator=(const Retrier&) = delete;
+
+    /**
+     * @brief Get the policy of an endpoint
+     */
+    const RetryPolicy& policy(Endpoint endpoint) const {
+        auto it = options_.endpoints.find(endpoint);
+        return it != options_.endpoints.end() ? it->second : options_.defaults;
+    }
+
+    /**
+     * @brief Account for a new request (not a retry) in the budget
+     */
+    void recordRequest() {
+        requests_.fetch_add(1, std::memory_order_relaxed);
+        std::lock_guard<std::mutex> lock(mutex_);
+        refill();
+        balance_ = std::min(options_.budget.maxBalance, balance_ + options_.budget.ratio);
+    }
+
+    /**
+     * @brief Decide whether to retry, and after how long
+     *
+     * Consumes one retry from the budget when the answer is yes.
+     *
+     * @param endpoint The endpoint the attempt went to
+     * @param attempt Number of attempts made so far (1 after the first)
+     * @param outcome How the attempt ended
+     * @return std::optional<std::chrono::milliseconds> The delay before the next attempt, or nothing to give up
+     */
+    std::optional<std::chrono::milliseconds> retryDelay(Endpoint endpoint, int attempt, const AttemptOutcome& outcome) {
+        const RetryPolicy& rules = policy(endpoint);
+        if (attempt >= rules.maxAttempts || outcome.delivered || !retryable(rules, outcome)) {
+            return std::nullopt;
+        }
+
+        std::chrono::milliseconds delay = backoff(rules, attempt);
+        if (rules.honorRetryAfter && outcome.headers) {
+            std::string value;
+            if (wire::findHeader(*outcome.headers, "Retry-After", value)) {
+                if (std::optional<std::chrono::milliseconds> retryAfter = parseRetryAfter(value)) {
+                    if (*retryAfter > rules.maxRetryAfter) {
+                        return std::nullopt;
+                    }
+                    delay = std::max(delay, *retryAfter);
+                }
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            refill();
+            if (balance_ < 1) {
+                budgetExhausted_.fetch_add(1, std::memory_order_relaxed);
+                return std::nullopt;
+            }
+            balance_ -= 1;
+        }
+        retries_.fetch_add(1, std::memory_order_relaxed);
+        return delay;
+    }
+
+    /**
+     * @brief Run a synchronous request with retries
+     *
+     * Inside a CallScope, no retry is made that would start after the
+     * deadline, and cancelling the token ends the backoff.
+     *
+     * @param endpoint The endpoint the request goes to
+     * @param send Performs one attempt; returns an HttpResponse or a status code
+     * @param delivered Optional; set by streaming sends once data reached the caller
+     * @return The result of the last attempt
+     * @throws The error of the last attempt
+     * @throws RequestCancelled if the call's token is cancelled during a backoff
+     */
+    template <typename Send>
+    auto run(Endpoint endpoint, Send&& send, const bool* delivered = nullptr) -> decltype(send()) {
+        recordRequest();
+        for (int attempt = 1;; ++attempt) {
+            AttemptOutcome outcome;
+            std::optional<decltype(send())> result;
+            try {
+                result.emplace(send());
+                describe(*result, outcome);
+            } catch (const TransportError&) {
+                outcome.error = std::current_exception();
+            }
+            outcome.delivered = delivered && *delivered;
+            std::optional<std::chrono::milliseconds> delay = retryDelay(endpoint, attempt, outcome);
+            if (delay) {
+                const CallOptions* call = CallScope::current();
+                if (call == nullptr) {
+                    std::this_thread::sleep_for(*delay);
+                    continue;
+                }
+                if (call->sleepFor(*delay)) {
+                    continue;
+                }
+            }
+            if (outcome.error) {
+                std::rethrow_exception(outcome.error);
+            }
+            return std::move(*result);
+        }
+    }
+
+    /**
+     * @brief Run a task after a delay, on the retrier's timer thread
+     *
+     * The retrier stays alive until the task has run.
+     */
+    void schedule(std::chrono::milliseconds delay, std::function<void()> task) {
+        scheduler_.schedule(Clock::now() + delay, [self = shared_from_this(), task = std::move(task)] { task(); });
+    }
+
+    /**
+     * @brief Get the counters
+     */
+    RetryStats stats() const {
+        RetryStats stats;
+        stats.requests = requests_.load(std::memory_order_relaxed);
+        stats.retries = retries_.load(std::memory_order_relaxed);
+        stats.budgetExhausted = budgetExhausted_.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+    /**
+     * @brief Parse a Retry-After value (delay-seconds or HTTP-date)
+     *
+     * @param value The header value
+     * @return std::optional<std::chrono::milliseconds> The delay, or nothing if unparseable
+     */
+    static std::optional<std::chrono::milliseconds> parseRetryAfter(const std::string& value) {
+        std::string trimmed = value;
+        trimmed.erase(0, trimmed.find_first_not_of(" \t"));
+        trimmed.erase(trimmed.find_last_not_of(" \t") + 1);
+        if (trimmed.empty()) {
+            return std::nullopt;
+        }
+        if (std::all_of(trimmed.begin(), trimmed.end(), [](char c) { return c >= '0' && c <= '9'; })) {
+            if (trimmed.size() > 9) {
+                return std::chrono::milliseconds::max();
+            }
+            return std::chrono::seconds(std::stol(trimmed));
+        }
+        std::tm tm{};
+        std::istringstream in(trimmed);
+        in.imbue(std::locale::classic());
+        in >> std::get_time(&tm, "%a, %d %b %Y %H:%M:%S");
+        if (in.fail()) {
+            return std::nullopt;
+        }
+        auto at = std::chrono::system_clock::from_time_t(timegm(&tm));
+        auto now = std::chrono::system_clock::now();
+        if (at <= now) {
+            return std::chrono::milliseconds(0);
+        }
+        return std::chrono::duration_cast<std::chrono::milliseconds>(at - now);
+    }
+
+private:
+    explicit Retrier(const RetryOptions& options) : options_(options) {
+        for (Endpoint endpoint : {Endpoint::Login, Endpoint::RefreshToken}) {
+            if (options_.endpoints.find(endpoint) == options_.endpoints.end()) {
+                RetryPolicy rules = options_.defaults;
+                rules.idempotent = false;
+                options_.endpoints.emplace(endpoint, rules);
+            }
+        }
+        balance_ = options_.budget.minRetriesPerSecond;
+        refilledAt_ = Clock::now();
+    }
+
+    static void describe(const HttpResponse& response, AttemptOutcome& outcome) {
+        outcome.statusCode = response.statusCode;
+        outcome.headers = &response.headers;
+    }
+
+    static void describe(int statusCode, AttemptOutcome& outcome) { outcome.statusCode = statusCode; }
+
+    static bool retryable(const RetryPolicy& rules, const AttemptOutcome& outcome) {
+        if (outcome.error) {
+            if (!rules.retryTransportErrors) {
+                return false;
+            }
+            try {
+                std::rethrow_exception(outcome.error);
+            } catch (const TransportError& error) {
+                return rules.idempotent || !error.requestSent();
+            } catch (...) {
+                return false;
+            }
+        }
+        const auto& statuses = rules.retryableStatuses;
+        if (std::find(statuses.begin(), statuses.end(), outcome.statusCode) == statuses.end()) {
+            return false;
+        }
+        // 429 and 503 mean the server turned the request away without acting on it.
+        return rules.idempotent || outcome.statusCode == 429 || outcome.statusCode == 503;
+    }
+
+    /// Full jitter: uniform in [0, min(maxDelay, baseDelay * 2^(attempt-1))].
+    static std::chrono::milliseconds backoff(const RetryPolicy& rules, int attempt) {
+        double ceiling = static_cast<double>(rules.baseDelay.count());
+        for (int i = 1; i < attempt && ceiling < rules.maxDelay.count(); ++i) {
+            ceiling *= 2;
+        }
+        ceiling = std::min(ceiling, static_cast<double>(rules.maxDelay.count()));
+        thread_local std::mt19937_64 random(std::random_device{}());
+        std::uniform_real_distribution<double> jitter(0, ceiling);
+        return std::chrono::milliseconds(static_cast<std::chrono::milliseconds::rep>(jitter(random)));
+    }
+
+    void refill() {
+        Clock::time_point now = Clock::now();
+        double elapsed = std::chrono::duration<double>(now - refilledAt_).count();
+        refilledAt_ = now;
+        balance_ = std::min(options_.budget.maxBalance, balance_ + elapsed * options_.budget.minRetriesPerSecond);
+    }
+
+    RetryOptions options_;
+    std::mutex mutex_;
+    double balance_ = 0;
+    Clock::time_point refilledAt_;
+    std::atomic<std::uint64_t> requests_{0};
+    std::atomic<std::uint64_t> retries_{0};
+    std::atomic<std::uint64_t> budgetExhausted_{0};
+    Scheduler scheduler_; ///< Declared last: stopped before the state its tasks may use
+};
+
+} // namespace client
+} // namespace sauron
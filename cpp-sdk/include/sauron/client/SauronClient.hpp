@@ -1,11 +1,33 @@
 #pragma once
 
 #include "HttpClient.hpp"
+#include "AsyncHttpClient.hpp"
+#include "Batch.hpp"
+#include "SseDecoder.hpp"
+#include "TokenRefresher.hpp"
+#include "ResponseCache.hpp"
+#include "RequestCoalescer.hpp"
+#include "RateLimiter.hpp"
+#include "Retrier.hpp"
+#include "Hedger.hpp"
+#include "Metrics.hpp"
+#include "Endpoint.hpp"
+#include "HttpStatusError.hpp"
+#include "HttpWire.hpp"
 #include "../dto/DTOs.hpp"
+#include <atomic>
 #include <string>
+#include <chrono>
 #include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
 #include <functional>
+#include <future>
+#include <optional>
 #include <stdexcept>
+#include <thread>
+#include <vector>
 #include <nlohmann/json.hpp>
 
 namespace sauron {
@@ -15,17 +37,56 @@ namespace client {
  * @brief Client for the Sauron AI Authentication & Query API
  *
  * Provides methods for authenticating with AI providers and making AI queries
+ *
+ * One client can be shared by many threads: queries, logins and token
+ * updates may run concurrently. The token is read from an atomically
+ * published snapshot and sent as a per-request Authorization header, so the
+ * shared HTTP client is never mutated on the query path. Sharing a client
+ * requires its HttpClient to be safe for concurrent calls; the built-in one
+ * is. Moving the client and enabling or disabling auto refresh are not
+ * thread-safe.
+ *
+ * Every call takes optional CallOptions. A call past its deadline fails
+ * with DeadlineExceeded and a cancelled one with RequestCancelled, wherever
+ * it is: waiting for a rate limiter permit or a pooled connection,
+ * connecting, sending, waiting for the response, reading a stream or
+ * backing off before a retry (asynchronous calls notice a cancellation there
+ * once the backoff ends). Neither error is retried. Calls with options are
+ * never coalesced with others, which run on their own deadlines.
  */
 class SauronClient {
 public:
+    /**
+     * @brief Completion callback for asynchronous calls
+     *
+     * On failure result is default-constructed and error holds the exception
+     * the synchronous call would have thrown.
+     */
+    template <typename T>
+    using AsyncCallback = std::function<void(T result, std::exception_ptr error)>;
+
+    static constexpr std::size_t kMaxWarmupPings = 8; ///< Health pings warmup() runs at a time
+
     /**
      * @brief Constructor with custom HTTP client
      *
+     * Asynchronous calls use the built-in AsyncHttpClient for the same base
+     * URL, created on first use.
+     *
      * @param httpClient Custom HTTP client implementation
      */
     explicit SauronClient(std::unique_ptr<HttpClient> httpClient)
         : httpClient_(std::move(httpClient)) {}
 
+    /**
+     * @brief Constructor with custom synchronous and asynchronous HTTP clients
+     *
+     * @param httpClient Custom HTTP client implementation
+     * @param asyncHttpClient Custom asynchronous HTTP client implementation
+     */
+    SauronClient(std::unique_ptr<HttpClient> httpClient, std::unique_ptr<AsyncHttpClient> asyncHttpClient)
+        : httpClient_(std::move(httpClient)), asyncHttpClient_(std::move(asyncHttpClient)) {}
+
     /**
      * @brief Destructor
      */
@@ -33,62 +94,88 @@ public:
     SauronClient(SauronClient&&) noexcept = default;
     SauronClient& operator=(SauronClient&&) noexcept = default;
 
+    /**
+     * @brief Login to an AI provider, with no deadline and no cancellation
+     */
+    virtual dto::TokenResponse login(const dto::LoginRequest& request) { return login(request, CallOptions()); }
+
     /**
      * @brief Login to an AI provider
      *
      * @param request The login request
+     * @param options Deadline and cancellation token of the call
      * @return dto::TokenResponse The token response
      * @throws std::runtime_error if the request fails
      */
-    virtual dto::TokenResponse login(const dto::LoginRequest& request) {
+    virtual dto::TokenResponse login(const dto::LoginRequest& request, const CallOptions& options) {
+        CallScope scope(options);
         request.validate();
-        auto response = httpClient_->post("/auth/login", request.toJson());
+        const std::string body = request.toJson().dump();
+        auto response = retried(Endpoint::Login, request.getProvider(), [&] {
+            return observed(Endpoint::Login, request.getProvider(), body.size(), [&] {
+                return httpClient_->post("/auth/login", body, "application/json");
+            });
+        });
         if (response.statusCode != 200) {
-            throw std::runtime_error(dto::Error::fromJson(nlohmann::json::parse(response.body)).getError());
+            throw statusError(response);
         }
-        auto tokenResponse = dto::TokenResponse::fromJson(nlohmann::json::parse(response.body));
+        auto tokenResponse = dto::TokenResponse::parse(response.body, responseFormat(response));
         setToken(tokenResponse.getToken());
         return tokenResponse;
     }
 
+    /**
+     * @brief Refresh the JWT token, with no deadline and no cancellation
+     */
+    virtual dto::TokenResponse refreshToken() { return refreshToken(CallOptions()); }
+
     /**
      * @brief Refresh the JWT token
      *
+     * @param options Deadline and cancellation token of the call
      * @return dto::TokenResponse The new token response
      * @throws std::runtime_error if the request fails
      */
-    virtual dto::TokenResponse refreshToken() {
-        if (token_.empty()) {
+    virtual dto::TokenResponse refreshToken(const CallOptions& options) {
+        CallScope scope(options);
+        std::string token = tokens_->get();
+        if (token.empty()) {
             throw std::runtime_error("No token available for refresh");
         }
-        httpClient_->setBearerToken(token_);
-        auto response = httpClient_->post("/auth/refresh", nlohmann::json({}));
+        auto response = retried(Endpoint::RefreshToken, std::nullopt, [&] {
+            return observed(Endpoint::RefreshToken, std::nullopt, 2, [&] { return postRefresh(*httpClient_, token); });
+        });
         if (response.statusCode != 200) {
-            throw std::runtime_error(dto::Error::fromJson(nlohmann::json::parse(response.body)).getError());
+            throw statusError(response);
         }
-        auto tokenResponse = dto::TokenResponse::fromJson(nlohmann::json::parse(response.body));
+        auto tokenResponse = dto::TokenResponse::parse(response.body, responseFormat(response));
         setToken(tokenResponse.getToken());
         return tokenResponse;
     }
 
+    /**
+     * @brief Send a query to an AI provider, with no deadline and no cancellation
+     */
+    virtual dto::AIQueryResponse query(const dto::AIQueryRequest& request) { return query(request, CallOptions()); }
+
     /**
      * @brief Send a query to an AI provider
      *
      * @param request The AI query request
+     * @param options Deadline and cancellation token of the call
      * @return dto::AIQueryResponse The AI response
      * @throws std::runtime_error if the request fails
      */
-    virtual dto::AIQueryResponse query(const dto::AIQueryRequest& request) {
-        request.validate();
-        if (token_.empty()) {
-            throw std::runtime_error("No token available. Please login first.");
-        }
-        httpClient_->setBearerToken(token_);
-        auto response = httpClient_->post("/ai/query", request.toJson());
-        if (response.statusCode != 200) {
-            throw std::runtime_error(dto::Error::fromJson(nlohmann::json::parse(response.body)).getError());
-        }
-        return dto::AIQueryResponse::fromJson(nlohmann::json::parse(response.body));
+    virtual dto::AIQueryResponse query(const dto::AIQueryRequest& request, const CallOptions& options) {
+        CallScope scope(options);
+        return postQuery<dto::AIQueryResponse>(Endpoint::Query, request);
+    }
+
+    /**
+     * @brief Stream a query to an AI provider, with no deadline and no cancellation
+     */
+    virtual bool queryStream(const dto::AIQueryRequest& request, const std::function<bool(const std::string&, bool)>& callback) {
+        return queryStream(request, callback, CallOptions());
     }
 
     /**
@@ -96,54 +183,424 @@ public:
      *
      * @param request The AI query request
      * @param callback The callback function to handle streaming data
+     * @param options Deadline and cancellation token of the call
      * @return bool True if the request was successful
      * @throws std::runtime_error if the request fails
      */
-    virtual bool queryStream(const dto::AIQueryRequest& request, const std::function<bool(const std::string&, bool)>& callback) {
-        request.validate();
-        if (token_.empty()) {
-            throw std::runtime_error("No token available. Please login first.");
-        }
-        httpClient_->setBearerToken(token_);
-        int statusCode = httpClient_->postStream("/ai/query/stream", request.toJson(), callback);
-        if (statusCode != 200) {
-            throw std::runtime_error("Stream request failed with status code: " + std::to_string(statusCode));
+    virtual bool queryStream(const dto::AIQueryRequest& request, const std::function<bool(const std::string&, bool)>& callback,
+                             const CallOptions& options) {
+        CallScope scope(options);
+        HttpResponse response = postStreamQuery(Endpoint::QueryStream, request, callback);
+        if (response.statusCode != 200) {
+            throw statusError(response);
         }
         return true;
     }
 
+    /**
+     * @brief Stream a query and receive decoded Server-Sent Events, with no deadline and no cancellation
+     */
+    virtual bool queryStreamEvents(const dto::AIQueryRequest& request, const SseDecoder::EventCallback& onEvent) {
+        return queryStreamEvents(request, onEvent, CallOptions());
+    }
+
+    /**
+     * @brief Stream a query and receive decoded Server-Sent Events
+     *
+     * Frames are decoded incrementally as chunks arrive, including events
+     * split across chunks and multi-line data. Event fields are views that
+     * are only valid during the callback.
+     *
+     * @param request The AI query request
+     * @param onEvent Called for every event; return false to stop
+     * @param options Deadline and cancellation token of the call
+     * @return bool True if the request was successful
+     * @throws std::runtime_error if the request fails
+     */
+    virtual bool queryStreamEvents(const dto::AIQueryRequest& request, const SseDecoder::EventCallback& onEvent,
+                                   const CallOptions& options) {
+        SseDecoder decoder;
+        SseDecoder::EventCallback observe = firstEventObserver(request.getProvider(), onEvent);
+        const SseDecoder::EventCallback& deliver = observe ? observe : onEvent;
+        return queryStream(request, [&decoder, &deliver](const std::string& chunk, bool done) {
+            bool keepGoing = decoder.feed(chunk, deliver);
+            if (done) {
+                decoder.finish();
+            }
+            return keepGoing;
+        }, options);
+    }
+
+    /**
+     * @brief Open connections ahead of the first requests
+     *
+     * Has the transport open up to the given number of pooled connections
+     * in parallel, so the first requests after a start do not each pay a
+     * DNS lookup and a TCP handshake in series. With pingHealth, the
+     * connections are then verified by GET /health, one per connection the
+     * transport opened, or one per connection wanted for transports that do
+     * not override HttpClient::warmup(), which the pings then warm. At most
+     * kMaxWarmupPings pings run at a time. The pings are neither retried nor
+     * recorded in the metrics. Only the synchronous transport is warmed.
+     *
+     * @param connections Number of connections wanted
+     * @param pingHealth Whether to verify the connections with GET /health
+     * @param options Deadline and cancellation token of the whole warmup
+     * @return std::size_t Connections opened, or with pingHealth the pings answered with 200
+     * @throws TransportError if no connection could be opened
+     * @throws RequestCancelled, DeadlineExceeded if the call stopped first
+     */
+    std::size_t warmup(std::size_t connections, bool pingHealth = false,
+                       const CallOptions& options = CallOptions()) {
+        std::size_t opened;
+        {
+            CallScope scope(options);
+            opened = httpClient_->warmup(connections);
+        }
+        if (!pingHealth) {
+            return opened;
+        }
+        const std::size_t pings = opened > 0 ? std::min(opened, connections) : connections;
+        std::atomic<std::size_t> next{0};
+        std::atomic<std::size_t> healthy{0};
+        auto ping = [this, pings, &next, &healthy, &options] {
+            CallScope scope(options);
+            while (!options.stopped() && next.fetch_add(1, std::memory_order_relaxed) < pings) {
+                try {
+                    if (httpClient_->get("/health").statusCode == 200) {
+                        healthy.fetch_add(1, std::memory_order_relaxed);
+                    }
+                } catch (const std::exception&) {
+                    // Counted as not ready
+                }
+            }
+        };
+        std::vector<std::thread> workers;
+        workers.reserve(std::min(pings, kMaxWarmupPings));
+        try {
+            while (workers.size() < std::min(pings, kMaxWarmupPings)) {
+                workers.emplace_back(ping);
+            }
+        } catch (...) {
+            next.store(pings, std::memory_order_relaxed);
+            for (auto& worker : workers) {
+                worker.join();
+            }
+            throw;
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        options.check();
+        return healthy.load();
+    }
+
+    /**
+     * @brief Check the health of the API, with no deadline and no cancellation
+     */
+    virtual dto::HealthResponse checkHealth() { return checkHealth(CallOptions()); }
+
     /**
      * @brief Check the health of the API
      *
+     * @param options Deadline and cancellation token of the call
      * @return dto::HealthResponse The health response
      * @throws std::runtime_error if the request fails
      */
-    virtual dto::HealthResponse checkHealth() {
-        auto response = httpClient_->get("/health");
+    virtual dto::HealthResponse checkHealth(const CallOptions& options) {
+        CallScope scope(options);
+        auto response = retried(Endpoint::Health, std::nullopt, [&] {
+            return observed(Endpoint::Health, std::nullopt, 0, [&] { return httpClient_->get("/health"); });
+        });
         if (response.statusCode != 200) {
-            throw std::runtime_error(dto::Error::fromJson(nlohmann::json::parse(response.body)).getError());
+            throw statusError(response);
         }
-        return dto::HealthResponse::fromJson(nlohmann::json::parse(response.body));
+        return dto::HealthResponse::parse(response.body, responseFormat(response));
+    }
+
+    /**
+     * @brief Send an algorithm query to an AI provider, with no deadline and no cancellation
+     */
+    virtual dto::AIAlgorithmResponse queryAlgorithm(const dto::AIQueryRequest& request) {
+        return queryAlgorithm(request, CallOptions());
     }
 
     /**
      * @brief Send an algorithm query to an AI provider
      *
      * @param request The AI query request
+     * @param options Deadline and cancellation token of the call
      * @return dto::AIAlgorithmResponse The AI algorithm response
      * @throws std::runtime_error if the request fails
      */
-    virtual dto::AIAlgorithmResponse queryAlgorithm(const dto::AIQueryRequest& request) {
-        request.validate();
-        if (token_.empty()) {
-            throw std::runtime_error("No token available. Please login first.");
-        }
-        httpClient_->setBearerToken(token_);
-        auto response = httpClient_->post("/ai/query/algorithm", request.toJson());
+    virtual dto::AIAlgorithmResponse queryAlgorithm(const dto::AIQueryRequest& request, const CallOptions& options) {
+        CallScope scope(options);
+        return postQuery<dto::AIAlgorithmResponse>(Endpoint::QueryAlgorithm, request);
+    }
+
+    /**
+     * @brief Send an algorithm query and parse the response as it arrives, with no deadline and no cancellation
+     */
+    virtual dto::AIAlgorithmResponse queryAlgorithmStream(const dto::AIQueryRequest& request,
+                                                          const dto::AlgorithmStreamCallbacks& callbacks) {
+        return queryAlgorithmStream(request, callbacks, CallOptions());
+    }
+
+    /**
+     * @brief Send an algorithm query and parse the response as it arrives
+     *
+     * The JSON body is parsed incrementally: explanation and response text
+     * are passed to the callbacks while they are still being received, and
+     * the complexity analysis as soon as its object is complete. The
+     * response is always requested as JSON, whatever the wire format.
+     *
+     * @param request The AI query request
+     * @param callbacks Receive the fields as they arrive; any may be empty
+     * @param options Deadline and cancellation token of the call
+     * @return dto::AIAlgorithmResponse The complete response, or what had arrived when a callback stopped
+     * @throws std::runtime_error if the request fails or the body is not valid JSON
+     */
+    virtual dto::AIAlgorithmResponse queryAlgorithmStream(const dto::AIQueryRequest& request,
+                                                          const dto::AlgorithmStreamCallbacks& callbacks,
+                                                          const CallOptions& options) {
+        CallScope scope(options);
+        dto::AlgorithmResponseParser parser(callbacks);
+        bool stopped = false;
+        HttpResponse response = postStreamQuery(Endpoint::QueryAlgorithm, request, [&](const std::string& chunk, bool) {
+            stopped = !parser.feed(chunk);
+            return !stopped;
+        });
         if (response.statusCode != 200) {
-            throw std::runtime_error(dto::Error::fromJson(nlohmann::json::parse(response.body)).getError());
+            throw statusError(response);
+        }
+        if (!stopped) {
+            parser.finish();
+        }
+        return parser.take();
+    }
+
+    /**
+     * @brief Send a query without blocking, with no deadline and no cancellation
+     */
+    virtual void queryAsync(const dto::AIQueryRequest& request, AsyncCallback<dto::AIQueryResponse> callback) {
+        queryAsync(request, std::move(callback), CallOptions());
+    }
+
+    /**
+     * @brief Send a query without blocking
+     *
+     * @param request The AI query request
+     * @param callback Called on the I/O thread with the response or the error;
+     *        on a response cache hit it runs on the calling thread before this returns
+     * @param options Deadline and cancellation token of the call
+     * @throws std::invalid_argument if the request is invalid
+     * @throws std::runtime_error if no token is available
+     */
+    virtual void queryAsync(const dto::AIQueryRequest& request, AsyncCallback<dto::AIQueryResponse> callback,
+                            const CallOptions& options) {
+        sendQueryAsync<dto::AIQueryResponse>(Endpoint::Query, request, std::move(callback), options);
+    }
+
+    /**
+     * @brief Send a query without blocking
+     *
+     * @param request The AI query request
+     * @param options Deadline and cancellation token of the call
+     * @return std::future<dto::AIQueryResponse> The AI response, or the error
+     */
+    std::future<dto::AIQueryResponse> queryAsync(const dto::AIQueryRequest& request,
+                                                 const CallOptions& options = CallOptions()) {
+        return toFuture<dto::AIQueryResponse>([&](AsyncCallback<dto::AIQueryResponse> callback) {
+            queryAsync(request, std::move(callback), options);
+        });
+    }
+
+    /**
+     * @brief Send an algorithm query without blocking, with no deadline and no cancellation
+     */
+    virtual void queryAlgorithmAsync(const dto::AIQueryRequest& request,
+                                     AsyncCallback<dto::AIAlgorithmResponse> callback) {
+        queryAlgorithmAsync(request, std::move(callback), CallOptions());
+    }
+
+    /**
+     * @brief Send an algorithm query without blocking
+     *
+     * @param request The AI query request
+     * @param callback Called on the I/O thread with the response or the error;
+     *        on a response cache hit it runs on the calling thread before this returns
+     * @param options Deadline and cancellation token of the call
+     * @throws std::invalid_argument if the request is invalid
+     * @throws std::runtime_error if no token is available
+     */
+    virtual void queryAlgorithmAsync(const dto::AIQueryRequest& request,
+                                     AsyncCallback<dto::AIAlgorithmResponse> callback,
+                                     const CallOptions& options) {
+        sendQueryAsync<dto::AIAlgorithmResponse>(Endpoint::QueryAlgorithm, request, std::move(callback), options);
+    }
+
+    /**
+     * @brief Send an algorithm query without blocking
+     *
+     * @param request The AI query request
+     * @param options Deadline and cancellation token of the call
+     * @return std::future<dto::AIAlgorithmResponse> The AI algorithm response, or the error
+     */
+    std::future<dto::AIAlgorithmResponse> queryAlgorithmAsync(const dto::AIQueryRequest& request,
+                                                              const CallOptions& options = CallOptions()) {
+        return toFuture<dto::AIAlgorithmResponse>([&](AsyncCallback<dto::AIAlgorithmResponse> callback) {
+            queryAlgorithmAsync(request, std::move(callback), options);
+        });
+    }
+
+    /**
+     * @brief Stream a query without blocking, with no deadline and no cancellation
+     */
+    virtual void queryStreamAsync(const dto::AIQueryRequest& request,
+                                  const std::function<bool(const std::string&, bool)>& callback,
+                                  AsyncCallback<bool> onComplete) {
+        queryStreamAsync(request, callback, std::move(onComplete), CallOptions());
+    }
+
+    /**
+     * @brief Stream a query without blocking
+     *
+     * @param request The AI query request
+     * @param callback Called on the I/O thread for every chunk; return false to stop
+     * @param onComplete Called once the stream ended, with true or the error
+     * @param options Deadline and cancellation token of the call
+     * @throws std::invalid_argument if the request is invalid
+     * @throws std::runtime_error if no token is available
+     */
+    virtual void queryStreamAsync(const dto::AIQueryRequest& request,
+                                  const std::function<bool(const std::string&, bool)>& callback,
+                                  AsyncCallback<bool> onComplete,
+                                  const CallOptions& options) {
+        sendAsync(Endpoint::QueryStream, request, options, callback,
+            [onComplete = std::move(onComplete)](HttpResponse response, std::exception_ptr error) {
+                if (!error && response.statusCode != 200) {
+                    error = std::make_exception_ptr(statusError(response));
+                }
+                onComplete(!error, error);
+            });
+    }
+
+    /**
+     * @brief Stream a query without blocking
+     *
+     * @param request The AI query request
+     * @param callback Called on the I/O thread for every chunk; return false to stop
+     * @param options Deadline and cancellation token of the call
+     * @return std::future<bool> True once the stream ended, or the error
+     */
+    std::future<bool> queryStreamAsync(const dto::AIQueryRequest& request,
+                                       const std::function<bool(const std::string&, bool)>& callback,
+                                       const CallOptions& options = CallOptions()) {
+        return toFuture<bool>([&](AsyncCallback<bool> onComplete) {
+            queryStreamAsync(request, callback, std::move(onComplete), options);
+        });
+    }
+
+    /**
+     * @brief Stream a query without blocking and receive decoded Server-Sent Events
+     *
+     * @param request The AI query request
+     * @param onEvent Called on the I/O thread for every event; return false to stop
+     * @param options Deadline and cancellation token of the call
+     * @return std::future<bool> True once the stream ended, or the error
+     */
+    std::future<bool> queryStreamEventsAsync(const dto::AIQueryRequest& request,
+                                             SseDecoder::EventCallback onEvent,
+                                             const CallOptions& options = CallOptions()) {
+        auto decoder = std::make_shared<SseDecoder>();
+        if (SseDecoder::EventCallback observe = firstEventObserver(request.getProvider(), onEvent)) {
+            onEvent = std::move(observe);
+        }
+        return queryStreamAsync(request, [decoder, onEvent = std::move(onEvent)](const std::string& chunk, bool done) {
+            bool keepGoing = decoder->feed(chunk, onEvent);
+            if (done) {
+                decoder->finish();
+            }
+            return keepGoing;
+        }, options);
+    }
+
+    /**
+     * @brief Send many queries with bounded concurrency
+     *
+     * Requests go out over the asynchronous transport with at most
+     * options.maxInFlight outstanding at a time. A failing request does not
+     * stop the batch; its error is recorded in its result.
+     *
+     * @param requests The AI query requests
+     * @param options Endpoint, concurrency cap, deadline and cancellation, and optional completion stream
+     * @return std::vector<BatchResult> One result per request, in input order
+     */
+    virtual std::vector<BatchResult> queryBatch(std::vector<dto::AIQueryRequest> requests,
+                                                const BatchOptions& options = {}) {
+        struct State {
+            std::mutex mutex;
+            std::condition_variable changed;
+            std::size_t inFlight = 0;
+            std::size_t completed = 0;
+        };
+        auto state = std::make_shared<State>();
+        std::vector<BatchResult> results(requests.size());
+        const std::size_t maxInFlight = options.maxInFlight == 0 ? 1 : options.maxInFlight;
+
+        auto finish = [state, &results, &options](BatchResult result) {
+            std::size_t index = result.index;
+            results[index] = std::move(result);
+            if (options.onResult) {
+                try {
+                    options.onResult(results[index]);
+                } catch (...) {
+                    // A faulty observer must not lose the remaining results.
+                }
+            }
+            std::lock_guard<std::mutex> lock(state->mutex);
+            --state->inFlight;
+            ++state->completed;
+            state->changed.notify_all();
+        };
+
+        for (std::size_t index = 0; index < requests.size(); ++index) {
+            {
+                std::unique_lock<std::mutex> lock(state->mutex);
+                state->changed.wait(lock, [&] { return state->inFlight < maxInFlight; });
+                ++state->inFlight;
+            }
+            BatchResult result;
+            result.index = index;
+            try {
+                if (options.endpoint == BatchEndpoint::QueryAlgorithm) {
+                    queryAlgorithmAsync(requests[index],
+                        [finish, result](dto::AIAlgorithmResponse response, std::exception_ptr error) mutable {
+                            result.error = error;
+                            if (!error) {
+                                result.algorithmResponse = std::move(response);
+                            }
+                            finish(std::move(result));
+                        }, options.call);
+                } else {
+                    queryAsync(requests[index],
+                        [finish, result](dto::AIQueryResponse response, std::exception_ptr error) mutable {
+                            result.error = error;
+                            if (!error) {
+                                result.response = std::move(response);
+                            }
+                            finish(std::move(result));
+                        }, options.call);
+                }
+            } catch (...) {
+                result.error = std::current_exception();
+                finish(std::move(result));
+            }
         }
-        return dto::AIAlgorithmResponse::fromJson(nlohmann::json::parse(response.body));
+
+        std::unique_lock<std::mutex> lock(state->mutex);
+        state->changed.wait(lock, [&] { return state->completed == requests.size(); });
+        return results;
     }
 
     /**
@@ -151,29 +608,875 @@ public:
      *
      * @param token The JWT token
      */
-    virtual void setToken(const std::string& token) {
-        token_ = token;
-        httpClient_->setBearerToken(token);
-    }
+    virtual void setToken(const std::string& token) { tokens_->set(token); }
 
     /**
      * @brief Get the JWT token
      *
      * @return std::string The JWT token
      */
-    virtual std::string getToken() const { return token_; }
+    virtual std::string getToken() const { return tokens_->get(); }
 
     /**
      * @brief Clear the JWT token
      */
-    virtual void clearToken() {
-        token_.clear();
-        httpClient_->clearAuthorization();
+    virtual void clearToken() { tokens_->set(std::string()); }
+
+    /**
+     * @brief Serve query and queryAlgorithm from a response cache
+     *
+     * Successful responses are stored under a hash of the endpoint and the
+     * request fields, and identical requests are answered from the cache
+     * until the entry expires or is evicted. Streams are never cached. A
+     * cache may be shared by several clients.
+     *
+     * @param cache The cache; null disables caching
+     */
+    void setResponseCache(std::shared_ptr<ResponseCache> cache) { std::atomic_store(&responseCache_, std::move(cache)); }
+
+    /**
+     * @brief Get the response cache
+     *
+     * @return std::shared_ptr<ResponseCache> The cache, or null if caching is disabled
+     */
+    std::shared_ptr<ResponseCache> getResponseCache() const { return std::atomic_load(&responseCache_); }
+
+    /**
+     * @brief Share one upstream request between identical concurrent calls
+     *
+     * While a query, queryAlgorithm or queryStream call is in flight,
+     * identical calls (same endpoint, provider, model, prompt and images)
+     * wait for its result instead of sending their own; streams are fanned
+     * out chunk by chunk. Followers of an asynchronous call are completed on
+     * the thread that completes the shared request.
+     *
+     * @param coalescer The coalescer; null disables coalescing
+     */
+    void setRequestCoalescer(std::shared_ptr<RequestCoalescer> coalescer) {
+        std::atomic_store(&requestCoalescer_, std::move(coalescer));
     }
 
+    /**
+     * @brief Get the request coalescer
+     *
+     * @return std::shared_ptr<RequestCoalescer> The coalescer, or null if coalescing is disabled
+     */
+    std::shared_ptr<RequestCoalescer> getRequestCoalescer() const { return std::atomic_load(&requestCoalescer_); }
+
+    /**
+     * @brief Govern upstream requests with a per-provider rate limiter
+     *
+     * Every request sent to /ai/query, /ai/query/algorithm or
+     * /ai/query/stream first takes a permit for its provider, so a burst
+     * waits client-side instead of turning into an error storm. Cache hits
+     * and coalesced followers need no permit. Synchronous calls wait on the
+     * calling thread; asynchronous calls return immediately and are sent once
+     * a permit is granted.
+     *
+     * @param limiter The limiter; null disables limiting
+     */
+    void setRateLimiter(std::shared_ptr<RateLimiter> limiter) { std::atomic_store(&rateLimiter_, std::move(limiter)); }
+
+    /**
+     * @brief Get the rate limiter
+     *
+     * @return std::shared_ptr<RateLimiter> The limiter, or null if limiting is disabled
+     */
+    std::shared_ptr<RateLimiter> getRateLimiter() const { return std::atomic_load(&rateLimiter_); }
+
+    /**
+     * @brief Retry failed requests according to per-endpoint policies
+     *
+     * Retries use exponential backoff with full jitter, wait at least as long
+     * as a Retry-After header asks, and draw on a budget shared by all calls
+     * so an outage does not multiply the load. Login and token refresh are
+     * only retried when the server provably did not process them; streams
+     * only until the first chunk reached the callback. Each attempt takes
+     * its own rate limiter permit.
+     *
+     * @param retrier The retrier; null disables retries
+     */
+    void setRetrier(std::shared_ptr<Retrier> retrier) { std::atomic_store(&retrier_, std::move(retrier)); }
+
+    /**
+     * @brief Get the retrier
+     *
+     * @return std::shared_ptr<Retrier> The retrier, or null if retries are disabled
+     */
+    std::shared_ptr<Retrier> getRetrier() const { return std::atomic_load(&retrier_); }
+
+    /**
+     * @brief Hedge slow queries to cut tail latency
+     *
+     * A query still unanswered after a high percentile of recent latencies
+     * is sent again over the pooled asynchronous transport; the first
+     * response wins and the other request is cancelled. Synchronous hedged
+     * calls use the asynchronous transport as well, so they bypass a custom
+     * HttpClient. The hedge shares the original request's rate limiter
+     * permit and retry attempt.
+     *
+     * @param hedger The hedger; null disables hedging
+     */
+    void setHedger(std::shared_ptr<Hedger> hedger) { std::atomic_store(&hedger_, std::move(hedger)); }
+
+    /**
+     * @brief Get the hedger
+     *
+     * @return std::shared_ptr<Hedger> The hedger, or null if hedging is disabled
+     */
+    std::shared_ptr<Hedger> getHedger() const { return std::atomic_load(&hedger_); }
+
+    /**
+     * @brief Record per-endpoint and per-provider metrics
+     *
+     * Every attempt records its latency, status code and payload sizes;
+     * the built-in transports add time to first byte, header bytes and time
+     * queued for a pooled connection. Retries and the time to the first
+     * decoded event of queryStreamEvents are counted as well. A registry may
+     * be shared by several clients; read it with Metrics::snapshot() or
+     * export it with prometheus::format().
+     *
+     * @param metrics The registry; null disables metrics
+     */
+    void setMetrics(std::shared_ptr<Metrics> metrics) { std::atomic_store(&metrics_, std::move(metrics)); }
+
+    /**
+     * @brief Get the metrics registry
+     *
+     * @return std::shared_ptr<Metrics> The registry, or null if metrics are disabled
+     */
+    std::shared_ptr<Metrics> getMetrics() const { return std::atomic_load(&metrics_); }
+
+    /**
+     * @brief Choose the encoding of query request bodies
+     *
+     * With WireFormat::CBOR or WireFormat::MSGPACK, the bodies of queries,
+     * algorithm queries and streams are sent in that format, with images as
+     * raw byte strings instead of base64 text, and the same format is asked
+     * for through Accept. Responses are decoded according to their
+     * Content-Type, so a server that still answers in JSON keeps working.
+     * Login and token refresh always use JSON.
+     *
+     * @param format The wire format; WireFormat::JSON by default
+     */
+    void setWireFormat(dto::WireFormat format) { wireFormat_->store(format, std::memory_order_relaxed); }
+
+    /**
+     * @brief Get the encoding of query request bodies
+     *
+     * @return dto::WireFormat The wire format
+     */
+    dto::WireFormat getWireFormat() const { return wireFormat_->load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Get the expiry of the current token
+     *
+     * @return std::optional<std::chrono::system_clock::time_point> The token's exp claim, if it has one
+     */
+    std::optional<std::chrono::system_clock::time_point> getTokenExpiry() const {
+        return jwt::expiry(tokens_->get());
+    }
+
+    /**
+     * @brief Renew the token in the background before it expires
+     *
+     * A refresher thread reads the exp claim of the current token and calls
+     * /auth/refresh options.margin ahead of it, then swaps the new token in,
+     * so requests never wait on a refresh. Logging in or setting a token
+     * reschedules it. Failed refreshes are retried every
+     * options.retryInterval until the token is replaced.
+     *
+     * The refresher shares the HTTP client with the calling threads, so a
+     * custom HttpClient must be safe for concurrent calls.
+     *
+     * @param options Refresh margin, retry interval and error observer
+     */
+    void enableAutoRefresh(const AutoRefreshOptions& options = {}) {
+        disableAutoRefresh();
+        std::shared_ptr<HttpClient> http = httpClient_;
+        std::shared_ptr<TokenStore> tokens = tokens_;
+        refresher_ = std::make_unique<TokenRefresher>(tokens_, [http, tokens] {
+            std::string token = tokens->get();
+            if (token.empty()) {
+                return;
+            }
+            tokens->set(requestRefresh(*http, token).getToken());
+        }, options);
+    }
+
+    /**
+     * @brief Stop renewing the token in the background
+     */
+    void disableAutoRefresh() { refresher_.reset(); }
+
 private:
-    std::unique_ptr<HttpClient> httpClient_;
-    std::string token_;
+    /**
+     * @brief Per-thread request body buffer, reused across calls
+     *
+     * Falls back to a private string when the thread's buffer is already in
+     * use (e.g. a query issued from inside a stream callback). Buffers that
+     * grew past kMaxRetainedCapacity are released so one huge request does not
+     * pin memory for the lifetime of the thread.
+     */
+    class ScratchBuffer {
+    public:
+        static constexpr std::size_t kMaxRetainedCapacity = 4 * 1024 * 1024;
+
+        ScratchBuffer() {
+            Slot& slot = threadSlot();
+            if (!slot.inUse) {
+                slot.inUse = true;
+                buffer_ = &slot.buffer;
+            } else {
+                buffer_ = &fallback_;
+            }
+        }
+
+        ~ScratchBuffer() {
+            Slot& slot = threadSlot();
+            if (buffer_ == &slot.buffer) {
+                if (slot.buffer.capacity() > kMaxRetainedCapacity) {
+                    std::string().swap(slot.buffer);
+                }
+                slot.inUse = false;
+            }
+        }
+
+        ScratchBuffer(const ScratchBuffer&) = delete;
+        ScratchBuffer& operator=(const ScratchBuffer&) = delete;
+
+        std::string& operator*() { return *buffer_; }
+
+    private:
+        struct Slot {
+            std::string buffer;
+            bool inUse = false;
+        };
+
+        static Slot& threadSlot() {
+            thread_local Slot slot;
+            return slot;
+        }
+
+        std::string* buffer_;
+        std::string fallback_;
+    };
+
+    std::shared_ptr<const TokenStore::Snapshot> authorization() const {
+        std::shared_ptr<const TokenStore::Snapshot> snapshot = tokens_->snapshot();
+        if (snapshot->token.empty()) {
+            throw std::runtime_error("No token available. Please login first.");
+        }
+        return snapshot;
+    }
+
+    template <typename T>
+    T postQuery(Endpoint endpoint, const dto::AIQueryRequest& request) {
+        const std::string path = endpointPath(endpoint);
+        request.validate();
+        auto auth = authorization();
+        const dto::WireFormat format = getWireFormat();
+        std::vector<std::string> negotiated;
+        const std::vector<std::string>& headers = queryHeaders(*auth, format, negotiated);
+        std::shared_ptr<ResponseCache> cache = std::atomic_load(&responseCache_);
+        const CallOptions* call = CallScope::current();
+        std::shared_ptr<RequestCoalescer> coalescer = call ? nullptr : std::atomic_load(&requestCoalescer_);
+        ResponseCache::Key key;
+        if (cache || coalescer) {
+            key = ResponseCache::makeKey(path, request, format);
+        }
+        if (cache) {
+            if (auto cached = cache->find(key)) {
+                return T::parse(*cached, format);
+            }
+        }
+        auto send = [&] {
+            return retried(endpoint, request.getProvider(), [&] {
+                return throttled(request.getProvider(), false, [&] {
+                    if (!request.getImageFiles().empty()) {
+                        // Image files are streamed from their mappings. Hedging would
+                        // need the body twice at once, so it is skipped.
+                        std::unique_ptr<dto::SegmentedBody> body = request.openBodyStream(format);
+                        return observed(endpoint, request.getProvider(), body->size(), [&] {
+                            return httpClient_->post(path, *body, dto::WireFormatToContentType(format), headers);
+                        });
+                    }
+                    std::shared_ptr<Hedger> hedger = std::atomic_load(&hedger_);
+                    if (hedger && hedger->hedges(endpoint)) {
+                        // Hedging needs the cancellable asynchronous transport.
+                        AsyncHttpRequest hedged;
+                        hedged.path = path;
+                        request.write(format, hedged.body);
+                        hedged.contentType = dto::WireFormatToContentType(format);
+                        hedged.headers = headers;
+                        if (call) {
+                            hedged.options = *call;
+                        }
+                        const std::size_t size = hedged.body.size();
+                        return observed(endpoint, request.getProvider(), size, [&] {
+                            return hedger->run(asyncHttpClient(), endpoint, std::move(hedged));
+                        });
+                    }
+                    ScratchBuffer body;
+                    request.write(format, *body);
+                    return observed(endpoint, request.getProvider(), (*body).size(), [&] {
+                        return httpClient_->post(path, *body, dto::WireFormatToContentType(format), headers);
+                    });
+                });
+            });
+        };
+        bool shared = false;
+        HttpResponse response = coalescer ? coalescer->run(key, send, &shared) : send();
+        if (response.statusCode != 200) {
+            throw statusError(response);
+        }
+        const dto::WireFormat received = responseFormat(response);
+        T result = T::parse(response.body, received);
+        if (cache && !shared && received == format) {
+            cache->insert(key, std::move(response.body));
+        }
+        return result;
+    }
+
+    template <typename T>
+    void sendQueryAsync(Endpoint endpoint, const dto::AIQueryRequest& request, AsyncCallback<T> callback,
+                        const CallOptions& options) {
+        std::shared_ptr<ResponseCache> cache = std::atomic_load(&responseCache_);
+        std::shared_ptr<RequestCoalescer> coalescer =
+            options.active() ? nullptr : std::atomic_load(&requestCoalescer_);
+        if (!cache && !coalescer) {
+            sendAsync(endpoint, request, options, nullptr, completion<T>(std::move(callback), [](HttpResponse& response) {
+                return T::parse(response.body, responseFormat(response));
+            }));
+            return;
+        }
+        request.validate();
+        authorization();
+        const dto::WireFormat format = getWireFormat();
+        ResponseCache::Key key = ResponseCache::makeKey(endpointPath(endpoint), request, format);
+        if (auto cached = cache ? cache->find(key) : nullptr) {
+            T result;
+            std::exception_ptr error;
+            try {
+                result = T::parse(*cached, format);
+            } catch (...) {
+                error = std::current_exception();
+            }
+            callback(std::move(result), error);
+            return;
+        }
+        if (coalescer && !coalescer->join(key, completion<T>(callback, [](HttpResponse& response) {
+                return T::parse(response.body, responseFormat(response));
+            }))) {
+            return;
+        }
+        AsyncCompletion done = completion<T>(std::move(callback), [cache, key, format](HttpResponse& response) {
+            const dto::WireFormat received = responseFormat(response);
+            T result = T::parse(response.body, received);
+            if (cache && received == format) {
+                cache->insert(key, std::move(response.body));
+            }
+            return result;
+        });
+        if (!coalescer) {
+            sendAsync(endpoint, request, options, nullptr, std::move(done));
+            return;
+        }
+        try {
+            sendAsync(endpoint, request, options, nullptr,
+                [coalescer, key, done = std::move(done)](HttpResponse response, std::exception_ptr error) {
+                    coalescer->complete(key, response, error);
+                    done(std::move(response), error);
+                });
+        } catch (...) {
+            coalescer->complete(key, HttpResponse(), std::current_exception());
+            throw;
+        }
+    }
+
+    template <typename Send>
+    static HttpResponse coalescedStream(RequestCoalescer& coalescer, const RequestCoalescer::Key& key,
+                                        const StreamCallback& callback, Send& send) {
+        bool leader = false;
+        std::shared_ptr<RequestCoalescer::StreamFlight> flight = coalescer.joinStream(key, leader);
+        if (!leader) {
+            // Followers get the status code; the leader's error body is not shared.
+            return HttpResponse{flight->consume(callback), std::string(), {}, {}};
+        }
+        // The leader keeps reading for its followers after its own callback
+        // declines or throws; its own error is rethrown once the stream ends.
+        bool leaderWants = true;
+        std::exception_ptr callbackError;
+        HttpResponse response;
+        try {
+            response = send([&](const std::string& chunk, bool done) {
+                if (leaderWants) {
+                    try {
+                        leaderWants = callback(chunk, done);
+                    } catch (...) {
+                        callbackError = std::current_exception();
+                        leaderWants = false;
+                    }
+                }
+                bool followersWant = flight->publish(chunk, done);
+                return coalescer.keepStreaming(*flight, leaderWants, followersWant);
+            });
+        } catch (...) {
+            coalescer.finishStream(key, flight, 0, std::current_exception());
+            throw;
+        }
+        coalescer.finishStream(key, flight, response.statusCode, nullptr);
+        if (callbackError) {
+            std::rethrow_exception(callbackError);
+        }
+        return response;
+    }
+
+    static HttpResponse postRefresh(HttpClient& http, const std::string& token) {
+        return http.post("/auth/refresh", "{}", "application/json", {"Authorization: Bearer " + token});
+    }
+
+    static dto::TokenResponse requestRefresh(HttpClient& http, const std::string& token) {
+        auto response = postRefresh(http, token);
+        if (response.statusCode != 200) {
+            throw statusError(response);
+        }
+        return dto::TokenResponse::parse(response.body, responseFormat(response));
+    }
+
+    /// Wire format of a response body, from its Content-Type.
+    static dto::WireFormat responseFormat(const HttpResponse& response) {
+        std::string contentType;
+        return wire::findHeader(response.headers, "Content-Type", contentType) ? dto::toWireFormat(contentType)
+                                                                               : dto::WireFormat::JSON;
+    }
+
+    /// Headers of a query: the authorization, plus Accept when asking for a binary format.
+    static const std::vector<std::string>& queryHeaders(const TokenStore::Snapshot& auth,
+                                                        dto::WireFormat format,
+                                                        std::vector<std::string>& storage) {
+        if (format == dto::WireFormat::JSON) {
+            return auth.headers;
+        }
+        storage = auth.headers;
+        storage.push_back(acceptHeader(format));
+        return storage;
+    }
+
+    /// Accept header asking for a binary format, with JSON as the fallback.
+    static std::string acceptHeader(dto::WireFormat format) {
+        return std::string("Accept: ") + dto::WireFormatToContentType(format) + ", application/json;q=0.5";
+    }
+
+    static HttpStatusError statusError(const HttpResponse& response) {
+        std::string message;
+        try {
+            message = dto::Error::parse(response.body, responseFormat(response)).getError();
+        } catch (const std::exception&) {
+            // Not a JSON error body, e.g. from a proxy.
+        }
+        if (message.empty()) {
+            message = "Request failed with status code: " + std::to_string(response.statusCode);
+        }
+        return HttpStatusError(response.statusCode, message, response.headers);
+    }
+
+    std::shared_ptr<AsyncHttpClient> asyncHttpClient() {
+        std::shared_ptr<AsyncHttpClient> client = std::atomic_load(&asyncHttpClient_);
+        if (!client) {
+            AsyncHttpClient::Factory factory = AsyncHttpClient::defaultFactory();
+            if (factory == nullptr) {
+                throw std::logic_error("SauronClient: no AsyncHttpClient; pass one to the constructor or include "
+                                       "sauron/client/DefaultHttpClient.hpp");
+            }
+            std::shared_ptr<AsyncHttpClient> created = factory(httpClient_->getBaseUrl());
+            if (std::atomic_compare_exchange_strong(&asyncHttpClient_, &client, created)) {
+                client = std::move(created);
+            }
+        }
+        return client;
+    }
+
+    /// One asynchronous call across its attempts.
+    struct AsyncCall {
+        AsyncHttpRequest request; ///< Template copied per attempt when retries are enabled
+        Endpoint endpoint;
+        dto::AIProvider provider;
+        AsyncCompletion onComplete;
+        std::weak_ptr<AsyncHttpClient> client; ///< Weak: a pending retry must not keep the transport alive
+        std::shared_ptr<RateLimiter> limiter;
+        std::shared_ptr<Retrier> retrier;
+        std::shared_ptr<Hedger> hedger;
+        std::shared_ptr<Metrics> metrics;
+        int attempts = 0;
+        std::atomic<bool> delivered{false};
+    };
+
+    void sendAsync(Endpoint endpoint,
+                   const dto::AIQueryRequest& request,
+                   const CallOptions& options,
+                   StreamCallback onData,
+                   AsyncCompletion onComplete) {
+        request.validate();
+        auto auth = authorization();
+        auto call = std::make_shared<AsyncCall>();
+        const dto::WireFormat format = getWireFormat();
+        call->request.path = endpointPath(endpoint);
+        if (!request.getImageFiles().empty()) {
+            // Attempts run one after another, so they can share the stream
+            call->request.bodyStream = request.openBodyStream(format);
+        } else {
+            request.write(format, call->request.body);
+        }
+        call->request.contentType = dto::WireFormatToContentType(format);
+        call->request.headers = auth->headers;
+        if (format != dto::WireFormat::JSON && !onData) {
+            // Streams answer with SSE whatever the request format
+            call->request.headers.push_back(acceptHeader(format));
+        }
+        call->request.onData = std::move(onData);
+        call->request.options = options;
+        call->endpoint = endpoint;
+        call->provider = request.getProvider();
+        call->onComplete = std::move(onComplete);
+        call->client = asyncHttpClient();
+        call->limiter = std::atomic_load(&rateLimiter_);
+        call->retrier = std::atomic_load(&retrier_);
+        if (!call->request.bodyStream) {
+            call->hedger = std::atomic_load(&hedger_);
+        }
+        call->metrics = std::atomic_load(&metrics_);
+        if (call->retrier) {
+            call->retrier->recordRequest();
+        }
+        startAttempt(std::move(call));
+    }
+
+    static void startAttempt(std::shared_ptr<AsyncCall> call) {
+        const CallOptions& options = call->request.options;
+        if (options.stopped()) {
+            call->onComplete(HttpResponse(), options.stopError());
+            return;
+        }
+        if (++call->attempts > 1 && call->metrics) {
+            call->metrics->recordRetry(call->endpoint, call->provider);
+        }
+        if (!call->retrier) {
+            dispatch(call, std::move(call->request), std::move(call->onComplete));
+            return;
+        }
+        AsyncHttpRequest request = call->request;
+        if (request.onData) {
+            request.onData = [call](const std::string& chunk, bool done) {
+                call->delivered.store(true, std::memory_order_relaxed);
+                return call->request.onData(chunk, done);
+            };
+        }
+        dispatch(call, std::move(request), [call](HttpResponse response, std::exception_ptr error) {
+            AttemptOutcome outcome;
+            outcome.error = error;
+            if (!error) {
+                outcome.statusCode = response.statusCode;
+                outcome.headers = &response.headers;
+            }
+            outcome.delivered = call->delivered.load(std::memory_order_relaxed);
+            auto delay = call->retrier->retryDelay(call->endpoint, call->attempts, outcome);
+            const CallOptions& options = call->request.options;
+            if (delay && options.deadline - CallOptions::Clock::now() > *delay) {
+                call->retrier->schedule(*delay, [call] {
+                    try {
+                        startAttempt(call);
+                    } catch (...) {
+                        call->onComplete(HttpResponse(), std::current_exception());
+                    }
+                });
+                return;
+            }
+            call->onComplete(std::move(response), error);
+        });
+    }
+
+    static void dispatch(const std::shared_ptr<AsyncCall>& call, AsyncHttpRequest request,
+                         AsyncCompletion onComplete) {
+        std::shared_ptr<AsyncHttpClient> client = call->client.lock();
+        if (!client) {
+            // The client was destroyed while a retry was pending.
+            onComplete(HttpResponse(), std::make_exception_ptr(RequestCancelled("SauronClient destroyed")));
+            return;
+        }
+        if (!call->limiter) {
+            transmit(*call, client, std::move(request), std::move(onComplete));
+            return;
+        }
+        // The request is sent from whichever thread the permit is granted on.
+        bool stream = static_cast<bool>(request.onData);
+        auto pending = std::make_shared<AsyncHttpRequest>(std::move(request));
+        call->limiter->acquireAsync(call->provider,
+            [call, client, pending, stream, onComplete](RateLimiter::Permit permit) {
+                auto held = std::make_shared<RateLimiter::Permit>(std::move(permit));
+                try {
+                    transmit(*call, client, std::move(*pending),
+                        [held, stream, onComplete](HttpResponse response, std::exception_ptr error) {
+                            if (!error) {
+                                held->complete(response.statusCode, !stream);
+                            } else if (isTransportError(error)) {
+                                held->fail();
+                            } else {
+                                held->release();
+                            }
+                            onComplete(std::move(response), error);
+                        });
+                } catch (...) {
+                    held->release();
+                    onComplete(HttpResponse(), std::current_exception());
+                }
+            },
+            pending->options, [onComplete](std::exception_ptr error) { onComplete(HttpResponse(), error); });
+    }
+
+    static void transmit(const AsyncCall& call, const std::shared_ptr<AsyncHttpClient>& client,
+                         AsyncHttpRequest request, AsyncCompletion onComplete) {
+        if (call.metrics) {
+            RequestSample sample;
+            sample.endpoint = call.endpoint;
+            sample.provider = call.provider;
+            std::size_t bodySize = request.bodyStream ? 0 : request.body.size();
+            onComplete = [metrics = call.metrics, sample, bodySize, start = Metrics::Clock::now(),
+                          onComplete = std::move(onComplete)](HttpResponse response, std::exception_ptr error) mutable {
+                sample.latency = Metrics::Clock::now() - start;
+                if (!error) {
+                    sample.statusCode = response.statusCode;
+                    sample.timing = withFallbacks(response, bodySize);
+                }
+                metrics->record(sample);
+                onComplete(std::move(response), error);
+            };
+        }
+        if (call.hedger) {
+            call.hedger->send(client, call.endpoint, std::move(request), std::move(onComplete));
+        } else {
+            client->send(std::move(request), std::move(onComplete));
+        }
+    }
+
+    /// Fills in sizes a custom transport did not report from what the SDK itself saw.
+    static HttpTiming withFallbacks(const HttpResponse& response, std::size_t bodySize) {
+        HttpTiming timing = response.timing;
+        if (timing.bytesSent == 0) {
+            timing.bytesSent = bodySize;
+        }
+        if (timing.bytesReceived == 0) {
+            timing.bytesReceived = response.body.size();
+        }
+        return timing;
+    }
+
+    template <typename Send>
+    HttpResponse observed(Endpoint endpoint, std::optional<dto::AIProvider> provider, std::size_t bodySize,
+                          Send&& send) {
+        std::shared_ptr<Metrics> metrics = std::atomic_load(&metrics_);
+        if (!metrics) {
+            return send();
+        }
+        RequestSample sample;
+        sample.endpoint = endpoint;
+        sample.provider = provider;
+        Metrics::Clock::time_point start = Metrics::Clock::now();
+        try {
+            HttpResponse response = send();
+            sample.latency = Metrics::Clock::now() - start;
+            sample.statusCode = response.statusCode;
+            sample.timing = withFallbacks(response, bodySize);
+            metrics->record(sample);
+            return response;
+        } catch (...) {
+            sample.latency = Metrics::Clock::now() - start;
+            metrics->record(sample);
+            throw;
+        }
+    }
+
+    /// Posts a query whose response is read as it arrives; returns it without the streamed body.
+    HttpResponse postStreamQuery(Endpoint endpoint, const dto::AIQueryRequest& request, const StreamCallback& callback) {
+        const char* path = endpointPath(endpoint);
+        request.validate();
+        auto auth = authorization();
+        const dto::WireFormat format = getWireFormat();
+        auto send = [&](const StreamCallback& onChunk) {
+            // Only a stream that has not delivered anything yet may be retried.
+            bool delivered = false;
+            StreamCallback tracked = [&](const std::string& chunk, bool done) {
+                delivered = true;
+                return onChunk(chunk, done);
+            };
+            return retried(endpoint, request.getProvider(), [&] {
+                return throttled(request.getProvider(), true, [&] {
+                    if (!request.getImageFiles().empty()) {
+                        std::unique_ptr<dto::SegmentedBody> body = request.openBodyStream(format);
+                        auto post = [&](const StreamCallback& onData) {
+                            return httpClient_->postStreamResponse(path, *body,
+                                                           dto::WireFormatToContentType(format), onData, auth->headers);
+                        };
+                        return observedStream(endpoint, request.getProvider(), body->size(), tracked, post);
+                    }
+                    ScratchBuffer body;
+                    request.write(format, *body);
+                    auto post = [&](const StreamCallback& onData) {
+                        return httpClient_->postStreamResponse(path, *body,
+                                                       dto::WireFormatToContentType(format), onData, auth->headers);
+                    };
+                    return observedStream(endpoint, request.getProvider(), (*body).size(), tracked, post);
+                });
+            }, &delivered);
+        };
+        std::shared_ptr<RequestCoalescer> coalescer =
+            CallScope::current() ? nullptr : std::atomic_load(&requestCoalescer_);
+        return coalescer
+            ? coalescedStream(*coalescer, ResponseCache::makeKey(path, request), callback, send)
+            : send(callback);
+    }
+
+    template <typename Send>
+    HttpResponse observedStream(Endpoint endpoint, dto::AIProvider provider, std::size_t bodySize, const StreamCallback& onChunk, Send&& send) {
+        std::shared_ptr<Metrics> metrics = std::atomic_load(&metrics_);
+        if (!metrics) {
+            return send(onChunk);
+        }
+        RequestSample sample;
+        sample.endpoint = endpoint;
+        sample.provider = provider;
+        sample.timing.bytesSent = bodySize;
+        Metrics::Clock::time_point start = Metrics::Clock::now();
+        // The synchronous transport reports no timing for streams; measure at the callback.
+        StreamCallback counted = [&](const std::string& chunk, bool done) {
+            if (sample.timing.firstByte.count() == 0 && !chunk.empty()) {
+                sample.timing.firstByte = Metrics::Clock::now() - start;
+            }
+            sample.timing.bytesReceived += chunk.size();
+            return onChunk(chunk, done);
+        };
+        HttpResponse response;
+        try {
+            response = send(counted);
+        } catch (...) {
+            sample.latency = Metrics::Clock::now() - start;
+            metrics->record(sample);
+            throw;
+        }
+        sample.statusCode = response.statusCode;
+        sample.latency = Metrics::Clock::now() - start;
+        metrics->record(sample);
+        return response;
+    }
+
+    SseDecoder::EventCallback firstEventObserver(dto::AIProvider provider, const SseDecoder::EventCallback& onEvent) {
+        std::shared_ptr<Metrics> metrics = std::atomic_load(&metrics_);
+        if (!metrics) {
+            return nullptr;
+        }
+        auto start = Metrics::Clock::now();
+        auto seen = std::make_shared<bool>(false);
+        return [metrics, provider, start, seen, onEvent](const SseEvent& event) {
+            if (!*seen) {
+                *seen = true;
+                metrics->recordFirstEvent(Endpoint::QueryStream, provider, Metrics::Clock::now() - start);
+            }
+            return onEvent(event);
+        };
+    }
+
+    template <typename Send>
+    auto retried(Endpoint endpoint, std::optional<dto::AIProvider> provider, Send&& send,
+                 const bool* delivered = nullptr) -> decltype(send()) {
+        std::shared_ptr<Retrier> retrier = std::atomic_load(&retrier_);
+        if (!retrier) {
+            return send();
+        }
+        std::shared_ptr<Metrics> metrics = std::atomic_load(&metrics_);
+        int attempts = 0;
+        return retrier->run(endpoint, [&] {
+            if (attempts++ > 0 && metrics) {
+                metrics->recordRetry(endpoint, provider);
+            }
+            return send();
+        }, delivered);
+    }
+
+    template <typename Send>
+    auto throttled(dto::AIProvider provider, bool stream, Send&& send) -> decltype(send()) {
+        std::shared_ptr<RateLimiter> limiter = std::atomic_load(&rateLimiter_);
+        if (!limiter) {
+            return send();
+        }
+        RateLimiter::Permit permit = limiter->acquire(provider, CallScope::current());
+        try {
+            auto result = send();
+            permit.complete(statusOf(result), !stream);
+            return result;
+        } catch (const TransportError&) {
+            permit.fail();
+            throw;
+        }
+    }
+
+    static int statusOf(const HttpResponse& response) { return response.statusCode; }
+    static int statusOf(int statusCode) { return statusCode; }
+
+    static bool isTransportError(const std::exception_ptr& error) {
+        try {
+            std::rethrow_exception(error);
+        } catch (const TransportError&) {
+            return true;
+        } catch (...) {
+            return false;
+        }
+    }
+
+    template <typename T, typename Parse>
+    static AsyncCompletion completion(AsyncCallback<T> callback, Parse parse) {
+        return [callback = std::move(callback), parse](HttpResponse response, std::exception_ptr error) {
+            T result;
+            if (!error) {
+                try {
+                    if (response.statusCode != 200) {
+                        throw statusError(response);
+                    }
+                    result = parse(response);
+                } catch (...) {
+                    error = std::current_exception();
+                }
+            }
+            callback(std::move(result), error);
+        };
+    }
+
+    template <typename T, typename Start>
+    static std::future<T> toFuture(Start start) {
+        auto promise = std::make_shared<std::promise<T>>();
+        std::future<T> future = promise->get_future();
+        start([promise](T result, std::exception_ptr error) {
+            if (error) {
+                promise->set_exception(error);
+            } else {
+                promise->set_value(std::move(result));
+            }
+        });
+        return future;
+    }
+
+    std::shared_ptr<HttpClient> httpClient_;
+    std::shared_ptr<AsyncHttpClient> asyncHttpClient_;
+    std::shared_ptr<TokenStore> tokens_ = std::make_shared<TokenStore>();
+    std::shared_ptr<ResponseCache> responseCache_;
+    std::shared_ptr<RequestCoalescer> requestCoalescer_;
+    std::shared_ptr<RateLimiter> rateLimiter_;
+    std::shared_ptr<Retrier> retrier_;
+    std::shared_ptr<Hedger> hedger_;
+    std::shared_ptr<Metrics> metrics_;
+    std::shared_ptr<std::atomic<dto::WireFormat>> wireFormat_ =
+        std::make_shared<std::atomic<dto::WireFormat>>(dto::WireFormat::JSON); ///< Shared so the client stays movable
+    std::unique_ptr<TokenRefresher> refresher_; ///< Declared last: stopped before the members it uses
+
 };
 
 } // namespace client
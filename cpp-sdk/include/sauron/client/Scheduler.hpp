@@ -0,0 +1,117 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace sauron {
+namespace client {
+
+/**
+ * @brief Runs tasks at a point in time on one background thread
+ *
+ * The thread starts on the first schedule() call. Tasks may hold the last
+ * reference to the scheduler's owner: destroying the scheduler from one of
+ * its own tasks is safe. Tasks still pending at destruction are dropped.
+ */
+class Scheduler {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    Scheduler() : state_(std::make_shared<State>()) {}
+
+    ~Scheduler() {
+        {
+            std::lock_guard<std::mutex> lock(state_->mutex);
+            state_->stopping = true;
+        }
+        state_->wake.notify_all();
+        if (thread_.joinable()) {
+            if (thread_.get_id() == std::this_thread::get_id()) {
+                thread_.detach(); // destroyed by one of its own tasks
+            } else {
+                thread_.join();
+            }
+        }
+    }
+
+    Scheduler(const Scheduler&) = delete;
+    Scheduler& operator=(const Scheduler&) = delete;
+
+    /**
+     * @brief Run a task at a point in time
+     *
+     * @param at When to run it
+     * @param task The task; runs on the scheduler thread and must not block
+     */
+    void schedule(Clock::time_point at, std::function<void()> task) {
+        {
+            std::lock_guard<std::mutex> lock(state_->mutex);
+            if (state_->stopping) {
+                return;
+            }
+            state_->tasks.push(Task{at, state_->sequence++, std::move(task)});
+            if (!thread_.joinable()) {
+                thread_ = std::thread(run, state_);
+            }
+        }
+        state_->wake.notify_all();
+    }
+
+private:
+    struct Task {
+        Clock::time_point at;
+        std::uint64_t sequence; ///< Keeps tasks due at the same time in FIFO order
+        std::function<void()> run;
+
+        bool operator>(const Task& other) const {
+            return at != other.at ? at > other.at : sequence > other.sequence;
+        }
+    };
+
+    /// Shared with the thread so it outlives a scheduler destroyed from a task.
+    struct State {
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::priority_queue<Task, std::vector<Task>, std::greater<Task>> tasks;
+        std::uint64_t sequence = 0;
+        bool stopping = false;
+    };
+
+    static void run(std::shared_ptr<State> state) {
+        std::unique_lock<std::mutex> lock(state->mutex);
+        while (!state->stopping) {
+            if (state->tasks.empty()) {
+                state->wake.wait(lock);
+                continue;
+            }
+            Clock::time_point at = state->tasks.top().at; // copied: the queue may grow while waiting
+            if (Clock::now() < at) {
+                state->wake.wait_until(lock, at);
+                continue;
+            }
+            std::function<void()> task = std::move(const_cast<Task&>(state->tasks.top()).run);
+            state->tasks.pop();
+            lock.unlock();
+            try {
+                task();
+            } catch (...) {
+                // Tasks report their own failures; keep the thread alive for the others.
+            }
+            task = nullptr; // may destroy the owner; only the shared state is used from here on
+            lock.lock();
+        }
+    }
+
+    std::shared_ptr<State> state_;
+    std::thread thread_;
+};
+
+} // namespace client
+} // namespace sauron
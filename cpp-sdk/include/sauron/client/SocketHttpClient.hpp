@@ -0,0 +1,509 @@
+#pragma once
+
+#include "HttpClient.hpp"
+#include "Cancellation.hpp"
+#include "Compression.hpp"
+#include "ConnectionPool.hpp"
+#include "HttpWire.hpp"
+#include "TransportError.hpp"
+#include "Url.hpp"
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+namespace sauron {
+namespace client {
+
+/**
+ * @brief Built-in HttpClient over plain Linux sockets
+ *
+ * Speaks HTTP/1.1 with persistent connections taken from a ConnectionPool,
+ * so consecutive get/post/postStream calls to the same origin reuse an
+ * established TCP connection instead of paying a new handshake. The client
+ * is safe to use from several threads; each call leases its own connection.
+ *
+ * Calls made inside a CallScope stop as soon as its deadline passes or its
+ * token is cancelled, at any step from waiting for a pooled connection to
+ * reading the last chunk of a stream. A connection whose request was not
+ * sent yet goes back to the pool; any other is closed.
+ */
+class SocketHttpClient : public HttpClient {
+public:
+    /**
+     * @brief Constructor with a private pool
+     *
+     * @param baseUrl The base URL, e.g. "http://localhost:3000"
+     * @param options Options for the connection pool
+     */
+    explicit SocketHttpClient(const std::string& baseUrl = "",
+                              const ConnectionPoolOptions& options = {})
+        : SocketHttpClient(baseUrl, ConnectionPool::create(options)) {}
+
+    /**
+     * @brief Constructor with a shared pool
+     *
+     * @param baseUrl The base URL, e.g. "http://localhost:3000"
+     * @param pool Connection pool, possibly shared with other clients
+     */
+    SocketHttpClient(const std::string& baseUrl, std::shared_ptr<ConnectionPool> pool)
+        : pool_(std::move(pool)) {
+        if (!baseUrl.empty()) {
+            setBaseUrl(baseUrl);
+        }
+    }
+
+    void setBaseUrl(const std::string& url) override {
+        Url parsed = Url::parse(url);
+        if (parsed.scheme != "http") {
+            throw std::invalid_argument("SocketHttpClient only supports http:// URLs: " + url);
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        baseUrl_ = url;
+        url_ = std::move(parsed);
+    }
+
+    std::string getBaseUrl() const override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return baseUrl_;
+    }
+
+    void setDefaultHeader(const std::string& name, const std::string& value) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& line : defaultHeaders_) {
+            if (wire::equalsIgnoreCase(wire::headerName(line), name)) {
+                line = name + ": " + value;
+                return;
+            }
+        }
+        defaultHeaders_.push_back(name + ": " + value);
+    }
+
+    void removeDefaultHeader(const std::string& name) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto it = defaultHeaders_.begin(); it != defaultHeaders_.end(); ++it) {
+            if (wire::equalsIgnoreCase(wire::headerName(*it), name)) {
+                defaultHeaders_.erase(it);
+                return;
+            }
+        }
+    }
+
+    void setBearerToken(const std::string& token) override {
+        setDefaultHeader("Authorization", "Bearer " + token);
+    }
+
+    void clearAuthorization() override {
+        removeDefaultHeader("Authorization");
+    }
+
+    HttpResponse get(const std::string& path,
+                     const std::vector<std::string>& headers = {}) override {
+        return perform("GET", path, std::string(), std::string(), headers, nullptr);
+    }
+
+    HttpResponse post(const std::string& path,
+                      const nlohmann::json& body,
+                      const std::vector<std::string>& headers = {}) override {
+        return perform("POST", path, body.dump(), "application/json", headers, nullptr);
+    }
+
+    HttpResponse post(const std::string& path,
+                      const std::string& body,
+                      const std::string& contentType,
+                      const std::vector<std::string>& headers = {}) override {
+        return perform("POST", path, body, contentType, headers, nullptr);
+    }
+
+    int postStream(const std::string& path,
+                   const nlohmann::json& body,
+                   const StreamCallback& callback,
+                   const std::vector<std::string>& headers = {}) override {
+        return perform("POST", path, body.dump(), "application/json", headers, &callback).statusCode;
+    }
+
+    int postStream(const std::string& path,
+                   const std::string& body,
+                   const std::string& contentType,
+                   const StreamCallback& callback,
+                   const std::vector<std::string>& headers = {}) override {
+        return perform("POST", path, body, contentType, headers, &callback).statusCode;
+    }
+
+    HttpResponse post(const std::string& path,
+                      dto::BodyStream& body,
+                      const std::string& contentType,
+                      const std::vector<std::string>& headers = {}) override {
+        return perform("POST", path, std::string(), contentType, headers, nullptr, &body);
+    }
+
+    int postStream(const std::string& path,
+                   dto::BodyStream& body,
+                   const std::string& contentType,
+                   const StreamCallback& callback,
+                   const std::vector<std::string>& headers = {}) override {
+        return perform("POST", path, std::string(), contentType, headers, &callback, &body).statusCode;
+    }
+
+    HttpResponse postStreamResponse(const std::string& path,
+                                    const std::string& body,
+                                    const std::string& contentType,
+                                    const StreamCallback& callback,
+                                    const std::vector<std::string>& headers = {}) override {
+        return perform("POST", path, body, contentType, headers, &callback);
+    }
+
+    HttpResponse postStreamResponse(const std::string& path,
+                                    dto::BodyStream& body,
+                                    const std::string& contentType,
+                                    const StreamCallback& callback,
+                                    const std::vector<std::string>& headers = {}) override {
+        return perform("POST", path, std::string(), contentType, headers, &callback, &body);
+    }
+
+    /**
+     * @brief Open pooled connections to the base URL in parallel
+     *
+     * Honours the deadline and token of the calling thread's CallScope.
+     *
+     * @throws TransportError if none of the missing connections could be established
+     * @see ConnectionPool::warmup
+     */
+    std::size_t warmup(std::size_t connections) override {
+        Url url;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (baseUrl_.empty()) {
+                throw std::logic_error("SocketHttpClient: base URL is not set");
+            }
+            url = url_;
+        }
+        return pool_->warmup(url, connections, CallScope::current());
+    }
+
+    /**
+     * @brief Enable or disable body compression
+     *
+     * Streamed bodies (the BodyStream overloads) are never compressed;
+     * their responses are still decompressed.
+     *
+     * @param options Compression options; the default-constructed value turns compression off
+     * @throws std::invalid_argument if the options need a coding that is not compiled in
+     */
+    void setCompression(const CompressionOptions& options) {
+        compression::validate(options);
+        std::lock_guard<std::mutex> lock(mutex_);
+        compression_ = options;
+    }
+
+    /**
+     * @brief Get the compression options
+     */
+    CompressionOptions getCompression() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return compression_;
+    }
+
+    /**
+     * @brief Get the connection pool used by this client
+     */
+    const std::shared_ptr<ConnectionPool>& pool() const { return pool_; }
+
+private:
+    static constexpr std::size_t kReadBufferSize = 16 * 1024;
+
+    HttpResponse perform(const std::string& method,
+                         const std::string& path,
+                         const std::string& body,
+                         const std::string& contentType,
+                         const std::vector<std::string>& headers,
+                         const StreamCallback* stream,
+                         dto::BodyStream* bodyStream = nullptr) {
+        const CallOptions* call = CallScope::current();
+        if (call) {
+            call->check();
+        }
+        Url url;
+        std::string head;
+        CompressionOptions compression;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (baseUrl_.empty()) {
+                throw std::logic_error("SocketHttpClient: base URL is not set");
+            }
+            url = url_;
+            compression = compression_;
+            if (!compression.decompressResponses && !compression.compressRequests) {
+                wire::writeRequestHead(method, url_.basePath + path, url_.hostHeader(), defaultHeaders_,
+                                       headers, contentType, bodyStream != nullptr ? wire::kChunked : body.size(),
+                                       head);
+            }
+        }
+        const std::string* payload = &body;
+        std::string encoded;
+        if (compression.decompressResponses || compression.compressRequests) {
+            // Compress outside the lock; multi-megabyte bodies take a while.
+            std::vector<std::string> extraHeaders = headers;
+            if (compression::prepareRequest(compression, body, extraHeaders, encoded)) {
+                payload = &encoded;
+            }
+            std::lock_guard<std::mutex> lock(mutex_);
+            wire::writeRequestHead(method, url.basePath + path, url.hostHeader(), defaultHeaders_, extraHeaders,
+                                   contentType, bodyStream != nullptr ? wire::kChunked : payload->size(), head);
+        }
+
+        // A pooled connection may have been closed by the server while idle;
+        // if it fails before any response byte arrives, replay once on a new one.
+        Connection::Clock::duration poolWait{};
+        for (int attempt = 0;; ++attempt) {
+            Connection::Clock::duration waited{};
+            ConnectionPool::Lease lease = pool_->acquire(url, &waited, call);
+            poolWait += waited;
+            bool reused = lease.reused();
+            try {
+                HttpResponse response = exchange(lease, head, *payload, bodyStream, stream,
+                                                 compression.decompressResponses, call);
+                response.timing.poolWait = poolWait;
+                return response;
+            } catch (const StaleConnection&) {
+                if (!reused || attempt > 0) {
+                    throw TransportError("Connection closed by peer before the response", true);
+                }
+            }
+        }
+    }
+
+    struct StaleConnection {};
+
+    /// The call's deadline passed or its token was cancelled.
+    struct Stopped {
+        std::exception_ptr error;
+        bool clean; ///< Nothing was sent, so the connection can be reused
+    };
+
+    HttpResponse exchange(ConnectionPool::Lease& lease,
+                          const std::string& head,
+                          const std::string& body,
+                          dto::BodyStream* bodyStream,
+                          const StreamCallback* stream,
+                          bool decompress,
+                          const CallOptions* call) {
+        try {
+            return exchangeOnce(lease, head, body, bodyStream, stream, decompress, call);
+        } catch (const Stopped& stopped) {
+            lease.release(stopped.clean);
+            std::rethrow_exception(stopped.error);
+        }
+    }
+
+    HttpResponse exchangeOnce(ConnectionPool::Lease& lease,
+                              const std::string& head,
+                              const std::string& body,
+                              dto::BodyStream* bodyStream,
+                              const StreamCallback* stream,
+                              bool decompress,
+                              const CallOptions* call) {
+        const Connection::Clock::time_point sentAt = Connection::Clock::now();
+        HttpResponse response;
+        response.statusCode = 0;
+        if (bodyStream != nullptr) {
+            response.timing.bytesSent = sendChunked(lease->fd(), head, *bodyStream, call);
+        } else {
+            sendRequest(lease->fd(), head, body, call);
+            response.timing.bytesSent = head.size() + body.size();
+        }
+
+        HttpResponseParser parser;
+        bool delivered = false;
+        std::string chunk;
+        HttpResponseParser::BodySink deliver = [&](const char* data, std::size_t size) {
+            if (stream != nullptr && parser.statusCode() >= 200 && parser.statusCode() < 300) {
+                delivered = true;
+                chunk.assign(data, size);
+                return (*stream)(chunk, false);
+            }
+            response.body.append(data, size);
+            return true;
+        };
+        compression::BodyDecoder decoder;
+        decoder.reset(decompress);
+        HttpResponseParser::BodySink sink = [&](const char* data, std::size_t size) {
+            return decoder.feed(parser.headers(), data, size, deliver);
+        };
+
+        char buffer[kReadBufferSize];
+        bool received = false;
+        while (!parser.complete() && !parser.aborted()) {
+            if (call) {
+                awaitSocket(lease->fd(), POLLIN, *call, false);
+            }
+            ssize_t n = ::recv(lease->fd(), buffer, sizeof(buffer), 0);
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                if (!received && (errno == ECONNRESET || errno == EPIPE)) {
+                    throw StaleConnection{};
+                }
+                throw TransportError(std::string("Failed to read HTTP response: ") + std::strerror(errno), true);
+            }
+            if (n == 0) {
+                if (!received) {
+                    throw StaleConnection{};
+                }
+                parser.finish();
+                break;
+            }
+            if (!received) {
+                response.timing.firstByte = Connection::Clock::now() - sentAt;
+            }
+            received = true;
+            response.timing.bytesReceived += static_cast<std::size_t>(n);
+            std::size_t consumed = parser.feed(buffer, static_cast<std::size_t>(n), sink);
+            if (parser.complete() && consumed < static_cast<std::size_t>(n)) {
+                // Unexpected bytes after the response: do not reuse the connection.
+                decoder.finish();
+                response.statusCode = parser.statusCode();
+                response.headers = std::move(parser.headers());
+                lease.release(false);
+                finishStream(stream, delivered, parser.statusCode());
+                return response;
+            }
+        }
+
+        if (!parser.aborted()) {
+            decoder.finish();
+        }
+        response.statusCode = parser.statusCode();
+        response.headers = std::move(parser.headers());
+        lease.release(parser.keepAlive());
+        if (!parser.aborted()) {
+            finishStream(stream, delivered, parser.statusCode());
+        }
+        return response;
+    }
+
+    static void finishStream(const StreamCallback* stream, bool delivered, int statusCode) {
+        if (stream != nullptr && (delivered || (statusCode >= 200 && statusCode < 300))) {
+            (*stream)(std::string(), true);
+        }
+    }
+
+    /// Waits until fd is ready for events; throws Stopped once the call must end.
+    static void awaitSocket(int fd, short events, const CallOptions& call, bool clean) {
+        pollfd pfds[2] = {{fd, events, 0}, {-1, POLLIN, 0}};
+        if (call.cancellation) {
+            pfds[1].fd = call.cancellation->fd();
+        }
+        for (;;) {
+            if (call.stopped()) {
+                throw Stopped{call.stopError(), clean};
+            }
+            int ready = ::poll(pfds, 2, call.pollTimeout());
+            if (ready < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                throw TransportError(std::string("Failed to poll socket: ") + std::strerror(errno), !clean);
+            }
+            if (ready > 0 && pfds[0].revents != 0) {
+                return;
+            }
+        }
+    }
+
+    /// Sends without blocking when the call has a deadline or token, polling while the socket is full.
+    static ssize_t sendSome(int fd, msghdr& msg, const CallOptions* call, bool sent) {
+        if (!call) {
+            return ::sendmsg(fd, &msg, MSG_NOSIGNAL);
+        }
+        for (;;) {
+            if (call->stopped()) {
+                throw Stopped{call->stopError(), !sent};
+            }
+            ssize_t n = ::sendmsg(fd, &msg, MSG_NOSIGNAL | MSG_DONTWAIT);
+            if (n >= 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+                return n;
+            }
+            awaitSocket(fd, POLLOUT, *call, !sent);
+        }
+    }
+
+    static void sendRequest(int fd, const std::string& head, const std::string& body, const CallOptions* call) {
+        iovec iov[2];
+        iov[0].iov_base = const_cast<char*>(head.data());
+        iov[0].iov_len = head.size();
+        iov[1].iov_base = const_cast<char*>(body.data());
+        iov[1].iov_len = body.size();
+        int iovcnt = body.empty() ? 1 : 2;
+        iovec* current = iov;
+        bool sent = false;
+
+        while (iovcnt > 0) {
+            msghdr msg{};
+            msg.msg_iov = current;
+            msg.msg_iovlen = static_cast<std::size_t>(iovcnt);
+            ssize_t n = sendSome(fd, msg, call, sent);
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                if (!sent && (errno == EPIPE || errno == ECONNRESET)) {
+                    throw StaleConnection{};
+                }
+                throw TransportError(std::string("Failed to send HTTP request: ") + std::strerror(errno), sent);
+            }
+            sent = true;
+            std::size_t written = static_cast<std::size_t>(n);
+            while (iovcnt > 0 && written >= current->iov_len) {
+                written -= current->iov_len;
+                ++current;
+                --iovcnt;
+            }
+            if (iovcnt > 0) {
+                current->iov_base = static_cast<char*>(current->iov_base) + written;
+                current->iov_len -= written;
+            }
+        }
+    }
+
+    static std::size_t sendChunked(int fd, const std::string& head, dto::BodyStream& body, const CallOptions* call) {
+        body.rewind();
+        wire::ChunkedBodyWriter writer(head, body);
+        iovec iov[wire::ChunkedBodyWriter::kMaxIovecs];
+        std::size_t sent = 0;
+        for (int count = writer.pending(iov); count > 0; count = writer.pending(iov)) {
+            msghdr msg{};
+            msg.msg_iov = iov;
+            msg.msg_iovlen = static_cast<std::size_t>(count);
+            ssize_t n = sendSome(fd, msg, call, sent > 0);
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                if (sent == 0 && (errno == EPIPE || errno == ECONNRESET)) {
+                    throw StaleConnection{};
+                }
+                throw TransportError(std::string("Failed to send HTTP request: ") + std::strerror(errno), sent > 0);
+            }
+            sent += static_cast<std::size_t>(n);
+            writer.advance(static_cast<std::size_t>(n));
+        }
+        return sent;
+    }
+
+    std::shared_ptr<ConnectionPool> pool_;
+    mutable std::mutex mutex_;
+    std::string baseUrl_;
+    Url url_;
+    std::vector<std::string> defaultHeaders_;
+    CompressionOptions compression_;
+};
+
+} // namespace client
+} // namespace sauron
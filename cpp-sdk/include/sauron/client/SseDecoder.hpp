@@ -0,0 +1,230 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace sauron {
+namespace client {
+
+/**
+ * @brief A decoded Server-Sent Event
+ *
+ * Views are only valid during the callback that receives the event: they
+ * point into the chunk passed to SseDecoder::feed() or into the decoder's
+ * own buffers. Copy what must outlive the callback.
+ */
+struct SseEvent {
+    std::string_view event;            ///< Event type ("message" when the frame has no event field)
+    std::string_view data;             ///< Data lines joined with '\n'
+    std::string_view id;               ///< Last event ID seen on the stream
+    std::optional<std::uint32_t> retry; ///< Reconnection time in milliseconds, if the frame set one
+};
+
+/**
+ * @brief Incremental text/event-stream decoder
+ *
+ * Accepts the stream in chunks of any size and dispatches complete events.
+ * Each byte is scanned once: lines are decoded in place from the incoming
+ * chunk, only a line split across chunks is buffered, and the fields of a
+ * frame split across chunks are copied once into the decoder's own buffers,
+ * so a large event arriving in many small reads costs time linear in its
+ * size. Data spanning several lines is joined in a reusable buffer, so
+ * steady-state decoding does not allocate.
+ */
+class SseDecoder {
+public:
+    /**
+     * @brief Receives decoded events
+     *
+     * @return bool False to stop decoding
+     */
+    using EventCallback = std::function<bool(const SseEvent& event)>;
+
+    /**
+     * @brief Feed a chunk of the stream
+     *
+     * A line ends at "\r\n", "\n" or a lone "\r"; a '\n' that starts the
+     * next chunk after a chunk ending in '\r' is skipped.
+     *
+     * @param chunk Bytes received from the transport
+     * @param onEvent Called for every event completed by this chunk
+     * @return bool False if the callback asked to stop
+     */
+    bool feed(std::string_view chunk, const EventCallback& onEvent) {
+        std::size_t pos = 0;
+        if (skipLf_ && !chunk.empty()) {
+            skipLf_ = false;
+            if (chunk.front() == '\n') {
+                pos = 1;
+            }
+        }
+        bool keepGoing = true;
+        while (keepGoing && pos < chunk.size()) {
+            std::size_t eol = chunk.find_first_of("\r\n", pos);
+            if (eol == std::string_view::npos) {
+                pending_.append(chunk.data() + pos, chunk.size() - pos);
+                break;
+            }
+            std::string_view line = chunk.substr(pos, eol - pos);
+            const bool buffered = !pending_.empty();
+            if (buffered) {
+                pending_.append(line.data(), line.size());
+                line = pending_;
+            }
+            pos = eol + 1;
+            if (chunk[eol] == '\r') {
+                if (pos == chunk.size()) {
+                    skipLf_ = true;
+                } else if (chunk[pos] == '\n') {
+                    ++pos;
+                }
+            }
+            if (line.empty()) {
+                keepGoing = dispatch(onEvent);
+            } else {
+                processLine(line);
+                if (buffered) {
+                    ownFrame(); // the line's views point into pending_
+                }
+            }
+            if (buffered) {
+                pending_.clear();
+            }
+        }
+
+        // Fields of an unfinished frame must outlive the chunk they point into.
+        ownFrame();
+        return keepGoing;
+    }
+
+    /**
+     * @brief End the stream
+     *
+     * An unfinished frame is discarded, as the event stream format requires,
+     * and the decoder is ready for another stream.
+     */
+    void finish() { reset(); }
+
+    /**
+     * @brief Forget buffered bytes and stream state
+     */
+    void reset() {
+        pending_.clear();
+        lastEventId_.clear();
+        skipLf_ = false;
+        resetFrame();
+    }
+
+    /**
+     * @brief Number of bytes buffered for an incomplete line
+     */
+    std::size_t pendingSize() const { return pending_.size(); }
+
+private:
+    void resetFrame() {
+        eventType_ = std::string_view();
+        data_ = std::string_view();
+        dataLines_ = 0;
+        eventOwned_ = false;
+        dataOwned_ = false;
+        retry_.reset();
+    }
+
+    // Copies the frame's fields that still point into the caller's chunk.
+    void ownFrame() {
+        if (!eventOwned_ && !eventType_.empty()) {
+            eventBuffer_.assign(eventType_.data(), eventType_.size());
+            eventType_ = eventBuffer_;
+            eventOwned_ = true;
+        }
+        if (!dataOwned_ && dataLines_ > 0) {
+            joined_.assign(data_.data(), data_.size());
+            data_ = joined_;
+            dataOwned_ = true;
+        }
+    }
+
+    void processLine(std::string_view line) {
+        if (line.front() == ':') {
+            return; // comment
+        }
+        std::string_view field = line;
+        std::string_view value;
+        std::size_t colon = line.find(':');
+        if (colon != std::string_view::npos) {
+            field = line.substr(0, colon);
+            value = line.substr(colon + 1);
+            if (!value.empty() && value.front() == ' ') {
+                value.remove_prefix(1);
+            }
+        }
+
+        if (field == "data") {
+            if (dataLines_ == 0) {
+                data_ = value;
+                dataOwned_ = false;
+            } else {
+                if (!dataOwned_) {
+                    joined_.assign(data_.data(), data_.size());
+                    dataOwned_ = true;
+                }
+                joined_.push_back('\n');
+                joined_.append(value.data(), value.size());
+                data_ = joined_;
+            }
+            ++dataLines_;
+        } else if (field == "event") {
+            eventType_ = value;
+            eventOwned_ = false;
+        } else if (field == "id") {
+            if (value.find('\0') == std::string_view::npos) {
+                lastEventId_.assign(value.data(), value.size());
+            }
+        } else if (field == "retry") {
+            std::uint32_t retry = 0;
+            bool valid = !value.empty();
+            for (char c : value) {
+                if (c < '0' || c > '9') {
+                    valid = false;
+                    break;
+                }
+                retry = retry * 10 + static_cast<std::uint32_t>(c - '0');
+            }
+            if (valid) {
+                retry_ = retry;
+            }
+        }
+    }
+
+    bool dispatch(const EventCallback& onEvent) {
+        bool keepGoing = true;
+        if (dataLines_ > 0) {
+            SseEvent event;
+            event.event = eventType_.empty() ? std::string_view("message") : eventType_;
+            event.data = data_;
+            event.id = lastEventId_;
+            event.retry = retry_;
+            keepGoing = onEvent(event);
+        }
+        resetFrame();
+        return keepGoing;
+    }
+
+    std::string pending_;     ///< Start of a line split across chunks
+    std::string joined_;      ///< Data of a multi-line or split frame
+    std::string eventBuffer_; ///< Event type of a split frame
+    std::string lastEventId_;
+    std::string_view eventType_;
+    std::string_view data_;
+    std::size_t dataLines_ = 0;
+    bool eventOwned_ = false; ///< eventType_ points into eventBuffer_
+    bool dataOwned_ = false;  ///< data_ points into joined_
+    bool skipLf_ = false;     ///< The last chunk ended in '\r'; a leading '\n' belongs to it
+    std::optional<std::uint32_t> retry_;
+};
+
+} // namespace client
+} // namespace sauron
@@ -0,0 +1,204 @@
+#pragma once
+
+#include "Jwt.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace sauron {
+namespace client {
+
+/**
+ * @brief Thread-safe holder of the current JWT
+ *
+ * The token is published as an immutable snapshot swapped in atomically
+ * (RCU-style): readers take a reference to the current snapshot without
+ * locking, and writers replace it wholesale. Every update also bumps a
+ * version and wakes waiters, which lets a TokenRefresher reschedule as soon
+ * as the token is replaced by a login.
+ */
+class TokenStore {
+public:
+    /**
+     * @brief Immutable view of one token
+     */
+    struct Snapshot {
+        std::string token;                ///< The JWT; empty when logged out
+        std::vector<std::string> headers; ///< Authorization header carrying the token, ready to attach to a request
+    };
+
+    TokenStore() : snapshot_(std::make_shared<const Snapshot>()) {}
+
+    /**
+     * @brief Get the current snapshot; never null
+     */
+    std::shared_ptr<const Snapshot> snapshot() const { return std::atomic_load(&snapshot_); }
+
+    /**
+     * @brief Get the current token (empty when logged out)
+     */
+    std::string get() const { return snapshot()->token; }
+
+    /**
+     * @brief Replace the current token
+     *
+     * @param token The new token; empty to log out
+     */
+    void set(const std::string& token) {
+        auto snapshot = std::make_shared<Snapshot>();
+        snapshot->token = token;
+        if (!token.empty()) {
+            snapshot->headers.push_back("Authorization: Bearer " + token);
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            std::atomic_store(&snapshot_, std::shared_ptr<const Snapshot>(std::move(snapshot)));
+            ++version_;
+        }
+        changed_.notify_all();
+    }
+
+private:
+    friend class TokenRefresher;
+
+    std::mutex mutex_; ///< Serializes writers and the refresher's waits; readers never take it
+    std::condition_variable changed_;
+    std::shared_ptr<const Snapshot> snapshot_;
+    std::uint64_t version_ = 0;
+};
+
+/**
+ * @brief Options for proactive token refresh
+ */
+struct AutoRefreshOptions {
+    std::chrono::seconds margin{60};       ///< Refresh this long before the token's exp claim
+    std::chrono::seconds retryInterval{5}; ///< Delay before retrying a failed refresh
+
+    /**
+     * @brief Optional; notified of failed refreshes, on the refresher thread
+     */
+    std::function<void(std::exception_ptr)> onError;
+};
+
+/**
+ * @brief Background thread renewing a JWT before it expires
+ *
+ * Reads the exp claim of the token in a TokenStore and calls the refresh
+ * function margin before it. The refresh function is expected to store the
+ * new token, which reschedules the next refresh. Tokens without an exp claim
+ * are left alone until they are replaced.
+ */
+class TokenRefresher {
+public:
+    /**
+     * @brief Performs one refresh; throws on failure
+     */
+    using RefreshFunction = std::function<void()>;
+
+    /**
+     * @brief Constructor; starts the refresher thread
+     *
+     * @param store The token store to watch
+     * @param refresh Performs the refresh and stores the new token
+     * @param options Refresh margin, retry interval and error observer
+     */
+    TokenRefresher(std::shared_ptr<TokenStore> store, RefreshFunction refresh, AutoRefreshOptions options = {})
+        : store_(std::move(store)), refresh_(std::move(refresh)), options_(std::move(options)) {
+        thread_ = std::thread([this] { run(); });
+    }
+
+    /**
+     * @brief Destructor; stops the refresher thread
+     */
+    ~TokenRefresher() { stop(); }
+
+    TokenRefresher(const TokenRefresher&) = delete;
+    TokenRefresher& operator=(const TokenRefresher&) = delete;
+
+    /**
+     * @brief Stop the refresher thread and wait for it to exit
+     */
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(store_->mutex_);
+            stopping_ = true;
+        }
+        store_->changed_.notify_all();
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+    }
+
+private:
+    using SystemClock = std::chrono::system_clock;
+
+    void run() {
+        std::optional<SystemClock::time_point> retryAt;
+        std::unique_lock<std::mutex> lock(store_->mutex_);
+        while (!stopping_) {
+            const std::uint64_t version = store_->version_;
+            std::optional<SystemClock::time_point> refreshAt = retryAt;
+            std::shared_ptr<const TokenStore::Snapshot> current = store_->snapshot();
+            if (!refreshAt && !current->token.empty()) {
+                if (auto expiry = jwt::expiry(current->token)) {
+                    refreshAt = *expiry - options_.margin;
+                    // A token living shorter than the margin would otherwise refresh in a loop.
+                    if (lastRefresh_ && *refreshAt < *lastRefresh_ + options_.retryInterval) {
+                        refreshAt = *lastRefresh_ + options_.retryInterval;
+                    }
+                }
+            }
+
+            auto changed = [&] { return stopping_ || store_->version_ != version; };
+            if (!refreshAt) {
+                store_->changed_.wait(lock, changed);
+                retryAt.reset();
+                continue;
+            }
+            if (store_->changed_.wait_until(lock, *refreshAt, changed)) {
+                retryAt.reset();
+                continue;
+            }
+
+            // Refresh without holding the lock so requests keep reading the current token.
+            lock.unlock();
+            std::exception_ptr error;
+            try {
+                refresh_();
+            } catch (...) {
+                error = std::current_exception();
+            }
+            if (error && options_.onError) {
+                try {
+                    options_.onError(error);
+                } catch (...) {
+                }
+            }
+            lock.lock();
+            lastRefresh_ = SystemClock::now();
+            if (error && store_->version_ == version) {
+                retryAt = SystemClock::now() + options_.retryInterval;
+            } else {
+                retryAt.reset();
+            }
+        }
+    }
+
+    std::shared_ptr<TokenStore> store_;
+    RefreshFunction refresh_;
+    AutoRefreshOptions options_;
+    bool stopping_ = false; ///< Guarded by the store's mutex
+    std::optional<SystemClock::time_point> lastRefresh_;
+    std::thread thread_;
+};
+
+} // namespace client
+} // namespace sauron
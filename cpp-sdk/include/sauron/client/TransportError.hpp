@@ -0,0 +1,57 @@
+#pragma once
+
+#include <stdexcept>
+#include <string>
+
+namespace sauron {
+namespace client {
+
+/**
+ * @brief Error raised when a request could not be carried over the network
+ *
+ * Thrown by the built-in transports for DNS, connect, send and receive
+ * failures and for malformed HTTP responses. HTTP error statuses are not
+ * transport errors; they are reported through HttpResponse::statusCode.
+ */
+class TransportError : public std::runtime_error {
+public:
+    /**
+     * @brief Constructor
+     *
+     * @param message Description of the failure
+     * @param requestSent Whether any part of the request reached the socket
+     */
+    explicit TransportError(const std::string& message, bool requestSent = false)
+        : std::runtime_error(message), requestSent_(requestSent) {}
+
+    /**
+     * @brief Whether the request may have been seen by the server
+     *
+     * @return bool True if bytes were written before the failure
+     */
+    bool requestSent() const { return requestSent_; }
+
+private:
+    bool requestSent_;
+};
+
+/**
+ * @brief Error delivered to a request that was cancelled before it completed
+ */
+class RequestCancelled : public std::runtime_error {
+public:
+    explicit RequestCancelled(const std::string& message = "Request cancelled")
+        : std::runtime_error(message) {}
+};
+
+/**
+ * @brief Error delivered to a request whose deadline passed before it completed
+ */
+class DeadlineExceeded : public std::runtime_error {
+public:
+    explicit DeadlineExceeded(const std::string& message = "Deadline exceeded")
+        : std::runtime_error(message) {}
+};
+
+} // namespace client
+} // namespace sauron
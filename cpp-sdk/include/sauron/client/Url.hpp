@@ -0,0 +1,125 @@
+#pragma once
+
+#include <cctype>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+namespace sauron {
+namespace client {
+
+/**
+ * @brief Components of an absolute http(s) URL
+ *
+ * Only the parts the built-in transports need are kept: scheme, host, port
+ * and an optional path prefix that is prepended to every request path.
+ */
+struct Url {
+    std::string scheme = "http"; ///< "http" or "https"
+    std::string host;            ///< Host name or IP literal (without brackets)
+    std::uint16_t port = 80;     ///< TCP port
+    std::string basePath;        ///< Path prefix without trailing slash (may be empty)
+
+    /**
+     * @brief Parse an absolute URL such as "http://localhost:3000/api"
+     *
+     * @param url The URL to parse
+     * @return Url The parsed URL
+     * @throws std::invalid_argument if the URL is malformed or the scheme is unsupported
+     */
+    static Url parse(const std::string& url) {
+        Url result;
+        std::string::size_type pos = url.find("://");
+        if (pos == std::string::npos) {
+            throw std::invalid_argument("Invalid URL (missing scheme): " + url);
+        }
+        result.scheme = url.substr(0, pos);
+        for (auto& c : result.scheme) {
+            c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+        }
+        if (result.scheme == "http") {
+            result.port = 80;
+        } else if (result.scheme == "https") {
+            result.port = 443;
+        } else {
+            throw std::invalid_argument("Unsupported URL scheme: " + result.scheme);
+        }
+
+        std::string::size_type authorityStart = pos + 3;
+        std::string::size_type pathStart = url.find('/', authorityStart);
+        std::string authority = url.substr(authorityStart, pathStart == std::string::npos
+                                                               ? std::string::npos
+                                                               : pathStart - authorityStart);
+        if (pathStart != std::string::npos) {
+            result.basePath = url.substr(pathStart);
+            while (!result.basePath.empty() && result.basePath.back() == '/') {
+                result.basePath.pop_back();
+            }
+        }
+
+        std::string portText;
+        if (!authority.empty() && authority.front() == '[') {
+            std::string::size_type close = authority.find(']');
+            if (close == std::string::npos) {
+                throw std::invalid_argument("Invalid URL (unterminated IPv6 literal): " + url);
+            }
+            result.host = authority.substr(1, close - 1);
+            if (close + 1 < authority.size()) {
+                if (authority[close + 1] != ':') {
+                    throw std::invalid_argument("Invalid URL authority: " + url);
+                }
+                portText = authority.substr(close + 2);
+            }
+        } else {
+            std::string::size_type colon = authority.rfind(':');
+            result.host = authority.substr(0, colon);
+            if (colon != std::string::npos) {
+                portText = authority.substr(colon + 1);
+            }
+        }
+
+        if (result.host.empty()) {
+            throw std::invalid_argument("Invalid URL (missing host): " + url);
+        }
+        if (!portText.empty()) {
+            unsigned long port = 0;
+            for (char c : portText) {
+                if (c < '0' || c > '9') {
+                    throw std::invalid_argument("Invalid URL port: " + url);
+                }
+                port = port * 10 + static_cast<unsigned long>(c - '0');
+                if (port > 65535) {
+                    throw std::invalid_argument("Invalid URL port: " + url);
+                }
+            }
+            result.port = static_cast<std::uint16_t>(port);
+        }
+        return result;
+    }
+
+    /**
+     * @brief Get the value for the Host header
+     *
+     * @return std::string "host" or "host:port" when the port is not the scheme default
+     */
+    std::string hostHeader() const {
+        std::string value = host.find(':') != std::string::npos ? "[" + host + "]" : host;
+        bool defaultPort = (scheme == "http" && port == 80) || (scheme == "https" && port == 443);
+        if (!defaultPort) {
+            value += ":" + std::to_string(port);
+        }
+        return value;
+    }
+
+    /**
+     * @brief Get the key identifying the origin for connection pooling
+     *
+     * @return std::string "scheme://host:port"
+     */
+    std::string originKey() const {
+        return scheme + "://" + host + ":" + std::to_string(port);
+    }
+};
+
+} // namespace client
+} // namespace sauron
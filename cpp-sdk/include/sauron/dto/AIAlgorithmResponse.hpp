@@ -1,7 +1,12 @@
 #pragma once
 
 #include "BaseDTO.hpp"
+#include "JsonSax.hpp"
+#include "JsonStream.hpp"
+#include <functional>
 #include <string>
+#include <string_view>
+#include <utility>
 #include <nlohmann/json.hpp>
 
 namespace sauron {
@@ -111,6 +116,60 @@ public:
         return response;
     }
 
+    /**
+     * @brief Construct from CBOR or MessagePack
+     * 
+     * @param data The encoded document
+     * @param format The wire format of data
+     * @return AIAlgorithmResponse The constructed object
+     * @throws nlohmann::json::parse_error if data is not a valid document
+     */
+    static AIAlgorithmResponse fromBinary(std::string_view data, WireFormat format) {
+        return fromJson(decodeWireFormat(data, format));
+    }
+
+    /**
+     * @brief Parse from JSON text without building a JSON DOM
+     * 
+     * @param json JSON text to parse, or a CBOR/MessagePack document
+     * @param format The wire format of json
+     * @return AIAlgorithmResponse The constructed object
+     * @throws nlohmann::json::parse_error if the text is not a valid document
+     */
+    static AIAlgorithmResponse parse(std::string_view json, WireFormat format = WireFormat::JSON) {
+        AIAlgorithmResponse response;
+        parseInto(json, response, format);
+        return response;
+    }
+
+    /**
+     * @brief Parse from JSON text into an existing object
+     * 
+     * Fields missing from the JSON are reset; string capacity already held by
+     * the object is reused.
+     * 
+     * @param json JSON text to parse, or a CBOR/MessagePack document
+     * @param out Object receiving the parsed fields
+     * @param format The wire format of json
+     * @throws nlohmann::json::parse_error if the text is not a valid document
+     */
+    static void parseInto(std::string_view json, AIAlgorithmResponse& out, WireFormat format = WireFormat::JSON) {
+        out.explanation.clear();
+        out.response.clear();
+        out.complexity.time.value.clear();
+        out.complexity.time.explanation.clear();
+        out.complexity.space.value.clear();
+        out.complexity.space.explanation.clear();
+        json_sax::parseFields(json, {
+            {{"explanation"}, &out.explanation},
+            {{"response"}, &out.response},
+            {{"complexity", "time", "value"}, &out.complexity.time.value},
+            {{"complexity", "time", "explanation"}, &out.complexity.time.explanation},
+            {{"complexity", "space", "value"}, &out.complexity.space.value},
+            {{"complexity", "space", "explanation"}, &out.complexity.space.explanation},
+        }, format);
+    }
+
     /**
      * @brief Convert to JSON
      * 
@@ -165,10 +224,114 @@ public:
     void setComplexity(const AlgorithmComplexity& comp) { complexity = comp; }
 
 private:
+    friend class AlgorithmResponseParser;
+
     std::string explanation;
     std::string response;
     AlgorithmComplexity complexity;
 };
 
+/**
+ * @brief Callbacks receiving an algorithm response while it arrives
+ *
+ * Text is passed on in pieces, as it is decoded; the pieces of a field
+ * concatenate to its value and are only valid during the call. Any callback
+ * may be left empty. Each returns false to stop.
+ */
+struct AlgorithmStreamCallbacks {
+    std::function<bool(std::string_view text)> onExplanation;           ///< Part of the explanation
+    std::function<bool(std::string_view text)> onResponse;              ///< Part of the response code
+    std::function<bool(const AlgorithmComplexity& complexity)> onComplexity; ///< The complexity object, once it is closed
+};
+
+/**
+ * @brief Incremental parser for a JSON AIAlgorithmResponse
+ *
+ * Fed the body in chunks as the transport receives them. Explanation and
+ * response text reach the callbacks as soon as their bytes are in, and the
+ * complexity analysis as soon as its object is closed, whatever order the
+ * fields come in; the complete response is assembled along the way.
+ */
+class AlgorithmResponseParser : private json_stream::Handler {
+public:
+    explicit AlgorithmResponseParser(AlgorithmStreamCallbacks callbacks = AlgorithmStreamCallbacks())
+        : callbacks_(std::move(callbacks)) {}
+
+    /**
+     * @brief Feed the next chunk of the body
+     *
+     * @param chunk Bytes received from the transport
+     * @return bool False if a callback asked to stop
+     * @throws std::runtime_error if the body is not valid JSON
+     */
+    bool feed(std::string_view chunk) {
+        return parser_.feed(chunk, *this);
+    }
+
+    /**
+     * @brief Check that the whole body has been received
+     *
+     * @throws std::runtime_error if the body is incomplete
+     */
+    void finish() {
+        parser_.finish();
+    }
+
+    /**
+     * @brief The response assembled so far
+     */
+    const AIAlgorithmResponse& response() const { return response_; }
+
+    /**
+     * @brief Move the assembled response out of the parser
+     */
+    AIAlgorithmResponse take() { return std::move(response_); }
+
+private:
+    bool string(const json_stream::Path& path, std::string_view text, bool complete) override {
+        (void)complete;
+        if (path.is({"explanation"})) {
+            response_.explanation.append(text.data(), text.size());
+            return text.empty() || !callbacks_.onExplanation || callbacks_.onExplanation(text);
+        }
+        if (path.is({"response"})) {
+            response_.response.append(text.data(), text.size());
+            return text.empty() || !callbacks_.onResponse || callbacks_.onResponse(text);
+        }
+        if (std::string* target = complexityField(path)) {
+            target->append(text.data(), text.size());
+        }
+        return true;
+    }
+
+    bool endObject(const json_stream::Path& path) override {
+        if (path.is({"complexity"}) && callbacks_.onComplexity) {
+            return callbacks_.onComplexity(response_.complexity);
+        }
+        return true;
+    }
+
+    std::string* complexityField(const json_stream::Path& path) {
+        AlgorithmComplexity& complexity = response_.complexity;
+        if (path.is({"complexity", "time", "value"})) {
+            return &complexity.time.value;
+        }
+        if (path.is({"complexity", "time", "explanation"})) {
+            return &complexity.time.explanation;
+        }
+        if (path.is({"complexity", "space", "value"})) {
+            return &complexity.space.value;
+        }
+        if (path.is({"complexity", "space", "explanation"})) {
+            return &complexity.space.explanation;
+        }
+        return nullptr;
+    }
+
+    AlgorithmStreamCallbacks callbacks_;
+    json_stream::Parser parser_;
+    AIAlgorithmResponse response_;
+};
+
 } // namespace dto
 } // namespace sauron 
\ No newline at end of file
@@ -2,7 +2,17 @@
 
 #include "BaseDTO.hpp"
 #include "AIProvider.hpp"
+#include "JsonWriter.hpp"
+#include "WireFormat.hpp"
+#include "BodyStream.hpp"
+#include "Conversation.hpp"
+#include "../util/Base64.hpp"
+#include "../util/MappedFile.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <optional>
 #include <nlohmann/json.hpp>
@@ -73,6 +83,12 @@ public:
             for (const auto& image : json["images"]) {
                 if (image.is_string()) {
                     request.images.push_back(image.get<std::string>());
+                } else if (image.is_binary()) {
+                    // Raw bytes from a CBOR or MessagePack body
+                    const auto& bytes = image.get_binary();
+                    std::string encoded;
+                    util::base64::encode(bytes.data(), bytes.size(), encoded);
+                    request.images.push_back(std::move(encoded));
                 }
             }
         }
@@ -80,6 +96,20 @@ public:
         return request;
     }
 
+    /**
+     * @brief Construct from CBOR or MessagePack
+     * 
+     * Images sent as byte strings are base64-encoded into getImages().
+     * 
+     * @param data The encoded document
+     * @param format The wire format of data
+     * @return AIQueryRequest The constructed object
+     * @throws nlohmann::json::parse_error if data is not a valid document
+     */
+    static AIQueryRequest fromBinary(std::string_view data, WireFormat format) {
+        return fromJson(decodeWireFormat(data, format));
+    }
+
     /**
      * @brief Convert to JSON
      * 
@@ -87,26 +117,192 @@ public:
      */
     nlohmann::json toJson() const override {
         nlohmann::json json;
-        json["prompt"] = prompt;
+        json["prompt"] = conversation ? conversation->render() : prompt;
         json["provider"] = AIProviderToString(provider);
         
         if (!model.empty()) {
             json["model"] = model;
         }
         
-        if (!images.empty()) {
+        if (!images.empty() || !imageFiles.empty()) {
             json["images"] = images;
+            for (const auto& file : imageFiles) {
+                json["images"].push_back(util::base64::encode(file->view()));
+            }
         }
         
         return json;
     }
 
+    /**
+     * @brief Serialize to JSON without building a JSON DOM
+     * 
+     * Escapes prompt, model and images straight into the buffer, sized
+     * exactly up front so the whole body costs at most one allocation. A
+     * conversation prompt is copied from its already escaped turns.
+     * Attached image files are encoded into the buffer too; see
+     * openBodyStream() to send them without that. Produces the same bytes as
+     * toJson().dump().
+     * 
+     * @param out Buffer that receives the JSON text; cleared first
+     * @throws std::invalid_argument if a field is not valid UTF-8
+     */
+    void writeJson(std::string& out) const override {
+        const std::string providerName = AIProviderToString(provider);
+        const std::size_t imageCount = images.size() + imageFiles.size();
+        std::size_t size = 2;
+        if (imageCount > 0) {
+            size += sizeof("\"images\":[]") - 1 + imageCount - 1;
+            for (const auto& image : images) {
+                size += json_writer::escapedSize(image, "images");
+            }
+            for (const auto& file : imageFiles) {
+                size += util::base64::encodedSize(file->size()) + 2;
+            }
+            size += 1;
+        }
+        if (!model.empty()) {
+            size += sizeof("\"model\":") - 1 + json_writer::escapedSize(model, "model") + 1;
+        }
+        size += sizeof("\"prompt\":") - 1 + promptEscapedSize() + 1;
+        size += sizeof("\"provider\":") - 1 + json_writer::escapedSize(providerName, "provider");
+
+        // Keys in the order nlohmann::json::dump() emits them
+        out.clear();
+        out.reserve(size);
+        out.push_back('{');
+        if (imageCount > 0) {
+            out.append("\"images\":[");
+            for (std::size_t i = 0; i < images.size(); ++i) {
+                if (i > 0) {
+                    out.push_back(',');
+                }
+                json_writer::appendString(out, images[i]);
+            }
+            for (std::size_t i = 0; i < imageFiles.size(); ++i) {
+                if (i > 0 || !images.empty()) {
+                    out.push_back(',');
+                }
+                out.push_back('"');
+                util::base64::encode(imageFiles[i]->data(), imageFiles[i]->size(), out);
+                out.push_back('"');
+            }
+            out.append("],");
+        }
+        if (!model.empty()) {
+            out.append("\"model\":");
+            json_writer::appendString(out, model);
+            out.push_back(',');
+        }
+        out.append("\"prompt\":");
+        appendPrompt(out);
+        out.append(",\"provider\":");
+        json_writer::appendString(out, providerName);
+        out.push_back('}');
+    }
+
+    /**
+     * @brief Serialize to CBOR or MessagePack without building a JSON DOM
+     * 
+     * Images are decoded from base64 straight into the buffer and sent as
+     * byte strings, a quarter smaller than their text form. An image that is
+     * not plain base64 (e.g. a data URL) is sent as a text string instead.
+     * Keys are written in the same order as writeJson().
+     * 
+     * @param format WireFormat::CBOR or WireFormat::MSGPACK
+     * @param out Buffer that receives the encoded request; cleared first
+     */
+    void writeBinary(WireFormat format, std::string& out) const override {
+        std::size_t size = 64 + (conversation ? conversation->bytes() : prompt.size()) + model.size();
+        for (const auto& image : images) {
+            size += image.size() * 3 / 4 + 9;
+        }
+        for (const auto& file : imageFiles) {
+            size += file->size() + 9;
+        }
+
+        out.clear();
+        out.reserve(size);
+        writeBinaryHead(format, out);
+        for (const auto& file : imageFiles) {
+            binary_writer::appendBytesHeader(out, format, file->size());
+            out.append(file->view().data(), file->size());
+        }
+        writeBinaryTail(format, out);
+    }
+
+    /**
+     * @brief Serialize to a body that streams attached image files
+     * 
+     * Produces the same bytes as write(format, out), but attached image
+     * files stay in their mappings: they are base64-encoded one block at a
+     * time as the body is sent (JSON) or sent as they are (CBOR and
+     * MessagePack), so the memory a request needs does not grow with the
+     * size of its image files. The body keeps its own copy of the other
+     * fields and does not refer to this request.
+     * 
+     * @param format The wire format
+     * @return std::unique_ptr<SegmentedBody> The body, ready to be read from the start
+     * @throws std::invalid_argument if a field is not valid UTF-8 (JSON)
+     */
+    std::unique_ptr<SegmentedBody> openBodyStream(WireFormat format) const {
+        auto body = std::make_unique<SegmentedBody>();
+        std::string text;
+        if (format == WireFormat::JSON) {
+            // The same layout as writeJson()
+            text.push_back('{');
+            if (!images.empty() || !imageFiles.empty()) {
+                text.append("\"images\":[");
+                for (std::size_t i = 0; i < images.size(); ++i) {
+                    if (i > 0) {
+                        text.push_back(',');
+                    }
+                    json_writer::appendString(text, images[i]);
+                }
+                for (std::size_t i = 0; i < imageFiles.size(); ++i) {
+                    text.append(i > 0 || !images.empty() ? ",\"" : "\"");
+                    body->appendText(text);
+                    body->appendBase64(imageFiles[i]);
+                    text.assign("\"");
+                }
+                text.append("],");
+            }
+            if (!model.empty()) {
+                text.append("\"model\":");
+                json_writer::appendString(text, model);
+                text.push_back(',');
+            }
+            text.append("\"prompt\":");
+            appendPrompt(text);
+            text.append(",\"provider\":");
+            json_writer::appendString(text, AIProviderToString(provider));
+            text.push_back('}');
+        } else {
+            writeBinaryHead(format, text);
+            for (const auto& file : imageFiles) {
+                binary_writer::appendBytesHeader(text, format, file->size());
+                body->appendText(text);
+                body->appendFile(file);
+                text.clear();
+            }
+            writeBinaryTail(format, text);
+        }
+        body->appendText(text);
+        return body;
+    }
+
     /**
      * @brief Validate the DTO
      * 
      * @throws std::invalid_argument if validation fails
      */
     void validate() const override {
+        if (conversation) {
+            if (conversation->empty()) {
+                throw std::invalid_argument("prompt is required");
+            }
+            return;
+        }
         validateRequired(prompt, "prompt");
         // Provider is already validated by the enum
     }
@@ -114,7 +310,7 @@ public:
     /**
      * @brief Get the prompt
      * 
-     * @return const std::string& The prompt
+     * @return const std::string& The prompt; empty if it is a conversation
      */
     const std::string& getPrompt() const {
         return prompt;
@@ -123,10 +319,37 @@ public:
     /**
      * @brief Set the prompt
      * 
+     * Replaces a conversation set with setConversation().
+     * 
      * @param text The prompt text
      */
     void setPrompt(const std::string& text) {
         prompt = text;
+        conversation.reset();
+    }
+
+    /**
+     * @brief Use a conversation as the prompt
+     * 
+     * The prompt becomes the conversation's rendered turns. The request
+     * keeps a copy, which shares the turns' text, and writes it into the
+     * body without flattening it first. Later changes to the conversation
+     * do not affect the request.
+     * 
+     * @param turns The conversation
+     */
+    void setConversation(Conversation turns) {
+        conversation = std::move(turns);
+        prompt.clear();
+    }
+
+    /**
+     * @brief Get the conversation used as the prompt
+     * 
+     * @return const Conversation* The conversation, or null for a plain prompt
+     */
+    const Conversation* getConversation() const {
+        return conversation ? &*conversation : nullptr;
     }
 
     /**
@@ -192,11 +415,149 @@ public:
         images.push_back(imageData);
     }
 
+    /**
+     * @brief Add an image from its raw bytes
+     *
+     * The bytes are base64-encoded straight into the new image, which is
+     * allocated once at its exact size, with the fastest kernel the CPU
+     * supports.
+     *
+     * @param data The image bytes
+     * @param size Number of bytes
+     */
+    void addImageBytes(const void* data, std::size_t size) {
+        std::string encoded;
+        util::base64::encode(static_cast<const std::uint8_t*>(data), size, encoded);
+        images.push_back(std::move(encoded));
+    }
+
+    /**
+     * @brief Add an image from its raw bytes
+     *
+     * @param bytes The image bytes
+     */
+    void addImageBytes(std::string_view bytes) {
+        addImageBytes(bytes.data(), bytes.size());
+    }
+
+    /**
+     * @brief Add an image from a file
+     *
+     * The file is mapped and encoded in place, so it is never copied into
+     * an intermediate buffer.
+     *
+     * @param path Path of the image file
+     * @throws std::runtime_error if the file cannot be read
+     */
+    void addImageFile(const std::string& path) {
+        util::MappedFile file(path);
+        addImageBytes(file.data(), file.size());
+    }
+
+    /**
+     * @brief Attach an image file to be streamed when the request is sent
+     * 
+     * Unlike addImageFile(), the image is not encoded into the request: the
+     * file is mapped and SauronClient sends it through openBodyStream(), so
+     * a request with many large images needs little more memory than one
+     * without. Attached images follow getImages() in the request's images.
+     * The file should not be modified until the request is sent.
+     * 
+     * @param path Path of the image file
+     * @throws std::runtime_error if the file cannot be mapped
+     */
+    void attachImageFile(const std::string& path) {
+        imageFiles.push_back(std::make_shared<const util::MappedFile>(path));
+    }
+
+#if defined(__unix__) || defined(__APPLE__)
+    /**
+     * @brief Attach the image file behind a descriptor
+     * 
+     * Like attachImageFile(); the descriptor may be closed once this returns.
+     * 
+     * @param fd Descriptor of a regular file (or memfd) open for reading
+     * @throws std::runtime_error if the descriptor cannot be mapped
+     */
+    void attachImageFd(int fd) {
+        imageFiles.push_back(std::make_shared<const util::MappedFile>(fd));
+    }
+#endif
+
+    /**
+     * @brief Get the attached image files
+     * 
+     * @return const std::vector<std::shared_ptr<const util::MappedFile>>& The mapped files
+     */
+    const std::vector<std::shared_ptr<const util::MappedFile>>& getImageFiles() const {
+        return imageFiles;
+    }
+
 private:
+    // Escaped size of the prompt, quotes included; validates a plain prompt
+    std::size_t promptEscapedSize() const {
+        return conversation ? conversation->escapedBytes() + 2 : json_writer::escapedSize(prompt, "prompt");
+    }
+
+    // The prompt as a quoted JSON string
+    void appendPrompt(std::string& out) const {
+        if (conversation) {
+            out.push_back('"');
+            conversation->appendEscapedTo(out);
+            out.push_back('"');
+        } else {
+            json_writer::appendString(out, prompt);
+        }
+    }
+
+    // Map header through the images array, up to where image files go
+    void writeBinaryHead(WireFormat format, std::string& out) const {
+        const bool hasImages = !images.empty() || !imageFiles.empty();
+        binary_writer::appendMapHeader(out, format, 2 + (hasImages ? 1 : 0) + (model.empty() ? 0 : 1));
+        if (!hasImages) {
+            return;
+        }
+        binary_writer::appendString(out, format, "images");
+        binary_writer::appendArrayHeader(out, format, images.size() + imageFiles.size());
+        for (const auto& image : images) {
+            std::string_view text(image);
+            while (!text.empty() && text.back() == '=') {
+                text.remove_suffix(1);
+            }
+            const std::size_t mark = out.size();
+            try {
+                binary_writer::appendBytesHeader(out, format, text.size() * 3 / 4);
+                util::base64::decode(text, out);
+            } catch (const std::invalid_argument&) {
+                out.resize(mark);
+                binary_writer::appendString(out, format, image);
+            }
+        }
+    }
+
+    // Everything after the images array
+    void writeBinaryTail(WireFormat format, std::string& out) const {
+        if (!model.empty()) {
+            binary_writer::appendString(out, format, "model");
+            binary_writer::appendString(out, format, model);
+        }
+        binary_writer::appendString(out, format, "prompt");
+        if (conversation) {
+            binary_writer::appendStringHeader(out, format, conversation->bytes());
+            conversation->appendTo(out);
+        } else {
+            binary_writer::appendString(out, format, prompt);
+        }
+        binary_writer::appendString(out, format, "provider");
+        binary_writer::appendString(out, format, AIProviderToString(provider));
+    }
+
     std::string prompt;
+    std::optional<Conversation> conversation; // Replaces prompt when set
     AIProvider provider = AIProvider::OPENAI; // Default to OpenAI
     std::string model = "default";           // Default model
     std::vector<std::string> images;         // Optional images
+    std::vector<std::shared_ptr<const util::MappedFile>> imageFiles; // Images streamed from files
 };
 
 } // namespace dto
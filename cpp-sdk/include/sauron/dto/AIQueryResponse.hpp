@@ -1,7 +1,9 @@
 #pragma once
 
 #include "BaseDTO.hpp"
+#include "JsonSax.hpp"
 #include <string>
+#include <string_view>
 #include <nlohmann/json.hpp>
 
 namespace sauron {
@@ -42,6 +44,48 @@ public:
         return response;
     }
 
+    /**
+     * @brief Construct from CBOR or MessagePack
+     * 
+     * @param data The encoded document
+     * @param format The wire format of data
+     * @return AIQueryResponse The constructed object
+     * @throws nlohmann::json::parse_error if data is not a valid document
+     */
+    static AIQueryResponse fromBinary(std::string_view data, WireFormat format) {
+        return fromJson(decodeWireFormat(data, format));
+    }
+
+    /**
+     * @brief Parse from JSON text without building a JSON DOM
+     * 
+     * @param json JSON text to parse, or a CBOR/MessagePack document
+     * @param format The wire format of json
+     * @return AIQueryResponse The constructed object
+     * @throws nlohmann::json::parse_error if the text is not a valid document
+     */
+    static AIQueryResponse parse(std::string_view json, WireFormat format = WireFormat::JSON) {
+        AIQueryResponse response;
+        parseInto(json, response, format);
+        return response;
+    }
+
+    /**
+     * @brief Parse from JSON text into an existing object
+     * 
+     * Fields missing from the JSON are reset; string capacity already held by
+     * the object is reused.
+     * 
+     * @param json JSON text to parse, or a CBOR/MessagePack document
+     * @param out Object receiving the parsed fields
+     * @param format The wire format of json
+     * @throws nlohmann::json::parse_error if the text is not a valid document
+     */
+    static void parseInto(std::string_view json, AIQueryResponse& out, WireFormat format = WireFormat::JSON) {
+        out.response.clear();
+        json_sax::parseFields(json, {{{"response"}, &out.response}}, format);
+    }
+
     /**
      * @brief Convert to JSON
      * 
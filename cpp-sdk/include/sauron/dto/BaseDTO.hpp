@@ -1,5 +1,6 @@
 #pragma once
 
+#include "WireFormat.hpp"
 #include <string>
 #include <vector>
 #include <optional>
@@ -31,7 +32,51 @@ public:
      * @return std::string JSON string representation of the DTO
      */
     std::string toString() const {
-        return toJson().dump();
+        std::string out;
+        writeJson(out);
+        return out;
+    }
+
+    /**
+     * @brief Serialize the DTO as JSON into an existing buffer
+     * 
+     * The buffer is cleared first; its capacity is reused, so a caller that
+     * keeps the buffer around avoids reallocating for every request. DTOs with
+     * large fields override this to write without building a JSON DOM.
+     * 
+     * @param out Buffer that receives the JSON text
+     */
+    virtual void writeJson(std::string& out) const {
+        out.clear();
+        out.append(toJson().dump());
+    }
+
+    /**
+     * @brief Serialize the DTO as CBOR or MessagePack into an existing buffer
+     * 
+     * The buffer is cleared first. DTOs with binary fields override this to
+     * write them as byte strings rather than base64 text.
+     * 
+     * @param format WireFormat::CBOR or WireFormat::MSGPACK
+     * @param out Buffer that receives the encoded DTO
+     */
+    virtual void writeBinary(WireFormat format, std::string& out) const {
+        out.clear();
+        encodeWireFormat(toJson(), format, out);
+    }
+
+    /**
+     * @brief Serialize the DTO in a wire format into an existing buffer
+     * 
+     * @param format The wire format
+     * @param out Buffer that receives the encoded DTO; cleared first
+     */
+    void write(WireFormat format, std::string& out) const {
+        if (format == WireFormat::JSON) {
+            writeJson(out);
+        } else {
+            writeBinary(format, out);
+        }
     }
 
     /**
@@ -0,0 +1,152 @@
+#pragma once
+
+#include "../util/Base64.hpp"
+#include "../util/MappedFile.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace sauron {
+namespace dto {
+
+/**
+ * @brief Request body produced piece by piece while it is sent
+ *
+ * Lets a transport send a body without ever holding all of it in memory.
+ * A stream is read by one sender at a time; rewind() starts it over for a
+ * retry.
+ */
+class BodyStream {
+public:
+    virtual ~BodyStream() = default;
+
+    /**
+     * @brief Next piece of the body
+     *
+     * @return std::string_view The piece, valid until the next call; empty once the body is complete
+     */
+    virtual std::string_view next() = 0;
+
+    /**
+     * @brief Start over from the first piece
+     */
+    virtual void rewind() = 0;
+
+    /**
+     * @brief Read the whole body into a string, from the start
+     *
+     * For transports that cannot stream a body.
+     *
+     * @param out Buffer receiving the body; cleared first
+     */
+    void readAll(std::string& out) {
+        out.clear();
+        rewind();
+        for (std::string_view piece = next(); !piece.empty(); piece = next()) {
+            out.append(piece.data(), piece.size());
+        }
+        rewind();
+    }
+};
+
+/**
+ * @brief Body made of text and memory-mapped files
+ *
+ * Text is copied in when the body is built; files are kept mapped and sent
+ * from their mappings, either as they are or base64-encoded one block at a
+ * time. Whatever the size of the files, the body holds its text plus one
+ * 64 KiB encoding buffer, and it does not refer to the object it was built
+ * from.
+ */
+class SegmentedBody : public BodyStream {
+public:
+    /// Bytes of a file encoded per piece; a multiple of 3, so only the last piece is padded.
+    static constexpr std::size_t kBase64Block = 48 * 1024;
+
+    /**
+     * @brief Append text
+     */
+    void appendText(std::string_view text) {
+        if (text.empty()) {
+            return;
+        }
+        if (segments_.empty() || segments_.back().kind != Kind::Text) {
+            segments_.push_back(Segment{Kind::Text, texts_.size(), nullptr});
+            texts_.emplace_back();
+        }
+        texts_.back().append(text.data(), text.size());
+        size_ += text.size();
+    }
+
+    /**
+     * @brief Append the bytes of a file, sent straight from its mapping
+     */
+    void appendFile(std::shared_ptr<const util::MappedFile> file) {
+        size_ += file->size();
+        segments_.push_back(Segment{Kind::File, 0, std::move(file)});
+    }
+
+    /**
+     * @brief Append a file as standard, padded base64 text, encoded as it is sent
+     */
+    void appendBase64(std::shared_ptr<const util::MappedFile> file) {
+        size_ += util::base64::encodedSize(file->size());
+        segments_.push_back(Segment{Kind::Base64, 0, std::move(file)});
+    }
+
+    /**
+     * @brief Total size of the body in bytes
+     */
+    std::size_t size() const { return size_; }
+
+    std::string_view next() override {
+        while (index_ < segments_.size()) {
+            const Segment& segment = segments_[index_];
+            std::string_view whole = segment.kind == Kind::Text ? std::string_view(texts_[segment.text])
+                                                               : segment.file->view();
+            if (offset_ >= whole.size()) {
+                ++index_;
+                offset_ = 0;
+                continue;
+            }
+            if (segment.kind != Kind::Base64) {
+                offset_ = whole.size();
+                return whole;
+            }
+            std::size_t take = std::min(kBase64Block, whole.size() - offset_);
+            scratch_.clear();
+            util::base64::encode(reinterpret_cast<const std::uint8_t*>(whole.data() + offset_), take, scratch_);
+            offset_ += take;
+            return scratch_;
+        }
+        return std::string_view();
+    }
+
+    void rewind() override {
+        index_ = 0;
+        offset_ = 0;
+    }
+
+private:
+    enum class Kind { Text, File, Base64 };
+
+    struct Segment {
+        Kind kind;
+        std::size_t text; ///< Index into texts_ for Kind::Text
+        std::shared_ptr<const util::MappedFile> file;
+    };
+
+    std::vector<Segment> segments_;
+    std::vector<std::string> texts_;
+    std::size_t size_ = 0;
+    std::size_t index_ = 0;  ///< Segment being sent
+    std::size_t offset_ = 0; ///< Bytes of that segment already sent (input bytes for Kind::Base64)
+    std::string scratch_;
+};
+
+} // namespace dto
+} // namespace sauron
@@ -0,0 +1,283 @@
+#pragma once
+
+#include "JsonWriter.hpp"
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace sauron {
+namespace dto {
+
+/**
+ * @brief Author of a conversation turn
+ */
+enum class Role {
+    SYSTEM,
+    USER,
+    ASSISTANT
+};
+
+/**
+ * @brief Convert Role enum to the label a turn is rendered with
+ *
+ * @param role The Role enum value
+ * @return std::string The label, e.g. "User"
+ */
+inline std::string RoleToString(Role role) {
+    switch (role) {
+        case Role::SYSTEM:
+            return "System";
+        case Role::USER:
+            return "User";
+        case Role::ASSISTANT:
+            return "Assistant";
+        default:
+            throw std::invalid_argument("Invalid Role value");
+    }
+}
+
+/**
+ * @brief Limits that drop the oldest turns of a Conversation
+ *
+ * Checked after every turn added. The system prompt and the newest turn
+ * are always kept, even if they alone exceed a limit.
+ */
+struct ConversationWindow {
+    std::size_t maxBytes = 0;  ///< Upper bound on the rendered prompt in bytes; zero for none
+    std::size_t maxTokens = 0; ///< Upper bound on its estimated tokens; zero for none
+    std::function<std::size_t(std::string_view)> countTokens; ///< Tokens in one rendered turn; empty for bytes / 4 rounded up
+};
+
+/**
+ * @brief Multi-turn prompt that grows without being rebuilt
+ *
+ * Each turn is rendered ("User: text") and JSON-escaped once, when it is
+ * added, and kept as an immutable chunk. The prompt is the turns in order,
+ * separated by blank lines; AIQueryRequest::setConversation() writes it
+ * into a request body chunk by chunk, so a turn costs time and memory for
+ * its own text only, not for the history before it.
+ *
+ * Copies share the chunks, so snapshotting a conversation into a request
+ * copies one pointer per turn. A conversation is not safe to modify from
+ * several threads at once; its copies are independent.
+ */
+class Conversation {
+public:
+    /**
+     * @brief Create an empty conversation
+     *
+     * @param window Limits that drop the oldest turns; unlimited by default
+     */
+    explicit Conversation(ConversationWindow window = {}) : window_(std::move(window)) {}
+
+    /**
+     * @brief Set the system prompt, rendered before every other turn
+     *
+     * It is never dropped by the window.
+     *
+     * @param text The system prompt; empty to remove it
+     * @throws std::invalid_argument if text is not valid UTF-8
+     */
+    void setSystem(std::string_view text) {
+        if (system_) {
+            forget(*system_);
+            system_.reset();
+        }
+        if (!text.empty()) {
+            system_ = makeChunk(Role::SYSTEM, text);
+            count(*system_);
+        }
+        applyWindow();
+    }
+
+    /**
+     * @brief Append a turn, then drop the oldest turns the window no longer fits
+     *
+     * @param role Who wrote the turn
+     * @param text The turn's text
+     * @throws std::invalid_argument if text is not valid UTF-8
+     */
+    void add(Role role, std::string_view text) {
+        turns_.push_back(makeChunk(role, text));
+        count(*turns_.back());
+        applyWindow();
+    }
+
+    /**
+     * @brief Append a user turn
+     */
+    void addUser(std::string_view text) { add(Role::USER, text); }
+
+    /**
+     * @brief Append an assistant turn, usually the previous response
+     */
+    void addAssistant(std::string_view text) { add(Role::ASSISTANT, text); }
+
+    /**
+     * @brief Remove every turn, keeping the system prompt and the window
+     */
+    void clear() {
+        for (const auto& turn : turns_) {
+            forget(*turn);
+        }
+        turns_.clear();
+    }
+
+    /**
+     * @brief Whether there is nothing to render
+     */
+    bool empty() const { return !system_ && turns_.empty(); }
+
+    /**
+     * @brief Number of turns kept, not counting the system prompt
+     */
+    std::size_t size() const { return turns_.size(); }
+
+    /**
+     * @brief Number of turns dropped by the window so far
+     */
+    std::size_t dropped() const { return dropped_; }
+
+    /**
+     * @brief Size of the rendered prompt in bytes
+     */
+    std::size_t bytes() const { return rawBytes_ + separators() * kSeparator.size(); }
+
+    /**
+     * @brief Estimated tokens of the rendered prompt
+     */
+    std::size_t tokens() const { return tokens_; }
+
+    /**
+     * @brief Size of the rendered prompt once JSON-escaped, without quotes
+     */
+    std::size_t escapedBytes() const { return escapedBytes_ + separators() * kEscapedSeparator.size(); }
+
+    /**
+     * @brief Append the rendered prompt
+     */
+    void appendTo(std::string& out) const {
+        forEachChunk([&out](const std::string& raw, const std::string&, bool separated) {
+            if (separated) {
+                out.append(kSeparator.data(), kSeparator.size());
+            }
+            out.append(raw);
+        });
+    }
+
+    /**
+     * @brief Append the rendered prompt JSON-escaped, without quotes
+     *
+     * Writes exactly escapedBytes() bytes, copied from the escaped chunks.
+     */
+    void appendEscapedTo(std::string& out) const {
+        forEachChunk([&out](const std::string&, const std::string& escaped, bool separated) {
+            if (separated) {
+                out.append(kEscapedSeparator.data(), kEscapedSeparator.size());
+            }
+            out.append(escaped);
+        });
+    }
+
+    /**
+     * @brief Render the prompt into one string
+     *
+     * For callers that need it flat; requests do not.
+     */
+    std::string render() const {
+        std::string out;
+        out.reserve(bytes());
+        appendTo(out);
+        return out;
+    }
+
+    /**
+     * @brief Visit the rendered turns in order, system prompt first
+     *
+     * @param visit Called with each turn's rendered text, without separators
+     */
+    template <typename Visit>
+    void forEachTurn(Visit&& visit) const {
+        forEachChunk([&visit](const std::string& raw, const std::string&, bool) { visit(std::string_view(raw)); });
+    }
+
+private:
+    struct Chunk {
+        std::string raw;     ///< "Label: text"
+        std::string escaped; ///< raw, JSON-escaped without quotes
+        std::size_t tokens = 0;
+    };
+
+    static constexpr std::string_view kSeparator = "\n\n";
+    static constexpr std::string_view kEscapedSeparator = "\\n\\n";
+
+    std::shared_ptr<const Chunk> makeChunk(Role role, std::string_view text) const {
+        auto chunk = std::make_shared<Chunk>();
+        const std::string label = RoleToString(role);
+        chunk->raw.reserve(label.size() + 2 + text.size());
+        chunk->raw.append(label).append(": ").append(text.data(), text.size());
+        chunk->escaped.reserve(json_writer::escapedSize(chunk->raw, "conversation turn") - 2);
+        json_writer::appendEscaped(chunk->escaped, chunk->raw);
+        chunk->tokens = window_.countTokens ? window_.countTokens(chunk->raw) : (chunk->raw.size() + 3) / 4;
+        return chunk;
+    }
+
+    template <typename Visit>
+    void forEachChunk(Visit&& visit) const {
+        bool separated = false;
+        if (system_) {
+            visit(system_->raw, system_->escaped, false);
+            separated = true;
+        }
+        for (const auto& turn : turns_) {
+            visit(turn->raw, turn->escaped, separated);
+            separated = true;
+        }
+    }
+
+    std::size_t separators() const {
+        std::size_t chunks = turns_.size() + (system_ ? 1 : 0);
+        return chunks > 0 ? chunks - 1 : 0;
+    }
+
+    void count(const Chunk& chunk) {
+        rawBytes_ += chunk.raw.size();
+        escapedBytes_ += chunk.escaped.size();
+        tokens_ += chunk.tokens;
+    }
+
+    void forget(const Chunk& chunk) {
+        rawBytes_ -= chunk.raw.size();
+        escapedBytes_ -= chunk.escaped.size();
+        tokens_ -= chunk.tokens;
+    }
+
+    void dropOldest() {
+        forget(*turns_.front());
+        turns_.pop_front();
+        ++dropped_;
+    }
+
+    void applyWindow() {
+        while (turns_.size() > 1 && ((window_.maxBytes > 0 && bytes() > window_.maxBytes) ||
+                                     (window_.maxTokens > 0 && tokens_ > window_.maxTokens))) {
+            dropOldest();
+        }
+    }
+
+    ConversationWindow window_;
+    std::shared_ptr<const Chunk> system_;
+    std::deque<std::shared_ptr<const Chunk>> turns_;
+    std::size_t rawBytes_ = 0;     ///< Sum of the chunks' raw sizes
+    std::size_t escapedBytes_ = 0; ///< Sum of the chunks' escaped sizes
+    std::size_t tokens_ = 0;
+    std::size_t dropped_ = 0;
+};
+
+} // namespace dto
+} // namespace sauron
@@ -10,10 +10,13 @@
 #include "AIQueryResponse.hpp"
 #include "AIAlgorithmResponse.hpp"
 #include "BaseDTO.hpp"
+#include "BodyStream.hpp"
+#include "Conversation.hpp"
 #include "Error.hpp"
 #include "HealthResponse.hpp"
 #include "LoginRequest.hpp"
 #include "TokenResponse.hpp"
+#include "WireFormat.hpp"
 
 namespace sauron {
 namespace dto {
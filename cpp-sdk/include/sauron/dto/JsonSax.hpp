@@ -0,0 +1,140 @@
+#pragma once
+
+#include "WireFormat.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+namespace sauron {
+namespace dto {
+
+/**
+ * @brief Single-pass response parsing without a JSON DOM
+ *
+ * DTOs bind each of their string fields to its key path; the SAX handler
+ * writes matching string values straight into those fields and skips
+ * everything else. Only values reached through objects match, and non-string
+ * values are ignored, which is what the fromJson() functions do as well.
+ */
+namespace json_sax {
+
+/**
+ * @brief Binds a key path such as {"complexity", "time", "value"} to a field
+ */
+struct FieldBinding {
+    std::string_view path[3]; ///< Keys from the root object; unused entries empty
+    std::string* target;      ///< Field receiving the string value
+};
+
+/**
+ * @brief SAX handler filling bound string fields
+ */
+class FieldHandler {
+public:
+    explicit FieldHandler(std::initializer_list<FieldBinding> fields) : fields_(fields) {}
+
+    bool null() { return true; }
+    bool boolean(bool) { return true; }
+    bool number_integer(std::int64_t) { return true; }
+    bool number_unsigned(std::uint64_t) { return true; }
+    bool number_float(double, const std::string&) { return true; }
+    bool binary(nlohmann::json::binary_t&) { return true; }
+
+    bool string(std::string& value) {
+        if (std::string* target = match()) {
+            // Reuse the field's capacity when it is large enough, otherwise
+            // take over the parser's buffer instead of copying it.
+            if (target->capacity() >= value.size()) {
+                target->assign(value);
+            } else {
+                target->swap(value);
+            }
+        }
+        return true;
+    }
+
+    bool start_object(std::size_t) {
+        frames_.push_back(Frame{false, std::string()});
+        return true;
+    }
+
+    bool key(std::string& key) {
+        frames_.back().key.swap(key);
+        return true;
+    }
+
+    bool end_object() {
+        frames_.pop_back();
+        return true;
+    }
+
+    bool start_array(std::size_t) {
+        frames_.push_back(Frame{true, std::string()});
+        return true;
+    }
+
+    bool end_array() {
+        frames_.pop_back();
+        return true;
+    }
+
+    template <typename Exception>
+    bool parse_error(std::size_t, const std::string&, const Exception& ex) {
+        throw ex;
+    }
+
+private:
+    struct Frame {
+        bool isArray;
+        std::string key;
+    };
+
+    std::string* match() const {
+        if (frames_.empty() || frames_.size() > 3) {
+            return nullptr;
+        }
+        for (const auto& field : fields_) {
+            bool matches = true;
+            for (std::size_t depth = 0; depth < 3 && matches; ++depth) {
+                if (depth < frames_.size()) {
+                    matches = !frames_[depth].isArray && frames_[depth].key == field.path[depth];
+                } else {
+                    matches = field.path[depth].empty();
+                }
+            }
+            if (matches) {
+                return field.target;
+            }
+        }
+        return nullptr;
+    }
+
+    std::initializer_list<FieldBinding> fields_;
+    std::vector<Frame> frames_;
+};
+
+/**
+ * @brief Parse a document into bound string fields
+ *
+ * CBOR and MessagePack documents go through the same handler, so binary
+ * responses are parsed without a DOM as well.
+ *
+ * @param json The JSON text, or a CBOR/MessagePack document
+ * @param fields The field bindings
+ * @param format The wire format of json
+ * @throws nlohmann::json::parse_error if the text is not a valid document
+ */
+inline void parseFields(std::string_view json, std::initializer_list<FieldBinding> fields,
+                        WireFormat format = WireFormat::JSON) {
+    FieldHandler handler(fields);
+    nlohmann::json::sax_parse(json.data(), json.data() + json.size(), &handler, toInputFormat(format));
+}
+
+} // namespace json_sax
+
+} // namespace dto
+} // namespace sauron
@@ -0,0 +1,540 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace sauron {
+namespace dto {
+
+/**
+ * @brief Incremental parsing of JSON that arrives in pieces
+ *
+ * The parser is pushed the document in chunks of any size, as a transport
+ * receives them, and passes string values on while they are still arriving.
+ * It is meant for responses whose text fields are worth showing before the
+ * body is complete; everything else is checked and skipped.
+ */
+namespace json_stream {
+
+/**
+ * @brief Key path of the value being parsed
+ *
+ * One frame per enclosing object or array, outermost first.
+ */
+class Path {
+public:
+    struct Frame {
+        bool array;      ///< The container is an array
+        std::string key; ///< Key of the current member; empty in arrays
+    };
+
+    /**
+     * @brief Check whether the value is reached through these keys
+     *
+     * As with json_sax bindings, only values reached through objects match.
+     *
+     * @param keys Keys from the root object, e.g. {"complexity", "time", "value"}
+     */
+    bool is(std::initializer_list<std::string_view> keys) const {
+        if (keys.size() != frames_.size()) {
+            return false;
+        }
+        auto frame = frames_.begin();
+        for (std::string_view key : keys) {
+            if (frame->array || frame->key != key) {
+                return false;
+            }
+            ++frame;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Number of enclosing objects and arrays
+     */
+    std::size_t depth() const { return frames_.size(); }
+
+    const std::vector<Frame>& frames() const { return frames_; }
+
+private:
+    friend class Parser;
+
+    std::vector<Frame> frames_;
+};
+
+/**
+ * @brief Receives what the parser finds
+ *
+ * Every function returns false to stop parsing. Text is only valid during
+ * the call.
+ */
+class Handler {
+public:
+    virtual ~Handler() = default;
+
+    /**
+     * @brief Part of a string value
+     *
+     * The parts of one value concatenate to its decoded text. The last part,
+     * which may be empty, has complete set.
+     *
+     * @param path Where the value is
+     * @param text Decoded text received since the previous part
+     * @param complete The closing quote has been read
+     */
+    virtual bool string(const Path& path, std::string_view text, bool complete) {
+        (void)path;
+        (void)text;
+        (void)complete;
+        return true;
+    }
+
+    /**
+     * @brief An object has been closed
+     *
+     * @param path Where the object is; the path of its parent's member
+     */
+    virtual bool endObject(const Path& path) {
+        (void)path;
+        return true;
+    }
+};
+
+/**
+ * @brief Push parser for one JSON document
+ *
+ * Plain runs of string text are handed on as views into the chunk, so text
+ * is only copied where an escape sequence or a chunk boundary splits it.
+ * Escapes, literals and numbers may be split anywhere.
+ */
+class Parser {
+public:
+    /**
+     * @brief Feed the next chunk of the document
+     *
+     * @param chunk Bytes received from the transport
+     * @param handler Receives the strings and objects completed or continued by this chunk
+     * @return bool False if the handler asked to stop; later chunks are then ignored
+     * @throws std::runtime_error if the chunk makes the document invalid
+     */
+    bool feed(std::string_view chunk, Handler& handler) {
+        if (stopped_) {
+            return false;
+        }
+        std::size_t i = 0;
+        const std::size_t n = chunk.size();
+        while (i < n && !stopped_) {
+            char c = chunk[i];
+            switch (state_) {
+            case State::Value:
+                if (isSpace(c)) {
+                    ++i;
+                } else {
+                    ++i;
+                    startValue(c, i - 1);
+                }
+                break;
+            case State::FirstKey:
+            case State::Key:
+                ++i;
+                if (isSpace(c)) {
+                    break;
+                }
+                if (c == '"') {
+                    inKey_ = true;
+                    state_ = State::String;
+                } else if (c == '}' && state_ == State::FirstKey) {
+                    closeContainer(handler);
+                } else {
+                    fail(consumed_ + i - 1, "expected an object key");
+                }
+                break;
+            case State::Colon:
+                ++i;
+                if (c == ':') {
+                    state_ = State::Value;
+                } else if (!isSpace(c)) {
+                    fail(consumed_ + i - 1, "expected ':'");
+                }
+                break;
+            case State::FirstElement:
+                if (isSpace(c)) {
+                    ++i;
+                } else if (c == ']') {
+                    ++i;
+                    closeContainer(handler);
+                } else {
+                    state_ = State::Value;
+                }
+                break;
+            case State::AfterValue:
+                ++i;
+                if (isSpace(c)) {
+                    break;
+                }
+                if (c == ',') {
+                    state_ = path_.frames_.back().array ? State::Value : State::Key;
+                } else if (c == (path_.frames_.back().array ? ']' : '}')) {
+                    closeContainer(handler);
+                } else {
+                    fail(consumed_ + i - 1, "expected ',' or the end of the container");
+                }
+                break;
+            case State::String:
+                i = scanString(chunk, i, handler);
+                break;
+            case State::Escape:
+                ++i;
+                escape(c, consumed_ + i - 1);
+                break;
+            case State::Unicode:
+                ++i;
+                unicode(c, consumed_ + i - 1);
+                break;
+            case State::Literal:
+                if (c != literal_[matched_]) {
+                    fail(consumed_ + i, "invalid literal");
+                }
+                ++i;
+                if (++matched_ == literal_.size()) {
+                    completeValue();
+                }
+                break;
+            case State::Number:
+                if (isNumberChar(c)) {
+                    number_.push_back(c);
+                    ++i;
+                } else {
+                    endNumber(consumed_ + i);
+                }
+                break;
+            case State::Done:
+                if (!isSpace(c)) {
+                    fail(consumed_ + i, "unexpected data after the document");
+                }
+                ++i;
+                break;
+            }
+        }
+        // Hand on what has arrived of a string that continues in the next chunk.
+        if (!stopped_ && !inKey_ && !text_.empty() &&
+            (state_ == State::String || state_ == State::Escape || state_ == State::Unicode)) {
+            emit(handler, text_, false);
+            text_.clear();
+        }
+        consumed_ += i;
+        return !stopped_;
+    }
+
+    /**
+     * @brief Check that the document is complete
+     *
+     * Call once the transport reports the end of the body.
+     *
+     * @throws std::runtime_error if the document is incomplete
+     */
+    void finish() {
+        if (state_ == State::Number && path_.frames_.empty()) {
+            endNumber(consumed_);
+        }
+        if (state_ != State::Done && !stopped_) {
+            fail(consumed_, "unexpected end of the document");
+        }
+    }
+
+    /**
+     * @brief Forget the document parsed so far
+     */
+    void reset() {
+        state_ = State::Value;
+        path_.frames_.clear();
+        text_.clear();
+        key_.clear();
+        number_.clear();
+        inKey_ = false;
+        stopped_ = false;
+        expectLow_ = false;
+        high_ = 0;
+        consumed_ = 0;
+    }
+
+    /**
+     * @brief Check whether a whole document has been read
+     */
+    bool done() const { return state_ == State::Done; }
+
+    /**
+     * @brief Number of bytes fed so far
+     */
+    std::size_t consumed() const { return consumed_; }
+
+private:
+    enum class State {
+        Value,        ///< Expecting a value
+        FirstKey,     ///< After '{': a key or '}'
+        Key,          ///< After ',' in an object: a key
+        Colon,        ///< After a key
+        FirstElement, ///< After '[': a value or ']'
+        AfterValue,   ///< After a member or element: ',' or the closing bracket
+        String,       ///< Inside a string
+        Escape,       ///< After a backslash
+        Unicode,      ///< Inside the digits of a \u escape
+        Literal,      ///< Inside true, false or null
+        Number,       ///< Inside a number
+        Done          ///< After the document
+    };
+
+    static bool isSpace(char c) {
+        return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+    }
+
+    static bool isNumberChar(char c) {
+        return (c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E';
+    }
+
+    [[noreturn]] static void fail(std::size_t offset, const char* reason) {
+        throw std::runtime_error("Invalid JSON at byte " + std::to_string(offset) + ": " + reason);
+    }
+
+    void startValue(char c, std::size_t at) {
+        switch (c) {
+        case '{':
+            path_.frames_.push_back(Path::Frame{false, std::string()});
+            state_ = State::FirstKey;
+            break;
+        case '[':
+            path_.frames_.push_back(Path::Frame{true, std::string()});
+            state_ = State::FirstElement;
+            break;
+        case '"':
+            inKey_ = false;
+            state_ = State::String;
+            break;
+        case 't':
+        case 'f':
+        case 'n':
+            literal_ = c == 't' ? "true" : c == 'f' ? "false" : "null";
+            matched_ = 1;
+            state_ = State::Literal;
+            break;
+        default:
+            if (c != '-' && (c < '0' || c > '9')) {
+                fail(consumed_ + at, "expected a value");
+            }
+            number_.assign(1, c);
+            state_ = State::Number;
+            break;
+        }
+    }
+
+    void completeValue() {
+        state_ = path_.frames_.empty() ? State::Done : State::AfterValue;
+    }
+
+    void closeContainer(Handler& handler) {
+        bool object = !path_.frames_.back().array;
+        path_.frames_.pop_back();
+        completeValue();
+        if (object && !handler.endObject(path_)) {
+            stopped_ = true;
+        }
+    }
+
+    void emit(Handler& handler, std::string_view text, bool complete) {
+        if (!handler.string(path_, text, complete)) {
+            stopped_ = true;
+        }
+    }
+
+    std::size_t scanString(std::string_view chunk, std::size_t i, Handler& handler) {
+        const std::size_t n = chunk.size();
+        if (expectLow_ && chunk[i] != '\\') {
+            fail(consumed_ + i, "unpaired surrogate in \\u escape");
+        }
+        std::size_t start = i;
+        while (i < n) {
+            unsigned char c = static_cast<unsigned char>(chunk[i]);
+            if (c == '"' || c == '\\' || c < 0x20) {
+                break;
+            }
+            ++i;
+        }
+        std::string_view run = chunk.substr(start, i - start);
+        std::string& buffer = inKey_ ? key_ : text_;
+        if (i == n) {
+            // The string continues in the next chunk.
+            if (!inKey_ && text_.empty()) {
+                if (!run.empty()) {
+                    emit(handler, run, false);
+                }
+            } else {
+                buffer.append(run.data(), run.size());
+            }
+            return i;
+        }
+        char c = chunk[i];
+        if (c == '\\') {
+            buffer.append(run.data(), run.size());
+            state_ = State::Escape;
+        } else if (c == '"') {
+            if (inKey_) {
+                key_.append(run.data(), run.size());
+                path_.frames_.back().key.swap(key_);
+                key_.clear();
+                inKey_ = false;
+                state_ = State::Colon;
+            } else {
+                completeValue();
+                if (text_.empty()) {
+                    emit(handler, run, true);
+                } else {
+                    text_.append(run.data(), run.size());
+                    emit(handler, text_, true);
+                    text_.clear();
+                }
+            }
+        } else {
+            fail(consumed_ + i, "control character in string");
+        }
+        return i + 1;
+    }
+
+    void escape(char c, std::size_t at) {
+        if (expectLow_ && c != 'u') {
+            fail(at, "unpaired surrogate in \\u escape");
+        }
+        std::string& buffer = inKey_ ? key_ : text_;
+        state_ = State::String;
+        switch (c) {
+        case '"': buffer.push_back('"'); break;
+        case '\\': buffer.push_back('\\'); break;
+        case '/': buffer.push_back('/'); break;
+        case 'b': buffer.push_back('\b'); break;
+        case 'f': buffer.push_back('\f'); break;
+        case 'n': buffer.push_back('\n'); break;
+        case 'r': buffer.push_back('\r'); break;
+        case 't': buffer.push_back('\t'); break;
+        case 'u':
+            unit_ = 0;
+            digits_ = 0;
+            state_ = State::Unicode;
+            break;
+        default:
+            fail(at, "invalid escape sequence");
+        }
+    }
+
+    void unicode(char c, std::size_t at) {
+        std::uint32_t digit;
+        if (c >= '0' && c <= '9') {
+            digit = static_cast<std::uint32_t>(c - '0');
+        } else if (c >= 'a' && c <= 'f') {
+            digit = static_cast<std::uint32_t>(c - 'a' + 10);
+        } else if (c >= 'A' && c <= 'F') {
+            digit = static_cast<std::uint32_t>(c - 'A' + 10);
+        } else {
+            fail(at, "invalid \\u escape");
+        }
+        unit_ = (unit_ << 4) | digit;
+        if (++digits_ < 4) {
+            return;
+        }
+        state_ = State::String;
+        std::uint32_t codePoint = unit_;
+        if (expectLow_) {
+            if (unit_ < 0xDC00 || unit_ > 0xDFFF) {
+                fail(at, "unpaired surrogate in \\u escape");
+            }
+            codePoint = 0x10000 + ((high_ - 0xD800) << 10) + (unit_ - 0xDC00);
+            expectLow_ = false;
+        } else if (unit_ >= 0xD800 && unit_ <= 0xDBFF) {
+            high_ = unit_;
+            expectLow_ = true;
+            return;
+        } else if (unit_ >= 0xDC00 && unit_ <= 0xDFFF) {
+            fail(at, "unpaired surrogate in \\u escape");
+        }
+        appendUtf8(inKey_ ? key_ : text_, codePoint);
+    }
+
+    static void appendUtf8(std::string& out, std::uint32_t codePoint) {
+        if (codePoint < 0x80) {
+            out.push_back(static_cast<char>(codePoint));
+        } else if (codePoint < 0x800) {
+            out.push_back(static_cast<char>(0xC0 | (codePoint >> 6)));
+            out.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+        } else if (codePoint < 0x10000) {
+            out.push_back(static_cast<char>(0xE0 | (codePoint >> 12)));
+            out.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+        } else {
+            out.push_back(static_cast<char>(0xF0 | (codePoint >> 18)));
+            out.push_back(static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+        }
+    }
+
+    /// Checks number_ against the JSON number grammar.
+    void endNumber(std::size_t at) {
+        std::size_t i = 0;
+        const std::size_t n = number_.size();
+        auto digits = [&] {
+            std::size_t start = i;
+            while (i < n && number_[i] >= '0' && number_[i] <= '9') {
+                ++i;
+            }
+            return i - start;
+        };
+        if (i < n && number_[i] == '-') {
+            ++i;
+        }
+        bool valid;
+        if (i < n && number_[i] == '0') {
+            ++i;
+            valid = true;
+        } else {
+            valid = digits() > 0;
+        }
+        if (valid && i < n && number_[i] == '.') {
+            ++i;
+            valid = digits() > 0;
+        }
+        if (valid && i < n && (number_[i] == 'e' || number_[i] == 'E')) {
+            ++i;
+            if (i < n && (number_[i] == '+' || number_[i] == '-')) {
+                ++i;
+            }
+            valid = digits() > 0;
+        }
+        if (!valid || i != n) {
+            fail(at, "invalid number");
+        }
+        number_.clear();
+        completeValue();
+    }
+
+    State state_ = State::Value;
+    Path path_;
+    std::string text_;          ///< Decoded text of the current string value not yet handed on
+    std::string key_;           ///< Decoded text of the current key
+    std::string number_;        ///< Characters of the current number
+    std::string_view literal_;  ///< Literal being matched
+    std::size_t matched_ = 0;   ///< Characters of literal_ matched so far
+    std::uint32_t unit_ = 0;    ///< Value of the \u escape being read
+    std::uint32_t high_ = 0;    ///< High surrogate waiting for its low half
+    int digits_ = 0;            ///< Hex digits of unit_ read so far
+    bool inKey_ = false;        ///< The current string is a key
+    bool expectLow_ = false;    ///< A high surrogate must be followed by a low one
+    bool stopped_ = false;      ///< The handler asked to stop
+    std::size_t consumed_ = 0;  ///< Bytes fed before the current chunk
+};
+
+} // namespace json_stream
+} // namespace dto
+} // namespace sauron
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+namespace sauron {
+namespace dto {
+
+/**
+ * @brief Minimal JSON writer appending straight into a caller-owned buffer
+ *
+ * Used by DTOs that are large enough for the nlohmann::json DOM to matter
+ * (prompts, base64 images). Output is byte-identical to nlohmann::json::dump()
+ * for the same object, including key order, so both paths are interchangeable.
+ * Sizes are computed first so that a whole document can be written with a
+ * single allocation.
+ */
+namespace json_writer {
+
+/**
+ * @brief Length of a string once quoted and escaped
+ *
+ * @param value The raw string
+ * @param field Field name used in the error message
+ * @return std::size_t Number of bytes appendString() will write
+ * @throws std::invalid_argument if the string is not valid UTF-8
+ */
+inline std::size_t escapedSize(std::string_view value, const char* field) {
+    std::size_t size = 2;
+    const auto* p = reinterpret_cast<const unsigned char*>(value.data());
+    const auto* end = p + value.size();
+    while (p < end) {
+        unsigned char c = *p;
+        if (c >= 0x20 && c < 0x80) {
+            size += (c == '"' || c == '\\') ? 2 : 1;
+            ++p;
+            continue;
+        }
+        if (c < 0x20) {
+            size += (c == '\b' || c == '\f' || c == '\n' || c == '\r' || c == '\t') ? 2 : 6;
+            ++p;
+            continue;
+        }
+        // Multi-byte UTF-8 sequence: copied verbatim once validated.
+        std::size_t length;
+        unsigned int codePoint;
+        if ((c & 0xE0) == 0xC0) {
+            length = 2;
+            codePoint = c & 0x1F;
+        } else if ((c & 0xF0) == 0xE0) {
+            length = 3;
+            codePoint = c & 0x0F;
+        } else if ((c & 0xF8) == 0xF0) {
+            length = 4;
+            codePoint = c & 0x07;
+        } else {
+            throw std::invalid_argument(std::string(field) + " is not valid UTF-8");
+        }
+        if (static_cast<std::size_t>(end - p) < length) {
+            throw std::invalid_argument(std::string(field) + " is not valid UTF-8");
+        }
+        for (std::size_t i = 1; i < length; ++i) {
+            if ((p[i] & 0xC0) != 0x80) {
+                throw std::invalid_argument(std::string(field) + " is not valid UTF-8");
+            }
+            codePoint = (codePoint << 6) | (p[i] & 0x3F);
+        }
+        static const unsigned int kMinimum[] = {0, 0, 0x80, 0x800, 0x10000};
+        if (codePoint < kMinimum[length] || codePoint > 0x10FFFF || (codePoint >= 0xD800 && codePoint <= 0xDFFF)) {
+            throw std::invalid_argument(std::string(field) + " is not valid UTF-8");
+        }
+        size += length;
+        p += length;
+    }
+    return size;
+}
+
+/**
+ * @brief Append the escaped contents of a JSON string, without the quotes
+ *
+ * The input must have been validated with escapedSize(), which counts two
+ * bytes more than this writes.
+ *
+ * @param out The output buffer
+ * @param value The raw string
+ */
+inline void appendEscaped(std::string& out, std::string_view value) {
+    static const char kHex[] = "0123456789abcdef";
+    const char* p = value.data();
+    const char* end = p + value.size();
+    while (p < end) {
+        // Copy the longest run that needs no escaping in one go.
+        const char* run = p;
+        while (p < end) {
+            auto c = static_cast<unsigned char>(*p);
+            if (c < 0x20 || c == '"' || c == '\\') {
+                break;
+            }
+            ++p;
+        }
+        out.append(run, static_cast<std::size_t>(p - run));
+        if (p == end) {
+            break;
+        }
+        auto c = static_cast<unsigned char>(*p++);
+        switch (c) {
+            case '"': out.append("\\\"", 2); break;
+            case '\\': out.append("\\\\", 2); break;
+            case '\b': out.append("\\b", 2); break;
+            case '\f': out.append("\\f", 2); break;
+            case '\n': out.append("\\n", 2); break;
+            case '\r': out.append("\\r", 2); break;
+            case '\t': out.append("\\t", 2); break;
+            default: {
+                char escaped[6] = {'\\', 'u', '0', '0', kHex[c >> 4], kHex[c & 0xF]};
+                out.append(escaped, 6);
+                break;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Append a quoted, escaped JSON string
+ *
+ * The input must have been validated with escapedSize().
+ *
+ * @param out The output buffer
+ * @param value The raw string
+ */
+inline void appendString(std::string& out, std::string_view value) {
+    out.push_back('"');
+    appendEscaped(out, value);
+    out.push_back('"');
+}
+
+} // namespace json_writer
+
+} // namespace dto
+} // namespace sauron
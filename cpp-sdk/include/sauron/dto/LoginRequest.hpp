@@ -3,6 +3,7 @@
 #include "BaseDTO.hpp"
 #include "AIProvider.hpp"
 #include <string>
+#include <string_view>
 #include <nlohmann/json.hpp>
 
 namespace sauron {
@@ -53,6 +54,18 @@ public:
         return request;
     }
 
+    /**
+     * @brief Construct from CBOR or MessagePack
+     * 
+     * @param data The encoded document
+     * @param format The wire format of data
+     * @return LoginRequest The constructed object
+     * @throws nlohmann::json::parse_error if data is not a valid document
+     */
+    static LoginRequest fromBinary(std::string_view data, WireFormat format) {
+        return fromJson(decodeWireFormat(data, format));
+    }
+
     /**
      * @brief Convert to JSON
      * 
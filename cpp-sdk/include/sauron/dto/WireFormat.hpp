@@ -0,0 +1,253 @@
+#pragma once
+
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <nlohmann/json.hpp>
+
+namespace sauron {
+namespace dto {
+
+/**
+ * @brief Encodings a DTO can travel in
+ *
+ * CBOR and MessagePack carry the same documents as JSON, but binary fields
+ * (such as AIQueryRequest images) travel as raw byte strings instead of
+ * base64 text.
+ */
+enum class WireFormat {
+    JSON,
+    CBOR,
+    MSGPACK
+};
+
+/**
+ * @brief Media type of a wire format, for Content-Type and Accept headers
+ *
+ * @param format The wire format
+ * @return const char* e.g. "application/cbor"
+ */
+inline const char* WireFormatToContentType(WireFormat format) {
+    switch (format) {
+        case WireFormat::CBOR:
+            return "application/cbor";
+        case WireFormat::MSGPACK:
+            return "application/msgpack";
+        default:
+            return "application/json";
+    }
+}
+
+/**
+ * @brief Wire format named by a Content-Type value
+ *
+ * Parameters such as "; charset=utf-8" are ignored. Anything that is not
+ * CBOR or MessagePack is treated as JSON, which is what servers that do not
+ * negotiate send.
+ *
+ * @param contentType The header value
+ * @return WireFormat The wire format
+ */
+inline WireFormat toWireFormat(std::string_view contentType) {
+    std::size_t end = contentType.find(';');
+    std::string type(contentType.substr(0, end));
+    while (!type.empty() && std::isspace(static_cast<unsigned char>(type.back()))) {
+        type.pop_back();
+    }
+    std::size_t begin = 0;
+    while (begin < type.size() && std::isspace(static_cast<unsigned char>(type[begin]))) {
+        ++begin;
+    }
+    type.erase(0, begin);
+    for (char& c : type) {
+        c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+    if (type == "application/cbor") {
+        return WireFormat::CBOR;
+    }
+    if (type == "application/msgpack" || type == "application/x-msgpack" || type == "application/vnd.msgpack") {
+        return WireFormat::MSGPACK;
+    }
+    return WireFormat::JSON;
+}
+
+/**
+ * @brief nlohmann input format of a wire format, for SAX parsing
+ */
+inline nlohmann::json::input_format_t toInputFormat(WireFormat format) {
+    switch (format) {
+        case WireFormat::CBOR:
+            return nlohmann::json::input_format_t::cbor;
+        case WireFormat::MSGPACK:
+            return nlohmann::json::input_format_t::msgpack;
+        default:
+            return nlohmann::json::input_format_t::json;
+    }
+}
+
+/**
+ * @brief Encode a document, appending to out
+ *
+ * @param json The document
+ * @param format The wire format
+ * @param out Buffer receiving the encoded bytes
+ */
+inline void encodeWireFormat(const nlohmann::json& json, WireFormat format, std::string& out) {
+    switch (format) {
+        case WireFormat::CBOR:
+            nlohmann::json::to_cbor(json, out);
+            break;
+        case WireFormat::MSGPACK:
+            nlohmann::json::to_msgpack(json, out);
+            break;
+        default:
+            out.append(json.dump());
+            break;
+    }
+}
+
+/**
+ * @brief Decode a document
+ *
+ * @param data The encoded bytes
+ * @param format The wire format
+ * @return nlohmann::json The document
+ * @throws nlohmann::json::parse_error if the data is not a valid document
+ */
+inline nlohmann::json decodeWireFormat(std::string_view data, WireFormat format) {
+    switch (format) {
+        case WireFormat::CBOR:
+            return nlohmann::json::from_cbor(data.begin(), data.end());
+        case WireFormat::MSGPACK:
+            return nlohmann::json::from_msgpack(data.begin(), data.end());
+        default:
+            return nlohmann::json::parse(data.begin(), data.end());
+    }
+}
+
+/**
+ * @brief Writers for the few CBOR and MessagePack items DTOs emit directly
+ *
+ * Only what hand-written DTO serializers need: map headers, text strings and
+ * byte string headers, all in their shortest encoding.
+ */
+namespace binary_writer {
+
+namespace detail {
+
+inline void appendBigEndian(std::string& out, std::uint64_t value, int bytes) {
+    for (int i = bytes - 1; i >= 0; --i) {
+        out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+    }
+}
+
+// CBOR head: major type in the top three bits, then the argument.
+inline void appendCborHead(std::string& out, std::uint8_t major, std::uint64_t value) {
+    const std::uint8_t type = static_cast<std::uint8_t>(major << 5);
+    if (value < 24) {
+        out.push_back(static_cast<char>(type | value));
+    } else if (value <= 0xFF) {
+        out.push_back(static_cast<char>(type | 24));
+        appendBigEndian(out, value, 1);
+    } else if (value <= 0xFFFF) {
+        out.push_back(static_cast<char>(type | 25));
+        appendBigEndian(out, value, 2);
+    } else if (value <= 0xFFFFFFFFu) {
+        out.push_back(static_cast<char>(type | 26));
+        appendBigEndian(out, value, 4);
+    } else {
+        out.push_back(static_cast<char>(type | 27));
+        appendBigEndian(out, value, 8);
+    }
+}
+
+} // namespace detail
+
+/**
+ * @brief Append the header of a map with n entries
+ */
+inline void appendMapHeader(std::string& out, WireFormat format, std::size_t n) {
+    if (format == WireFormat::CBOR) {
+        detail::appendCborHead(out, 5, n);
+    } else if (n < 16) {
+        out.push_back(static_cast<char>(0x80 | n));
+    } else if (n <= 0xFFFF) {
+        out.push_back(static_cast<char>(0xDE));
+        detail::appendBigEndian(out, n, 2);
+    } else {
+        out.push_back(static_cast<char>(0xDF));
+        detail::appendBigEndian(out, n, 4);
+    }
+}
+
+/**
+ * @brief Append the header of an array with n elements
+ */
+inline void appendArrayHeader(std::string& out, WireFormat format, std::size_t n) {
+    if (format == WireFormat::CBOR) {
+        detail::appendCborHead(out, 4, n);
+    } else if (n < 16) {
+        out.push_back(static_cast<char>(0x90 | n));
+    } else if (n <= 0xFFFF) {
+        out.push_back(static_cast<char>(0xDC));
+        detail::appendBigEndian(out, n, 2);
+    } else {
+        out.push_back(static_cast<char>(0xDD));
+        detail::appendBigEndian(out, n, 4);
+    }
+}
+
+/**
+ * @brief Append the header of a byte string of n bytes; the bytes follow
+ */
+inline void appendBytesHeader(std::string& out, WireFormat format, std::size_t n) {
+    if (format == WireFormat::CBOR) {
+        detail::appendCborHead(out, 2, n);
+    } else if (n <= 0xFF) {
+        out.push_back(static_cast<char>(0xC4));
+        detail::appendBigEndian(out, n, 1);
+    } else if (n <= 0xFFFF) {
+        out.push_back(static_cast<char>(0xC5));
+        detail::appendBigEndian(out, n, 2);
+    } else {
+        out.push_back(static_cast<char>(0xC6));
+        detail::appendBigEndian(out, n, 4);
+    }
+}
+
+/**
+ * @brief Append the header of a text string of n bytes; the UTF-8 bytes follow
+ */
+inline void appendStringHeader(std::string& out, WireFormat format, std::size_t n) {
+    if (format == WireFormat::CBOR) {
+        detail::appendCborHead(out, 3, n);
+    } else if (n < 32) {
+        out.push_back(static_cast<char>(0xA0 | n));
+    } else if (n <= 0xFF) {
+        out.push_back(static_cast<char>(0xD9));
+        detail::appendBigEndian(out, n, 1);
+    } else if (n <= 0xFFFF) {
+        out.push_back(static_cast<char>(0xDA));
+        detail::appendBigEndian(out, n, 2);
+    } else {
+        out.push_back(static_cast<char>(0xDB));
+        detail::appendBigEndian(out, n, 4);
+    }
+}
+
+/**
+ * @brief Append a text string
+ *
+ * The text is copied as is; callers pass UTF-8.
+ */
+inline void appendString(std::string& out, WireFormat format, std::string_view text) {
+    appendStringHeader(out, format, text.size());
+    out.append(text.data(), text.size());
+}
+
+} // namespace binary_writer
+
+} // namespace dto
+} // namespace sauron
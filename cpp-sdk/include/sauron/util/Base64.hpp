@@ -0,0 +1,529 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define SAURON_BASE64_X86 1
+#include <immintrin.h>
+#else
+#define SAURON_BASE64_X86 0
+#endif
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#define SAURON_BASE64_NEON 1
+#include <arm_neon.h>
+#else
+#define SAURON_BASE64_NEON 0
+#endif
+
+namespace sauron {
+namespace util {
+
+/**
+ * @brief Base64 encoding and decoding (RFC 4648)
+ *
+ * Bulk data goes through SIMD kernels (AVX2 or SSE4.1 on x86-64, NEON on
+ * AArch64) picked at runtime from what the CPU supports; the last few bytes
+ * and any other CPU use the scalar code. Every kernel produces the same
+ * output.
+ */
+namespace base64 {
+
+/**
+ * @brief Alphabet variant
+ */
+enum class Alphabet {
+    Standard, ///< '+' and '/', padded with '='
+    Url       ///< '-' and '_', padding optional (as used by JWT)
+};
+
+/**
+ * @brief Implementation used for the bulk of the data
+ */
+enum class Kernel {
+    Scalar, ///< Portable table-driven code
+    Sse41,  ///< SSSE3 shuffles with an SSE4.1 validity test, 16 characters per step
+    Avx2,   ///< AVX2, 32 characters per step
+    Neon    ///< AArch64 NEON table lookups, 64 characters per step
+};
+
+namespace detail {
+
+inline const char* chars(Alphabet alphabet) {
+    return alphabet == Alphabet::Standard
+        ? "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/"
+        : "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+}
+
+// Value of each character in either alphabet, -1 if it is not one.
+struct DecodeTable {
+    std::int8_t values[256];
+};
+
+inline const DecodeTable& decodeTable() {
+    static const DecodeTable table = [] {
+        DecodeTable t{};
+        for (int c = 0; c < 256; ++c) {
+            t.values[c] = -1;
+        }
+        const char* standard = chars(Alphabet::Standard);
+        for (int v = 0; v < 64; ++v) {
+            t.values[static_cast<unsigned char>(standard[v])] = static_cast<std::int8_t>(v);
+        }
+        t.values[static_cast<unsigned char>('-')] = 62;
+        t.values[static_cast<unsigned char>('_')] = 63;
+        return t;
+    }();
+    return table;
+}
+
+inline unsigned supportedKernels() {
+    static const unsigned mask = [] {
+        unsigned m = 1u << static_cast<int>(Kernel::Scalar);
+#if SAURON_BASE64_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("ssse3") && __builtin_cpu_supports("sse4.1")) {
+            m |= 1u << static_cast<int>(Kernel::Sse41);
+        }
+        if (__builtin_cpu_supports("avx2")) {
+            m |= 1u << static_cast<int>(Kernel::Avx2);
+        }
+#elif SAURON_BASE64_NEON
+        m |= 1u << static_cast<int>(Kernel::Neon);
+#endif
+        return m;
+    }();
+    return mask;
+}
+
+// Encodes all of data, including the padded tail.
+inline void encodeScalar(char* dst, const std::uint8_t* data, std::size_t size, Alphabet alphabet) {
+    const char* table = chars(alphabet);
+    std::size_t i = 0;
+    for (; i + 3 <= size; i += 3) {
+        std::uint32_t v = (std::uint32_t(data[i]) << 16) | (std::uint32_t(data[i + 1]) << 8) | data[i + 2];
+        *dst++ = table[(v >> 18) & 0x3F];
+        *dst++ = table[(v >> 12) & 0x3F];
+        *dst++ = table[(v >> 6) & 0x3F];
+        *dst++ = table[v & 0x3F];
+    }
+    std::size_t rest = size - i;
+    if (rest > 0) {
+        std::uint32_t v = std::uint32_t(data[i]) << 16;
+        if (rest == 2) {
+            v |= std::uint32_t(data[i + 1]) << 8;
+        }
+        *dst++ = table[(v >> 18) & 0x3F];
+        *dst++ = table[(v >> 12) & 0x3F];
+        if (rest == 2) {
+            *dst++ = table[(v >> 6) & 0x3F];
+        }
+        if (alphabet == Alphabet::Standard) {
+            if (rest == 1) {
+                *dst++ = '=';
+            }
+            *dst++ = '=';
+        }
+    }
+}
+
+// Decodes all of text, which has no padding and a length that is not 4k + 1.
+// Returns false on a character outside both alphabets.
+inline bool decodeScalar(std::uint8_t* dst, const char* text, std::size_t size) {
+    const std::int8_t* values = decodeTable().values;
+    std::size_t i = 0;
+    for (; i + 4 <= size; i += 4) {
+        std::int8_t a = values[static_cast<unsigned char>(text[i])];
+        std::int8_t b = values[static_cast<unsigned char>(text[i + 1])];
+        std::int8_t c = values[static_cast<unsigned char>(text[i + 2])];
+        std::int8_t d = values[static_cast<unsigned char>(text[i + 3])];
+        if ((a | b | c | d) < 0) {
+            return false;
+        }
+        std::uint32_t v = (std::uint32_t(a) << 18) | (std::uint32_t(b) << 12) | (std::uint32_t(c) << 6) | std::uint32_t(d);
+        *dst++ = static_cast<std::uint8_t>(v >> 16);
+        *dst++ = static_cast<std::uint8_t>(v >> 8);
+        *dst++ = static_cast<std::uint8_t>(v);
+    }
+    std::uint32_t accumulator = 0;
+    int bits = 0;
+    for (; i < size; ++i) {
+        std::int8_t v = values[static_cast<unsigned char>(text[i])];
+        if (v < 0) {
+            return false;
+        }
+        accumulator = (accumulator << 6) | static_cast<std::uint32_t>(v);
+        bits += 6;
+        if (bits >= 8) {
+            bits -= 8;
+            *dst++ = static_cast<std::uint8_t>(accumulator >> bits);
+        }
+    }
+    return true;
+}
+
+// The block functions below handle whole blocks from the start of their input
+// and return how many input bytes they consumed, always a multiple of 3 when
+// encoding and of 4 when decoding; the caller finishes the rest with the
+// scalar code. Decoders only take the standard alphabet and stop at the first
+// block holding anything else, leaving the scalar code to accept '-' and '_'
+// or report the error.
+
+#if SAURON_BASE64_X86
+
+// Spreads 12 bytes per 128-bit lane into 16 six-bit values, one per byte.
+__attribute__((target("ssse3,sse4.1"))) inline __m128i encodeReshuffle(__m128i in) {
+    in = _mm_shuffle_epi8(in, _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+    const __m128i t0 = _mm_and_si128(in, _mm_set1_epi32(0x0FC0FC00));
+    const __m128i t1 = _mm_mulhi_epu16(t0, _mm_set1_epi32(0x04000040));
+    const __m128i t2 = _mm_and_si128(in, _mm_set1_epi32(0x003F03F0));
+    const __m128i t3 = _mm_mullo_epi16(t2, _mm_set1_epi32(0x01000010));
+    return _mm_or_si128(t1, t3);
+}
+
+// Offset to add to each six-bit value, by range: A-Z, a-z, 0-9 (ten entries),
+// then the two alphabet-specific characters.
+__attribute__((target("ssse3,sse4.1"))) inline __m128i encodeOffsets(Alphabet alphabet) {
+    const char c62 = alphabet == Alphabet::Standard ? '+' : '-';
+    const char c63 = alphabet == Alphabet::Standard ? '/' : '_';
+    return _mm_setr_epi8('A', 'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                         '0' - 52, '0' - 52, '0' - 52, static_cast<char>(c62 - 62), static_cast<char>(c63 - 63), 0, 0);
+}
+
+__attribute__((target("ssse3,sse4.1"))) inline std::size_t encodeBlocksSse41(char* dst, const std::uint8_t* data,
+                                                                            std::size_t size, Alphabet alphabet) {
+    const __m128i offsets = encodeOffsets(alphabet);
+    std::size_t i = 0;
+    // Each step loads 16 bytes and uses 12 of them
+    for (; size - i >= 16; i += 12, dst += 16) {
+        const __m128i values = encodeReshuffle(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i)));
+        __m128i range = _mm_subs_epu8(values, _mm_set1_epi8(51));
+        range = _mm_sub_epi8(range, _mm_cmpgt_epi8(values, _mm_set1_epi8(25)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm_add_epi8(values, _mm_shuffle_epi8(offsets, range)));
+    }
+    return i;
+}
+
+__attribute__((target("avx2"))) inline std::size_t encodeBlocksAvx2(char* dst, const std::uint8_t* data,
+                                                                   std::size_t size, Alphabet alphabet) {
+    const __m256i shuffle = _mm256_broadcastsi128_si256(
+        _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+    const __m256i offsets = _mm256_broadcastsi128_si256(encodeOffsets(alphabet));
+    std::size_t i = 0;
+    // Each step loads 12 + 16 bytes and uses 24 of them
+    for (; size - i >= 28; i += 24, dst += 32) {
+        const __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        const __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + 12));
+        __m256i in = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+        in = _mm256_shuffle_epi8(in, shuffle);
+        const __m256i t0 = _mm256_and_si256(in, _mm256_set1_epi32(0x0FC0FC00));
+        const __m256i t1 = _mm256_mulhi_epu16(t0, _mm256_set1_epi32(0x04000040));
+        const __m256i t2 = _mm256_and_si256(in, _mm256_set1_epi32(0x003F03F0));
+        const __m256i t3 = _mm256_mullo_epi16(t2, _mm256_set1_epi32(0x01000010));
+        const __m256i values = _mm256_or_si256(t1, t3);
+        __m256i range = _mm256_subs_epu8(values, _mm256_set1_epi8(51));
+        range = _mm256_sub_epi8(range, _mm256_cmpgt_epi8(values, _mm256_set1_epi8(25)));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst),
+                            _mm256_add_epi8(values, _mm256_shuffle_epi8(offsets, range)));
+    }
+    return i;
+}
+
+// Nibble tables classifying standard-alphabet characters: a character is
+// valid when its low-nibble and high-nibble classes share no bit. The roll
+// table holds the offset from character to value, by high nibble ('/' gets
+// its own slot).
+#define SAURON_BASE64_DECODE_LUT_LO \
+    0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A
+#define SAURON_BASE64_DECODE_LUT_HI \
+    0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10
+#define SAURON_BASE64_DECODE_LUT_ROLL 0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0
+
+__attribute__((target("ssse3,sse4.1"))) inline std::size_t decodeBlocksSse41(std::uint8_t* dst, const char* text,
+                                                                            std::size_t size) {
+    const __m128i lutLo = _mm_setr_epi8(SAURON_BASE64_DECODE_LUT_LO);
+    const __m128i lutHi = _mm_setr_epi8(SAURON_BASE64_DECODE_LUT_HI);
+    const __m128i lutRoll = _mm_setr_epi8(SAURON_BASE64_DECODE_LUT_ROLL);
+    const __m128i mask2F = _mm_set1_epi8(0x2F);
+    std::size_t i = 0;
+    // Each step stores 16 bytes and keeps 12; stop while the output still has room
+    for (; size - i >= 24; i += 16, dst += 12) {
+        __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i));
+        const __m128i hiNibbles = _mm_and_si128(_mm_srli_epi32(in, 4), mask2F);
+        const __m128i lo = _mm_shuffle_epi8(lutLo, _mm_and_si128(in, mask2F));
+        const __m128i hi = _mm_shuffle_epi8(lutHi, hiNibbles);
+        if (!_mm_testz_si128(lo, hi)) {
+            break;
+        }
+        const __m128i roll = _mm_shuffle_epi8(lutRoll, _mm_add_epi8(_mm_cmpeq_epi8(in, mask2F), hiNibbles));
+        in = _mm_add_epi8(in, roll);
+        in = _mm_maddubs_epi16(in, _mm_set1_epi32(0x01400140));
+        in = _mm_madd_epi16(in, _mm_set1_epi32(0x00011000));
+        in = _mm_shuffle_epi8(in, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), in);
+    }
+    return i;
+}
+
+__attribute__((target("avx2"))) inline std::size_t decodeBlocksAvx2(std::uint8_t* dst, const char* text,
+                                                                   std::size_t size) {
+    const __m256i lutLo = _mm256_broadcastsi128_si256(_mm_setr_epi8(SAURON_BASE64_DECODE_LUT_LO));
+    const __m256i lutHi = _mm256_broadcastsi128_si256(_mm_setr_epi8(SAURON_BASE64_DECODE_LUT_HI));
+    const __m256i lutRoll = _mm256_broadcastsi128_si256(_mm_setr_epi8(SAURON_BASE64_DECODE_LUT_ROLL));
+    const __m256i mask2F = _mm256_set1_epi8(0x2F);
+    const __m256i pack = _mm256_broadcastsi128_si256(
+        _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+    std::size_t i = 0;
+    // Each step stores 32 bytes and keeps 24; stop while the output still has room
+    for (; size - i >= 44; i += 32, dst += 24) {
+        __m256i in = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + i));
+        const __m256i hiNibbles = _mm256_and_si256(_mm256_srli_epi32(in, 4), mask2F);
+        const __m256i lo = _mm256_shuffle_epi8(lutLo, _mm256_and_si256(in, mask2F));
+        const __m256i hi = _mm256_shuffle_epi8(lutHi, hiNibbles);
+        if (!_mm256_testz_si256(lo, hi)) {
+            break;
+        }
+        const __m256i roll = _mm256_shuffle_epi8(lutRoll, _mm256_add_epi8(_mm256_cmpeq_epi8(in, mask2F), hiNibbles));
+        in = _mm256_add_epi8(in, roll);
+        in = _mm256_maddubs_epi16(in, _mm256_set1_epi32(0x01400140));
+        in = _mm256_madd_epi16(in, _mm256_set1_epi32(0x00011000));
+        in = _mm256_shuffle_epi8(in, pack);
+        in = _mm256_permutevar8x32_epi32(in, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 7, 7));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst), in);
+    }
+    return i;
+}
+
+#undef SAURON_BASE64_DECODE_LUT_LO
+#undef SAURON_BASE64_DECODE_LUT_HI
+#undef SAURON_BASE64_DECODE_LUT_ROLL
+
+#endif // SAURON_BASE64_X86
+
+#if SAURON_BASE64_NEON
+
+inline std::size_t encodeBlocksNeon(char* dst, const std::uint8_t* data, std::size_t size, Alphabet alphabet) {
+    const std::uint8_t* table = reinterpret_cast<const std::uint8_t*>(chars(alphabet));
+    uint8x16x4_t lookup;
+    lookup.val[0] = vld1q_u8(table);
+    lookup.val[1] = vld1q_u8(table + 16);
+    lookup.val[2] = vld1q_u8(table + 32);
+    lookup.val[3] = vld1q_u8(table + 48);
+    const uint8x16_t mask = vdupq_n_u8(0x3F);
+    std::size_t i = 0;
+    for (; size - i >= 48; i += 48, dst += 64) {
+        const uint8x16x3_t in = vld3q_u8(data + i);
+        uint8x16x4_t out;
+        out.val[0] = vqtbl4q_u8(lookup, vshrq_n_u8(in.val[0], 2));
+        out.val[1] = vqtbl4q_u8(lookup, vandq_u8(vorrq_u8(vshlq_n_u8(in.val[0], 4), vshrq_n_u8(in.val[1], 4)), mask));
+        out.val[2] = vqtbl4q_u8(lookup, vandq_u8(vorrq_u8(vshlq_n_u8(in.val[1], 2), vshrq_n_u8(in.val[2], 6)), mask));
+        out.val[3] = vqtbl4q_u8(lookup, vandq_u8(in.val[2], mask));
+        vst4q_u8(reinterpret_cast<std::uint8_t*>(dst), out);
+    }
+    return i;
+}
+
+// Unlike the x86 kernels this one looks every character up in the full
+// table, so it takes both alphabets.
+inline std::size_t decodeBlocksNeon(std::uint8_t* dst, const char* text, std::size_t size) {
+    const std::uint8_t* values = reinterpret_cast<const std::uint8_t*>(decodeTable().values);
+    uint8x16x4_t low, high;
+    for (int k = 0; k < 4; ++k) {
+        low.val[k] = vld1q_u8(values + 16 * k);
+        high.val[k] = vld1q_u8(values + 64 + 16 * k);
+    }
+    const uint8x16_t offset = vdupq_n_u8(64);
+    const uint8x16_t ascii = vdupq_n_u8(0x80);
+    std::size_t i = 0;
+    for (; size - i >= 64; i += 64, dst += 48) {
+        const uint8x16x4_t in = vld4q_u8(reinterpret_cast<const std::uint8_t*>(text + i));
+        uint8x16x4_t v;
+        uint8x16_t invalid = vdupq_n_u8(0);
+        for (int k = 0; k < 4; ++k) {
+            // Characters 0-63 from the low table, 64-127 from the high one;
+            // invalid characters and non-ASCII bytes come out above 63
+            v.val[k] = vqtbx4q_u8(vqtbl4q_u8(low, in.val[k]), high, vsubq_u8(in.val[k], offset));
+            v.val[k] = vorrq_u8(v.val[k], vandq_u8(in.val[k], ascii));
+            invalid = vorrq_u8(invalid, v.val[k]);
+        }
+        if (vmaxvq_u8(invalid) > 63) {
+            break;
+        }
+        uint8x16x3_t out;
+        out.val[0] = vorrq_u8(vshlq_n_u8(v.val[0], 2), vshrq_n_u8(v.val[1], 4));
+        out.val[1] = vorrq_u8(vshlq_n_u8(v.val[1], 4), vshrq_n_u8(v.val[2], 2));
+        out.val[2] = vorrq_u8(vshlq_n_u8(v.val[2], 6), v.val[3]);
+        vst3q_u8(dst, out);
+    }
+    return i;
+}
+
+#endif // SAURON_BASE64_NEON
+
+} // namespace detail
+
+/**
+ * @brief Whether this CPU can run a kernel
+ */
+inline bool isSupported(Kernel kernel) {
+    return (detail::supportedKernels() >> static_cast<int>(kernel)) & 1u;
+}
+
+/**
+ * @brief Fastest kernel this CPU supports, detected once
+ */
+inline Kernel bestKernel() {
+    static const Kernel kernel = isSupported(Kernel::Avx2)    ? Kernel::Avx2
+                                 : isSupported(Kernel::Sse41) ? Kernel::Sse41
+                                 : isSupported(Kernel::Neon)  ? Kernel::Neon
+                                                              : Kernel::Scalar;
+    return kernel;
+}
+
+/**
+ * @brief Name of a kernel, e.g. "avx2"
+ */
+inline const char* kernelName(Kernel kernel) {
+    switch (kernel) {
+        case Kernel::Sse41:
+            return "sse4.1";
+        case Kernel::Avx2:
+            return "avx2";
+        case Kernel::Neon:
+            return "neon";
+        default:
+            return "scalar";
+    }
+}
+
+/**
+ * @brief Size of the encoded form of n bytes
+ */
+inline std::size_t encodedSize(std::size_t n, Alphabet alphabet = Alphabet::Standard) {
+    return alphabet == Alphabet::Standard ? (n + 2) / 3 * 4 : (n * 4 + 2) / 3;
+}
+
+/**
+ * @brief Encode bytes, appending to out
+ *
+ * out grows once, by exactly encodedSize(size, alphabet).
+ *
+ * @param data The bytes to encode
+ * @param size Number of bytes
+ * @param out Buffer receiving the encoded text
+ * @param alphabet Alphabet variant
+ * @param kernel Implementation to use; the default is bestKernel()
+ * @throws std::invalid_argument if the CPU does not support kernel
+ */
+inline void encode(const std::uint8_t* data, std::size_t size, std::string& out,
+                   Alphabet alphabet = Alphabet::Standard, Kernel kernel = bestKernel()) {
+    if (!isSupported(kernel)) {
+        throw std::invalid_argument(std::string("Base64 kernel not supported: ") + kernelName(kernel));
+    }
+    std::size_t start = out.size();
+    out.resize(start + encodedSize(size, alphabet));
+    char* dst = &out[start];
+    std::size_t done = 0;
+    switch (kernel) {
+#if SAURON_BASE64_X86
+        case Kernel::Avx2:
+            done = detail::encodeBlocksAvx2(dst, data, size, alphabet);
+            break;
+        case Kernel::Sse41:
+            done = detail::encodeBlocksSse41(dst, data, size, alphabet);
+            break;
+#endif
+#if SAURON_BASE64_NEON
+        case Kernel::Neon:
+            done = detail::encodeBlocksNeon(dst, data, size, alphabet);
+            break;
+#endif
+        default:
+            break;
+    }
+    detail::encodeScalar(dst + done / 3 * 4, data + done, size - done, alphabet);
+}
+
+/**
+ * @brief Encode bytes
+ *
+ * @param data The bytes to encode
+ * @param alphabet Alphabet variant
+ * @return std::string The encoded text
+ */
+inline std::string encode(std::string_view data, Alphabet alphabet = Alphabet::Standard) {
+    std::string out;
+    encode(reinterpret_cast<const std::uint8_t*>(data.data()), data.size(), out, alphabet);
+    return out;
+}
+
+/**
+ * @brief Decode text, appending the bytes to out
+ *
+ * Accepts both alphabets; padding is optional. out grows once, by exactly
+ * the decoded size, and is left as it was if the text is invalid.
+ *
+ * @param text The encoded text
+ * @param out Buffer receiving the decoded bytes
+ * @param kernel Implementation to use; the default is bestKernel()
+ * @throws std::invalid_argument if the text is not valid base64, or the CPU
+ *         does not support kernel
+ */
+inline void decode(std::string_view text, std::string& out, Kernel kernel = bestKernel()) {
+    if (!isSupported(kernel)) {
+        throw std::invalid_argument(std::string("Base64 kernel not supported: ") + kernelName(kernel));
+    }
+    while (!text.empty() && text.back() == '=') {
+        text.remove_suffix(1);
+    }
+    if (text.size() % 4 == 1) {
+        throw std::invalid_argument("Invalid base64 length");
+    }
+    std::size_t start = out.size();
+    out.resize(start + text.size() * 3 / 4);
+    std::uint8_t* dst = reinterpret_cast<std::uint8_t*>(&out[start]);
+    std::size_t done = 0;
+    switch (kernel) {
+#if SAURON_BASE64_X86
+        case Kernel::Avx2:
+            done = detail::decodeBlocksAvx2(dst, text.data(), text.size());
+            break;
+        case Kernel::Sse41:
+            done = detail::decodeBlocksSse41(dst, text.data(), text.size());
+            break;
+#endif
+#if SAURON_BASE64_NEON
+        case Kernel::Neon:
+            done = detail::decodeBlocksNeon(dst, text.data(), text.size());
+            break;
+#endif
+        default:
+            break;
+    }
+    if (!detail::decodeScalar(dst + done / 4 * 3, text.data() + done, text.size() - done)) {
+        out.resize(start);
+        throw std::invalid_argument("Invalid base64 character");
+    }
+}
+
+/**
+ * @brief Decode text
+ *
+ * @param text The encoded text
+ * @return std::string The decoded bytes
+ * @throws std::invalid_argument if the text is not valid base64
+ */
+inline std::string decode(std::string_view text) {
+    std::string out;
+    decode(text, out);
+    return out;
+}
+
+} // namespace base64
+
+} // namespace util
+} // namespace sauron
@@ -0,0 +1,180 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <string_view>
+
+namespace sauron {
+namespace util {
+
+/**
+ * @brief Fast non-cryptographic hashing
+ */
+namespace hash {
+
+namespace detail {
+
+constexpr std::uint64_t kPrime1 = 11400714785074694791ULL;
+constexpr std::uint64_t kPrime2 = 14029467366897019727ULL;
+constexpr std::uint64_t kPrime3 = 1609587929392839161ULL;
+constexpr std::uint64_t kPrime4 = 9650029242287828579ULL;
+constexpr std::uint64_t kPrime5 = 2870177450012600261ULL;
+
+inline std::uint64_t rotl(std::uint64_t value, int bits) {
+    return (value << bits) | (value >> (64 - bits));
+}
+
+inline std::uint64_t read64(const unsigned char* p) {
+    std::uint64_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+inline std::uint32_t read32(const unsigned char* p) {
+    std::uint32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+inline std::uint64_t round(std::uint64_t acc, std::uint64_t input) {
+    acc += input * kPrime2;
+    acc = rotl(acc, 31);
+    return acc * kPrime1;
+}
+
+inline std::uint64_t mergeRound(std::uint64_t acc, std::uint64_t value) {
+    acc ^= round(0, value);
+    return acc * kPrime1 + kPrime4;
+}
+
+} // namespace detail
+
+/**
+ * @brief XXH64 of a byte string
+ *
+ * Matches the reference XXH64 on little-endian hosts.
+ *
+ * @param data The bytes to hash
+ * @param seed Seed; chaining the previous hash as the seed hashes a sequence of fields
+ * @return std::uint64_t The hash
+ */
+inline std::uint64_t xxh64(std::string_view data, std::uint64_t seed = 0) {
+    using namespace detail;
+    const std::size_t size = data.size();
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(data.data());
+    const unsigned char* end = p + size;
+    std::uint64_t h;
+
+    if (size >= 32) {
+        std::uint64_t v1 = seed + kPrime1 + kPrime2;
+        std::uint64_t v2 = seed + kPrime2;
+        std::uint64_t v3 = seed;
+        std::uint64_t v4 = seed - kPrime1;
+        const unsigned char* limit = end - 32;
+        do {
+            v1 = round(v1, read64(p));
+            v2 = round(v2, read64(p + 8));
+            v3 = round(v3, read64(p + 16));
+            v4 = round(v4, read64(p + 24));
+            p += 32;
+        } while (p <= limit);
+        h = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+        h = mergeRound(h, v1);
+        h = mergeRound(h, v2);
+        h = mergeRound(h, v3);
+        h = mergeRound(h, v4);
+    } else {
+        h = seed + kPrime5;
+    }
+    h += static_cast<std::uint64_t>(size);
+
+    for (; p + 8 <= end; p += 8) {
+        h ^= round(0, read64(p));
+        h = rotl(h, 27) * kPrime1 + kPrime4;
+    }
+    if (p + 4 <= end) {
+        h ^= static_cast<std::uint64_t>(read32(p)) * kPrime1;
+        h = rotl(h, 23) * kPrime2 + kPrime3;
+        p += 4;
+    }
+    for (; p < end; ++p) {
+        h ^= (*p) * kPrime5;
+        h = rotl(h, 11) * kPrime1;
+    }
+
+    h ^= h >> 33;
+    h *= kPrime2;
+    h ^= h >> 29;
+    h *= kPrime3;
+    h ^= h >> 32;
+    return h;
+}
+
+/**
+ * @brief 128-bit hash built from two independently seeded XXH64 chains
+ *
+ * Accidental collisions are negligible for any realistic number of keys,
+ * but XXH64 is not collision-resistant: with known seeds, colliding inputs
+ * can be constructed. Hasher128 seeds each process randomly for that reason.
+ */
+struct Hash128 {
+    std::uint64_t high = 0;
+    std::uint64_t low = 0;
+
+    bool operator==(const Hash128& other) const { return high == other.high && low == other.low; }
+    bool operator!=(const Hash128& other) const { return !(*this == other); }
+};
+
+/**
+ * @brief Incrementally hashes a sequence of fields into a Hash128
+ *
+ * Each field is length-delimited by XXH64, so ("ab", "c") and ("a", "bc")
+ * hash differently. Both chains start from a random per-process seed, so
+ * values must not be persisted or compared across processes.
+ */
+class Hasher128 {
+public:
+    /**
+     * @brief Hash one field
+     */
+    Hasher128& add(std::string_view field) {
+        value_.high = xxh64(field, value_.high);
+        value_.low = xxh64(field, value_.low);
+        return *this;
+    }
+
+    /**
+     * @brief Hash one integer field
+     */
+    Hasher128& add(std::uint64_t field) {
+        return add(std::string_view(reinterpret_cast<const char*>(&field), sizeof(field)));
+    }
+
+    /**
+     * @brief Get the hash of the fields added so far
+     */
+    Hash128 value() const { return value_; }
+
+private:
+    /// Drawn once per process, so hashes are stable within it and unpredictable outside.
+    static Hash128 processSeed() {
+        static const Hash128 seed = [] {
+            std::random_device random;
+            auto draw = [&random] { return static_cast<std::uint64_t>(random()) << 32 | random(); };
+            Hash128 value;
+            value.high = draw();
+            value.low = draw();
+            return value;
+        }();
+        return seed;
+    }
+
+    Hash128 value_ = processSeed();
+};
+
+} // namespace hash
+
+} // namespace util
+} // namespace sauron
@@ -0,0 +1,177 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace sauron {
+namespace util {
+
+/**
+ * @brief Bucket layout shared by HdrHistogram and HistogramSnapshot
+ *
+ * Values below 128 get one bucket each; every power-of-two range above is
+ * split into 64 equal buckets, so a recorded value is off by less than 1/64
+ * (about 1.6%) of itself. Values up to 2^40 - 1 are tracked; larger ones are
+ * clamped.
+ */
+struct HdrLayout {
+    static constexpr int kSubBucketBits = 6;
+    static constexpr std::uint64_t kLinearLimit = std::uint64_t(1) << (kSubBucketBits + 1);
+    static constexpr int kMaxBits = 40;
+    static constexpr std::uint64_t kMaxValue = (std::uint64_t(1) << kMaxBits) - 1;
+    static constexpr std::size_t kBucketCount =
+        kLinearLimit + std::size_t(kMaxBits - kSubBucketBits - 1) * (std::size_t(1) << kSubBucketBits);
+
+    /**
+     * @brief Index of the bucket a value falls in
+     */
+    static std::size_t bucketOf(std::uint64_t value) {
+        value = std::min(value, kMaxValue);
+        if (value < kLinearLimit) {
+            return static_cast<std::size_t>(value);
+        }
+        int magnitude = 63 - __builtin_clzll(value); // >= kSubBucketBits + 1
+        int shift = magnitude - kSubBucketBits;
+        std::size_t octave = static_cast<std::size_t>(magnitude - kSubBucketBits - 1);
+        std::size_t sub = static_cast<std::size_t>(value >> shift) - (std::size_t(1) << kSubBucketBits);
+        return kLinearLimit + (octave << kSubBucketBits) + sub;
+    }
+
+    /**
+     * @brief Largest value that falls in a bucket
+     */
+    static std::uint64_t highestIn(std::size_t bucket) {
+        if (bucket < kLinearLimit) {
+            return bucket;
+        }
+        std::size_t offset = bucket - kLinearLimit;
+        int shift = static_cast<int>(offset >> kSubBucketBits) + 1;
+        std::uint64_t sub = (offset & ((std::size_t(1) << kSubBucketBits) - 1)) + (std::uint64_t(1) << kSubBucketBits);
+        return ((sub + 1) << shift) - 1;
+    }
+};
+
+/**
+ * @brief Point-in-time copy of one or more histograms
+ */
+class HistogramSnapshot {
+public:
+    HistogramSnapshot() : counts_(HdrLayout::kBucketCount, 0) {}
+
+    /**
+     * @brief Number of recorded values
+     */
+    std::uint64_t count() const { return count_; }
+
+    /**
+     * @brief Sum of the recorded values
+     */
+    std::uint64_t sum() const { return sum_; }
+
+    /**
+     * @brief Mean of the recorded values, or 0 if there are none
+     */
+    double mean() const { return count_ == 0 ? 0.0 : static_cast<double>(sum_) / static_cast<double>(count_); }
+
+    /**
+     * @brief Largest recorded value (within bucket precision), or 0 if there are none
+     */
+    std::uint64_t max() const { return valueAtQuantile(1.0); }
+
+    /**
+     * @brief Value below which a fraction of the recorded values fall
+     *
+     * @param quantile Fraction in [0, 1], e.g. 0.99
+     * @return std::uint64_t The highest value of the bucket holding that rank, or 0 if empty
+     */
+    std::uint64_t valueAtQuantile(double quantile) const {
+        if (count_ == 0) {
+            return 0;
+        }
+        quantile = std::min(1.0, std::max(0.0, quantile));
+        std::uint64_t rank = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(quantile * static_cast<double>(count_) + 0.5));
+        std::uint64_t seen = 0;
+        for (std::size_t bucket = 0; bucket < counts_.size(); ++bucket) {
+            seen += counts_[bucket];
+            if (seen >= rank) {
+                return HdrLayout::highestIn(bucket);
+            }
+        }
+        return HdrLayout::highestIn(counts_.size() - 1);
+    }
+
+    /**
+     * @brief Number of values per bucket, indexed as in HdrLayout
+     */
+    const std::vector<std::uint64_t>& counts() const { return counts_; }
+
+    /**
+     * @brief Add another snapshot's values to this one
+     */
+    void merge(const HistogramSnapshot& other) {
+        for (std::size_t bucket = 0; bucket < counts_.size(); ++bucket) {
+            counts_[bucket] += other.counts_[bucket];
+        }
+        count_ += other.count_;
+        sum_ += other.sum_;
+    }
+
+private:
+    friend class HdrHistogram;
+
+    std::vector<std::uint64_t> counts_;
+    std::uint64_t count_ = 0;
+    std::uint64_t sum_ = 0;
+};
+
+/**
+ * @brief High dynamic range histogram with a single recording thread
+ *
+ * Recording is wait-free and does no read-modify-write: only one thread may
+ * record into a histogram, while any thread may read it concurrently (e.g.
+ * through snapshotInto()). Use one histogram per recording thread and merge
+ * the snapshots.
+ */
+class HdrHistogram {
+public:
+    HdrHistogram() = default;
+    HdrHistogram(const HdrHistogram&) = delete;
+    HdrHistogram& operator=(const HdrHistogram&) = delete;
+
+    /**
+     * @brief Record a value; only call from the owning thread
+     */
+    void record(std::uint64_t value) {
+        bump(counts_[HdrLayout::bucketOf(value)], 1);
+        bump(sum_, value);
+    }
+
+    /**
+     * @brief Add the current counts to a snapshot
+     */
+    void snapshotInto(HistogramSnapshot& snapshot) const {
+        std::uint64_t total = 0;
+        for (std::size_t bucket = 0; bucket < counts_.size(); ++bucket) {
+            std::uint64_t n = counts_[bucket].load(std::memory_order_relaxed);
+            snapshot.counts_[bucket] += n;
+            total += n;
+        }
+        snapshot.count_ += total;
+        snapshot.sum_ += sum_.load(std::memory_order_relaxed);
+    }
+
+private:
+    static void bump(std::atomic<std::uint64_t>& counter, std::uint64_t by) {
+        counter.store(counter.load(std::memory_order_relaxed) + by, std::memory_order_relaxed);
+    }
+
+    std::array<std::atomic<std::uint64_t>, HdrLayout::kBucketCount> counts_{};
+    std::atomic<std::uint64_t> sum_{0};
+};
+
+} // namespace util
+} // namespace sauron
@@ -0,0 +1,172 @@
+#pragma once
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include <fstream>
+#endif
+
+namespace sauron {
+namespace util {
+
+/**
+ * @brief Read-only memory mapping of a whole file
+ *
+ * Lets a file be read in place, without copying it into a buffer first. The
+ * mapping is private, so later writes to the file by other processes may or
+ * may not show through; map files that are not being modified.
+ *
+ * Where there is no mmap() (anything but Unix and macOS) the file is read
+ * into memory instead, and descriptors cannot be mapped.
+ */
+class MappedFile {
+public:
+    /**
+     * @brief Map a file
+     *
+     * @param path Path of the file
+     * @throws std::runtime_error if the file cannot be opened or mapped
+     */
+    explicit MappedFile(const std::string& path) {
+#if defined(__unix__) || defined(__APPLE__)
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            throw std::runtime_error("Failed to open " + path + ": " + std::strerror(errno));
+        }
+        try {
+            map(fd, path);
+        } catch (...) {
+            ::close(fd);
+            throw;
+        }
+        ::close(fd);
+#else
+        read(path);
+#endif
+    }
+
+#if defined(__unix__) || defined(__APPLE__)
+    /**
+     * @brief Map the file behind a descriptor
+     *
+     * The whole file is mapped whatever the descriptor's offset. The
+     * descriptor stays owned by the caller and may be closed right away.
+     *
+     * @param fd Descriptor of a regular file (or memfd) open for reading
+     * @throws std::runtime_error if the descriptor cannot be mapped
+     */
+    explicit MappedFile(int fd) {
+        map(fd, "fd " + std::to_string(fd));
+    }
+#endif
+
+    ~MappedFile() {
+        unmap();
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    MappedFile(MappedFile&& other) noexcept
+        : data_(std::exchange(other.data_, nullptr)), size_(std::exchange(other.size_, 0)) {}
+
+    MappedFile& operator=(MappedFile&& other) noexcept {
+        if (this != &other) {
+            unmap();
+            data_ = std::exchange(other.data_, nullptr);
+            size_ = std::exchange(other.size_, 0);
+        }
+        return *this;
+    }
+
+    /**
+     * @brief First byte of the file; nullptr if it is empty
+     */
+    const std::uint8_t* data() const { return data_; }
+
+    /**
+     * @brief Size of the file in bytes
+     */
+    std::size_t size() const { return size_; }
+
+    /**
+     * @brief The file's bytes
+     */
+    std::string_view view() const {
+        return std::string_view(reinterpret_cast<const char*>(data_), size_);
+    }
+
+private:
+#if defined(__unix__) || defined(__APPLE__)
+    void map(int fd, const std::string& name) {
+        struct stat info;
+        if (::fstat(fd, &info) != 0) {
+            throw std::runtime_error("Failed to stat " + name + ": " + std::strerror(errno));
+        }
+        if (!S_ISREG(info.st_mode)) {
+            throw std::runtime_error("Not a regular file: " + name);
+        }
+        size_ = static_cast<std::size_t>(info.st_size);
+        if (size_ > 0) {
+            void* data = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data == MAP_FAILED) {
+                size_ = 0;
+                throw std::runtime_error("Failed to map " + name + ": " + std::strerror(errno));
+            }
+            ::madvise(data, size_, MADV_SEQUENTIAL);
+            data_ = static_cast<const std::uint8_t*>(data);
+        }
+    }
+
+    void unmap() {
+        if (data_ != nullptr) {
+            ::munmap(const_cast<std::uint8_t*>(data_), size_);
+            data_ = nullptr;
+        }
+    }
+#else
+    void read(const std::string& path) {
+        std::ifstream in(path, std::ios::binary | std::ios::ate);
+        if (!in) {
+            throw std::runtime_error("Failed to open " + path);
+        }
+        std::streamoff end = in.tellg();
+        if (end < 0) {
+            throw std::runtime_error("Failed to read " + path);
+        }
+        size_ = static_cast<std::size_t>(end);
+        if (size_ > 0) {
+            std::uint8_t* data = new std::uint8_t[size_];
+            in.seekg(0);
+            if (!in.read(reinterpret_cast<char*>(data), static_cast<std::streamsize>(size_))) {
+                delete[] data;
+                size_ = 0;
+                throw std::runtime_error("Failed to read " + path);
+            }
+            data_ = data;
+        }
+    }
+
+    void unmap() {
+        delete[] data_;
+        data_ = nullptr;
+    }
+#endif
+
+    const std::uint8_t* data_ = nullptr;
+    std::size_t size_ = 0;
+};
+
+} // namespace util
+} // namespace sauron
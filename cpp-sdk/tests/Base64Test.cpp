@@ -0,0 +1,129 @@
+#include <gtest/gtest.h>
+#include <sauron/util/Base64.hpp>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace sauron::util::base64;
+
+namespace {
+
+const Kernel kKernels[] = {Kernel::Sse41, Kernel::Avx2, Kernel::Neon};
+const Alphabet kAlphabets[] = {Alphabet::Standard, Alphabet::Url};
+
+std::string randomBytes(std::mt19937& rng, std::size_t size) {
+    std::string bytes(size, '\0');
+    for (char& c : bytes) {
+        c = static_cast<char>(rng() & 0xFF);
+    }
+    return bytes;
+}
+
+std::string encodeWith(const std::string& bytes, Alphabet alphabet, Kernel kernel) {
+    std::string out;
+    encode(reinterpret_cast<const std::uint8_t*>(bytes.data()), bytes.size(), out, alphabet, kernel);
+    return out;
+}
+
+std::string decodeWith(const std::string& text, Kernel kernel) {
+    std::string out;
+    decode(text, out, kernel);
+    return out;
+}
+
+// Every SIMD kernel must agree with the scalar code, including on the tail
+// it hands to it, so each input is checked with every kernel this CPU runs.
+void expectKernelsAgree(const std::string& bytes) {
+    for (Alphabet alphabet : kAlphabets) {
+        std::string expected = encodeWith(bytes, alphabet, Kernel::Scalar);
+        ASSERT_EQ(expected.size(), encodedSize(bytes.size(), alphabet));
+        ASSERT_EQ(decodeWith(expected, Kernel::Scalar), bytes);
+        for (Kernel kernel : kKernels) {
+            if (!isSupported(kernel)) {
+                continue;
+            }
+            SCOPED_TRACE(kernelName(kernel));
+            ASSERT_EQ(encodeWith(bytes, alphabet, kernel), expected) << "size " << bytes.size();
+            ASSERT_EQ(decodeWith(expected, kernel), bytes) << "size " << bytes.size();
+        }
+    }
+}
+
+} // namespace
+
+TEST(Base64, KnownVectors) {
+    EXPECT_EQ(encode(""), "");
+    EXPECT_EQ(encode("f"), "Zg==");
+    EXPECT_EQ(encode("fo"), "Zm8=");
+    EXPECT_EQ(encode("foo"), "Zm9v");
+    EXPECT_EQ(encode("foobar"), "Zm9vYmFy");
+    EXPECT_EQ(encode("\xfb\xff", Alphabet::Standard), "+/8=");
+    EXPECT_EQ(encode("\xfb\xff", Alphabet::Url), "-_8");
+    EXPECT_EQ(decode("Zm9vYmFy"), "foobar");
+    EXPECT_EQ(decode("Zm8"), "fo");
+    EXPECT_EQ(decode("-_8"), "\xfb\xff");
+}
+
+TEST(Base64, KernelsMatchScalarForEveryLengthUpTo256) {
+    std::mt19937 rng(1);
+    for (std::size_t size = 0; size <= 256; ++size) {
+        expectKernelsAgree(randomBytes(rng, size));
+    }
+}
+
+TEST(Base64, KernelsMatchScalarOnRandomInputs) {
+    std::mt19937 rng(2);
+    for (int round = 0; round < 200; ++round) {
+        expectKernelsAgree(randomBytes(rng, rng() % 4096));
+    }
+}
+
+TEST(Base64, KernelsMatchScalarOnEveryByteValue) {
+    std::string bytes;
+    for (int repeat = 0; repeat < 3; ++repeat) {
+        for (int value = 0; value < 256; ++value) {
+            bytes.push_back(static_cast<char>(value));
+        }
+    }
+    expectKernelsAgree(bytes);
+}
+
+TEST(Base64, KernelsRejectInvalidCharactersAnywhere) {
+    std::mt19937 rng(3);
+    std::string valid = encodeWith(randomBytes(rng, 192), Alphabet::Standard, Kernel::Scalar);
+    std::vector<Kernel> kernels = {Kernel::Scalar};
+    for (Kernel kernel : kKernels) {
+        if (isSupported(kernel)) {
+            kernels.push_back(kernel);
+        }
+    }
+    for (Kernel kernel : kernels) {
+        SCOPED_TRACE(kernelName(kernel));
+        for (std::size_t at = 0; at < valid.size(); ++at) {
+            for (char bad : {'*', ' ', '\0', '\x80', '='}) {
+                std::string text = valid;
+                text[at] = bad;
+                if (bad == '=' && at + 1 == text.size()) {
+                    continue; // trailing padding is accepted
+                }
+                std::string out = "kept";
+                EXPECT_THROW(decode(text, out, kernel), std::invalid_argument) << "position " << at;
+                EXPECT_EQ(out, "kept");
+            }
+        }
+    }
+}
+
+TEST(Base64, RejectsImpossibleLength) {
+    EXPECT_THROW(decode("Zm9vY"), std::invalid_argument);
+}
+
+TEST(Base64, UnsupportedKernelThrows) {
+    for (Kernel kernel : kKernels) {
+        if (!isSupported(kernel)) {
+            std::string out;
+            EXPECT_THROW(decode("Zm9v", out, kernel), std::invalid_argument);
+        }
+    }
+}
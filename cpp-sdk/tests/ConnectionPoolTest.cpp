@@ -0,0 +1,165 @@
+#include <gtest/gtest.h>
+#include <sauron/client/ConnectionPool.hpp>
+#include <sauron/client/SauronClient.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <arpa/inet.h>
+#include <dlfcn.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace sauron;
+using namespace sauron::client;
+
+namespace {
+
+std::mutex resolveMutex;
+std::map<std::string, int> resolveCounts; // "host:port" -> getaddrinfo calls
+
+int resolveCount(const Url& url) {
+    std::lock_guard<std::mutex> lock(resolveMutex);
+    return resolveCounts[url.host + ":" + std::to_string(url.port)];
+}
+
+} // namespace
+
+// Counts lookups, then defers to the C library: the pool's calls bind to this
+// definition because it is in the executable.
+extern "C" int getaddrinfo(const char* node, const char* service, const addrinfo* hints, addrinfo** results) {
+    using Real = int (*)(const char*, const char*, const addrinfo*, addrinfo**);
+    static Real real = reinterpret_cast<Real>(::dlsym(RTLD_NEXT, "getaddrinfo"));
+    if (node && service) {
+        std::lock_guard<std::mutex> lock(resolveMutex);
+        ++resolveCounts[std::string(node) + ":" + service];
+    }
+    return real(node, service, hints, results);
+}
+
+namespace {
+
+// A loopback socket that accepts connections into its backlog and never answers.
+class Listener {
+public:
+    Listener() {
+        fd_ = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t length = sizeof(address);
+        if (::bind(fd_, reinterpret_cast<sockaddr*>(&address), length) != 0 || ::listen(fd_, 64) != 0 ||
+            ::getsockname(fd_, reinterpret_cast<sockaddr*>(&address), &length) != 0) {
+            throw std::runtime_error("cannot listen on loopback");
+        }
+        url_ = Url::parse("http://127.0.0.1:" + std::to_string(ntohs(address.sin_port)));
+    }
+
+    ~Listener() { ::close(fd_); }
+
+    const Url& url() const { return url_; }
+
+private:
+    int fd_ = -1;
+    Url url_;
+};
+
+// Answers /health after a pause, tracking how many calls overlap.
+class SlowHealthClient : public HttpClient {
+public:
+    void setBaseUrl(const std::string&) override {}
+    std::string getBaseUrl() const override { return ""; }
+    void setDefaultHeader(const std::string&, const std::string&) override {}
+    void removeDefaultHeader(const std::string&) override {}
+    void setBearerToken(const std::string&) override {}
+    void clearAuthorization() override {}
+
+    HttpResponse get(const std::string& path, const std::vector<std::string>& = {}) override {
+        int now = ++concurrent;
+        int seen = maxConcurrent.load();
+        while (now > seen && !maxConcurrent.compare_exchange_weak(seen, now)) {
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        --concurrent;
+        ++calls;
+        return HttpResponse{path == "/health" ? 200 : 404, "{\"status\":\"ok\"}", {}, {}};
+    }
+
+    HttpResponse post(const std::string&, const nlohmann::json&, const std::vector<std::string>& = {}) override {
+        return HttpResponse{404, "", {}, {}};
+    }
+    HttpResponse post(const std::string&, const std::string&, const std::string&,
+                      const std::vector<std::string>& = {}) override {
+        return HttpResponse{404, "", {}, {}};
+    }
+    int postStream(const std::string&, const nlohmann::json&, const StreamCallback&,
+                   const std::vector<std::string>& = {}) override {
+        return 404;
+    }
+
+    std::atomic<int> concurrent{0};
+    std::atomic<int> maxConcurrent{0};
+    std::atomic<int> calls{0};
+};
+
+} // namespace
+
+TEST(ConnectionPool, WarmupOpensConnectionsUpToTheHostLimit) {
+    Listener listener;
+    ConnectionPoolOptions options;
+    options.maxConnectionsPerHost = 6;
+    auto pool = ConnectionPool::create(options);
+    EXPECT_EQ(pool->warmup(listener.url(), 4), 4u);
+    EXPECT_EQ(pool->idleCount(listener.url()), 4u);
+    EXPECT_EQ(pool->warmup(listener.url(), 4), 0u) << "already warm";
+    EXPECT_EQ(pool->warmup(listener.url(), 100), 2u);
+    EXPECT_EQ(pool->idleCount(listener.url()), 6u);
+    EXPECT_TRUE(pool->acquire(listener.url()).reused());
+}
+
+TEST(ConnectionPool, ResolvesAgainOnceTheDnsTtlExpires) {
+    Listener listener;
+    ConnectionPoolOptions options;
+    options.dnsTtl = std::chrono::milliseconds(100);
+    auto pool = ConnectionPool::create(options);
+    const int before = resolveCount(listener.url());
+
+    ASSERT_EQ(pool->warmup(listener.url(), 1), 1u);
+    EXPECT_EQ(resolveCount(listener.url()), before + 1);
+    pool->clear();
+    ASSERT_EQ(pool->warmup(listener.url(), 2), 2u);
+    EXPECT_EQ(resolveCount(listener.url()), before + 1) << "cached within the TTL";
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(150));
+    pool->clear();
+    ASSERT_EQ(pool->warmup(listener.url(), 1), 1u);
+    EXPECT_EQ(resolveCount(listener.url()), before + 2) << "expired";
+
+    options.dnsTtl = std::chrono::milliseconds(0);
+    auto uncached = ConnectionPool::create(options);
+    for (int i = 0; i < 3; ++i) {
+        ASSERT_EQ(uncached->warmup(listener.url(), 1), 1u);
+        uncached->clear();
+    }
+    EXPECT_EQ(resolveCount(listener.url()), before + 5) << "a zero TTL resolves for every connect";
+}
+
+TEST(SauronClient, WarmupCapsConcurrentHealthPings) {
+    auto http = std::make_unique<SlowHealthClient>();
+    SlowHealthClient& fake = *http;
+    SauronClient client(std::move(http));
+
+    EXPECT_EQ(client.warmup(40, true), 40u);
+    EXPECT_EQ(fake.calls.load(), 40);
+    EXPECT_LE(fake.maxConcurrent.load(), static_cast<int>(SauronClient::kMaxWarmupPings));
+    EXPECT_GT(fake.maxConcurrent.load(), 1) << "the pings run in parallel";
+
+    fake.calls = 0;
+    EXPECT_EQ(client.warmup(3, false), 0u) << "without pingHealth nothing is sent";
+    EXPECT_EQ(fake.calls.load(), 0);
+}
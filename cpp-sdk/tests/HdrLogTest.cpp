@@ -0,0 +1,195 @@
+#include <gtest/gtest.h>
+#include <loadgen/HdrLog.hpp>
+#include <sauron/util/Base64.hpp>
+#include <sauron/util/HdrHistogram.hpp>
+#include <cstring>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <zlib.h>
+
+using namespace sauron;
+
+namespace {
+
+// A minimal reader of the compressed V2 histogram encoding, written from the
+// HdrHistogram specification rather than from the writer.
+struct DecodedHistogram {
+    std::uint32_t cookie = 0;
+    std::uint32_t normalizingIndexOffset = 0;
+    std::uint32_t significantDigits = 0;
+    std::uint64_t lowest = 0;
+    std::uint64_t highest = 0;
+    double ratio = 0;
+    std::map<std::uint64_t, std::uint64_t> counts; ///< Lowest value of each non-empty range -> count
+};
+
+std::uint32_t getInt(const std::uint8_t* at) {
+    return (std::uint32_t(at[0]) << 24) | (std::uint32_t(at[1]) << 16) | (std::uint32_t(at[2]) << 8) | at[3];
+}
+
+std::uint64_t getLong(const std::uint8_t* at) {
+    return (std::uint64_t(getInt(at)) << 32) | getInt(at + 4);
+}
+
+// Lowest value of a counts index in a histogram with 2 significant digits
+// (128 sub-buckets per half) and a lowest discernible value of 1.
+std::uint64_t valueFromIndex(std::size_t index) {
+    int bucket = static_cast<int>(index >> 7) - 1;
+    std::uint64_t sub = (index & 127) + 128;
+    if (bucket < 0) {
+        sub -= 128;
+        bucket = 0;
+    }
+    return sub << bucket;
+}
+
+DecodedHistogram decodeCompressed(const std::string& text) {
+    std::string packed = util::base64::decode(text);
+    const auto* bytes = reinterpret_cast<const std::uint8_t*>(packed.data());
+    EXPECT_GE(packed.size(), 8u);
+    EXPECT_EQ(getInt(bytes), 0x1c849314u);
+    EXPECT_EQ(getInt(bytes + 4), packed.size() - 8);
+
+    std::vector<std::uint8_t> plain(1 << 20);
+    uLongf size = plain.size();
+    EXPECT_EQ(uncompress(plain.data(), &size, bytes + 8, static_cast<uLong>(packed.size() - 8)), Z_OK);
+    plain.resize(size);
+
+    DecodedHistogram out;
+    EXPECT_GE(plain.size(), 40u);
+    out.cookie = getInt(&plain[0]);
+    EXPECT_EQ(getInt(&plain[4]), plain.size() - 40);
+    out.normalizingIndexOffset = getInt(&plain[8]);
+    out.significantDigits = getInt(&plain[12]);
+    out.lowest = getLong(&plain[16]);
+    out.highest = getLong(&plain[24]);
+    std::uint64_t ratioBits = getLong(&plain[32]);
+    std::memcpy(&out.ratio, &ratioBits, sizeof(out.ratio));
+
+    std::size_t index = 0;
+    for (std::size_t pos = 40; pos < plain.size();) {
+        std::uint64_t zigzag = 0;
+        for (int shift = 0; pos < plain.size(); shift += 7) {
+            std::uint8_t byte = plain[pos++];
+            zigzag |= std::uint64_t(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) {
+                break;
+            }
+        }
+        std::int64_t value = static_cast<std::int64_t>(zigzag >> 1) ^ -static_cast<std::int64_t>(zigzag & 1);
+        if (value < 0) {
+            index += static_cast<std::size_t>(-value);
+        } else {
+            if (value > 0) {
+                out.counts[valueFromIndex(index)] += static_cast<std::uint64_t>(value);
+            }
+            ++index;
+        }
+    }
+    return out;
+}
+
+// Each bucket of the SDK's histogram is expected at the range holding its
+// highest value.
+std::map<std::uint64_t, std::uint64_t> expectedCounts(const util::HistogramSnapshot& snapshot) {
+    std::map<std::uint64_t, std::uint64_t> out;
+    for (std::size_t bucket = 0; bucket < snapshot.counts().size(); ++bucket) {
+        if (snapshot.counts()[bucket] == 0) {
+            continue;
+        }
+        std::uint64_t value = util::HdrLayout::highestIn(bucket);
+        int shift = 0;
+        while ((value >> shift) >= 256) {
+            ++shift;
+        }
+        out[(value >> shift) << shift] += snapshot.counts()[bucket];
+    }
+    return out;
+}
+
+} // namespace
+
+TEST(HdrLog, EncodesTheV2Header) {
+    util::HdrHistogram histogram;
+    histogram.record(1000);
+    util::HistogramSnapshot snapshot;
+    histogram.snapshotInto(snapshot);
+    DecodedHistogram decoded = decodeCompressed(loadgen::HdrLogWriter::encodeCompressed(snapshot));
+    EXPECT_EQ(decoded.cookie, 0x1c849313u);
+    EXPECT_EQ(decoded.normalizingIndexOffset, 0u);
+    EXPECT_EQ(decoded.significantDigits, 2u);
+    EXPECT_EQ(decoded.lowest, 1u);
+    EXPECT_EQ(decoded.highest, util::HdrLayout::kMaxValue);
+    EXPECT_EQ(decoded.ratio, 1.0);
+}
+
+TEST(HdrLog, EmptyHistogram) {
+    util::HistogramSnapshot snapshot;
+    DecodedHistogram decoded = decodeCompressed(loadgen::HdrLogWriter::encodeCompressed(snapshot));
+    EXPECT_TRUE(decoded.counts.empty());
+}
+
+TEST(HdrLog, CountsRoundTrip) {
+    std::mt19937_64 rng(1);
+    for (int round = 0; round < 50; ++round) {
+        util::HdrHistogram histogram;
+        std::size_t values = 1 + rng() % 5000;
+        for (std::size_t i = 0; i < values; ++i) {
+            // Spread over the whole range: a random magnitude, then a random value within it.
+            int bits = static_cast<int>(rng() % util::HdrLayout::kMaxBits);
+            histogram.record((rng() & ((std::uint64_t(1) << bits) - 1)) | (std::uint64_t(1) << bits) >> 1);
+        }
+        util::HistogramSnapshot snapshot;
+        histogram.snapshotInto(snapshot);
+        DecodedHistogram decoded = decodeCompressed(loadgen::HdrLogWriter::encodeCompressed(snapshot));
+        ASSERT_EQ(decoded.counts, expectedCounts(snapshot)) << "round " << round;
+        std::uint64_t total = 0;
+        for (const auto& entry : decoded.counts) {
+            total += entry.second;
+        }
+        EXPECT_EQ(total, snapshot.count());
+    }
+}
+
+TEST(HdrLog, SmallValuesKeepTheirOwnRanges) {
+    util::HdrHistogram histogram;
+    for (std::uint64_t value = 0; value < 128; ++value) {
+        histogram.record(value);
+    }
+    util::HistogramSnapshot snapshot;
+    histogram.snapshotInto(snapshot);
+    DecodedHistogram decoded = decodeCompressed(loadgen::HdrLogWriter::encodeCompressed(snapshot));
+    ASSERT_EQ(decoded.counts.size(), 128u);
+    for (std::uint64_t value = 0; value < 128; ++value) {
+        EXPECT_EQ(decoded.counts[value], 1u) << value;
+    }
+}
+
+TEST(HdrLog, WritesIntervalLines) {
+    std::ostringstream out;
+    loadgen::HdrLogWriter writer(out, std::chrono::system_clock::time_point(std::chrono::seconds(1700000000)));
+    writer.writeHeader();
+    util::HdrHistogram histogram;
+    histogram.record(2500);
+    util::HistogramSnapshot snapshot;
+    histogram.snapshotInto(snapshot);
+    writer.writeInterval("query", std::chrono::duration<double>(1.5), std::chrono::duration<double>(1.0), snapshot);
+
+    std::istringstream lines(out.str());
+    std::string line;
+    std::getline(lines, line);
+    EXPECT_EQ(line, "#[Histogram log format version 1.3]");
+    std::getline(lines, line);
+    EXPECT_EQ(line, "#[StartTime: 1700000000.000 (seconds since epoch)]");
+    std::getline(lines, line);
+    EXPECT_EQ(line, "\"StartTimestamp\",\"Interval_Length\",\"Interval_Max\",\"Interval_Compressed_Histogram\"");
+    std::getline(lines, line);
+    std::string prefix = "Tag=query,1.500,1.000,2.527,";
+    ASSERT_EQ(line.compare(0, prefix.size(), prefix), 0) << line;
+    DecodedHistogram decoded = decodeCompressed(line.substr(prefix.size()));
+    ASSERT_EQ(decoded.counts.size(), 1u);
+    EXPECT_EQ(decoded.counts.begin()->second, 1u);
+}
@@ -0,0 +1,275 @@
+#include <gtest/gtest.h>
+#include <sauron/client/Hedger.hpp>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace sauron::client;
+
+namespace {
+
+// Holds every request until the test completes or cancels it.
+class FakeAsyncClient : public AsyncHttpClient {
+public:
+    void setBaseUrl(const std::string&) override {}
+    std::string getBaseUrl() const override { return ""; }
+    void setDefaultHeader(const std::string&, const std::string&) override {}
+    void removeDefaultHeader(const std::string&) override {}
+
+    RequestId send(AsyncHttpRequest, AsyncCompletion onComplete) override {
+        RequestId id;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            id = ++lastId_;
+            pending_[id] = std::move(onComplete);
+        }
+        sent_.notify_all();
+        if (onSend) {
+            onSend(id);
+        }
+        return id;
+    }
+
+    void cancel(RequestId id) override {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            cancelled_.push_back(id);
+        }
+        fail(id, std::make_exception_ptr(RequestCancelled()));
+    }
+
+    void succeed(RequestId id, const std::string& body = "") {
+        HttpResponse response{200, body, {}, {}};
+        finish(id, std::move(response), nullptr);
+    }
+
+    void fail(RequestId id, std::exception_ptr error) { finish(id, HttpResponse{}, error); }
+
+    // Waits until this many requests have been sent in total.
+    bool waitForSent(RequestId count) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        return sent_.wait_for(lock, std::chrono::seconds(5), [&] { return lastId_ >= count; });
+    }
+
+    RequestId sentCount() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return lastId_;
+    }
+
+    std::vector<RequestId> cancelled() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return cancelled_;
+    }
+
+    std::function<void(RequestId)> onSend; ///< Runs inside send(), before it returns
+
+private:
+    void finish(RequestId id, HttpResponse response, std::exception_ptr error) {
+        AsyncCompletion onComplete;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = pending_.find(id);
+            if (it == pending_.end()) {
+                return; // already completed
+            }
+            onComplete = std::move(it->second);
+            pending_.erase(it);
+        }
+        onComplete(std::move(response), error);
+    }
+
+    std::mutex mutex_;
+    std::condition_variable sent_;
+    RequestId lastId_ = 0;
+    std::map<RequestId, AsyncCompletion> pending_;
+    std::vector<RequestId> cancelled_;
+};
+
+// What a hedged request completed with.
+struct Outcome {
+    int calls = 0;
+    HttpResponse response;
+    std::exception_ptr error;
+};
+
+HedgeOptions testOptions() {
+    HedgeOptions options;
+    options.minSamples = 5;
+    options.window = 5;
+    options.minDelay = std::chrono::milliseconds(5);
+    options.budgetRatio = 1;
+    return options;
+}
+
+AsyncCompletion recordInto(Outcome& outcome) {
+    return [&outcome](HttpResponse response, std::exception_ptr error) {
+        ++outcome.calls;
+        outcome.response = std::move(response);
+        outcome.error = error;
+    };
+}
+
+AsyncHttpRequest queryRequest() {
+    AsyncHttpRequest request;
+    request.path = "/ai/query";
+    return request;
+}
+
+// Sends minSamples fast requests, so that later slow ones are hedged.
+void warmUp(Hedger& hedger, const std::shared_ptr<FakeAsyncClient>& client, std::size_t samples) {
+    for (std::size_t i = 0; i < samples; ++i) {
+        Outcome outcome;
+        hedger.send(client, Endpoint::Query, queryRequest(), recordInto(outcome));
+        client->succeed(client->sentCount());
+        ASSERT_EQ(outcome.calls, 1);
+    }
+}
+
+} // namespace
+
+TEST(Hedger, WaitsForMinSamplesBeforeHedging) {
+    auto hedger = Hedger::create(testOptions());
+    auto client = std::make_shared<FakeAsyncClient>();
+    EXPECT_FALSE(hedger->hedgeDelay(Endpoint::Query));
+    warmUp(*hedger, client, 4);
+    EXPECT_FALSE(hedger->hedgeDelay(Endpoint::Query));
+
+    Outcome slow;
+    hedger->send(client, Endpoint::Query, queryRequest(), recordInto(slow));
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_EQ(client->sentCount(), 5u) << "not hedged below minSamples";
+    client->succeed(5);
+    ASSERT_EQ(slow.calls, 1);
+
+    std::optional<std::chrono::milliseconds> delay = hedger->hedgeDelay(Endpoint::Query);
+    ASSERT_TRUE(delay);
+    EXPECT_GE(*delay, std::chrono::milliseconds(5)) << "never below minDelay";
+    EXPECT_FALSE(hedger->hedgeDelay(Endpoint::Health));
+}
+
+TEST(Hedger, CancelsTheLoser) {
+    auto hedger = Hedger::create(testOptions());
+    auto client = std::make_shared<FakeAsyncClient>();
+    warmUp(*hedger, client, 5);
+
+    // The hedge wins.
+    Outcome outcome;
+    hedger->send(client, Endpoint::Query, queryRequest(), recordInto(outcome));
+    ASSERT_TRUE(client->waitForSent(7));
+    client->succeed(7, "from the hedge");
+    EXPECT_EQ(outcome.calls, 1);
+    EXPECT_FALSE(outcome.error);
+    EXPECT_EQ(outcome.response.body, "from the hedge");
+    EXPECT_EQ(client->cancelled(), (std::vector<AsyncHttpClient::RequestId>{6}));
+    client->succeed(6);
+    EXPECT_EQ(outcome.calls, 1);
+
+    // The primary wins.
+    Outcome second;
+    hedger->send(client, Endpoint::Query, queryRequest(), recordInto(second));
+    ASSERT_TRUE(client->waitForSent(9));
+    client->succeed(8, "from the primary");
+    EXPECT_EQ(second.calls, 1);
+    EXPECT_EQ(second.response.body, "from the primary");
+    EXPECT_EQ(client->cancelled(), (std::vector<AsyncHttpClient::RequestId>{6, 9}));
+
+    HedgeStats stats = hedger->stats();
+    EXPECT_EQ(stats.requests, 7u);
+    EXPECT_EQ(stats.hedges, 2u);
+    EXPECT_EQ(stats.hedgeWins, 1u);
+}
+
+TEST(Hedger, CancelsAHedgeThatLostBeforeSendReturned) {
+    auto hedger = Hedger::create(testOptions());
+    auto client = std::make_shared<FakeAsyncClient>();
+    warmUp(*hedger, client, 5);
+
+    // The primary answers while the hedge is still being submitted, before
+    // its id is known to the race.
+    client->onSend = [&](AsyncHttpClient::RequestId id) {
+        if (id == 7) {
+            client->succeed(6, "from the primary");
+        }
+    };
+    Outcome outcome;
+    hedger->send(client, Endpoint::Query, queryRequest(), recordInto(outcome));
+    ASSERT_TRUE(client->waitForSent(7));
+    for (int i = 0; i < 500 && client->cancelled().empty(); ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_EQ(outcome.calls, 1);
+    EXPECT_EQ(outcome.response.body, "from the primary");
+    EXPECT_EQ(client->cancelled(), (std::vector<AsyncHttpClient::RequestId>{7}));
+    EXPECT_EQ(hedger->stats().hedgeWins, 0u);
+}
+
+TEST(Hedger, SkipsTheHedgeWhenTheBudgetIsEmpty) {
+    HedgeOptions options = testOptions();
+    options.budgetRatio = 0.1;
+    auto hedger = Hedger::create(options);
+    auto client = std::make_shared<FakeAsyncClient>();
+    warmUp(*hedger, client, 5);
+
+    Outcome outcome;
+    hedger->send(client, Endpoint::Query, queryRequest(), recordInto(outcome));
+    for (int i = 0; i < 5000 && hedger->stats().budgetExhausted == 0; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    HedgeStats stats = hedger->stats();
+    EXPECT_EQ(stats.budgetExhausted, 1u);
+    EXPECT_EQ(stats.hedges, 0u);
+    EXPECT_EQ(client->sentCount(), 6u);
+    client->succeed(6);
+    EXPECT_EQ(outcome.calls, 1);
+}
+
+TEST(Hedger, ErrorWaitsForTheOtherCopy) {
+    auto hedger = Hedger::create(testOptions());
+    auto client = std::make_shared<FakeAsyncClient>();
+    warmUp(*hedger, client, 5);
+
+    Outcome outcome;
+    hedger->send(client, Endpoint::Query, queryRequest(), recordInto(outcome));
+    ASSERT_TRUE(client->waitForSent(7));
+    client->fail(6, std::make_exception_ptr(TransportError("connection reset")));
+    EXPECT_EQ(outcome.calls, 0) << "the hedge may still answer";
+    client->succeed(7, "from the hedge");
+    EXPECT_EQ(outcome.calls, 1);
+    EXPECT_FALSE(outcome.error);
+    EXPECT_EQ(outcome.response.body, "from the hedge");
+
+    // With both copies failing, the last error is reported.
+    Outcome failed;
+    hedger->send(client, Endpoint::Query, queryRequest(), recordInto(failed));
+    ASSERT_TRUE(client->waitForSent(9));
+    client->fail(9, std::make_exception_ptr(TransportError("first")));
+    client->fail(8, std::make_exception_ptr(TransportError("second")));
+    ASSERT_EQ(failed.calls, 1);
+    ASSERT_TRUE(failed.error);
+    try {
+        std::rethrow_exception(failed.error);
+    } catch (const TransportError& error) {
+        EXPECT_STREQ(error.what(), "second");
+    }
+}
+
+TEST(Hedger, SendsOtherEndpointsOnce) {
+    auto hedger = Hedger::create(testOptions());
+    auto client = std::make_shared<FakeAsyncClient>();
+    warmUp(*hedger, client, 5);
+
+    Outcome outcome;
+    hedger->send(client, Endpoint::Health, queryRequest(), recordInto(outcome));
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_EQ(client->sentCount(), 6u);
+    client->fail(6, std::make_exception_ptr(TransportError("refused")));
+    EXPECT_EQ(outcome.calls, 1);
+    EXPECT_TRUE(outcome.error);
+    EXPECT_EQ(hedger->stats().requests, 5u);
+}
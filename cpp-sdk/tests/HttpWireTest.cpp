@@ -0,0 +1,262 @@
+#include <gtest/gtest.h>
+#include <sauron/client/HttpWire.hpp>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace sauron;
+using namespace sauron::client;
+
+namespace {
+
+// One response as the parser saw it.
+struct Parsed {
+    int status = 0;
+    std::string body;
+    bool keepAlive = false;
+    std::vector<std::string> headers;
+};
+
+// Feed a stream of responses in the given chunk sizes (cycled), reusing the
+// parser the way a keep-alive connection does, and return every complete
+// response. The last one may end with the connection (read until close).
+std::vector<Parsed> parseStream(const std::string& stream, const std::vector<std::size_t>& sizes, bool closeAtEnd = false) {
+    std::vector<Parsed> out;
+    HttpResponseParser parser;
+    std::string body;
+    auto sink = [&](const char* data, std::size_t size) {
+        body.append(data, size);
+        return true;
+    };
+    auto collect = [&] {
+        out.push_back(Parsed{parser.statusCode(), body, parser.keepAlive(), parser.headers()});
+        body.clear();
+        parser.reset();
+    };
+    std::size_t pos = 0;
+    for (std::size_t i = 0; pos < stream.size(); ++i) {
+        std::size_t end = std::min(stream.size(), pos + std::max<std::size_t>(1, sizes[i % sizes.size()]));
+        while (pos < end) {
+            pos += parser.feed(stream.data() + pos, end - pos, sink);
+            if (parser.complete()) {
+                collect();
+            }
+        }
+    }
+    if (closeAtEnd) {
+        parser.finish();
+        collect();
+    }
+    return out;
+}
+
+const std::string kChunkedResponse =
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Type: text/plain\r\n"
+    "Transfer-Encoding: chunked\r\n"
+    "\r\n"
+    "5\r\nHello\r\n"
+    "1A; ext=1\r\n, this chunk is 26 bytes!!\r\n"
+    "0\r\n"
+    "X-Trailer: yes\r\n"
+    "\r\n";
+
+const std::string kLengthResponse =
+    "HTTP/1.1 201 Created\r\n"
+    "content-length: 11\r\n"
+    "\r\n"
+    "hello world";
+
+const std::string kNoContentResponse =
+    "HTTP/1.1 204 No Content\r\n"
+    "\r\n";
+
+} // namespace
+
+TEST(HttpResponseParser, ChunkedBody) {
+    std::vector<Parsed> parsed = parseStream(kChunkedResponse, {kChunkedResponse.size()});
+    ASSERT_EQ(parsed.size(), 1u);
+    EXPECT_EQ(parsed[0].status, 200);
+    EXPECT_EQ(parsed[0].body, "Hello, this chunk is 26 bytes!!");
+    EXPECT_TRUE(parsed[0].keepAlive);
+    EXPECT_EQ(parsed[0].headers.size(), 2u);
+}
+
+TEST(HttpResponseParser, HeadAndBodySplitAtEveryByte) {
+    const std::string responses[] = {kChunkedResponse, kLengthResponse, kNoContentResponse};
+    for (const std::string& response : responses) {
+        std::vector<Parsed> whole = parseStream(response, {response.size()});
+        ASSERT_EQ(whole.size(), 1u);
+        for (std::size_t split = 1; split < response.size(); ++split) {
+            std::vector<Parsed> parsed = parseStream(response, {split, response.size()});
+            ASSERT_EQ(parsed.size(), 1u) << "split at " << split;
+            EXPECT_EQ(parsed[0].status, whole[0].status) << "split at " << split;
+            EXPECT_EQ(parsed[0].body, whole[0].body) << "split at " << split;
+            EXPECT_EQ(parsed[0].headers, whole[0].headers) << "split at " << split;
+        }
+        std::vector<Parsed> bytewise = parseStream(response, {1});
+        ASSERT_EQ(bytewise.size(), 1u);
+        EXPECT_EQ(bytewise[0].body, whole[0].body);
+    }
+}
+
+TEST(HttpResponseParser, KeepAliveReuseAcrossPipelinedResponses) {
+    const std::string interim = "HTTP/1.1 100 Continue\r\n\r\n";
+    std::string stream = kChunkedResponse + kLengthResponse + kNoContentResponse + interim + kLengthResponse;
+    std::mt19937 rng(1);
+    for (int round = 0; round < 500; ++round) {
+        std::vector<std::size_t> sizes;
+        for (int i = 0; i < 16; ++i) {
+            sizes.push_back(1 + rng() % 40);
+        }
+        std::vector<Parsed> parsed = parseStream(stream, sizes);
+        ASSERT_EQ(parsed.size(), 4u);
+        EXPECT_EQ(parsed[0].body, "Hello, this chunk is 26 bytes!!");
+        EXPECT_EQ(parsed[1].status, 201);
+        EXPECT_EQ(parsed[1].body, "hello world");
+        EXPECT_EQ(parsed[2].status, 204);
+        EXPECT_EQ(parsed[2].body, "");
+        EXPECT_EQ(parsed[3].status, 201);
+        EXPECT_EQ(parsed[3].headers.size(), 1u);
+        for (const Parsed& response : parsed) {
+            EXPECT_TRUE(response.keepAlive);
+        }
+    }
+}
+
+TEST(HttpResponseParser, StopsConsumingAtTheEndOfAResponse) {
+    std::string stream = kLengthResponse + kChunkedResponse;
+    HttpResponseParser parser;
+    std::string body;
+    std::size_t consumed = parser.feed(stream.data(), stream.size(), [&](const char* data, std::size_t size) {
+        body.append(data, size);
+        return true;
+    });
+    EXPECT_EQ(consumed, kLengthResponse.size());
+    EXPECT_TRUE(parser.complete());
+    EXPECT_EQ(body, "hello world");
+}
+
+TEST(HttpResponseParser, BodyUntilClose) {
+    std::string response = "HTTP/1.1 200 OK\r\nContent-Type: text/plain\r\n\r\nstreamed until the end";
+    std::vector<Parsed> parsed = parseStream(response, {7}, true);
+    ASSERT_EQ(parsed.size(), 1u);
+    EXPECT_EQ(parsed[0].body, "streamed until the end");
+    EXPECT_FALSE(parsed[0].keepAlive);
+}
+
+TEST(HttpResponseParser, ConnectionHeaders) {
+    std::vector<Parsed> parsed = parseStream("HTTP/1.1 200 OK\r\nConnection: close\r\nContent-Length: 0\r\n\r\n", {5});
+    ASSERT_EQ(parsed.size(), 1u);
+    EXPECT_FALSE(parsed[0].keepAlive);
+    parsed = parseStream("HTTP/1.0 200 OK\r\nContent-Length: 2\r\n\r\nok", {5});
+    ASSERT_EQ(parsed.size(), 1u);
+    EXPECT_FALSE(parsed[0].keepAlive);
+    parsed = parseStream("HTTP/1.0 200 OK\r\nConnection: Keep-Alive\r\nContent-Length: 2\r\n\r\nok", {5});
+    ASSERT_EQ(parsed.size(), 1u);
+    EXPECT_TRUE(parsed[0].keepAlive);
+}
+
+TEST(HttpResponseParser, NoBodyForHead) {
+    HttpResponseParser parser;
+    parser.reset(true);
+    std::string response = "HTTP/1.1 200 OK\r\nContent-Length: 1234\r\n\r\n";
+    std::size_t consumed = parser.feed(response.data(), response.size(), [](const char*, std::size_t) { return true; });
+    EXPECT_EQ(consumed, response.size());
+    EXPECT_TRUE(parser.complete());
+}
+
+TEST(HttpResponseParser, SinkCanAbort) {
+    HttpResponseParser parser;
+    parser.feed(kChunkedResponse.data(), kChunkedResponse.size(), [](const char*, std::size_t) { return false; });
+    EXPECT_TRUE(parser.aborted());
+    EXPECT_FALSE(parser.keepAlive());
+}
+
+TEST(HttpResponseParser, RejectsMalformedResponses) {
+    const char* responses[] = {
+        "SMTP 220 hello\r\n",
+        "HTTP/1.1 2x0 OK\r\n",
+        "HTTP/1.1 200 OK\r\nContent-Length: 12a\r\n\r\n",
+        "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\nzz\r\n",
+        "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n2\r\nabX\r\n",
+        // Sizes that overflow size_t must not wrap (to 0, the last chunk, here)
+        "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n10000000000000000\r\n",
+        "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n1ffffffffffffffff\r\n",
+        "HTTP/1.1 200 OK\r\nContent-Length: 18446744073709551616\r\n\r\n",
+        "HTTP/1.1 200 OK\r\nContent-Length: 99999999999999999999\r\n\r\n",
+    };
+    for (const char* response : responses) {
+        HttpResponseParser parser;
+        std::string text(response);
+        EXPECT_THROW(parser.feed(text.data(), text.size(), [](const char*, std::size_t) { return true; }), TransportError)
+            << response;
+    }
+    HttpResponseParser parser;
+    std::string line = "HTTP/1.1 200 OK\r\nX-Long: " + std::string(70 * 1024, 'a');
+    EXPECT_THROW(parser.feed(line.data(), line.size(), [](const char*, std::size_t) { return true; }), TransportError);
+}
+
+TEST(HttpResponseParser, AcceptsTheLargestSizes) {
+    // Leading zeros are not significant digits.
+    std::string response = "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n"
+                           "00000000000000000000000000000003\r\nabc\r\n0\r\n\r\n";
+    std::vector<Parsed> parsed = parseStream(response, {response.size()});
+    ASSERT_EQ(parsed.size(), 1u);
+    EXPECT_EQ(parsed[0].body, "abc");
+
+    const std::string heads[] = {
+        "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\nffffffffffffffff\r\n",
+        "HTTP/1.1 200 OK\r\nContent-Length: 18446744073709551615\r\n\r\n",
+    };
+    for (const std::string& head : heads) {
+        HttpResponseParser parser;
+        EXPECT_EQ(parser.feed(head.data(), head.size(), [](const char*, std::size_t) { return true; }), head.size());
+        EXPECT_FALSE(parser.complete());
+    }
+}
+
+TEST(HttpResponseParser, TruncatedResponseFailsOnClose) {
+    for (std::size_t size = 0; size < kLengthResponse.size(); ++size) {
+        HttpResponseParser parser;
+        parser.feed(kLengthResponse.data(), size, [](const char*, std::size_t) { return true; });
+        EXPECT_FALSE(parser.complete());
+        EXPECT_THROW(parser.finish(), TransportError) << "after " << size << " bytes";
+    }
+}
+
+TEST(ChunkedBodyWriter, RoundTripsThroughTheParser) {
+    dto::SegmentedBody body;
+    body.appendText("first piece");
+    body.appendText(std::string(5000, 'x'));
+    body.appendText("last");
+    std::string expected;
+    body.readAll(expected);
+
+    std::string head = "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n";
+    std::mt19937 rng(1);
+    for (int round = 0; round < 50; ++round) {
+        body.rewind();
+        wire::ChunkedBodyWriter writer(head, body);
+        std::string wireBytes;
+        iovec iov[wire::ChunkedBodyWriter::kMaxIovecs];
+        for (int count = writer.pending(iov); count > 0; count = writer.pending(iov)) {
+            // Write a random prefix of what is pending, as a short writev would.
+            std::size_t total = 0;
+            for (int i = 0; i < count; ++i) {
+                total += iov[i].iov_len;
+            }
+            std::size_t written = 1 + rng() % total;
+            for (int i = 0, left = static_cast<int>(written); i < count && left > 0; ++i) {
+                std::size_t n = std::min<std::size_t>(iov[i].iov_len, static_cast<std::size_t>(left));
+                wireBytes.append(static_cast<const char*>(iov[i].iov_base), n);
+                left -= static_cast<int>(n);
+            }
+            writer.advance(written);
+        }
+        ASSERT_EQ(wireBytes.compare(wireBytes.size() - 5, 5, "0\r\n\r\n"), 0);
+        std::vector<Parsed> parsed = parseStream(wireBytes, {1 + rng() % 64});
+        ASSERT_EQ(parsed.size(), 1u);
+        EXPECT_EQ(parsed[0].body, expected);
+    }
+}
@@ -0,0 +1,257 @@
+#include <gtest/gtest.h>
+#include <nlohmann/json.hpp>
+#include <sauron/dto/JsonStream.hpp>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace sauron::dto::json_stream;
+
+namespace {
+
+// What a document reports, in document order: each string value and each
+// closed object, with the path it was found at. nlohmann_json walks a
+// parsed document to produce the expected list.
+struct Record {
+    bool object;
+    std::string path;
+    std::string text;
+
+    bool operator==(const Record& other) const {
+        return object == other.object && path == other.path && text == other.text;
+    }
+};
+
+std::ostream& operator<<(std::ostream& out, const Record& record) {
+    return out << (record.object ? "object " : "string ") << record.path << " \"" << record.text << "\"";
+}
+
+std::string render(const Path& path) {
+    std::string out;
+    for (const Path::Frame& frame : path.frames()) {
+        out += frame.array ? "/[]" : "/" + frame.key;
+    }
+    return out;
+}
+
+class Recorder : public Handler {
+public:
+    bool string(const Path& path, std::string_view text, bool complete) override {
+        current_.append(text.data(), text.size());
+        if (complete) {
+            records.push_back(Record{false, render(path), current_});
+            current_.clear();
+        }
+        return true;
+    }
+
+    bool endObject(const Path& path) override {
+        EXPECT_TRUE(current_.empty());
+        records.push_back(Record{true, render(path), std::string()});
+        return true;
+    }
+
+    std::vector<Record> records;
+
+private:
+    std::string current_;
+};
+
+void walk(const nlohmann::json& value, const std::string& path, std::vector<Record>& out) {
+    if (value.is_string()) {
+        out.push_back(Record{false, path, value.get<std::string>()});
+    } else if (value.is_array()) {
+        for (const nlohmann::json& element : value) {
+            walk(element, path + "/[]", out);
+        }
+    } else if (value.is_object()) {
+        for (auto member = value.begin(); member != value.end(); ++member) {
+            walk(member.value(), path + "/" + member.key(), out);
+        }
+        out.push_back(Record{true, path, std::string()});
+    }
+}
+
+std::vector<Record> expected(const nlohmann::json& document) {
+    std::vector<Record> out;
+    walk(document, std::string(), out);
+    return out;
+}
+
+std::string randomText(std::mt19937& rng) {
+    static const std::vector<std::string> pieces = {
+        "a", "text", " ", "\"", "\\", "/", "\n", "\t", "\x01", "\x1f", "\xc3\xa9", "\xe2\x82\xac", "\xf0\x9f\x98\x80", "}", "]"};
+    std::string text;
+    for (std::size_t n = rng() % 8; n > 0; --n) {
+        text += pieces[rng() % pieces.size()];
+    }
+    return text;
+}
+
+nlohmann::json randomValue(std::mt19937& rng, int depth) {
+    switch (rng() % (depth > 4 ? 5 : 7)) {
+        case 0:
+            return randomText(rng);
+        case 1:
+            return static_cast<std::int64_t>(rng()) - 0x7fffffff;
+        case 2:
+            return static_cast<double>(rng()) / 1024.0;
+        case 3:
+            return rng() % 2 == 0;
+        case 4:
+            return nullptr;
+        case 5: {
+            nlohmann::json array = nlohmann::json::array();
+            for (std::size_t n = rng() % 5; n > 0; --n) {
+                array.push_back(randomValue(rng, depth + 1));
+            }
+            return array;
+        }
+        default: {
+            nlohmann::json object = nlohmann::json::object();
+            for (std::size_t n = rng() % 5; n > 0; --n) {
+                object[randomText(rng)] = randomValue(rng, depth + 1);
+            }
+            return object;
+        }
+    }
+}
+
+// Feed text in chunks cut at random points, empty chunks included.
+std::vector<Record> parseInChunks(const std::string& text, std::mt19937& rng) {
+    Parser parser;
+    Recorder recorder;
+    std::size_t pos = 0;
+    while (pos < text.size()) {
+        std::size_t size = std::min<std::size_t>(text.size() - pos, rng() % 9);
+        EXPECT_TRUE(parser.feed(std::string_view(text).substr(pos, size), recorder));
+        pos += size;
+    }
+    parser.finish();
+    EXPECT_TRUE(parser.done());
+    EXPECT_EQ(parser.consumed(), text.size());
+    return recorder.records;
+}
+
+bool acceptsInChunks(const std::string& text, std::mt19937& rng) {
+    Parser parser;
+    Handler handler;
+    try {
+        std::size_t pos = 0;
+        while (pos < text.size()) {
+            std::size_t size = std::min<std::size_t>(text.size() - pos, 1 + rng() % 5);
+            parser.feed(std::string_view(text).substr(pos, size), handler);
+            pos += size;
+        }
+        parser.finish();
+        return true;
+    } catch (const std::runtime_error&) {
+        return false;
+    }
+}
+
+} // namespace
+
+TEST(JsonStream, MatchesReferenceOnRandomDocumentsAndSplits) {
+    std::mt19937 rng(1);
+    for (int round = 0; round < 2000; ++round) {
+        nlohmann::json document = randomValue(rng, 0);
+        std::vector<Record> reference = expected(document);
+        for (int indent : {-1, 2}) {
+            std::string text = document.dump(indent, ' ', indent < 0);
+            SCOPED_TRACE(text);
+            ASSERT_EQ(parseInChunks(text, rng), reference);
+        }
+    }
+}
+
+TEST(JsonStream, MatchesReferenceAtEverySplitPoint) {
+    std::string text = R"({"a": [1, -2.5e+3, "x\"y\\z\u00e9\ud83d\ude00", {"b": "tr\/ue"}], "c": {"d": null, "e": true}, )"
+                       R"("f": "plain text long enough to be handed on as a view", "g": false})";
+    std::vector<Record> reference = expected(nlohmann::json::parse(text));
+    for (std::size_t a = 0; a <= text.size(); ++a) {
+        for (std::size_t b = a; b <= text.size(); b += 7) {
+            Parser parser;
+            Recorder recorder;
+            parser.feed(std::string_view(text).substr(0, a), recorder);
+            parser.feed(std::string_view(text).substr(a, b - a), recorder);
+            parser.feed(std::string_view(text).substr(b), recorder);
+            parser.finish();
+            ASSERT_EQ(recorder.records, reference) << "split at " << a << " and " << b;
+        }
+    }
+}
+
+TEST(JsonStream, ValidityMatchesReferenceOnMutatedDocuments) {
+    // The parser does not validate UTF-8, so mutations stay within ASCII.
+    // They leave out 'e' and 'E': nlohmann_json rejects exponents a double
+    // cannot hold, which the JSON grammar allows.
+    static const std::string alphabet = "{}[],:\"\\ \t\n0123456789-+.trufalsnbx/";
+    std::mt19937 rng(2);
+    int rejected = 0;
+    for (int round = 0; round < 20000; ++round) {
+        std::string text = randomValue(rng, 0).dump(-1, ' ', true);
+        for (std::size_t n = 1 + rng() % 3; n > 0; --n) {
+            std::size_t at = rng() % (text.size() + 1);
+            switch (rng() % 3) {
+                case 0:
+                    text.insert(at, 1, alphabet[rng() % alphabet.size()]);
+                    break;
+                case 1:
+                    if (at < text.size()) {
+                        text.erase(at, 1);
+                    }
+                    break;
+                default:
+                    if (at < text.size()) {
+                        text[at] = alphabet[rng() % alphabet.size()];
+                    }
+                    break;
+            }
+        }
+        bool valid = nlohmann::json::accept(text);
+        ASSERT_EQ(acceptsInChunks(text, rng), valid) << testing::PrintToString(text);
+        rejected += valid ? 0 : 1;
+    }
+    EXPECT_GT(rejected, 1000);
+}
+
+TEST(JsonStream, RejectsInvalidDocuments) {
+    for (const char* text : {"", "{", "[1,]", "{\"a\"}", "{\"a\":1,}", "01", "1.", "-", "1e", "tru", "nul",
+                             "\"\\x\"", "\"\\ud800\"", "\"\\udc00\"", "\"\\ud800\\u0041\"", "\"a\nb\"", "[1] 2",
+                             "{1:2}", "[\"a\" \"b\"]"}) {
+        std::mt19937 rng(3);
+        EXPECT_FALSE(acceptsInChunks(text, rng)) << text;
+        EXPECT_FALSE(nlohmann::json::accept(text)) << text;
+    }
+}
+
+TEST(JsonStream, StopsWhenTheHandlerAsks) {
+    struct Stopper : Handler {
+        bool string(const Path& path, std::string_view text, bool complete) override {
+            (void)text;
+            ++calls;
+            return !(complete && path.is({"stop"}));
+        }
+        int calls = 0;
+    } stopper;
+    Parser parser;
+    EXPECT_FALSE(parser.feed(R"({"stop": "here", "later": "ignored")", stopper));
+    EXPECT_FALSE(parser.feed(R"(, "more": "x"})", stopper));
+    EXPECT_EQ(stopper.calls, 1);
+    parser.finish();
+}
+
+TEST(JsonStream, ResetStartsANewDocument) {
+    Parser parser;
+    Handler ignored;
+    Recorder recorder;
+    parser.feed(R"({"a": "b)", ignored);
+    parser.reset();
+    parser.feed(R"(["c"])", recorder);
+    parser.finish();
+    ASSERT_EQ(recorder.records.size(), 1u);
+    EXPECT_EQ(recorder.records[0].text, "c");
+    EXPECT_EQ(recorder.records[0].path, "/[]");
+}
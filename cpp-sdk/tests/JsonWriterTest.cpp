@@ -0,0 +1,161 @@
+#include <gtest/gtest.h>
+#include <sauron/dto/DTOs.hpp>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace sauron;
+using namespace sauron::dto;
+
+namespace {
+
+// The UTF-8 encoding of a code point.
+std::string utf8(std::uint32_t codePoint) {
+    std::string out;
+    if (codePoint < 0x80) {
+        out.push_back(static_cast<char>(codePoint));
+    } else if (codePoint < 0x800) {
+        out.push_back(static_cast<char>(0xC0 | (codePoint >> 6)));
+        out.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+    } else if (codePoint < 0x10000) {
+        out.push_back(static_cast<char>(0xE0 | (codePoint >> 12)));
+        out.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+    } else {
+        out.push_back(static_cast<char>(0xF0 | (codePoint >> 18)));
+        out.push_back(static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+    }
+    return out;
+}
+
+// Valid UTF-8 text mixing plain ASCII, characters JSON escapes, and every sequence length.
+std::string randomText(std::mt19937& rng, std::size_t codePoints) {
+    std::string text;
+    for (std::size_t i = 0; i < codePoints; ++i) {
+        std::uint32_t codePoint;
+        switch (rng() % 5) {
+            case 0: codePoint = rng() % 0x20; break;
+            case 1: codePoint = "\"\\/\x7f"[rng() % 4]; break;
+            case 2: codePoint = 0x80 + rng() % (0x800 - 0x80); break;
+            case 3: codePoint = 0x800 + rng() % (0xD800 - 0x800); break;
+            default: codePoint = 0x10000 + rng() % (0x110000 - 0x10000); break;
+        }
+        text += utf8(codePoint);
+        text.append(rng() % 4, 'a');
+    }
+    return text;
+}
+
+std::string written(const std::string& value) {
+    std::string out;
+    json_writer::appendString(out, value);
+    return out;
+}
+
+// A file removed when the test ends.
+struct TempFile {
+    std::string path;
+
+    explicit TempFile(const std::string& contents) {
+        char name[] = "/tmp/sauron-json-test-XXXXXX";
+        int fd = mkstemp(name);
+        path = name;
+        std::FILE* file = fdopen(fd, "wb");
+        std::fwrite(contents.data(), 1, contents.size(), file);
+        std::fclose(file);
+    }
+
+    ~TempFile() { std::remove(path.c_str()); }
+};
+
+} // namespace
+
+TEST(JsonWriter, EscapesEveryAsciiCharacterLikeNlohmann) {
+    for (int c = 0; c < 0x80; ++c) {
+        const std::string value = "x" + std::string(1, static_cast<char>(c)) + "y";
+        SCOPED_TRACE("character " + std::to_string(c));
+        EXPECT_EQ(written(value), nlohmann::json(value).dump());
+        EXPECT_EQ(json_writer::escapedSize(value, "value"), written(value).size());
+    }
+}
+
+TEST(JsonWriter, MatchesNlohmannOnRandomUtf8) {
+    std::mt19937 rng(4);
+    for (int i = 0; i < 2000; ++i) {
+        const std::string value = randomText(rng, rng() % 64);
+        EXPECT_EQ(written(value), nlohmann::json(value).dump()) << "iteration " << i;
+        EXPECT_EQ(json_writer::escapedSize(value, "value"), written(value).size()) << "iteration " << i;
+    }
+    for (std::uint32_t codePoint : {0x7Fu, 0x80u, 0x7FFu, 0x800u, 0xD7FFu, 0xE000u, 0xFFFFu, 0x10000u, 0x10FFFFu}) {
+        EXPECT_EQ(written(utf8(codePoint)), nlohmann::json(utf8(codePoint)).dump()) << codePoint;
+    }
+}
+
+TEST(JsonWriter, RejectsInvalidUtf8) {
+    const char* invalid[] = {
+        "\x80",             // continuation byte without a lead
+        "\xC0\x80",         // overlong NUL
+        "\xE0\x80\x80",     // overlong
+        "\xED\xA0\x80",     // UTF-16 surrogate
+        "\xF4\x90\x80\x80", // above U+10FFFF
+        "\xE2\x82",         // truncated
+        "\xF8\x88\x80\x80", // five-byte lead
+        "\xC3(",            // bad continuation
+    };
+    for (const char* value : invalid) {
+        EXPECT_THROW(json_writer::escapedSize(value, "prompt"), std::invalid_argument) << value;
+        EXPECT_THROW(nlohmann::json(value).dump(), nlohmann::json::type_error) << "nlohmann rejects it too";
+    }
+    try {
+        json_writer::escapedSize("ok \xFF", "prompt");
+        ADD_FAILURE() << "expected std::invalid_argument";
+    } catch (const std::invalid_argument& error) {
+        EXPECT_STREQ(error.what(), "prompt is not valid UTF-8");
+    }
+}
+
+TEST(JsonWriter, RequestIsByteIdenticalToTheDom) {
+    std::mt19937 rng(11);
+    TempFile imageFile(std::string("\x89PNG\r\n\x1a\n", 8) + std::string(1000, '\0'));
+
+    std::vector<AIQueryRequest> requests;
+    requests.emplace_back("", AIProvider::OPENAI, "");
+    requests.emplace_back("plain prompt", AIProvider::ANTHROPIC);
+    requests.emplace_back("quotes \" and \\ and\nnewlines\t\x01", AIProvider::GOOGLE, "model \"x\"");
+    requests.emplace_back(randomText(rng, 500), AIProvider::OPENAI, randomText(rng, 8),
+                          std::vector<std::string>{util::base64::encode(std::string(300, '\xff')),
+                                                   "data:image/png;base64,iVBORw0KGgo=", ""});
+    AIQueryRequest withFiles("describe both", AIProvider::OPENAI, "gpt-4o", {"aGVsbG8="});
+    withFiles.attachImageFile(imageFile.path);
+    withFiles.attachImageFile(imageFile.path);
+    requests.push_back(withFiles);
+    AIQueryRequest onlyFile("describe", AIProvider::OPENAI);
+    onlyFile.attachImageFile(imageFile.path);
+    requests.push_back(onlyFile);
+
+    Conversation conversation;
+    conversation.add(Role::SYSTEM, "be \"brief\"");
+    conversation.add(Role::USER, randomText(rng, 50));
+    conversation.add(Role::ASSISTANT, "line\r\nbreak \\ done");
+    AIQueryRequest withConversation("ignored", AIProvider::ANTHROPIC, "claude");
+    withConversation.setConversation(conversation);
+    requests.push_back(withConversation);
+
+    for (std::size_t i = 0; i < requests.size(); ++i) {
+        SCOPED_TRACE("request " + std::to_string(i));
+        const std::string expected = requests[i].toJson().dump();
+        std::string out = "stale contents";
+        requests[i].writeJson(out);
+        EXPECT_EQ(out, expected);
+        EXPECT_EQ(requests[i].toString(), expected);
+
+        std::string streamed;
+        requests[i].openBodyStream(WireFormat::JSON)->readAll(streamed);
+        EXPECT_EQ(streamed, expected);
+    }
+}
@@ -0,0 +1,63 @@
+#include <gtest/gtest.h>
+#include <sauron/client/Jwt.hpp>
+#include <chrono>
+#include <string>
+
+using namespace sauron;
+using namespace sauron::client;
+
+namespace {
+
+using std::chrono::seconds;
+using std::chrono::system_clock;
+
+// An unsigned JWT carrying the given claims, encoded as issuers do: base64url without padding.
+std::string tokenWith(const std::string& claims) {
+    return util::base64::encode("{\"alg\":\"none\"}", util::base64::Alphabet::Url) + "." +
+           util::base64::encode(claims, util::base64::Alphabet::Url) + ".signature";
+}
+
+} // namespace
+
+TEST(Jwt, ReadsExpFromAnUnpaddedBase64UrlPayload) {
+    // Chosen so that the payload encodes to both '-' and '_' and would need padding.
+    const std::string claims = "{\"exp\":2000000000,\"sub\":\">>>??\"}";
+    const std::string token = tokenWith(claims);
+    const std::string payload = token.substr(token.find('.') + 1, token.rfind('.') - token.find('.') - 1);
+    ASSERT_NE(payload.find('-'), std::string::npos) << payload;
+    ASSERT_NE(payload.find('_'), std::string::npos) << payload;
+    ASSERT_NE(payload.size() % 4, 0u) << payload;
+
+    EXPECT_EQ(jwt::expiry(token), system_clock::time_point(seconds(2000000000)));
+    EXPECT_EQ(jwt::expiry(tokenWith("{\"exp\":1700000000.75}")), system_clock::time_point(seconds(1700000000)))
+        << "fractional seconds are dropped";
+
+    // Padded and standard-alphabet payloads are accepted too.
+    const std::string padded = "e30." + util::base64::encode("{\"exp\":1}") + ".sig";
+    EXPECT_EQ(jwt::expiry(padded), system_clock::time_point(seconds(1)));
+}
+
+TEST(Jwt, IgnoresAnExpThatIsNotANumber) {
+    EXPECT_FALSE(jwt::expiry(tokenWith("{\"sub\":\"user\"}")));
+    EXPECT_FALSE(jwt::expiry(tokenWith("{\"exp\":\"2000000000\"}")));
+    EXPECT_FALSE(jwt::expiry(tokenWith("{\"exp\":null}")));
+    EXPECT_FALSE(jwt::expiry(tokenWith("{\"exp\":true}")));
+    EXPECT_FALSE(jwt::expiry(tokenWith("{\"exp\":[2000000000]}")));
+    EXPECT_FALSE(jwt::expiry(tokenWith("{\"exp\":1e300}"))) << "beyond system_clock";
+    EXPECT_FALSE(jwt::expiry(tokenWith("{\"exp\":-1e300}")));
+    EXPECT_TRUE(jwt::claims(tokenWith("{\"exp\":\"2000000000\"}"))) << "the claims themselves are fine";
+}
+
+TEST(Jwt, RejectsMalformedTokens) {
+    const std::string exp = util::base64::encode("{\"exp\":2000000000}", util::base64::Alphabet::Url);
+    EXPECT_FALSE(jwt::claims(""));
+    EXPECT_FALSE(jwt::claims("opaque-token"));
+    EXPECT_FALSE(jwt::claims("header." + exp)) << "no signature segment";
+    EXPECT_FALSE(jwt::claims("header..signature")) << "empty payload";
+    EXPECT_FALSE(jwt::claims("header.!!!!.signature")) << "not base64";
+    EXPECT_FALSE(jwt::claims("header." + exp.substr(0, exp.size() - 3) + ".signature")) << "truncated";
+    EXPECT_FALSE(jwt::claims(tokenWith("not json")));
+    EXPECT_FALSE(jwt::claims(tokenWith("[2000000000]"))) << "claims must be an object";
+    EXPECT_FALSE(jwt::expiry("header.!!!!.signature"));
+    EXPECT_TRUE(jwt::claims("header." + exp + ".signature"));
+}
@@ -0,0 +1,192 @@
+#include <gtest/gtest.h>
+#include <sauron/client/RateLimiter.hpp>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+using namespace sauron;
+using namespace sauron::client;
+
+namespace {
+
+const dto::AIProvider kProvider = dto::AIProvider::OPENAI;
+
+// A limiter with only the AIMD controller, starting at the given limit.
+std::shared_ptr<RateLimiter> adaptiveLimiter(double limit, double maxLimit = 256) {
+    RateLimiterOptions options;
+    options.defaults.aimd.initialLimit = limit;
+    options.defaults.aimd.maxLimit = maxLimit;
+    return RateLimiter::create(options);
+}
+
+} // namespace
+
+TEST(RateLimiter, TokenBucketBoundsTheRate) {
+    RateLimiterOptions options;
+    options.defaults.requestsPerSecond = 20;
+    options.defaults.burst = 2;
+    options.defaults.adaptive = false;
+    auto limiter = RateLimiter::create(options);
+
+    auto start = std::chrono::steady_clock::now();
+    limiter->acquire(kProvider);
+    limiter->acquire(kProvider);
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(40)) << "the burst is free";
+    for (int i = 0; i < 4; ++i) {
+        limiter->acquire(kProvider);
+    }
+    // Four tokens past the burst take 200 ms to refill at 20 per second.
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    EXPECT_GE(elapsed, std::chrono::milliseconds(180));
+    EXPECT_LT(elapsed, std::chrono::seconds(2));
+    EXPECT_EQ(limiter->stats(kProvider).granted, 6u);
+    EXPECT_EQ(limiter->stats(kProvider).concurrencyLimit, 0);
+}
+
+TEST(RateLimiter, OtherProvidersHaveTheirOwnBucket) {
+    RateLimiterOptions options;
+    options.defaults.adaptive = false;
+    options.providers[kProvider].requestsPerSecond = 0.001;
+    options.providers[kProvider].adaptive = false;
+    auto limiter = RateLimiter::create(options);
+
+    limiter->acquire(kProvider);
+    bool granted = false;
+    limiter->acquireAsync(kProvider, [&](RateLimiter::Permit) { granted = true; });
+    EXPECT_FALSE(granted);
+    EXPECT_EQ(limiter->stats(kProvider).waiting, 1u);
+    limiter->acquire(dto::AIProvider::ANTHROPIC); // does not wait
+}
+
+TEST(RateLimiter, CapsConcurrencyAtTheLimit) {
+    auto limiter = adaptiveLimiter(2);
+    RateLimiter::Permit first = limiter->acquire(kProvider);
+    RateLimiter::Permit second = limiter->acquire(kProvider);
+    std::vector<RateLimiter::Permit> later;
+    limiter->acquireAsync(kProvider, [&](RateLimiter::Permit permit) { later.push_back(std::move(permit)); });
+    EXPECT_TRUE(later.empty());
+    EXPECT_EQ(limiter->stats(kProvider).inFlight, 2u);
+    first.release();
+    EXPECT_EQ(later.size(), 1u);
+    EXPECT_EQ(limiter->stats(kProvider).inFlight, 2u);
+}
+
+TEST(RateLimiter, BacksOffOn429And5xxOncePerRoundTrip) {
+    auto limiter = adaptiveLimiter(16);
+    std::vector<RateLimiter::Permit> permits;
+    for (int i = 0; i < 3; ++i) {
+        permits.push_back(limiter->acquire(kProvider));
+    }
+    permits[0].complete(429);
+    EXPECT_EQ(limiter->stats(kProvider).concurrencyLimit, 8);
+    // Granted before the decrease: the same overload, not a new one.
+    permits[1].complete(503);
+    EXPECT_EQ(limiter->stats(kProvider).concurrencyLimit, 8);
+    EXPECT_EQ(limiter->stats(kProvider).backoffs, 1u);
+
+    limiter->acquire(kProvider).complete(500);
+    EXPECT_EQ(limiter->stats(kProvider).concurrencyLimit, 4);
+    limiter->acquire(kProvider).fail();
+    EXPECT_EQ(limiter->stats(kProvider).concurrencyLimit, 2);
+    // A client error is a healthy response: the limit grows again.
+    limiter->acquire(kProvider).complete(404, false);
+    EXPECT_DOUBLE_EQ(limiter->stats(kProvider).concurrencyLimit, 2.5);
+    EXPECT_EQ(limiter->stats(kProvider).backoffs, 3u);
+}
+
+TEST(RateLimiter, NeverBacksOffBelowTheMinimum) {
+    auto limiter = adaptiveLimiter(2);
+    for (int i = 0; i < 5; ++i) {
+        limiter->acquire(kProvider).complete(429);
+    }
+    EXPECT_EQ(limiter->stats(kProvider).concurrencyLimit, 1);
+}
+
+TEST(RateLimiter, GrowsAdditivelyWhileTheLimitIsUsed) {
+    auto limiter = adaptiveLimiter(4, 4.4);
+    // One request at a time never uses a limit of 4, so it must not grow.
+    for (int i = 0; i < 10; ++i) {
+        limiter->acquire(kProvider).complete(200, false);
+    }
+    EXPECT_EQ(limiter->stats(kProvider).concurrencyLimit, 4);
+
+    std::vector<RateLimiter::Permit> permits;
+    for (int i = 0; i < 4; ++i) {
+        permits.push_back(limiter->acquire(kProvider));
+    }
+    permits[0].complete(200, false);
+    EXPECT_DOUBLE_EQ(limiter->stats(kProvider).concurrencyLimit, 4.25);
+    for (auto& permit : permits) {
+        permit.complete(200, false);
+    }
+    EXPECT_DOUBLE_EQ(limiter->stats(kProvider).concurrencyLimit, 4.4) << "capped at maxLimit";
+}
+
+TEST(RateLimiter, GrantsWaitersInArrivalOrder) {
+    auto limiter = adaptiveLimiter(1);
+    RateLimiter::Permit held = limiter->acquire(kProvider);
+    std::vector<int> order;
+    std::vector<RateLimiter::Permit> permits;
+    permits.reserve(5); // each release grants the next waiter while permits[i] is in use
+    for (int i = 0; i < 5; ++i) {
+        limiter->acquireAsync(kProvider, [&, i](RateLimiter::Permit permit) {
+            order.push_back(i);
+            permits.push_back(std::move(permit));
+        });
+    }
+    EXPECT_EQ(limiter->stats(kProvider).waiting, 5u);
+    held.release();
+    for (int i = 0; i < 4; ++i) {
+        permits[i].release();
+    }
+    EXPECT_EQ(order, (std::vector<int>{0, 1, 2, 3, 4}));
+    EXPECT_EQ(limiter->stats(kProvider).waiting, 0u);
+}
+
+TEST(RateLimiter, ReleasesThePermitWhenTheCallbackThrows) {
+    auto limiter = adaptiveLimiter(1);
+    RateLimiter::Permit held = limiter->acquire(kProvider);
+    bool nextGranted = false;
+    limiter->acquireAsync(kProvider, [](RateLimiter::Permit) { throw std::runtime_error("send failed"); });
+    limiter->acquireAsync(kProvider, [&](RateLimiter::Permit) { nextGranted = true; });
+    held.release();
+    EXPECT_TRUE(nextGranted);
+    EXPECT_EQ(limiter->stats(kProvider).inFlight, 0u);
+    EXPECT_EQ(limiter->stats(kProvider).backoffs, 0u);
+}
+
+TEST(RateLimiter, DroppedPermitReleasesWithoutFeedback) {
+    auto limiter = adaptiveLimiter(8);
+    {
+        RateLimiter::Permit permit = limiter->acquire(kProvider);
+        RateLimiter::Permit moved = std::move(permit);
+        EXPECT_EQ(limiter->stats(kProvider).inFlight, 1u);
+    }
+    RateLimiterStats stats = limiter->stats(kProvider);
+    EXPECT_EQ(stats.inFlight, 0u);
+    EXPECT_EQ(stats.concurrencyLimit, 8);
+    EXPECT_EQ(stats.backoffs, 0u);
+}
+
+TEST(RateLimiter, WaitEndsAtTheDeadlineOrOnCancel) {
+    auto limiter = adaptiveLimiter(1);
+    RateLimiter::Permit held = limiter->acquire(kProvider);
+
+    CallOptions call = CallOptions::timeout(std::chrono::milliseconds(20));
+    EXPECT_THROW(limiter->acquire(kProvider, &call), DeadlineExceeded);
+
+    CancellationToken token;
+    std::exception_ptr stopped;
+    CallOptions cancellable;
+    cancellable.cancellation = token;
+    limiter->acquireAsync(kProvider, [](RateLimiter::Permit) { FAIL() << "granted after cancel"; },
+                          cancellable, [&](std::exception_ptr error) { stopped = error; });
+    token.cancel();
+    ASSERT_TRUE(stopped);
+    EXPECT_THROW(std::rethrow_exception(stopped), RequestCancelled);
+    EXPECT_EQ(limiter->stats(kProvider).waiting, 0u);
+
+    held.release();
+    EXPECT_EQ(limiter->stats(kProvider).granted, 1u);
+}
@@ -0,0 +1,140 @@
+#include <gtest/gtest.h>
+#include <sauron/client/RequestCoalescer.hpp>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace sauron::client;
+
+namespace {
+
+const RequestCoalescer::Key kKey{1, 2};
+
+// A follower consuming a stream on its own thread.
+struct Follower {
+    std::vector<std::string> chunks;
+    std::future<int> status;
+
+    Follower(std::shared_ptr<RequestCoalescer::StreamFlight> flight, std::size_t stopAfter = SIZE_MAX) {
+        status = std::async(std::launch::async, [this, flight, stopAfter] {
+            return flight->consume([this, stopAfter](const std::string& chunk, bool) {
+                chunks.push_back(chunk);
+                return chunks.size() < stopAfter;
+            });
+        });
+    }
+};
+
+} // namespace
+
+TEST(RequestCoalescer, SharesOneRequestBetweenConcurrentCallers) {
+    auto coalescer = RequestCoalescer::create();
+    std::promise<void> followerJoined;
+    std::future<HttpResponse> leader = std::async(std::launch::async, [&] {
+        return coalescer->run(kKey, [&] {
+            followerJoined.get_future().wait();
+            return HttpResponse{200, "shared body", {}, {}};
+        });
+    });
+    while (coalescer->stats().leaders == 0) {
+        std::this_thread::yield();
+    }
+    bool shared = false;
+    std::future<HttpResponse> follower = std::async(std::launch::async, [&] {
+        return coalescer->run(kKey, []() -> HttpResponse { throw std::logic_error("followers do not send"); }, &shared);
+    });
+    while (coalescer->stats().followers == 0) {
+        std::this_thread::yield();
+    }
+    followerJoined.set_value();
+    EXPECT_EQ(leader.get().body, "shared body");
+    EXPECT_EQ(follower.get().body, "shared body");
+    EXPECT_TRUE(shared);
+
+    // The key is free again once the leader completed.
+    EXPECT_EQ(coalescer->run(kKey, [] { return HttpResponse{200, "fresh", {}, {}}; }).body, "fresh");
+    EXPECT_EQ(coalescer->stats().leaders, 2u);
+}
+
+TEST(RequestCoalescer, FollowerJoiningMidStreamIsReplayedWhatItMissed) {
+    auto coalescer = RequestCoalescer::create();
+    bool leader = false;
+    auto flight = coalescer->joinStream(kKey, leader);
+    ASSERT_TRUE(leader);
+    flight->publish("one ", false);
+    flight->publish("two ", false);
+
+    bool joinedAsLeader = true;
+    Follower follower(coalescer->joinStream(kKey, joinedAsLeader));
+    EXPECT_FALSE(joinedAsLeader);
+    EXPECT_TRUE(flight->publish("three", true));
+    coalescer->finishStream(kKey, flight, 200, nullptr);
+
+    EXPECT_EQ(follower.status.get(), 200);
+    EXPECT_EQ(follower.chunks, (std::vector<std::string>{"one ", "two ", "three"}));
+    EXPECT_EQ(coalescer->stats().followers, 1u);
+}
+
+TEST(RequestCoalescer, FollowersReceiveTheLeadersError) {
+    auto coalescer = RequestCoalescer::create();
+    bool leader = false;
+    auto flight = coalescer->joinStream(kKey, leader);
+    flight->publish("partial", false);
+    Follower follower(coalescer->joinStream(kKey, leader));
+    coalescer->finishStream(kKey, flight, 0, std::make_exception_ptr(TransportError("connection reset")));
+    EXPECT_THROW(follower.status.get(), TransportError);
+    EXPECT_EQ(follower.chunks, (std::vector<std::string>{"partial"}));
+}
+
+TEST(RequestCoalescer, StreamPastTheReplayLimitAdmitsNoFollowers) {
+    RequestCoalescerOptions options;
+    options.maxReplayBytes = 8;
+    auto coalescer = RequestCoalescer::create(options);
+    bool leader = false;
+    auto flight = coalescer->joinStream(kKey, leader);
+    flight->publish("1234", false);
+
+    Follower early(coalescer->joinStream(kKey, leader));
+    ASSERT_FALSE(leader);
+    flight->publish("5678", false);
+    flight->publish("9", false); // past the limit
+
+    auto second = coalescer->joinStream(kKey, leader);
+    EXPECT_TRUE(leader) << "a late caller sends its own request";
+    EXPECT_NE(second, flight);
+
+    // The early follower still gets the whole stream while chunks are dropped behind it.
+    flight->publish("tail", true);
+    coalescer->finishStream(kKey, flight, 200, nullptr);
+    EXPECT_EQ(early.status.get(), 200);
+    EXPECT_EQ(early.chunks, (std::vector<std::string>{"1234", "5678", "9", "tail"}));
+
+    // Finishing the first stream leaves the one that replaced it in place.
+    Follower late(coalescer->joinStream(kKey, leader));
+    EXPECT_FALSE(leader);
+    second->publish("new", true);
+    coalescer->finishStream(kKey, second, 200, nullptr);
+    EXPECT_EQ(late.status.get(), 200);
+    EXPECT_EQ(late.chunks, (std::vector<std::string>{"new"}));
+}
+
+TEST(RequestCoalescer, LeaderStopsOnceNobodyWantsTheStream) {
+    auto coalescer = RequestCoalescer::create();
+    bool leader = false;
+    auto flight = coalescer->joinStream(kKey, leader);
+    Follower follower(coalescer->joinStream(kKey, leader), 1);
+    flight->publish("a", false);
+    EXPECT_EQ(follower.status.get(), 200);
+    EXPECT_EQ(follower.chunks, (std::vector<std::string>{"a"}));
+
+    EXPECT_FALSE(flight->publish("b", false));
+    EXPECT_FALSE(coalescer->keepStreaming(*flight, false, false));
+    auto next = coalescer->joinStream(kKey, leader);
+    EXPECT_TRUE(leader) << "a closing stream is not joined";
+    coalescer->finishStream(kKey, flight, 200, nullptr);
+    coalescer->finishStream(kKey, next, 200, nullptr);
+}
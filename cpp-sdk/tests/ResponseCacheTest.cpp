@@ -0,0 +1,175 @@
+#include <gtest/gtest.h>
+#include <sauron/client/ResponseCache.hpp>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace sauron;
+using namespace sauron::client;
+
+namespace {
+
+// Charged per entry on top of its body; mirrors ResponseCache::kEntryOverhead.
+constexpr std::size_t kOverhead = 128;
+
+ResponseCache::Key keyFor(const std::string& prompt) {
+    return ResponseCache::makeKey("/ai/query", dto::AIQueryRequest(prompt, dto::AIProvider::OPENAI));
+}
+
+// A file removed when the test ends.
+struct TempFile {
+    std::string path;
+
+    explicit TempFile(const std::string& contents) {
+        char name[] = "/tmp/sauron-cache-test-XXXXXX";
+        int fd = mkstemp(name);
+        path = name;
+        std::FILE* file = fdopen(fd, "wb");
+        std::fwrite(contents.data(), 1, contents.size(), file);
+        std::fclose(file);
+    }
+
+    ~TempFile() { std::remove(path.c_str()); }
+};
+
+} // namespace
+
+TEST(ResponseCache, EvictsLeastRecentlyUsedToStayInBudget) {
+    ResponseCacheOptions options;
+    options.shards = 1;
+    options.maxBytes = 3 * (100 + kOverhead);
+    auto cache = ResponseCache::create(options);
+
+    const std::string body(100, 'x');
+    cache->insert(keyFor("a"), body);
+    cache->insert(keyFor("b"), body);
+    cache->insert(keyFor("c"), body);
+    ASSERT_TRUE(cache->find(keyFor("a"))); // now the most recently used
+    cache->insert(keyFor("d"), body);
+
+    EXPECT_TRUE(cache->find(keyFor("a")));
+    EXPECT_FALSE(cache->find(keyFor("b")));
+    EXPECT_TRUE(cache->find(keyFor("c")));
+    EXPECT_TRUE(cache->find(keyFor("d")));
+    ResponseCacheStats stats = cache->stats();
+    EXPECT_EQ(stats.entries, 3u);
+    EXPECT_EQ(stats.evictions, 1u);
+    EXPECT_EQ(stats.bytes, options.maxBytes);
+
+    // A bigger body evicts as many entries as it needs.
+    cache->insert(keyFor("e"), std::string(250, 'y'));
+    stats = cache->stats();
+    EXPECT_LE(stats.bytes, options.maxBytes);
+    EXPECT_EQ(stats.entries, 2u);
+    EXPECT_EQ(*cache->find(keyFor("e")), std::string(250, 'y'));
+}
+
+TEST(ResponseCache, ReplacingAnEntryDoesNotChargeItTwice) {
+    ResponseCacheOptions options;
+    options.shards = 1;
+    auto cache = ResponseCache::create(options);
+    cache->insert(keyFor("a"), "old");
+    cache->insert(keyFor("a"), "new body");
+    EXPECT_EQ(*cache->find(keyFor("a")), "new body");
+    ResponseCacheStats stats = cache->stats();
+    EXPECT_EQ(stats.entries, 1u);
+    EXPECT_EQ(stats.bytes, 8 + kOverhead);
+
+    cache->invalidate(keyFor("a"));
+    EXPECT_FALSE(cache->find(keyFor("a")));
+    EXPECT_EQ(cache->stats().bytes, 0u);
+}
+
+TEST(ResponseCache, SkipsBodiesLargerThanAShard) {
+    ResponseCacheOptions options;
+    options.shards = 4;
+    options.maxBytes = 4 * 1024;
+    auto cache = ResponseCache::create(options);
+    cache->insert(keyFor("big"), std::string(2 * 1024, 'x'));
+    EXPECT_FALSE(cache->find(keyFor("big")));
+    EXPECT_EQ(cache->stats().insertions, 0u);
+}
+
+TEST(ResponseCache, ExpiresEntriesAfterTheTtl) {
+    ResponseCacheOptions options;
+    options.ttl = std::chrono::milliseconds(30);
+    auto cache = ResponseCache::create(options);
+    cache->insert(keyFor("a"), "body");
+    EXPECT_TRUE(cache->find(keyFor("a")));
+    std::this_thread::sleep_for(std::chrono::milliseconds(60));
+    EXPECT_FALSE(cache->find(keyFor("a")));
+    ResponseCacheStats stats = cache->stats();
+    EXPECT_EQ(stats.expirations, 1u);
+    EXPECT_EQ(stats.entries, 0u);
+    EXPECT_EQ(stats.hits, 1u);
+    EXPECT_EQ(stats.misses, 1u);
+
+    options.ttl = std::chrono::milliseconds(0);
+    auto unexpiring = ResponseCache::create(options);
+    unexpiring->insert(keyFor("a"), "body");
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    EXPECT_TRUE(unexpiring->find(keyFor("a"))) << "a zero TTL disables expiry";
+}
+
+TEST(ResponseCache, KeySeparatesEveryField) {
+    TempFile png("\x89PNG one");
+    TempFile otherPng("\x89PNG two");
+    TempFile samePng("\x89PNG one");
+
+    auto base = [] { return dto::AIQueryRequest("prompt", dto::AIProvider::OPENAI, "gpt-4"); };
+    std::vector<std::pair<std::string, ResponseCache::Key>> keys;
+    auto add = [&keys](const std::string& name, ResponseCache::Key key) { keys.emplace_back(name, key); };
+
+    add("base", ResponseCache::makeKey("/ai/query", base()));
+    add("endpoint", ResponseCache::makeKey("/ai/query/algorithm", base()));
+    add("format", ResponseCache::makeKey("/ai/query", base(), dto::WireFormat::CBOR));
+    add("msgpack", ResponseCache::makeKey("/ai/query", base(), dto::WireFormat::MSGPACK));
+    add("provider", ResponseCache::makeKey("/ai/query", dto::AIQueryRequest("prompt", dto::AIProvider::ANTHROPIC, "gpt-4")));
+    add("model", ResponseCache::makeKey("/ai/query", dto::AIQueryRequest("prompt", dto::AIProvider::OPENAI, "gpt-4o")));
+    add("prompt", ResponseCache::makeKey("/ai/query", dto::AIQueryRequest("prompt!", dto::AIProvider::OPENAI, "gpt-4")));
+
+    dto::Conversation conversation;
+    conversation.add(dto::Role::USER, "prompt");
+    dto::AIQueryRequest request = base();
+    request.setConversation(conversation);
+    add("conversation", ResponseCache::makeKey("/ai/query", request));
+    conversation.add(dto::Role::ASSISTANT, "answer");
+    request.setConversation(conversation);
+    add("longer conversation", ResponseCache::makeKey("/ai/query", request));
+    conversation = dto::Conversation();
+    conversation.add(dto::Role::ASSISTANT, "prompt");
+    request.setConversation(conversation);
+    add("other role", ResponseCache::makeKey("/ai/query", request));
+
+    // Field boundaries count: ("ab", "c") is not ("a", "bc").
+    request = base();
+    request.setImages({"ab", "c"});
+    add("images ab,c", ResponseCache::makeKey("/ai/query", request));
+    request.setImages({"a", "bc"});
+    add("images a,bc", ResponseCache::makeKey("/ai/query", request));
+
+    request = base();
+    request.attachImageFile(png.path);
+    add("image file", ResponseCache::makeKey("/ai/query", request));
+    ResponseCache::Key sameContent = [&] {
+        dto::AIQueryRequest same = base();
+        same.attachImageFile(samePng.path);
+        return ResponseCache::makeKey("/ai/query", same);
+    }();
+    request = base();
+    request.attachImageFile(otherPng.path);
+    add("other image file", ResponseCache::makeKey("/ai/query", request));
+    request.attachImageFile(png.path);
+    add("two image files", ResponseCache::makeKey("/ai/query", request));
+
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+        for (std::size_t j = i + 1; j < keys.size(); ++j) {
+            EXPECT_NE(keys[i].second, keys[j].second) << keys[i].first << " vs " << keys[j].first;
+        }
+    }
+    EXPECT_EQ(ResponseCache::makeKey("/ai/query", base()), keys[0].second) << "stable within the process";
+    EXPECT_EQ(sameContent, keys[keys.size() - 3].second) << "files are hashed by content, not path";
+}
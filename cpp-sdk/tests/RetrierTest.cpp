@@ -0,0 +1,206 @@
+#include <gtest/gtest.h>
+#include <sauron/client/Retrier.hpp>
+#include <chrono>
+#include <cstdlib>
+#include <ctime>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace sauron::client;
+
+namespace {
+
+using std::chrono::milliseconds;
+using std::chrono::seconds;
+
+// Options with a budget large enough never to get in the way.
+RetryOptions unlimitedOptions() {
+    RetryOptions options;
+    options.defaults.maxAttempts = 100;
+    options.budget.minRetriesPerSecond = 1e9;
+    options.budget.maxBalance = 1e9;
+    return options;
+}
+
+AttemptOutcome status(int statusCode, const std::vector<std::string>* headers = nullptr) {
+    AttemptOutcome outcome;
+    outcome.statusCode = statusCode;
+    outcome.headers = headers;
+    return outcome;
+}
+
+AttemptOutcome transportError(bool requestSent) {
+    AttemptOutcome outcome;
+    outcome.error = std::make_exception_ptr(TransportError("connection reset", requestSent));
+    return outcome;
+}
+
+// An HTTP-date the given number of seconds from now.
+std::string httpDate(long offsetSeconds) {
+    std::time_t at = std::time(nullptr) + offsetSeconds;
+    std::tm tm{};
+    gmtime_r(&at, &tm);
+    std::ostringstream out;
+    out.imbue(std::locale::classic());
+    out << std::put_time(&tm, "%a, %d %b %Y %H:%M:%S GMT");
+    return out.str();
+}
+
+} // namespace
+
+TEST(Retrier, FullJitterStaysUnderTheCappedExponential) {
+    RetryOptions options = unlimitedOptions();
+    options.defaults.baseDelay = milliseconds(100);
+    options.defaults.maxDelay = milliseconds(1000);
+    auto retrier = Retrier::create(options);
+    for (int attempt = 1; attempt <= 8; ++attempt) {
+        SCOPED_TRACE("attempt " + std::to_string(attempt));
+        long ceiling = std::min(1000L, 100L << (attempt - 1));
+        milliseconds lowest = milliseconds::max();
+        milliseconds highest{0};
+        for (int i = 0; i < 2000; ++i) {
+            std::optional<milliseconds> delay = retrier->retryDelay(Endpoint::Query, attempt, status(503));
+            ASSERT_TRUE(delay);
+            lowest = std::min(lowest, *delay);
+            highest = std::max(highest, *delay);
+        }
+        EXPECT_GE(lowest.count(), 0);
+        EXPECT_LE(highest.count(), ceiling);
+        // Spread over the whole range, not clustered near the ceiling.
+        EXPECT_LT(lowest.count(), ceiling / 10 + 1);
+        EXPECT_GT(highest.count(), ceiling * 9 / 10);
+    }
+}
+
+TEST(Retrier, GivesUpAfterMaxAttemptsOrOnceDataWasDelivered) {
+    RetryOptions options = unlimitedOptions();
+    options.defaults.maxAttempts = 3;
+    auto retrier = Retrier::create(options);
+    EXPECT_TRUE(retrier->retryDelay(Endpoint::Query, 2, status(503)));
+    EXPECT_FALSE(retrier->retryDelay(Endpoint::Query, 3, status(503)));
+    EXPECT_FALSE(retrier->retryDelay(Endpoint::Query, 1, status(404)));
+    AttemptOutcome delivered = transportError(true);
+    delivered.delivered = true;
+    EXPECT_FALSE(retrier->retryDelay(Endpoint::QueryStream, 1, delivered));
+}
+
+TEST(Retrier, ParsesRetryAfterDelaySeconds) {
+    EXPECT_EQ(Retrier::parseRetryAfter("120"), milliseconds(120000));
+    EXPECT_EQ(Retrier::parseRetryAfter(" \t5 "), milliseconds(5000));
+    EXPECT_EQ(Retrier::parseRetryAfter("0"), milliseconds(0));
+    EXPECT_EQ(Retrier::parseRetryAfter("12345678901234567890"), milliseconds::max());
+    EXPECT_FALSE(Retrier::parseRetryAfter(""));
+    EXPECT_FALSE(Retrier::parseRetryAfter("-1"));
+    EXPECT_FALSE(Retrier::parseRetryAfter("soon"));
+}
+
+TEST(Retrier, ParsesRetryAfterHttpDateAsUtc) {
+    // The date is GMT whatever the local time zone: timegm, not mktime.
+    const char* savedTz = std::getenv("TZ");
+    std::string saved = savedTz ? savedTz : "";
+    setenv("TZ", "America/New_York", 1);
+    tzset();
+
+    std::optional<milliseconds> delay = Retrier::parseRetryAfter(httpDate(30));
+    ASSERT_TRUE(delay) << httpDate(30);
+    EXPECT_GE(*delay, seconds(28));
+    EXPECT_LE(*delay, seconds(30));
+    EXPECT_EQ(Retrier::parseRetryAfter("Sun, 06 Nov 1994 08:49:37 GMT"), milliseconds(0));
+
+    if (savedTz) {
+        setenv("TZ", saved.c_str(), 1);
+    } else {
+        unsetenv("TZ");
+    }
+    tzset();
+}
+
+TEST(Retrier, HonorsRetryAfterUpToTheLimit) {
+    RetryOptions options = unlimitedOptions();
+    options.defaults.baseDelay = milliseconds(1);
+    options.defaults.maxRetryAfter = seconds(60);
+    auto retrier = Retrier::create(options);
+
+    std::vector<std::string> headers = {"Retry-After: 2"};
+    EXPECT_EQ(retrier->retryDelay(Endpoint::Query, 1, status(429, &headers)), milliseconds(2000));
+    headers = {"retry-after: " + httpDate(120)};
+    EXPECT_FALSE(retrier->retryDelay(Endpoint::Query, 1, status(429, &headers)));
+    headers = {"Retry-After: whenever"};
+    EXPECT_LE(retrier->retryDelay(Endpoint::Query, 1, status(429, &headers)), milliseconds(1));
+}
+
+TEST(Retrier, BudgetLimitsRetriesToAFractionOfRequests) {
+    RetryOptions options = unlimitedOptions();
+    options.budget.ratio = 0.5;
+    options.budget.minRetriesPerSecond = 0;
+    options.budget.maxBalance = 3;
+    auto retrier = Retrier::create(options);
+
+    EXPECT_FALSE(retrier->retryDelay(Endpoint::Query, 1, status(503))) << "nothing saved up yet";
+    for (int i = 0; i < 4; ++i) {
+        retrier->recordRequest();
+    }
+    EXPECT_TRUE(retrier->retryDelay(Endpoint::Query, 1, status(503)));
+    EXPECT_TRUE(retrier->retryDelay(Endpoint::Query, 1, status(503)));
+    EXPECT_FALSE(retrier->retryDelay(Endpoint::Query, 1, status(503)));
+
+    for (int i = 0; i < 100; ++i) {
+        retrier->recordRequest();
+    }
+    int granted = 0;
+    while (retrier->retryDelay(Endpoint::Query, 1, status(503))) {
+        ++granted;
+    }
+    EXPECT_EQ(granted, 3) << "capped at maxBalance";
+
+    RetryStats stats = retrier->stats();
+    EXPECT_EQ(stats.requests, 104u);
+    EXPECT_EQ(stats.retries, 5u);
+    EXPECT_EQ(stats.budgetExhausted, 3u);
+}
+
+TEST(Retrier, NeverRetriesLoginOrRefreshTheServerMayHaveProcessed) {
+    auto retrier = Retrier::create(unlimitedOptions());
+    for (Endpoint endpoint : {Endpoint::Login, Endpoint::RefreshToken}) {
+        EXPECT_FALSE(retrier->policy(endpoint).idempotent);
+        for (int statusCode : {408, 500, 502, 504}) {
+            EXPECT_FALSE(retrier->retryDelay(endpoint, 1, status(statusCode))) << statusCode;
+            EXPECT_TRUE(retrier->retryDelay(Endpoint::Query, 1, status(statusCode))) << statusCode;
+        }
+        EXPECT_FALSE(retrier->retryDelay(endpoint, 1, transportError(true)));
+        // Turned away, or never sent: nothing happened on the server.
+        EXPECT_TRUE(retrier->retryDelay(endpoint, 1, status(429)));
+        EXPECT_TRUE(retrier->retryDelay(endpoint, 1, status(503)));
+        EXPECT_TRUE(retrier->retryDelay(endpoint, 1, transportError(false)));
+    }
+
+    RetryOptions options = unlimitedOptions();
+    options.endpoints[Endpoint::Login] = options.defaults;
+    EXPECT_TRUE(Retrier::create(options)->policy(Endpoint::Login).idempotent) << "an explicit policy wins";
+}
+
+TEST(Retrier, RunRetriesUntilSuccess) {
+    RetryOptions options = unlimitedOptions();
+    options.defaults.baseDelay = milliseconds(1);
+    auto retrier = Retrier::create(options);
+
+    int attempts = 0;
+    int result = retrier->run(Endpoint::Query, [&] {
+        ++attempts;
+        if (attempts == 1) {
+            throw TransportError("connection refused");
+        }
+        return attempts == 2 ? 502 : 200;
+    });
+    EXPECT_EQ(result, 200);
+    EXPECT_EQ(attempts, 3);
+
+    attempts = 0;
+    EXPECT_THROW(retrier->run(Endpoint::Login, [&]() -> int {
+        ++attempts;
+        throw TransportError("connection reset", true);
+    }), TransportError);
+    EXPECT_EQ(attempts, 1);
+}
@@ -0,0 +1,141 @@
+#include <gtest/gtest.h>
+#include <sauron/client/SauronClient.hpp>
+#include <sauron/client/SocketHttpClient.hpp>
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace sauron;
+using namespace sauron::client;
+
+namespace {
+
+// A loopback server answering every request with the same canned response.
+class CannedServer {
+public:
+    explicit CannedServer(std::string response) : response_(std::move(response)) {
+        fd_ = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t length = sizeof(address);
+        if (::bind(fd_, reinterpret_cast<sockaddr*>(&address), length) != 0 || ::listen(fd_, 16) != 0 ||
+            ::getsockname(fd_, reinterpret_cast<sockaddr*>(&address), &length) != 0) {
+            throw std::runtime_error("cannot listen on loopback");
+        }
+        url_ = "http://127.0.0.1:" + std::to_string(ntohs(address.sin_port));
+        thread_ = std::thread([this] { serve(); });
+    }
+
+    ~CannedServer() {
+        ::shutdown(fd_, SHUT_RDWR);
+        ::close(fd_);
+        thread_.join();
+    }
+
+    const std::string& url() const { return url_; }
+
+private:
+    void serve() {
+        for (;;) {
+            int client = ::accept(fd_, nullptr, nullptr);
+            if (client < 0) {
+                return;
+            }
+            readRequest(client);
+            ::send(client, response_.data(), response_.size(), MSG_NOSIGNAL);
+            ::close(client);
+        }
+    }
+
+    // Reads the head and a Content-Length body.
+    static void readRequest(int client) {
+        std::string request;
+        char buffer[4096];
+        std::size_t headEnd = std::string::npos;
+        std::size_t total = SIZE_MAX;
+        while (request.size() < total) {
+            ssize_t n = ::recv(client, buffer, sizeof(buffer), 0);
+            if (n <= 0) {
+                return;
+            }
+            request.append(buffer, static_cast<std::size_t>(n));
+            if (headEnd == std::string::npos && (headEnd = request.find("\r\n\r\n")) != std::string::npos) {
+                std::string head = request.substr(0, headEnd);
+                std::transform(head.begin(), head.end(), head.begin(), ::tolower);
+                std::size_t at = head.find("content-length:");
+                total = headEnd + 4 + (at == std::string::npos ? 0 : std::strtoul(head.c_str() + at + 15, nullptr, 10));
+            }
+        }
+    }
+
+    int fd_ = -1;
+    std::string url_;
+    std::string response_;
+    std::thread thread_;
+};
+
+std::string httpResponse(const std::string& statusLine, const std::string& headers, const std::string& body) {
+    return "HTTP/1.1 " + statusLine + "\r\n" + headers + "Content-Length: " + std::to_string(body.size()) +
+           "\r\nConnection: close\r\n\r\n" + body;
+}
+
+std::unique_ptr<SauronClient> clientFor(const CannedServer& server) {
+    auto client = std::make_unique<SauronClient>(std::make_unique<SocketHttpClient>(server.url()));
+    client->setToken("token");
+    return client;
+}
+
+const dto::AIQueryRequest kRequest("prompt", dto::AIProvider::OPENAI);
+
+} // namespace
+
+TEST(SauronClient, StreamReportsTheServersErrorBody) {
+    CannedServer server(httpResponse("429 Too Many Requests",
+                                     "Content-Type: application/json\r\nRetry-After: 7\r\n",
+                                     "{\"error\":\"rate limited\"}"));
+    auto client = clientFor(server);
+
+    bool delivered = false;
+    try {
+        client->queryAlgorithmStream(kRequest, dto::AlgorithmStreamCallbacks());
+        FAIL() << "expected HttpStatusError";
+    } catch (const HttpStatusError& error) {
+        EXPECT_EQ(error.statusCode(), 429);
+        EXPECT_STREQ(error.what(), "rate limited");
+        std::string retryAfter;
+        EXPECT_TRUE(wire::findHeader(error.headers(), "Retry-After", retryAfter));
+        EXPECT_EQ(retryAfter, "7");
+    }
+
+    try {
+        client->queryStream(kRequest, [&](const std::string&, bool) {
+            delivered = true;
+            return true;
+        });
+        FAIL() << "expected HttpStatusError";
+    } catch (const HttpStatusError& error) {
+        EXPECT_EQ(error.statusCode(), 429);
+        EXPECT_STREQ(error.what(), "rate limited");
+    }
+    EXPECT_FALSE(delivered) << "an error body is not stream data";
+}
+
+TEST(SauronClient, StreamErrorWithoutAnErrorBodyReportsTheStatus) {
+    CannedServer server(httpResponse("502 Bad Gateway", "Content-Type: text/html\r\n", "<html>bad gateway</html>"));
+    auto client = clientFor(server);
+    try {
+        client->queryAlgorithmStream(kRequest, dto::AlgorithmStreamCallbacks());
+        FAIL() << "expected HttpStatusError";
+    } catch (const HttpStatusError& error) {
+        EXPECT_EQ(error.statusCode(), 502);
+        EXPECT_STREQ(error.what(), "Request failed with status code: 502");
+    }
+}
@@ -0,0 +1,138 @@
+#include <gtest/gtest.h>
+#include <sauron/client/SseDecoder.hpp>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace sauron::client;
+
+namespace {
+
+struct Event {
+    std::string event;
+    std::string data;
+    std::string id;
+    std::optional<std::uint32_t> retry;
+
+    bool operator==(const Event& other) const {
+        return event == other.event && data == other.data && id == other.id && retry == other.retry;
+    }
+};
+
+std::ostream& operator<<(std::ostream& out, const Event& event) {
+    return out << event.event << " [" << event.data << "] id=" << event.id;
+}
+
+// Decode a stream cut into chunks of the given sizes (cycled), then end it.
+std::vector<Event> decode(const std::string& stream, const std::vector<std::size_t>& sizes) {
+    std::vector<Event> events;
+    SseDecoder decoder;
+    auto onEvent = [&](const SseEvent& event) {
+        events.push_back(Event{std::string(event.event), std::string(event.data), std::string(event.id), event.retry});
+        return true;
+    };
+    std::size_t pos = 0;
+    for (std::size_t i = 0; pos < stream.size(); ++i) {
+        std::size_t size = std::min(stream.size() - pos, sizes[i % sizes.size()]);
+        EXPECT_TRUE(decoder.feed(std::string_view(stream).substr(pos, size), onEvent));
+        pos += size;
+    }
+    decoder.finish();
+    EXPECT_EQ(decoder.pendingSize(), 0u);
+    return events;
+}
+
+const std::string kStream =
+    ": comment\n"
+    "data: first\n"
+    "\n"
+    "event: delta\r\n"
+    "data: line one\r\n"
+    "data:line two\r\n"
+    "id: 42\r\n"
+    "\r\n"
+    "retry: 1500\r"
+    "data\r"
+    "\r"
+    "event: done\n"
+    "data: {\"ok\": true}\n"
+    "unknown: ignored\n"
+    "\n"
+    "data: dropped, the stream ends before the blank line\n";
+
+const std::vector<Event> kExpected = {
+    {"message", "first", "", std::nullopt},
+    {"delta", "line one\nline two", "42", std::nullopt},
+    {"message", "", "42", 1500u},
+    {"done", "{\"ok\": true}", "42", std::nullopt},
+};
+
+} // namespace
+
+TEST(SseDecoder, DecodesWholeStream) {
+    EXPECT_EQ(decode(kStream, {kStream.size()}), kExpected);
+}
+
+TEST(SseDecoder, SameEventsAtEverySplitPoint) {
+    for (std::size_t a = 0; a <= kStream.size(); ++a) {
+        for (std::size_t b = a; b <= kStream.size(); ++b) {
+            std::vector<Event> events;
+            SseDecoder decoder;
+            auto onEvent = [&](const SseEvent& event) {
+                events.push_back(Event{std::string(event.event), std::string(event.data), std::string(event.id), event.retry});
+                return true;
+            };
+            decoder.feed(std::string_view(kStream).substr(0, a), onEvent);
+            decoder.feed(std::string_view(kStream).substr(a, b - a), onEvent);
+            decoder.feed(std::string_view(kStream).substr(b), onEvent);
+            decoder.finish();
+            ASSERT_EQ(events, kExpected) << "split at " << a << " and " << b;
+        }
+    }
+}
+
+TEST(SseDecoder, SameEventsOnRandomSplits) {
+    std::mt19937 rng(1);
+    for (int round = 0; round < 2000; ++round) {
+        std::vector<std::size_t> sizes;
+        for (int i = 0; i < 8; ++i) {
+            sizes.push_back(1 + rng() % 12);
+        }
+        ASSERT_EQ(decode(kStream, sizes), kExpected);
+    }
+}
+
+TEST(SseDecoder, LargeEventInSmallReads) {
+    std::string payload(1 << 20, 'p');
+    std::string stream = "event: big\ndata: " + payload + "\ndata: " + payload + "\n\n";
+    std::vector<Event> events = decode(stream, {16});
+    ASSERT_EQ(events.size(), 1u);
+    EXPECT_EQ(events[0].event, "big");
+    EXPECT_EQ(events[0].data, payload + "\n" + payload);
+}
+
+TEST(SseDecoder, CallbackCanStop) {
+    SseDecoder decoder;
+    int calls = 0;
+    EXPECT_FALSE(decoder.feed("data: a\n\ndata: b\n\n", [&](const SseEvent&) {
+        ++calls;
+        return false;
+    }));
+    EXPECT_EQ(calls, 1);
+}
+
+TEST(SseDecoder, FinishForgetsTheStream) {
+    SseDecoder decoder;
+    std::vector<Event> events;
+    auto onEvent = [&](const SseEvent& event) {
+        events.push_back(Event{std::string(event.event), std::string(event.data), std::string(event.id), event.retry});
+        return true;
+    };
+    decoder.feed("id: 7\n\nevent: partial\ndata: unfinished\r", onEvent);
+    decoder.finish();
+    EXPECT_EQ(decoder.pendingSize(), 0u);
+    // A fresh stream: no last event ID, and a leading '\n' is an empty line.
+    decoder.feed("\ndata: next\n\n", onEvent);
+    ASSERT_EQ(events.size(), 1u);
+    EXPECT_EQ(events[0], (Event{"message", "next", "", std::nullopt}));
+}
@@ -0,0 +1,168 @@
+#include <gtest/gtest.h>
+#include <sauron/client/TokenRefresher.hpp>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace sauron;
+using namespace sauron::client;
+
+namespace {
+
+using std::chrono::milliseconds;
+using std::chrono::seconds;
+using SystemClock = std::chrono::system_clock;
+
+// An unsigned JWT expiring at the given time.
+std::string tokenExpiringAt(SystemClock::time_point at) {
+    long long exp = std::chrono::duration_cast<seconds>(at.time_since_epoch()).count();
+    return "e30." + util::base64::encode("{\"exp\":" + std::to_string(exp) + "}", util::base64::Alphabet::Url) +
+           ".signature";
+}
+
+// A refresh function recording when it runs; stores a token valid for an hour.
+class FakeRefresh {
+public:
+    explicit FakeRefresh(std::shared_ptr<TokenStore> store) : store_(std::move(store)) {}
+
+    TokenRefresher::RefreshFunction function() {
+        return [this] {
+            bool fail;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                calls_.push_back(SystemClock::now());
+                fail = failuresLeft_ > 0 && failuresLeft_-- > 0;
+            }
+            called_.notify_all();
+            if (fail) {
+                throw std::runtime_error("refresh failed");
+            }
+            store_->set(tokenExpiringAt(SystemClock::now() + std::chrono::hours(1)));
+        };
+    }
+
+    void failNext(int count) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        failuresLeft_ = count;
+    }
+
+    // Waits until the refresh ran this many times in total.
+    bool waitForCalls(std::size_t count, milliseconds timeout = milliseconds(5000)) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        return called_.wait_for(lock, timeout, [&] { return calls_.size() >= count; });
+    }
+
+    std::vector<SystemClock::time_point> calls() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return calls_;
+    }
+
+private:
+    std::shared_ptr<TokenStore> store_;
+    std::mutex mutex_;
+    std::condition_variable called_;
+    std::vector<SystemClock::time_point> calls_;
+    int failuresLeft_ = 0;
+};
+
+AutoRefreshOptions shortMargin() {
+    AutoRefreshOptions options;
+    options.margin = seconds(1);
+    options.retryInterval = seconds(1);
+    return options;
+}
+
+} // namespace
+
+TEST(TokenStore, SetPublishesANewSnapshot) {
+    TokenStore store;
+    EXPECT_EQ(store.get(), "");
+    EXPECT_TRUE(store.snapshot()->headers.empty());
+    std::shared_ptr<const TokenStore::Snapshot> before = store.snapshot();
+
+    store.set("abc");
+    EXPECT_EQ(store.get(), "abc");
+    EXPECT_EQ(store.snapshot()->headers, (std::vector<std::string>{"Authorization: Bearer abc"}));
+    EXPECT_EQ(before->token, "") << "readers keep the snapshot they took";
+
+    store.set("");
+    EXPECT_TRUE(store.snapshot()->headers.empty());
+}
+
+TEST(TokenRefresher, RefreshesTheMarginBeforeTheExpiry) {
+    auto store = std::make_shared<TokenStore>();
+    const SystemClock::time_point expiry = SystemClock::now() + seconds(2);
+    store->set(tokenExpiringAt(expiry));
+    FakeRefresh refresh(store);
+    TokenRefresher refresher(store, refresh.function(), shortMargin());
+
+    ASSERT_TRUE(refresh.waitForCalls(1));
+    const SystemClock::time_point at = refresh.calls()[0];
+    EXPECT_GE(at, std::chrono::time_point_cast<seconds>(expiry) - seconds(1));
+    EXPECT_LT(at, expiry);
+
+    // The new token is an hour away: nothing more to do.
+    std::this_thread::sleep_for(milliseconds(100));
+    EXPECT_EQ(refresh.calls().size(), 1u);
+}
+
+TEST(TokenRefresher, ReschedulesWhenTheTokenIsReplaced) {
+    auto store = std::make_shared<TokenStore>();
+    store->set(tokenExpiringAt(SystemClock::now() + std::chrono::hours(1)));
+    FakeRefresh refresh(store);
+    TokenRefresher refresher(store, refresh.function(), shortMargin());
+    std::this_thread::sleep_for(milliseconds(50));
+    EXPECT_TRUE(refresh.calls().empty());
+
+    // A login storing a token already inside the margin wakes the refresher at once.
+    const SystemClock::time_point replacedAt = SystemClock::now();
+    store->set(tokenExpiringAt(replacedAt));
+    ASSERT_TRUE(refresh.waitForCalls(1, milliseconds(500))) << "not woken by the version bump";
+    EXPECT_LT(refresh.calls()[0] - replacedAt, milliseconds(500));
+
+    // Logging out leaves nothing to refresh.
+    store->set("");
+    std::this_thread::sleep_for(milliseconds(50));
+    EXPECT_EQ(refresh.calls().size(), 1u);
+}
+
+TEST(TokenRefresher, RetriesAFailedRefreshAfterTheRetryInterval) {
+    auto store = std::make_shared<TokenStore>();
+    store->set(tokenExpiringAt(SystemClock::now()));
+    FakeRefresh refresh(store);
+    refresh.failNext(1);
+    std::vector<std::string> errors;
+    AutoRefreshOptions options = shortMargin();
+    options.onError = [&errors](std::exception_ptr error) {
+        try {
+            std::rethrow_exception(error);
+        } catch (const std::exception& e) {
+            errors.push_back(e.what());
+        }
+    };
+    TokenRefresher refresher(store, refresh.function(), options);
+
+    ASSERT_TRUE(refresh.waitForCalls(2));
+    std::vector<SystemClock::time_point> calls = refresh.calls();
+    EXPECT_GE(calls[1] - calls[0], milliseconds(900));
+    refresher.stop();
+    EXPECT_EQ(errors, (std::vector<std::string>{"refresh failed"}));
+}
+
+TEST(TokenRefresher, LeavesTokensWithoutExpiryAlone) {
+    auto store = std::make_shared<TokenStore>();
+    store->set("opaque-token");
+    FakeRefresh refresh(store);
+    auto started = std::chrono::steady_clock::now();
+    {
+        TokenRefresher refresher(store, refresh.function(), shortMargin());
+        std::this_thread::sleep_for(milliseconds(50));
+    }
+    EXPECT_LT(std::chrono::steady_clock::now() - started, seconds(1)) << "stop() wakes the waiting thread";
+    EXPECT_TRUE(refresh.calls().empty());
+}
@@ -0,0 +1,158 @@
+#include <gtest/gtest.h>
+#include <sauron/dto/DTOs.hpp>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace sauron;
+using namespace sauron::dto;
+
+namespace {
+
+const WireFormat kBinaryFormats[] = {WireFormat::CBOR, WireFormat::MSGPACK};
+
+const char* formatName(WireFormat format) { return WireFormatToContentType(format); }
+
+std::string randomBytes(std::mt19937& rng, std::size_t size) {
+    std::string bytes(size, '\0');
+    for (char& c : bytes) {
+        c = static_cast<char>(rng() & 0xFF);
+    }
+    return bytes;
+}
+
+nlohmann::json::binary_t binary(const std::string& bytes) {
+    return nlohmann::json::binary_t(std::vector<std::uint8_t>(bytes.begin(), bytes.end()));
+}
+
+// The reference encoding of a document, straight from nlohmann.
+std::string referenceEncoding(const nlohmann::json& json, WireFormat format) {
+    std::vector<std::uint8_t> bytes =
+        format == WireFormat::CBOR ? nlohmann::json::to_cbor(json) : nlohmann::json::to_msgpack(json);
+    return std::string(bytes.begin(), bytes.end());
+}
+
+// A file removed when the test ends.
+struct TempFile {
+    std::string path;
+
+    explicit TempFile(const std::string& contents) {
+        char name[] = "/tmp/sauron-wire-test-XXXXXX";
+        int fd = mkstemp(name);
+        path = name;
+        std::FILE* file = fdopen(fd, "wb");
+        std::fwrite(contents.data(), 1, contents.size(), file);
+        std::fclose(file);
+    }
+
+    ~TempFile() { std::remove(path.c_str()); }
+};
+
+} // namespace
+
+TEST(WireFormat, RequestMatchesTheReferenceEncoder) {
+    std::mt19937 rng(19);
+    // Image and text sizes on both sides of every CBOR and MessagePack length boundary.
+    const std::size_t sizes[] = {0, 1, 23, 24, 31, 32, 255, 256, 65535, 65536, 100000};
+    for (WireFormat format : kBinaryFormats) {
+        for (std::size_t size : sizes) {
+            SCOPED_TRACE(std::string(formatName(format)) + ", " + std::to_string(size) + " bytes");
+            const std::string image = randomBytes(rng, size);
+            const std::string prompt(size, 'p');
+            AIQueryRequest request(prompt, AIProvider::ANTHROPIC, "claude",
+                                   {util::base64::encode(image), "data:image/png;base64,AAAA"});
+
+            nlohmann::json expected;
+            expected["images"] = {binary(image), "data:image/png;base64,AAAA"};
+            expected["model"] = "claude";
+            expected["prompt"] = prompt;
+            expected["provider"] = AIProviderToString(AIProvider::ANTHROPIC);
+
+            std::string encoded;
+            request.write(format, encoded);
+            EXPECT_EQ(encoded, referenceEncoding(expected, format));
+
+            AIQueryRequest decoded = AIQueryRequest::fromBinary(encoded, format);
+            EXPECT_EQ(decoded.getPrompt(), prompt);
+            EXPECT_EQ(decoded.getModel(), "claude");
+            EXPECT_EQ(decoded.getProvider(), AIProvider::ANTHROPIC);
+            ASSERT_EQ(decoded.getImages().size(), 2u);
+            EXPECT_EQ(util::base64::decode(decoded.getImages()[0]), image) << "raw bytes survive";
+            EXPECT_EQ(decoded.getImages()[1], "data:image/png;base64,AAAA");
+        }
+    }
+
+    Conversation conversation;
+    conversation.add(Role::USER, "question");
+    conversation.add(Role::ASSISTANT, "answer");
+    AIQueryRequest request("", AIProvider::OPENAI, "gpt-4o");
+    request.setConversation(conversation);
+    nlohmann::json expected = {{"model", "gpt-4o"}, {"prompt", conversation.render()}, {"provider", "openai"}};
+    for (WireFormat format : kBinaryFormats) {
+        std::string encoded;
+        request.write(format, encoded);
+        EXPECT_EQ(encoded, referenceEncoding(expected, format)) << formatName(format) << ", conversation";
+    }
+}
+
+TEST(WireFormat, AttachedImageFilesTravelAsRawBytes) {
+    std::mt19937 rng(7);
+    const std::string first = randomBytes(rng, 70000);
+    const std::string second = randomBytes(rng, 3);
+    TempFile firstFile(first);
+    TempFile secondFile(second);
+    const std::string inlined = randomBytes(rng, 40);
+
+    AIQueryRequest request("describe", AIProvider::OPENAI, "gpt-4o");
+    request.setImages({util::base64::encode(inlined)});
+    request.attachImageFile(firstFile.path);
+    request.attachImageFile(secondFile.path);
+
+    nlohmann::json expected;
+    expected["images"] = {binary(inlined), binary(first), binary(second)};
+    expected["model"] = "gpt-4o";
+    expected["prompt"] = "describe";
+    expected["provider"] = AIProviderToString(AIProvider::OPENAI);
+
+    for (WireFormat format : kBinaryFormats) {
+        SCOPED_TRACE(formatName(format));
+        std::string encoded;
+        request.write(format, encoded);
+        EXPECT_EQ(encoded, referenceEncoding(expected, format));
+
+        std::string streamed;
+        request.openBodyStream(format)->readAll(streamed);
+        EXPECT_EQ(streamed, encoded) << "the streamed body has the same bytes";
+
+        nlohmann::json decoded = decodeWireFormat(encoded, format);
+        ASSERT_EQ(decoded["images"].size(), 3u);
+        EXPECT_EQ(decoded["images"][1].get_binary(), binary(first));
+        EXPECT_EQ(decoded["images"][2].get_binary(), binary(second));
+    }
+}
+
+TEST(WireFormat, ResponsesRoundTrip) {
+    const std::string longText(70000, 'r');
+    AIAlgorithmResponse algorithm("explanation \xE2\x9C\x93", longText,
+                                  AlgorithmComplexity(ComplexityInfo("O(n)", "one pass"),
+                                                      ComplexityInfo("O(1)", "")));
+    AIQueryResponse query(longText);
+    for (WireFormat format : kBinaryFormats) {
+        SCOPED_TRACE(formatName(format));
+        std::string encoded;
+        algorithm.write(format, encoded);
+        EXPECT_EQ(encoded, referenceEncoding(algorithm.toJson(), format));
+        AIAlgorithmResponse parsed = AIAlgorithmResponse::parse(encoded, format);
+        EXPECT_EQ(parsed.toJson(), algorithm.toJson());
+
+        query.write(format, encoded);
+        EXPECT_EQ(encoded, referenceEncoding(query.toJson(), format));
+        EXPECT_EQ(AIQueryResponse::parse(encoded, format).getResponse(), longText);
+
+        // What a server encodes with any conforming library parses the same.
+        nlohmann::json server = {{"response", "short"}, {"extra", {1, 2, 3}}};
+        EXPECT_EQ(AIQueryResponse::parse(referenceEncoding(server, format), format).getResponse(), "short");
+    }
+}
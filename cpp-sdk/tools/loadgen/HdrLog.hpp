@@ -0,0 +1,169 @@
+#pragma once
+
+#include <sauron/util/Base64.hpp>
+#include <sauron/util/HdrHistogram.hpp>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <zlib.h>
+
+namespace sauron {
+namespace loadgen {
+
+/**
+ * @brief Writes HdrHistogram interval logs (format version 1.3)
+ *
+ * Each line holds one interval's histogram in the compressed V2 encoding,
+ * so the file can be read by HistogramLogProcessor, HistogramLogAnalyzer or
+ * any other HdrHistogram log reader. Values are microseconds; interval
+ * maxima are written in milliseconds.
+ *
+ * The SDK's histograms keep 64 sub-buckets per power of two. They are
+ * re-encoded as histograms with 2 significant digits, each bucket's count
+ * placed at the highest value of the bucket.
+ */
+class HdrLogWriter {
+public:
+    /**
+     * @brief Constructor
+     *
+     * @param out Stream receiving the log
+     * @param start Time the intervals are measured from
+     */
+    HdrLogWriter(std::ostream& out, std::chrono::system_clock::time_point start) : out_(out), start_(start) {}
+
+    /**
+     * @brief Write the format, start time and column legend
+     */
+    void writeHeader() {
+        double seconds = std::chrono::duration<double>(start_.time_since_epoch()).count();
+        char line[128];
+        std::snprintf(line, sizeof(line), "#[StartTime: %.3f (seconds since epoch)]\n", seconds);
+        out_ << "#[Histogram log format version 1.3]\n" << line
+             << "\"StartTimestamp\",\"Interval_Length\",\"Interval_Max\",\"Interval_Compressed_Histogram\"\n";
+    }
+
+    /**
+     * @brief Write one interval
+     *
+     * @param tag Tag of the line, e.g. the operation; empty for none
+     * @param intervalStart Start of the interval, relative to the start time
+     * @param intervalLength Length of the interval
+     * @param histogram Values recorded during the interval, in microseconds
+     */
+    void writeInterval(const std::string& tag, std::chrono::duration<double> intervalStart,
+                       std::chrono::duration<double> intervalLength, const util::HistogramSnapshot& histogram) {
+        char numbers[96];
+        std::snprintf(numbers, sizeof(numbers), "%.3f,%.3f,%.3f,", intervalStart.count(), intervalLength.count(),
+                      static_cast<double>(histogram.max()) / 1000.0);
+        if (!tag.empty()) {
+            out_ << "Tag=" << tag << ",";
+        }
+        out_ << numbers << encodeCompressed(histogram) << "\n";
+    }
+
+    /**
+     * @brief Base64 of the compressed V2 encoding of a histogram
+     *
+     * @throws std::runtime_error if compression fails
+     */
+    static std::string encodeCompressed(const util::HistogramSnapshot& histogram) {
+        std::vector<std::uint8_t> plain = encode(histogram);
+        uLongf size = compressBound(static_cast<uLong>(plain.size()));
+        std::vector<std::uint8_t> packed(8 + size);
+        if (compress2(packed.data() + 8, &size, plain.data(), static_cast<uLong>(plain.size()), Z_BEST_SPEED) != Z_OK) {
+            throw std::runtime_error("Failed to compress histogram");
+        }
+        packed.resize(8 + size);
+        putInt(packed.data(), kCompressedCookie);
+        putInt(packed.data() + 4, static_cast<std::uint32_t>(size));
+        return util::base64::encode(std::string_view(reinterpret_cast<const char*>(packed.data()), packed.size()));
+    }
+
+private:
+    static constexpr std::uint32_t kCookie = 0x1c849303 | 0x10;
+    static constexpr std::uint32_t kCompressedCookie = 0x1c849304 | 0x10;
+    static constexpr int kSignificantDigits = 2;       ///< 256 sub-buckets, 128 per half
+    static constexpr int kSubBucketHalfCountMagnitude = 7;
+    static constexpr std::uint64_t kHighestTrackable = util::HdrLayout::kMaxValue;
+
+    /// Counts index of a value in a 2-significant-digit histogram whose lowest value is 1.
+    static std::size_t indexOf(std::uint64_t value) {
+        int bucket = 56 - __builtin_clzll(value | 255);
+        std::uint64_t sub = value >> bucket;
+        return (static_cast<std::size_t>(bucket + 1) << kSubBucketHalfCountMagnitude) +
+               static_cast<std::size_t>(sub) - (std::size_t(1) << kSubBucketHalfCountMagnitude);
+    }
+
+    static std::vector<std::uint8_t> encode(const util::HistogramSnapshot& histogram) {
+        std::vector<std::int64_t> counts;
+        const std::vector<std::uint64_t>& buckets = histogram.counts();
+        for (std::size_t bucket = 0; bucket < buckets.size(); ++bucket) {
+            if (buckets[bucket] == 0) {
+                continue;
+            }
+            std::size_t index = indexOf(util::HdrLayout::highestIn(bucket));
+            if (counts.size() <= index) {
+                counts.resize(index + 1, 0);
+            }
+            counts[index] += static_cast<std::int64_t>(buckets[bucket]);
+        }
+
+        std::vector<std::uint8_t> out(40);
+        putInt(&out[0], kCookie);
+        putInt(&out[8], 0); // normalizing index offset
+        putInt(&out[12], kSignificantDigits);
+        putLong(&out[16], 1); // lowest discernible value
+        putLong(&out[24], kHighestTrackable);
+        double ratio = 1.0; // integer to double conversion ratio
+        std::uint64_t ratioBits;
+        std::memcpy(&ratioBits, &ratio, sizeof(ratioBits));
+        putLong(&out[32], ratioBits);
+
+        // Counts as ZigZag LEB128; a run of zeros is written as its negated length.
+        for (std::size_t i = 0; i < counts.size();) {
+            std::int64_t value = counts[i++];
+            if (value == 0) {
+                std::int64_t zeros = 1;
+                while (i < counts.size() && counts[i] == 0) {
+                    ++zeros;
+                    ++i;
+                }
+                value = zeros > 1 ? -zeros : 0;
+            }
+            std::uint64_t zigzag = (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63);
+            do {
+                std::uint8_t byte = zigzag & 0x7F;
+                zigzag >>= 7;
+                out.push_back(zigzag ? byte | 0x80 : byte);
+            } while (zigzag);
+        }
+        putInt(&out[4], static_cast<std::uint32_t>(out.size() - 40));
+        return out;
+    }
+
+    static void putInt(std::uint8_t* at, std::uint32_t value) {
+        for (int i = 3; i >= 0; --i) {
+            at[i] = static_cast<std::uint8_t>(value);
+            value >>= 8;
+        }
+    }
+
+    static void putLong(std::uint8_t* at, std::uint64_t value) {
+        for (int i = 7; i >= 0; --i) {
+            at[i] = static_cast<std::uint8_t>(value);
+            value >>= 8;
+        }
+    }
+
+    std::ostream& out_;
+    std::chrono::system_clock::time_point start_;
+};
+
+} // namespace loadgen
+} // namespace sauron
@@ -0,0 +1,455 @@
+#include "HdrLog.hpp"
+#include <sauron/Sauron.hpp>
+#include <sauron/client/DefaultHttpClient.hpp>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace sauron;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+enum Operation { Query, Algorithm, Stream, OperationCount };
+
+const char* const kOperationNames[OperationCount] = {"query", "algorithm", "stream"};
+
+struct Options {
+    std::string url = "http://127.0.0.1:3000";
+    std::string token;
+    std::string apiKey = "loadgen";
+    dto::AIProvider provider = dto::AIProvider::OPENAI;
+    std::string model;
+    std::string prompt = "Explain merge sort in one paragraph.";
+    std::string profile = "constant";
+    double rate = 100;
+    double rampTo = 0;
+    std::chrono::duration<double> duration{30};
+    std::chrono::duration<double> warmup{0};
+    std::chrono::duration<double> interval{1};
+    std::chrono::duration<double> drainTimeout{30};
+    std::array<double, OperationCount> mix{1, 0, 0};
+    std::size_t connections = 1024;
+    std::size_t maxInFlight = 100000;
+    std::string histLog;
+    std::uint64_t seed = std::random_device{}();
+};
+
+void usage(const char* program) {
+    std::cerr
+        << "Usage: " << program << " [options]\n"
+        << "\n"
+        << "Open-loop load generator: requests are sent on a schedule that does not wait for\n"
+        << "responses, and latency is measured from the scheduled start, so a stalled server\n"
+        << "shows up in the tail instead of silently lowering the request rate.\n"
+        << "\n"
+        << "  --url URL             Server (default http://127.0.0.1:3000)\n"
+        << "  --token JWT           Use this token instead of logging in\n"
+        << "  --api-key KEY         API key to log in with (default \"loadgen\")\n"
+        << "  --provider NAME       openai, anthropic, google, mistral or custom (default openai)\n"
+        << "  --model NAME          Model to request\n"
+        << "  --prompt TEXT         Prompt of every request\n"
+        << "  --profile NAME        constant, ramp or poisson (default constant)\n"
+        << "  --rate N              Requests per second; the starting rate of a ramp (default 100)\n"
+        << "  --ramp-to N           Rate at the end of a ramp\n"
+        << "  --duration S          Seconds of load, warmup included (default 30)\n"
+        << "  --warmup S            Seconds of load left out of the results (default 0)\n"
+        << "  --mix SPEC            Weights, e.g. query=8,algorithm=1,stream=1 (default query=1)\n"
+        << "  --connections N       Connection limit of the transport (default 1024)\n"
+        << "  --max-in-flight N     Requests outstanding before new ones are dropped (default 100000)\n"
+        << "  --interval S          Length of histogram log intervals (default 1)\n"
+        << "  --hist-log FILE       Write an HdrHistogram interval log (values in microseconds)\n"
+        << "  --drain-timeout S     Seconds to wait for outstanding requests at the end (default 30)\n"
+        << "  --seed N              Seed for the Poisson schedule and the mix\n";
+}
+
+void parseMix(const std::string& spec, std::array<double, OperationCount>& mix) {
+    mix.fill(0);
+    std::stringstream in(spec);
+    std::string item;
+    while (std::getline(in, item, ',')) {
+        std::size_t eq = item.find('=');
+        std::string name = item.substr(0, eq);
+        double weight = eq == std::string::npos ? 1 : std::stod(item.substr(eq + 1));
+        auto it = std::find(std::begin(kOperationNames), std::end(kOperationNames), name);
+        if (it == std::end(kOperationNames) || weight < 0) {
+            throw std::invalid_argument("unknown operation " + name);
+        }
+        mix[static_cast<std::size_t>(it - std::begin(kOperationNames))] = weight;
+    }
+    if (mix[Query] + mix[Algorithm] + mix[Stream] <= 0) {
+        throw std::invalid_argument("the mix needs a positive weight");
+    }
+}
+
+bool parseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h" || i + 1 >= argc) {
+            return false;
+        }
+        std::string value = argv[++i];
+        auto seconds = [&] { return std::chrono::duration<double>(std::stod(value)); };
+        if (arg == "--url") {
+            options.url = value;
+        } else if (arg == "--token") {
+            options.token = value;
+        } else if (arg == "--api-key") {
+            options.apiKey = value;
+        } else if (arg == "--provider") {
+            options.provider = dto::toAIProvider(value);
+        } else if (arg == "--model") {
+            options.model = value;
+        } else if (arg == "--prompt") {
+            options.prompt = value;
+        } else if (arg == "--profile") {
+            if (value != "constant" && value != "ramp" && value != "poisson") {
+                throw std::invalid_argument("unknown profile " + value);
+            }
+            options.profile = value;
+        } else if (arg == "--rate") {
+            options.rate = std::stod(value);
+        } else if (arg == "--ramp-to") {
+            options.rampTo = std::stod(value);
+        } else if (arg == "--duration") {
+            options.duration = seconds();
+        } else if (arg == "--warmup") {
+            options.warmup = seconds();
+        } else if (arg == "--interval") {
+            options.interval = seconds();
+        } else if (arg == "--drain-timeout") {
+            options.drainTimeout = seconds();
+        } else if (arg == "--mix") {
+            parseMix(value, options.mix);
+        } else if (arg == "--connections") {
+            options.connections = std::stoul(value);
+        } else if (arg == "--max-in-flight") {
+            options.maxInFlight = std::stoul(value);
+        } else if (arg == "--hist-log") {
+            options.histLog = value;
+        } else if (arg == "--seed") {
+            options.seed = std::stoull(value);
+        } else {
+            return false;
+        }
+    }
+    if (options.rate <= 0 || (options.profile == "ramp" && options.rampTo <= 0) || options.interval.count() <= 0) {
+        throw std::invalid_argument("rates and the interval must be positive");
+    }
+    return true;
+}
+
+/**
+ * Intended start times of the requests, independent of when responses arrive.
+ */
+class Schedule {
+public:
+    explicit Schedule(const Options& options) : options_(options), random_(options.seed) {}
+
+    /// Time after `elapsed` at which the next request is due.
+    std::chrono::duration<double> next(std::chrono::duration<double> elapsed) {
+        double rate = options_.rate;
+        if (options_.profile == "ramp") {
+            double progress = std::min(1.0, elapsed.count() / options_.duration.count());
+            rate = options_.rate + (options_.rampTo - options_.rate) * progress;
+        }
+        if (options_.profile == "poisson") {
+            return elapsed + std::chrono::duration<double>(std::exponential_distribution<double>(rate)(random_));
+        }
+        return elapsed + std::chrono::duration<double>(1.0 / rate);
+    }
+
+    Operation pick() {
+        std::discrete_distribution<int> choose(options_.mix.begin(), options_.mix.end());
+        return static_cast<Operation>(choose(random_));
+    }
+
+private:
+    const Options& options_;
+    std::mt19937_64 random_;
+};
+
+/**
+ * Latencies per operation. Response time runs from the intended start
+ * (corrected for coordinated omission); service time from the moment the
+ * request was handed to the client, which is later when the sender fell
+ * behind schedule.
+ */
+class Recorder {
+public:
+    struct Totals {
+        util::HistogramSnapshot responseTime;
+        util::HistogramSnapshot serviceTime;
+        std::uint64_t errors = 0;
+    };
+
+    Recorder() {
+        for (auto& interval : intervals_) {
+            interval = std::make_unique<util::HdrHistogram>();
+        }
+    }
+
+    void record(Operation op, Clock::duration responseTime, Clock::duration serviceTime, bool failed) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (failed) {
+            ++totals_[op].errors;
+            return;
+        }
+        intervals_[op]->record(micros(responseTime));
+        service_[op].record(micros(serviceTime));
+    }
+
+    /// Takes the histograms recorded since the previous call and adds them to the totals.
+    std::array<util::HistogramSnapshot, OperationCount> takeInterval() {
+        std::array<std::unique_ptr<util::HdrHistogram>, OperationCount> taken;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (std::size_t op = 0; op < OperationCount; ++op) {
+                taken[op] = std::move(intervals_[op]);
+                intervals_[op] = std::make_unique<util::HdrHistogram>();
+            }
+        }
+        std::array<util::HistogramSnapshot, OperationCount> snapshots;
+        for (std::size_t op = 0; op < OperationCount; ++op) {
+            taken[op]->snapshotInto(snapshots[op]);
+            std::lock_guard<std::mutex> lock(mutex_);
+            totals_[op].responseTime.merge(snapshots[op]);
+        }
+        return snapshots;
+    }
+
+    std::array<Totals, OperationCount> totals() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::array<Totals, OperationCount> totals = totals_;
+        for (std::size_t op = 0; op < OperationCount; ++op) {
+            totals[op].serviceTime = util::HistogramSnapshot();
+            service_[op].snapshotInto(totals[op].serviceTime);
+        }
+        return totals;
+    }
+
+private:
+    static std::uint64_t micros(Clock::duration duration) {
+        auto us = std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+        return us < 0 ? 0 : static_cast<std::uint64_t>(us);
+    }
+
+    std::mutex mutex_;
+    std::array<std::unique_ptr<util::HdrHistogram>, OperationCount> intervals_;
+    std::array<util::HdrHistogram, OperationCount> service_;
+    std::array<Totals, OperationCount> totals_;
+};
+
+void printTable(const char* title, const std::array<Recorder::Totals, OperationCount>& totals,
+                util::HistogramSnapshot Recorder::Totals::*histogram, double seconds) {
+    std::printf("\n%s (ms)\n", title);
+    std::printf("%-10s %10s %8s %10s %9s %9s %9s %9s %9s %9s\n", "operation", "count", "errors", "rate/s", "p50",
+                "p90", "p99", "p99.9", "p99.99", "max");
+    util::HistogramSnapshot all;
+    std::uint64_t errors = 0;
+    auto row = [&](const char* name, const util::HistogramSnapshot& h, std::uint64_t failed) {
+        auto ms = [&](double q) { return static_cast<double>(h.valueAtQuantile(q)) / 1000.0; };
+        std::printf("%-10s %10llu %8llu %10.1f %9.3f %9.3f %9.3f %9.3f %9.3f %9.3f\n", name,
+                    static_cast<unsigned long long>(h.count()), static_cast<unsigned long long>(failed),
+                    static_cast<double>(h.count() + failed) / seconds, ms(0.5), ms(0.9), ms(0.99), ms(0.999),
+                    ms(0.9999), static_cast<double>(h.max()) / 1000.0);
+    };
+    for (std::size_t op = 0; op < OperationCount; ++op) {
+        const util::HistogramSnapshot& h = totals[op].*histogram;
+        if (h.count() + totals[op].errors == 0) {
+            continue;
+        }
+        row(kOperationNames[op], h, totals[op].errors);
+        all.merge(h);
+        errors += totals[op].errors;
+    }
+    row("all", all, errors);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    try {
+        if (!parseOptions(argc, argv, options)) {
+            usage(argv[0]);
+            return 2;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Invalid arguments: " << e.what() << "\n";
+        return 2;
+    }
+
+    // Declared before the client: requests it cancels on destruction still report here.
+    Recorder recorder;
+    std::atomic<std::size_t> inFlight{0};
+    std::atomic<std::uint64_t> sent{0};
+    std::atomic<std::uint64_t> completed{0};
+    std::atomic<std::uint64_t> dropped{0};
+    std::mutex drainMutex;
+    std::condition_variable drained;
+
+    client::ConnectionPoolOptions pool = client::EpollHttpClient::defaultOptions();
+    pool.maxConnectionsPerHost = options.connections;
+    client::SauronClient sauron(client::HttpClient::create(options.url),
+                                std::make_unique<client::EpollHttpClient>(options.url, pool));
+    try {
+        if (options.token.empty()) {
+            sauron.login(dto::LoginRequest(options.apiKey, options.provider));
+        } else {
+            sauron.setToken(options.token);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Login failed: " << e.what() << "\n";
+        return 1;
+    }
+    dto::AIQueryRequest request(options.prompt, options.provider, options.model);
+
+    std::ofstream logFile;
+    std::unique_ptr<loadgen::HdrLogWriter> log;
+    if (!options.histLog.empty()) {
+        logFile.open(options.histLog);
+        if (!logFile) {
+            std::cerr << "Cannot write " << options.histLog << "\n";
+            return 1;
+        }
+        log = std::make_unique<loadgen::HdrLogWriter>(logFile, std::chrono::system_clock::now());
+        log->writeHeader();
+    }
+
+    const Clock::time_point start = Clock::now();
+    const Clock::time_point measureFrom = start + std::chrono::duration_cast<Clock::duration>(options.warmup);
+    const Clock::time_point end = start + std::chrono::duration_cast<Clock::duration>(options.duration);
+
+    auto launch = [&](Operation op, Clock::time_point intended) {
+        bool measured = intended >= measureFrom;
+        Clock::time_point sentAt = Clock::now();
+        inFlight.fetch_add(1);
+        sent.fetch_add(1, std::memory_order_relaxed);
+        auto done = [&, op, intended, sentAt, measured](bool failed) {
+            Clock::time_point now = Clock::now();
+            if (measured) {
+                recorder.record(op, now - intended, now - sentAt, failed);
+            }
+            completed.fetch_add(1, std::memory_order_relaxed);
+            if (inFlight.fetch_sub(1) == 1) {
+                std::lock_guard<std::mutex> lock(drainMutex);
+                drained.notify_all();
+            }
+        };
+        try {
+            switch (op) {
+            case Query:
+                sauron.queryAsync(request, [done](dto::AIQueryResponse, std::exception_ptr error) { done(!!error); });
+                break;
+            case Algorithm:
+                sauron.queryAlgorithmAsync(request,
+                    [done](dto::AIAlgorithmResponse, std::exception_ptr error) { done(!!error); });
+                break;
+            case Stream:
+                sauron.queryStreamAsync(request, [](const std::string&, bool) { return true; },
+                    [done](bool, std::exception_ptr error) { done(!!error); });
+                break;
+            case OperationCount:
+                break;
+            }
+        } catch (const std::exception&) {
+            done(true);
+        }
+    };
+
+    // Writes histogram log intervals and a progress line until the load ends.
+    std::atomic<bool> loading{true};
+    auto reportInterval = [&](Clock::time_point from, Clock::time_point to) {
+        std::array<util::HistogramSnapshot, OperationCount> interval = recorder.takeInterval();
+        util::HistogramSnapshot all;
+        for (std::size_t op = 0; op < OperationCount; ++op) {
+            all.merge(interval[op]);
+            if (log && interval[op].count() > 0) {
+                log->writeInterval(kOperationNames[op], from - start, to - from, interval[op]);
+            }
+        }
+        if (log) {
+            log->writeInterval("", from - start, to - from, all);
+            logFile.flush();
+        }
+        std::fprintf(stderr, "%6.1fs  sent %llu  completed %llu  in flight %zu  p99 %.3f ms  max %.3f ms\n",
+                     std::chrono::duration<double>(to - start).count(),
+                     static_cast<unsigned long long>(sent.load()), static_cast<unsigned long long>(completed.load()),
+                     inFlight.load(), static_cast<double>(all.valueAtQuantile(0.99)) / 1000.0,
+                     static_cast<double>(all.max()) / 1000.0);
+    };
+    std::thread reporter([&] {
+        Clock::time_point from = start;
+        const auto step = std::chrono::duration_cast<Clock::duration>(options.interval);
+        std::unique_lock<std::mutex> lock(drainMutex);
+        while (loading.load()) {
+            Clock::time_point to = from + step;
+            drained.wait_until(lock, to, [&] { return !loading.load(); });
+            if (!loading.load()) {
+                break;
+            }
+            lock.unlock();
+            reportInterval(from, to);
+            from = to;
+            lock.lock();
+        }
+        lock.unlock();
+        reportInterval(from, Clock::now());
+    });
+
+    Schedule schedule(options);
+    std::chrono::duration<double> due{0};
+    for (Clock::time_point intended = start; intended < end;
+         due = schedule.next(due), intended = start + std::chrono::duration_cast<Clock::duration>(due)) {
+        // Never wait for responses: a late request is sent at once, and its
+        // latency still counts from when it was due.
+        std::this_thread::sleep_until(intended);
+        Operation op = schedule.pick();
+        if (inFlight.load() >= options.maxInFlight) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            if (intended >= measureFrom) {
+                recorder.record(op, Clock::duration(), Clock::duration(), true);
+            }
+            continue;
+        }
+        launch(op, intended);
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(drainMutex);
+        drained.wait_for(lock, options.drainTimeout, [&] { return inFlight.load() == 0; });
+        loading.store(false);
+        drained.notify_all();
+    }
+    reporter.join();
+
+    double measuredSeconds = std::chrono::duration<double>(options.duration - options.warmup).count();
+    std::array<Recorder::Totals, OperationCount> totals = recorder.totals();
+    std::printf("Target %s %.1f req/s", options.profile.c_str(), options.rate);
+    if (options.profile == "ramp") {
+        std::printf(" to %.1f req/s", options.rampTo);
+    }
+    std::printf(" for %.1f s (%.1f s warmup) against %s\n", options.duration.count(), options.warmup.count(),
+                options.url.c_str());
+    std::printf("Sent %llu, dropped %llu at the in-flight limit, %zu still outstanding\n",
+                static_cast<unsigned long long>(sent.load()), static_cast<unsigned long long>(dropped.load()),
+                inFlight.load());
+    printTable("Response time, from intended start (corrected for coordinated omission)", totals,
+               &Recorder::Totals::responseTime, measuredSeconds);
+    printTable("Service time, from hand-off to the client (uncorrected)", totals, &Recorder::Totals::serviceTime,
+               measuredSeconds);
+    return inFlight.load() == 0 ? 0 : 1;
+}
@@ -0,0 +1,920 @@
+#pragma once
+
+#include <sauron/client/HttpWire.hpp>
+#include <sauron/client/Jwt.hpp>
+#include <sauron/dto/AIProvider.hpp>
+#include <sauron/dto/WireFormat.hpp>
+#include <sauron/util/Base64.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <optional>
+#include <queue>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <nlohmann/json.hpp>
+
+namespace sauron {
+namespace mock {
+
+/**
+ * @brief A configurable delay
+ *
+ * JSON form: {"distribution": "fixed", "ms": 20},
+ * {"distribution": "uniform", "min_ms": 10, "max_ms": 50},
+ * {"distribution": "exponential", "mean_ms": 30} or
+ * {"distribution": "lognormal", "median_ms": 40, "p99_ms": 400}.
+ */
+struct LatencyDistribution {
+    enum class Kind { Fixed, Uniform, Exponential, LogNormal };
+
+    Kind kind = Kind::Fixed;
+    double first = 0;  ///< Milliseconds: fixed value, uniform minimum, exponential mean or lognormal median
+    double second = 0; ///< Milliseconds: uniform maximum or lognormal 99th percentile
+
+    static LatencyDistribution fixed(double ms) { return LatencyDistribution{Kind::Fixed, ms, 0}; }
+
+    /**
+     * @brief Draw one delay
+     */
+    std::chrono::microseconds sample(std::mt19937_64& random) const {
+        double ms = first;
+        switch (kind) {
+        case Kind::Fixed:
+            break;
+        case Kind::Uniform:
+            ms = std::uniform_real_distribution<double>(first, std::max(first, second))(random);
+            break;
+        case Kind::Exponential:
+            ms = first > 0 ? std::exponential_distribution<double>(1.0 / first)(random) : 0;
+            break;
+        case Kind::LogNormal: {
+            if (first <= 0) {
+                ms = 0;
+                break;
+            }
+            // z(0.99) = 2.3263: sigma puts the 99th percentile at `second`.
+            double mu = std::log(first);
+            double sigma = second > first ? (std::log(second) - mu) / 2.3263 : 0;
+            ms = std::lognormal_distribution<double>(mu, sigma)(random);
+            break;
+        }
+        }
+        return std::chrono::microseconds(static_cast<std::int64_t>(std::max(0.0, ms) * 1000));
+    }
+
+    /**
+     * @brief Read a distribution from its JSON form
+     *
+     * @throws std::invalid_argument on an unknown distribution
+     */
+    static LatencyDistribution fromJson(const nlohmann::json& json) {
+        std::string name = json.value("distribution", "fixed");
+        if (name == "fixed") {
+            return LatencyDistribution{Kind::Fixed, json.value("ms", 0.0), 0};
+        }
+        if (name == "uniform") {
+            return LatencyDistribution{Kind::Uniform, json.value("min_ms", 0.0), json.value("max_ms", 0.0)};
+        }
+        if (name == "exponential") {
+            return LatencyDistribution{Kind::Exponential, json.value("mean_ms", 0.0), 0};
+        }
+        if (name == "lognormal") {
+            return LatencyDistribution{Kind::LogNormal, json.value("median_ms", 0.0), json.value("p99_ms", 0.0)};
+        }
+        throw std::invalid_argument("Unknown latency distribution: " + name);
+    }
+};
+
+/**
+ * @brief How one path answers
+ */
+struct EndpointBehavior {
+    LatencyDistribution latency;      ///< Delay before the response (the first event, for streams)
+    double errorRate = 0;             ///< Fraction of valid requests answered with errorStatus
+    int errorStatus = 500;            ///< Status of injected errors
+    std::optional<int> retryAfter;    ///< Retry-After seconds sent with injected errors
+    std::string body;                 ///< Success body; empty for the built-in one
+    std::size_t responseBytes = 0;    ///< Size of the generated "response" text when body is empty
+
+    static EndpointBehavior fromJson(const nlohmann::json& json) {
+        EndpointBehavior behavior;
+        if (json.contains("latency")) {
+            behavior.latency = LatencyDistribution::fromJson(json["latency"]);
+        }
+        behavior.errorRate = json.value("error_rate", 0.0);
+        behavior.errorStatus = json.value("error_status", 500);
+        if (json.contains("retry_after")) {
+            behavior.retryAfter = json["retry_after"].get<int>();
+        }
+        if (json.contains("body")) {
+            behavior.body = json["body"].is_string() ? json["body"].get<std::string>() : json["body"].dump();
+        }
+        behavior.responseBytes = json.value("response_bytes", std::size_t(0));
+        return behavior;
+    }
+};
+
+/**
+ * @brief Shape of /ai/query/stream responses
+ *
+ * Every token is one event whose data is {"response": "<token>"}; the
+ * stream ends with "data: [DONE]" when done is set.
+ */
+struct StreamBehavior {
+    std::size_t tokens = 20;                                   ///< Events per stream
+    LatencyDistribution interval = LatencyDistribution::fixed(20); ///< Delay between events
+    std::string token = "token ";                              ///< Text of every event
+    bool done = true;                                          ///< Whether to end with a [DONE] event
+
+    static StreamBehavior fromJson(const nlohmann::json& json) {
+        StreamBehavior behavior;
+        behavior.tokens = json.value("tokens", behavior.tokens);
+        if (json.contains("interval")) {
+            behavior.interval = LatencyDistribution::fromJson(json["interval"]);
+        }
+        behavior.token = json.value("token", behavior.token);
+        behavior.done = json.value("done", behavior.done);
+        return behavior;
+    }
+};
+
+/**
+ * @brief Options for MockServer
+ *
+ * JSON form (every key optional):
+ * {"host": "127.0.0.1", "port": 3000, "threads": 2, "token_ttl_s": 3600,
+ *  "require_auth": true, "endpoints": {"/ai/query": {...}}, "stream": {...}}
+ */
+struct MockServerOptions {
+    std::string host = "127.0.0.1";       ///< IPv4 address to listen on
+    std::uint16_t port = 3000;            ///< Port; 0 picks a free one (see MockServer::port())
+    unsigned threads = 1;                 ///< Event loops, each with its own SO_REUSEPORT listener
+    std::chrono::seconds tokenTtl{3600};  ///< Lifetime ("exp") of issued tokens
+    bool requireAuth = true;              ///< Whether bearer-protected paths reject missing or expired tokens
+    std::map<std::string, EndpointBehavior> endpoints; ///< Per-path behavior; paths without one answer at once
+    StreamBehavior stream;                ///< Shape of /ai/query/stream responses
+
+    static MockServerOptions fromJson(const nlohmann::json& json) {
+        MockServerOptions options;
+        options.host = json.value("host", options.host);
+        options.port = json.value("port", options.port);
+        options.threads = json.value("threads", options.threads);
+        options.tokenTtl = std::chrono::seconds(json.value("token_ttl_s", static_cast<long long>(options.tokenTtl.count())));
+        options.requireAuth = json.value("require_auth", options.requireAuth);
+        if (json.contains("endpoints")) {
+            for (const auto& entry : json["endpoints"].items()) {
+                options.endpoints[entry.key()] = EndpointBehavior::fromJson(entry.value());
+            }
+        }
+        if (json.contains("stream")) {
+            options.stream = StreamBehavior::fromJson(json["stream"]);
+        }
+        return options;
+    }
+};
+
+/**
+ * @brief Counters of a MockServer
+ */
+struct MockServerStats {
+    std::uint64_t connections = 0;    ///< Connections accepted
+    std::uint64_t requests = 0;       ///< Requests parsed
+    std::uint64_t injectedErrors = 0; ///< Responses replaced by an injected error
+    std::uint64_t streams = 0;        ///< Event streams started
+};
+
+/**
+ * @brief Loopback implementation of every path in openapi.yaml
+ *
+ * Serves HTTP/1.1 with keep-alive from one or more epoll loops. Delays are
+ * timers, not sleeps, so a single loop holds thousands of slow requests.
+ * Requests are validated like the real service (400 on a malformed body,
+ * 401 without a valid bearer token); valid ones are answered after the
+ * endpoint's latency, or with an injected error at its error rate. Bodies
+ * may be CBOR or MessagePack (by Content-Type), and replies use the first
+ * of those listed in Accept; error replies are always JSON.
+ */
+class MockServer {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @brief Bind and start serving
+     *
+     * @param options Address, threads and endpoint behavior
+     * @throws std::runtime_error if the address cannot be bound
+     */
+    explicit MockServer(MockServerOptions options) : options_(std::move(options)) {
+        options_.threads = std::max(1u, options_.threads);
+        for (unsigned i = 0; i < options_.threads; ++i) {
+            loops_.push_back(std::make_unique<Loop>(*this, listen(i == 0 ? options_.port : port_), i));
+        }
+        for (auto& loop : loops_) {
+            loop->thread = std::thread([raw = loop.get()] { raw->run(); });
+        }
+    }
+
+    ~MockServer() { stop(); }
+
+    MockServer(const MockServer&) = delete;
+    MockServer& operator=(const MockServer&) = delete;
+
+    /**
+     * @brief Stop serving and close every connection
+     */
+    void stop() {
+        for (auto& loop : loops_) {
+            loop->wake();
+        }
+        for (auto& loop : loops_) {
+            if (loop->thread.joinable()) {
+                loop->thread.join();
+            }
+        }
+        loops_.clear();
+    }
+
+    /**
+     * @brief The port being served
+     */
+    std::uint16_t port() const { return port_; }
+
+    /**
+     * @brief Base URL to hand to SauronClient
+     */
+    std::string baseUrl() const { return "http://" + options_.host + ":" + std::to_string(port_); }
+
+    /**
+     * @brief Get the counters
+     */
+    MockServerStats stats() const {
+        MockServerStats stats;
+        stats.connections = connections_.load(std::memory_order_relaxed);
+        stats.requests = requests_.load(std::memory_order_relaxed);
+        stats.injectedErrors = injectedErrors_.load(std::memory_order_relaxed);
+        stats.streams = streams_.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+private:
+    struct Request {
+        std::string method;
+        std::string path;
+        std::vector<std::string> headers;
+        std::string body;
+        bool keepAlive = true;
+    };
+
+    /// What to send once a request's delay has passed.
+    struct Reply {
+        int status = 200;
+        std::string body;
+        std::optional<int> retryAfter;
+        bool stream = false;
+        dto::WireFormat format = dto::WireFormat::JSON; ///< Encoding of body
+    };
+
+    struct Connection {
+        int fd = -1;
+        std::string in;
+        std::string out;
+        bool busy = false;            ///< A request is being answered; later ones wait in `in`
+        bool closeAfterReply = false;
+        bool wantWrite = false;
+        std::size_t eventsLeft = 0;   ///< Stream events still to send
+        Reply pending;
+    };
+
+    struct Timer {
+        Clock::time_point at;
+        std::uint64_t id;
+        bool operator>(const Timer& other) const { return at > other.at; }
+    };
+
+    class Loop {
+    public:
+        Loop(MockServer& server, int listenFd, unsigned index)
+            : server_(server), listenFd_(listenFd), random_(std::random_device{}() + index) {
+            epollFd_ = ::epoll_create1(EPOLL_CLOEXEC);
+            wakeFd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+            watch(listenFd_, kListenId, EPOLLIN, EPOLL_CTL_ADD);
+            watch(wakeFd_, kWakeId, EPOLLIN, EPOLL_CTL_ADD);
+        }
+
+        ~Loop() {
+            for (auto& entry : connections_) {
+                ::close(entry.second.fd);
+            }
+            ::close(listenFd_);
+            ::close(wakeFd_);
+            ::close(epollFd_);
+        }
+
+        void wake() {
+            stopping_.store(true, std::memory_order_relaxed);
+            std::uint64_t one = 1;
+            ssize_t ignored = ::write(wakeFd_, &one, sizeof(one));
+            (void)ignored;
+        }
+
+        void run() {
+            epoll_event events[kMaxEvents];
+            while (!stopping_.load(std::memory_order_relaxed)) {
+                int n = ::epoll_wait(epollFd_, events, kMaxEvents, nextTimeoutMs());
+                for (int i = 0; i < n; ++i) {
+                    std::uint64_t id = events[i].data.u64;
+                    if (id == kListenId) {
+                        accept();
+                    } else if (id != kWakeId) {
+                        if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+                            onReadable(id);
+                        }
+                        if (events[i].events & EPOLLOUT) {
+                            flush(id);
+                        }
+                    }
+                }
+                fireTimers();
+            }
+        }
+
+        std::thread thread;
+
+    private:
+        static constexpr int kMaxEvents = 256;
+        static constexpr std::uint64_t kListenId = 0;
+        static constexpr std::uint64_t kWakeId = 1;
+
+        void watch(int fd, std::uint64_t id, std::uint32_t events, int operation) {
+            epoll_event ev{};
+            ev.events = events;
+            ev.data.u64 = id;
+            ::epoll_ctl(epollFd_, operation, fd, &ev);
+        }
+
+        void accept() {
+            for (;;) {
+                int fd = ::accept4(listenFd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+                if (fd < 0) {
+                    return;
+                }
+                int one = 1;
+                ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+                std::uint64_t id = nextId_++;
+                connections_[id].fd = fd;
+                watch(fd, id, EPOLLIN, EPOLL_CTL_ADD);
+                server_.connections_.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        void onReadable(std::uint64_t id) {
+            auto it = connections_.find(id);
+            if (it == connections_.end()) {
+                return;
+            }
+            Connection& conn = it->second;
+            char buffer[16384];
+            for (;;) {
+                ssize_t n = ::recv(conn.fd, buffer, sizeof(buffer), 0);
+                if (n > 0) {
+                    conn.in.append(buffer, static_cast<std::size_t>(n));
+                    continue;
+                }
+                if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+                    close(id);
+                    return;
+                }
+                if (errno != EINTR) {
+                    break;
+                }
+            }
+            serveNext(id, conn);
+        }
+
+        /// Starts answering the next buffered request, if the connection is idle.
+        void serveNext(std::uint64_t id, Connection& conn) {
+            if (conn.busy || conn.closeAfterReply) {
+                return;
+            }
+            Request request;
+            std::size_t consumed = 0;
+            switch (parse(conn.in, request, consumed)) {
+            case ParseResult::Incomplete:
+                return;
+            case ParseResult::Invalid:
+                conn.pending = Reply{400, error("Malformed HTTP request"), std::nullopt, false};
+                conn.closeAfterReply = true;
+                conn.busy = true;
+                reply(id, conn);
+                return;
+            case ParseResult::Complete:
+                break;
+            }
+            conn.in.erase(0, consumed);
+            conn.busy = true;
+            conn.closeAfterReply = !request.keepAlive;
+            server_.requests_.fetch_add(1, std::memory_order_relaxed);
+
+            const EndpointBehavior* behavior = server_.behavior(request.path);
+            conn.pending = server_.handle(request, random_);
+            if (behavior && conn.pending.status == 200 && behavior->errorRate > 0 &&
+                std::uniform_real_distribution<double>(0, 1)(random_) < behavior->errorRate) {
+                server_.injectedErrors_.fetch_add(1, std::memory_order_relaxed);
+                conn.pending = Reply{behavior->errorStatus, error("Injected failure"), behavior->retryAfter, false};
+            }
+            std::chrono::microseconds delay = behavior ? behavior->latency.sample(random_) : std::chrono::microseconds(0);
+            if (delay.count() == 0) {
+                reply(id, conn);
+            } else {
+                timers_.push(Timer{Clock::now() + delay, id});
+            }
+        }
+
+        /// Sends the pending reply: the whole response, or a stream head and its first event.
+        void reply(std::uint64_t id, Connection& conn) {
+            Reply& pending = conn.pending;
+            if (pending.stream) {
+                server_.streams_.fetch_add(1, std::memory_order_relaxed);
+                conn.out.append("HTTP/1.1 200 OK\r\nContent-Type: text/event-stream\r\n"
+                                "Cache-Control: no-cache\r\nTransfer-Encoding: chunked\r\n\r\n");
+                conn.eventsLeft = server_.options_.stream.tokens + (server_.options_.stream.done ? 1 : 0);
+                nextEvent(id, conn);
+                return;
+            }
+            writeResponse(conn.out, pending.status, pending.body, pending.format, pending.retryAfter,
+                          conn.closeAfterReply);
+            finish(id, conn);
+        }
+
+        void nextEvent(std::uint64_t id, Connection& conn) {
+            const StreamBehavior& stream = server_.options_.stream;
+            if (conn.eventsLeft == 0) {
+                conn.out.append("0\r\n\r\n");
+                finish(id, conn);
+                return;
+            }
+            bool last = stream.done && conn.eventsLeft == 1;
+            std::string event = last ? "data: [DONE]\n\n"
+                                     : "data: " + nlohmann::json{{"response", stream.token}}.dump() + "\n\n";
+            appendChunk(conn.out, event);
+            --conn.eventsLeft;
+            if (!flush(id)) {
+                return;
+            }
+            if (conn.eventsLeft == 0) {
+                nextEvent(id, conn);
+            } else {
+                timers_.push(Timer{Clock::now() + stream.interval.sample(random_), id});
+            }
+        }
+
+        /// Ends the current exchange and moves on to a pipelined request, if any.
+        void finish(std::uint64_t id, Connection& conn) {
+            conn.busy = false;
+            conn.pending = Reply{};
+            if (!flush(id)) {
+                return;
+            }
+            if (conn.closeAfterReply) {
+                if (conn.out.empty()) {
+                    close(id);
+                }
+                return;
+            }
+            serveNext(id, conn);
+        }
+
+        /// Writes what it can; returns false if the connection was closed.
+        bool flush(std::uint64_t id) {
+            auto it = connections_.find(id);
+            if (it == connections_.end()) {
+                return false;
+            }
+            Connection& conn = it->second;
+            while (!conn.out.empty()) {
+                ssize_t n = ::send(conn.fd, conn.out.data(), conn.out.size(), MSG_NOSIGNAL);
+                if (n > 0) {
+                    conn.out.erase(0, static_cast<std::size_t>(n));
+                } else if (n < 0 && errno == EINTR) {
+                    continue;
+                } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                    break;
+                } else {
+                    close(id);
+                    return false;
+                }
+            }
+            bool wantWrite = !conn.out.empty();
+            if (wantWrite != conn.wantWrite) {
+                conn.wantWrite = wantWrite;
+                watch(conn.fd, id, EPOLLIN | (wantWrite ? EPOLLOUT : 0u), EPOLL_CTL_MOD);
+            }
+            if (!wantWrite && conn.closeAfterReply && !conn.busy) {
+                close(id);
+                return false;
+            }
+            return true;
+        }
+
+        void close(std::uint64_t id) {
+            auto it = connections_.find(id);
+            if (it == connections_.end()) {
+                return;
+            }
+            ::epoll_ctl(epollFd_, EPOLL_CTL_DEL, it->second.fd, nullptr);
+            ::close(it->second.fd);
+            connections_.erase(it); // pending timers find no connection and are dropped
+        }
+
+        int nextTimeoutMs() const {
+            if (timers_.empty()) {
+                return -1;
+            }
+            auto wait = std::chrono::duration_cast<std::chrono::microseconds>(timers_.top().at - Clock::now());
+            // Round up so a timer is never polled for before it is due.
+            return wait.count() <= 0 ? 0 : static_cast<int>((wait.count() + 999) / 1000);
+        }
+
+        void fireTimers() {
+            Clock::time_point now = Clock::now();
+            while (!timers_.empty() && timers_.top().at <= now) {
+                std::uint64_t id = timers_.top().id;
+                timers_.pop();
+                auto it = connections_.find(id);
+                if (it == connections_.end()) {
+                    continue;
+                }
+                Connection& conn = it->second;
+                if (conn.eventsLeft > 0) {
+                    nextEvent(id, conn);
+                } else {
+                    reply(id, conn);
+                }
+            }
+        }
+
+        MockServer& server_;
+        int listenFd_;
+        int epollFd_ = -1;
+        int wakeFd_ = -1;
+        std::atomic<bool> stopping_{false};
+        std::mt19937_64 random_;
+        std::uint64_t nextId_ = 2;
+        std::unordered_map<std::uint64_t, Connection> connections_;
+        std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> timers_;
+    };
+
+    enum class ParseResult { Incomplete, Invalid, Complete };
+
+    static constexpr std::size_t kMaxHeadBytes = 64 * 1024;
+
+    /// Parses one request from the front of `in`; Content-Length and chunked bodies are supported.
+    static ParseResult parse(const std::string& in, Request& request, std::size_t& consumed) {
+        std::size_t headEnd = in.find("\r\n\r\n");
+        if (headEnd == std::string::npos) {
+            return in.size() > kMaxHeadBytes ? ParseResult::Invalid : ParseResult::Incomplete;
+        }
+        std::size_t lineEnd = in.find("\r\n");
+        std::string requestLine = in.substr(0, lineEnd);
+        std::size_t sp1 = requestLine.find(' ');
+        std::size_t sp2 = requestLine.rfind(' ');
+        if (sp1 == std::string::npos || sp2 == sp1) {
+            return ParseResult::Invalid;
+        }
+        request.method = requestLine.substr(0, sp1);
+        request.path = requestLine.substr(sp1 + 1, sp2 - sp1 - 1);
+        std::string version = requestLine.substr(sp2 + 1);
+        request.path = request.path.substr(0, request.path.find('?'));
+        request.keepAlive = version != "HTTP/1.0";
+
+        std::size_t pos = lineEnd + 2;
+        while (pos < headEnd) {
+            std::size_t end = in.find("\r\n", pos);
+            request.headers.push_back(in.substr(pos, end - pos));
+            pos = end + 2;
+        }
+        std::string value;
+        if (client::wire::findHeader(request.headers, "Connection", value)) {
+            if (client::wire::equalsIgnoreCase(value, "close")) {
+                request.keepAlive = false;
+            } else if (client::wire::equalsIgnoreCase(value, "keep-alive")) {
+                request.keepAlive = true;
+            }
+        }
+
+        std::size_t bodyStart = headEnd + 4;
+        if (client::wire::findHeader(request.headers, "Transfer-Encoding", value) &&
+            value.find("chunked") != std::string::npos) {
+            std::size_t at = bodyStart;
+            for (;;) {
+                std::size_t sizeEnd = in.find("\r\n", at);
+                if (sizeEnd == std::string::npos) {
+                    return ParseResult::Incomplete;
+                }
+                std::size_t size = 0;
+                try {
+                    size = std::stoul(in.substr(at, sizeEnd - at), nullptr, 16);
+                } catch (const std::exception&) {
+                    return ParseResult::Invalid;
+                }
+                at = sizeEnd + 2;
+                if (size == 0) {
+                    std::size_t trailerEnd = in.find("\r\n", at);
+                    // Skip trailers up to the empty line.
+                    while (trailerEnd != std::string::npos && trailerEnd != at) {
+                        at = trailerEnd + 2;
+                        trailerEnd = in.find("\r\n", at);
+                    }
+                    if (trailerEnd == std::string::npos) {
+                        return ParseResult::Incomplete;
+                    }
+                    consumed = at + 2;
+                    return ParseResult::Complete;
+                }
+                if (in.size() < at + size + 2) {
+                    return ParseResult::Incomplete;
+                }
+                request.body.append(in, at, size);
+                at += size + 2;
+            }
+        }
+        std::size_t length = 0;
+        if (client::wire::findHeader(request.headers, "Content-Length", value)) {
+            try {
+                length = std::stoul(value);
+            } catch (const std::exception&) {
+                return ParseResult::Invalid;
+            }
+        }
+        if (in.size() < bodyStart + length) {
+            return ParseResult::Incomplete;
+        }
+        request.body.assign(in, bodyStart, length);
+        consumed = bodyStart + length;
+        return ParseResult::Complete;
+    }
+
+    int listen(std::uint16_t port) {
+        int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd < 0) {
+            throw std::runtime_error(std::string("socket() failed: ") + std::strerror(errno));
+        }
+        int one = 1;
+        ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        ::setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one));
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        if (::inet_pton(AF_INET, options_.host.c_str(), &addr.sin_addr) != 1) {
+            ::close(fd);
+            throw std::runtime_error("Invalid IPv4 address: " + options_.host);
+        }
+        if (::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || ::listen(fd, SOMAXCONN) != 0) {
+            int code = errno;
+            ::close(fd);
+            throw std::runtime_error("Failed to listen on " + options_.host + ":" + std::to_string(port) + ": " +
+                                     std::strerror(code));
+        }
+        socklen_t size = sizeof(addr);
+        ::getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &size);
+        port_ = ntohs(addr.sin_port);
+        return fd;
+    }
+
+    const EndpointBehavior* behavior(const std::string& path) const {
+        auto it = options_.endpoints.find(path);
+        return it == options_.endpoints.end() ? nullptr : &it->second;
+    }
+
+    /// Validates a request and builds its reply; injected errors are applied by the caller.
+    Reply handle(const Request& request, std::mt19937_64& random) const {
+        static const std::map<std::string, std::string> methods = {
+            {"/auth/login", "POST"}, {"/auth/refresh", "POST"}, {"/ai/query", "POST"},
+            {"/ai/query/algorithm", "POST"}, {"/ai/query/stream", "POST"}, {"/health", "GET"},
+        };
+        auto method = methods.find(request.path);
+        if (method == methods.end()) {
+            return Reply{404, error("Not found"), std::nullopt, false};
+        }
+        if (request.method != method->second) {
+            return Reply{405, error("Method not allowed"), std::nullopt, false};
+        }
+        const dto::WireFormat format = acceptedFormat(request);
+        if (request.path == "/health") {
+            return ok(request.path, nlohmann::json{{"status", "ok"}}, format);
+        }
+        if (request.path == "/auth/login") {
+            nlohmann::json body = decodeBody(request);
+            if (!body.is_object() || !body.contains("api_key") || !body["api_key"].is_string() ||
+                body["api_key"].get<std::string>().empty() || !validProvider(body, "provider")) {
+                return Reply{400, error("api_key and a valid provider are required"), std::nullopt, false};
+            }
+            return ok(request.path, nlohmann::json{{"token", issueToken(body["provider"].get<std::string>(), random)}},
+                      format);
+        }
+
+        if (std::optional<std::string> failure = authorize(request)) {
+            return Reply{401, error(*failure), std::nullopt, false};
+        }
+        if (request.path == "/auth/refresh") {
+            return ok(request.path, nlohmann::json{{"token", issueToken("refresh", random)}}, format);
+        }
+
+        nlohmann::json body = decodeBody(request);
+        if (!body.is_object() || !body.contains("prompt") || !body["prompt"].is_string() ||
+            body["prompt"].get<std::string>().empty() || !validProvider(body, "provider") ||
+            (body.contains("images") && !body["images"].is_array())) {
+            return Reply{400, error("prompt and a valid provider are required"), std::nullopt, false};
+        }
+        if (request.path == "/ai/query/stream") {
+            Reply reply;
+            reply.stream = true;
+            return reply;
+        }
+        if (request.path == "/ai/query/algorithm") {
+            return ok(request.path, nlohmann::json{
+                {"explanation", "Merge sort splits the input in halves, sorts them and merges the results."},
+                {"response", responseText(request.path, "def merge_sort(xs): ...")},
+                {"complexity", {
+                    {"time", {{"value", "O(n log n)"}, {"explanation", "log n levels of linear merges."}}},
+                    {"space", {{"value", "O(n)"}, {"explanation", "The merge buffer."}}},
+                }},
+            }, format);
+        }
+        return ok(request.path, nlohmann::json{{"response", responseText(request.path, "This is a mock response.")}},
+                  format);
+    }
+
+    /// A 200 reply in the negotiated format; a configured body replaces the generated one.
+    Reply ok(const std::string& path, nlohmann::json body, dto::WireFormat format) const {
+        const EndpointBehavior* configured = behavior(path);
+        if (configured && !configured->body.empty()) {
+            body = nlohmann::json::parse(configured->body, nullptr, false);
+            if (body.is_discarded()) {
+                // Not JSON: send it verbatim.
+                return Reply{200, configured->body, std::nullopt, false};
+            }
+        }
+        Reply reply{200, std::string(), std::nullopt, false, format};
+        dto::encodeWireFormat(body, format, reply.body);
+        return reply;
+    }
+
+    /// Parses a request body by its Content-Type; discarded if it is not a valid document.
+    static nlohmann::json decodeBody(const Request& request) {
+        std::string contentType;
+        dto::WireFormat format = client::wire::findHeader(request.headers, "Content-Type", contentType)
+            ? dto::toWireFormat(contentType)
+            : dto::WireFormat::JSON;
+        try {
+            return dto::decodeWireFormat(request.body, format);
+        } catch (const nlohmann::json::exception&) {
+            return nlohmann::json(nlohmann::json::value_t::discarded);
+        }
+    }
+
+    /// The first binary format listed in Accept, or JSON.
+    static dto::WireFormat acceptedFormat(const Request& request) {
+        std::string accept;
+        if (!client::wire::findHeader(request.headers, "Accept", accept)) {
+            return dto::WireFormat::JSON;
+        }
+        std::size_t begin = 0;
+        while (begin < accept.size()) {
+            std::size_t end = accept.find(',', begin);
+            if (end == std::string::npos) {
+                end = accept.size();
+            }
+            dto::WireFormat format = dto::toWireFormat(std::string_view(accept).substr(begin, end - begin));
+            if (format != dto::WireFormat::JSON) {
+                return format;
+            }
+            begin = end + 1;
+        }
+        return dto::WireFormat::JSON;
+    }
+
+    std::string responseText(const std::string& path, const char* fallback) const {
+        const EndpointBehavior* configured = behavior(path);
+        if (!configured || configured->responseBytes == 0) {
+            return fallback;
+        }
+        std::string text;
+        text.reserve(configured->responseBytes);
+        while (text.size() < configured->responseBytes) {
+            text += "lorem ipsum dolor sit amet ";
+        }
+        text.resize(configured->responseBytes);
+        return text;
+    }
+
+    /// Returns the reason a bearer-protected request is rejected, if it is.
+    std::optional<std::string> authorize(const Request& request) const {
+        if (!options_.requireAuth) {
+            return std::nullopt;
+        }
+        std::string value;
+        if (!client::wire::findHeader(request.headers, "Authorization", value) || value.compare(0, 7, "Bearer ") != 0 ||
+            value.size() == 7) {
+            return std::string("Missing bearer token");
+        }
+        if (auto expiry = client::jwt::expiry(value.substr(7))) {
+            if (*expiry <= std::chrono::system_clock::now()) {
+                return std::string("Token expired");
+            }
+        }
+        return std::nullopt;
+    }
+
+    std::string issueToken(const std::string& subject, std::mt19937_64& random) const {
+        auto now = std::chrono::duration_cast<std::chrono::seconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        nlohmann::json claims = {{"sub", subject}, {"iat", now}, {"exp", now + options_.tokenTtl.count()},
+                                 {"jti", std::to_string(random())}};
+        using util::base64::Alphabet;
+        return util::base64::encode("{\"alg\":\"none\",\"typ\":\"JWT\"}", Alphabet::Url) + "." +
+               util::base64::encode(claims.dump(), Alphabet::Url) + ".mock";
+    }
+
+    static bool validProvider(const nlohmann::json& body, const char* key) {
+        if (!body.contains(key) || !body[key].is_string()) {
+            return false;
+        }
+        try {
+            dto::toAIProvider(body[key].get<std::string>());
+            return true;
+        } catch (const std::invalid_argument&) {
+            return false;
+        }
+    }
+
+    static std::string error(const std::string& message) { return nlohmann::json{{"error", message}}.dump(); }
+
+    static const char* reason(int status) {
+        switch (status) {
+        case 200: return "OK";
+        case 400: return "Bad Request";
+        case 401: return "Unauthorized";
+        case 404: return "Not Found";
+        case 405: return "Method Not Allowed";
+        case 408: return "Request Timeout";
+        case 429: return "Too Many Requests";
+        case 500: return "Internal Server Error";
+        case 502: return "Bad Gateway";
+        case 503: return "Service Unavailable";
+        case 504: return "Gateway Timeout";
+        default: return "Unknown";
+        }
+    }
+
+    static void writeResponse(std::string& out, int status, const std::string& body, dto::WireFormat format,
+                              const std::optional<int>& retryAfter, bool close) {
+        out.append("HTTP/1.1 ").append(std::to_string(status)).append(" ").append(reason(status));
+        out.append("\r\nContent-Type: ").append(dto::WireFormatToContentType(format));
+        out.append("\r\nContent-Length: ").append(std::to_string(body.size()));
+        if (retryAfter) {
+            out.append("\r\nRetry-After: ").append(std::to_string(*retryAfter));
+        }
+        if (close) {
+            out.append("\r\nConnection: close");
+        }
+        out.append("\r\n\r\n").append(body);
+    }
+
+    static void appendChunk(std::string& out, const std::string& data) {
+        char size[20];
+        std::snprintf(size, sizeof(size), "%zx\r\n", data.size());
+        out.append(size).append(data).append("\r\n");
+    }
+
+    MockServerOptions options_;
+    std::uint16_t port_ = 0;
+    std::atomic<std::uint64_t> connections_{0};
+    std::atomic<std::uint64_t> requests_{0};
+    std::atomic<std::uint64_t> injectedErrors_{0};
+    std::atomic<std::uint64_t> streams_{0};
+    std::vector<std::unique_ptr<Loop>> loops_; ///< Declared last: stopped before the state they use
+};
+
+} // namespace mock
+} // namespace sauron
@@ -0,0 +1,85 @@
+#include "MockServer.hpp"
+#include <csignal>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+namespace {
+
+void usage(const char* program) {
+    std::cerr << "Usage: " << program << " [--config FILE] [--host ADDRESS] [--port PORT] [--threads N]\n"
+              << "\n"
+              << "Serves every path of openapi.yaml on loopback. FILE is JSON, e.g.\n"
+              << "  {\"threads\": 2,\n"
+              << "   \"endpoints\": {\"/ai/query\": {\"latency\": {\"distribution\": \"lognormal\",\n"
+              << "                                             \"median_ms\": 40, \"p99_ms\": 400},\n"
+              << "                                \"error_rate\": 0.01, \"error_status\": 503,\n"
+              << "                                \"retry_after\": 1}},\n"
+              << "   \"stream\": {\"tokens\": 50, \"interval\": {\"distribution\": \"fixed\", \"ms\": 15}}}\n"
+              << "Command-line flags override the file.\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    nlohmann::json config = nlohmann::json::object();
+    nlohmann::json overrides = nlohmann::json::object();
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h") {
+            usage(argv[0]);
+            return 0;
+        }
+        if (i + 1 >= argc) {
+            usage(argv[0]);
+            return 2;
+        }
+        std::string value = argv[++i];
+        try {
+            if (arg == "--config") {
+                std::ifstream file(value);
+                if (!file) {
+                    std::cerr << "Cannot open " << value << "\n";
+                    return 2;
+                }
+                config = nlohmann::json::parse(file);
+            } else if (arg == "--host") {
+                overrides["host"] = value;
+            } else if (arg == "--port") {
+                overrides["port"] = std::stoi(value);
+            } else if (arg == "--threads") {
+                overrides["threads"] = std::stoi(value);
+            } else {
+                usage(argv[0]);
+                return 2;
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "Invalid value for " << arg << ": " << e.what() << "\n";
+            return 2;
+        }
+    }
+    config.update(overrides);
+
+    // Handled by sigwait below rather than by a signal handler.
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+    try {
+        sauron::mock::MockServer server(sauron::mock::MockServerOptions::fromJson(config));
+        std::cout << "Listening on " << server.baseUrl() << std::endl;
+        int received = 0;
+        sigwait(&signals, &received);
+        sauron::mock::MockServerStats stats = server.stats();
+        server.stop();
+        std::cout << "Served " << stats.requests << " requests on " << stats.connections << " connections ("
+                  << stats.streams << " streams, " << stats.injectedErrors << " injected errors)" << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}